@@ -4,15 +4,23 @@
 #include <vector>
 #include <glm/gtc/quaternion.hpp>
 #include <data/PathData.hpp>
+#include <ai/AIGraphNode.hpp>
 #include <array>
+#include <limits>
 #include <rw/types.hpp>
 
-struct AIGraphNode;
-
 class AIGraph
 {
 public:
 
+	/// Bits of (1 << AIGraphNode::NodeType) for queries that take any node
+	static const unsigned int AnyType = ~0u;
+
+	static unsigned int typeBit(AIGraphNode::NodeType type) { return 1u << type; }
+
+	typedef std::array<std::vector<AIGraphNode*>,WORLD_GRID_CELLS> NodeGrid;
+
+	AIGraph();
 	~AIGraph();
 
 	std::vector<AIGraphNode*> nodes;
@@ -27,11 +35,57 @@ public:
 	/**
 	 * Stores the external AI Grid Nodes organised by world grid cell
 	 */
-	std::array<std::vector<AIGraphNode*>,WORLD_GRID_CELLS> gridNodes;
+	NodeGrid gridNodes;
+
+	/**
+	 * Stores every node organised by world grid cell, nodes outside the
+	 * grid are kept in the nearest cell on its edge
+	 */
+	NodeGrid allGridNodes;
+
+	/**
+	 * Incremented whenever nodes are added, so copies of the graph know
+	 * when to rebuild
+	 */
+	uint32_t revision;
 
 	void createPathNodes(const glm::vec3& position, const glm::quat& rotation, PathData& path);
 
 	void gatherExternalNodesNear(const glm::vec3& center, const float radius, std::vector<AIGraphNode*>& nodes);
+
+	/**
+	 * Appends the nodes, internal or external, within radius of center to out
+	 * @param types Bits of (1 << AIGraphNode::NodeType) to include
+	 */
+	void gatherNodesNear(const glm::vec3& center, float radius, std::vector<AIGraphNode*>& out,
+						 unsigned int types = AnyType) const;
+
+	/**
+	 * Appends up to count nodes within maxDistance of center to out,
+	 * nearest first
+	 */
+	void findNearestNodes(const glm::vec3& center, size_t count, float maxDistance,
+						  std::vector<AIGraphNode*>& out, unsigned int types = AnyType) const;
+
+	/**
+	 * Returns the nearest node within maxDistance of center, or nullptr
+	 */
+	AIGraphNode* findNearestNode(const glm::vec3& center, unsigned int types = AnyType,
+								 float maxDistance = std::numeric_limits<float>::max()) const;
+
+private:
+	/**
+	 * Calls function with each node in grid that's in a cell overlapping
+	 * the square around center
+	 */
+	template<class Function>
+	static void forEachNodeNear(const NodeGrid& grid, const glm::vec3& center, float radius,
+								const Function& function);
+
+	/**
+	 * Returns true if the square around center overlaps every grid cell
+	 */
+	static bool coversGrid(const glm::vec3& center, float radius);
 };
 
 #endif
@@ -28,6 +28,9 @@ struct AIGraphNode
     int32_t nextIndex;
 	
 	bool disabled;
+
+	/// Position of the node in AIGraph::nodes
+	uint32_t index;
 	
 	std::vector<AIGraphNode*> connections;
 };
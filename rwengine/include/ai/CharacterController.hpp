@@ -103,6 +103,15 @@ public:
 	 */
 	bool isCurrentActivity(const std::string& activity) const;
 	
+	/**
+	 * @brief plan Decides what the character should do next.
+	 *
+	 * Called from the character's tickParallel, so it may read the world
+	 * but only change the controller.
+	 * @param dt
+	 */
+	virtual void plan(float /*dt*/) { }
+
 	/**
 	 * @brief update Updates the controller.
 	 * @param dt
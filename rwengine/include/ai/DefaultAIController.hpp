@@ -8,14 +8,16 @@ struct AIGraphNode;
 class DefaultAIController : public CharacterController
 {
 	glm::vec3 gotoPos;
+
+	/// Seeded from the world's, so the AI's choices can be reproduced
+	std::default_random_engine randomEngine;
 public:
 	
-	DefaultAIController(CharacterObject* character)
-	 : CharacterController(character) {}
+	DefaultAIController(CharacterObject* character);
 
 	glm::vec3 getTargetPosition();
 	
-    virtual void update(float dt);
+    virtual void plan(float dt);
 };
 
 #endif
@@ -0,0 +1,144 @@
+#pragma once
+#ifndef _RWENGINE_ROUTEPLANNER_HPP_
+#define _RWENGINE_ROUTEPLANNER_HPP_
+#include <ai/AIGraphNode.hpp>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class AIGraph;
+class WorkContext;
+
+/**
+ * @brief Finds routes between nodes of the AI graph
+ *
+ * Searches run over a compact copy of the graph: each node is its index in
+ * AIGraph::nodes, positions are kept in separate arrays and the connections
+ * are packed into one array. The copy is rebuilt when nodes are added to the
+ * graph, and the disabled flags are copied again by refreshDisabled().
+ *
+ * A route only passes through nodes of the start node's type that aren't
+ * disabled, the start node itself may be disabled. The most recently found
+ * routes are cached, including the queries that had no route.
+ */
+class RoutePlanner
+{
+public:
+	typedef std::vector<AIGraphNode*> Route;
+
+	/// Called with the route, which is empty if there isn't one
+	typedef std::function<void(const Route&)> Callback;
+
+	enum Algorithm
+	{
+		/// A* from the start to the goal
+		AStar,
+		/// A* from both ends, until the searches meet
+		Bidirectional
+	};
+
+	struct Stats
+	{
+		size_t hits;
+		size_t misses;
+		/// Nodes taken from the open lists by every search
+		size_t expanded;
+	};
+
+	RoutePlanner(const AIGraph& graph, size_t cacheSize = 256);
+	~RoutePlanner();
+
+	/**
+	 * Finds the shortest route from start to goal
+	 * @param out Receives the nodes along the route, including both ends
+	 * @return false if there is no route
+	 */
+	bool findRoute(AIGraphNode* start, AIGraphNode* goal, Route& out,
+				   Algorithm algorithm = AStar);
+
+	/**
+	 * Finds a route between the nodes of type nearest to start and goal
+	 */
+	bool findRoute(const glm::vec3& start, const glm::vec3& goal, AIGraphNode::NodeType type,
+				   Route& out, Algorithm algorithm = AStar);
+
+	/**
+	 * Searches for the route on the work context's threads, callback is
+	 * called from WorkContext::update(). If the route is cached callback is
+	 * called immediately. The planner must outlive the request.
+	 */
+	void findRouteAsync(WorkContext* work, AIGraphNode* start, AIGraphNode* goal,
+						const Callback& callback, Algorithm algorithm = AStar);
+
+	/**
+	 * Copies the disabled flags of the nodes again and forgets the cached
+	 * routes, call after changing AIGraphNode::disabled
+	 */
+	void refreshDisabled();
+
+	void clearCache();
+
+	size_t getCacheSize() const { return entries.size(); }
+	const Stats& getStats() const { return stats; }
+
+private:
+	struct Network;
+	struct Search;
+	class RouteJob;
+
+	typedef std::shared_ptr<const Network> NetworkPtr;
+	typedef std::shared_ptr<const std::vector<uint8_t>> DisabledPtr;
+
+	struct Entry
+	{
+		uint64_t key;
+		bool found;
+		Route route;
+	};
+
+	const AIGraph& graph;
+
+	/// The graph's revision when network was built
+	uint32_t networkRevision;
+	NetworkPtr network;
+	DisabledPtr disabled;
+	/// Scratch for searches that aren't running, async searches each take one
+	std::vector<std::unique_ptr<Search>> spareSearches;
+
+	size_t capacity;
+	/// Incremented whenever the cache is cleared, so stale async results are dropped
+	uint32_t cacheGeneration;
+	/// Most recently used first
+	std::list<Entry> entries;
+	std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+	Stats stats;
+
+	/**
+	 * Rebuilds the network if the graph has changed since it was built
+	 */
+	void updateNetwork();
+
+	std::unique_ptr<Search> takeSearch();
+	void returnSearch(std::unique_ptr<Search> search);
+
+	/// Returns true if node is in the current network
+	bool inNetwork(AIGraphNode* node) const;
+
+	static uint64_t routeKey(uint32_t start, uint32_t goal)
+	{
+		return (uint64_t(start) << 32) | goal;
+	}
+
+	/**
+	 * Copies the cached route to out and returns true if it's cached
+	 */
+	bool findCached(uint64_t key, bool& found, Route& out);
+
+	void cacheRoute(uint64_t key, bool found, const Route& route);
+};
+
+#endif
@@ -0,0 +1,131 @@
+#pragma once
+#ifndef _RWENGINE_AUDIODEVICE_HPP_
+#define _RWENGINE_AUDIODEVICE_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief The few things sound effects need from an audio library
+ *
+ * Buffers hold 16-bit mono PCM so sources can be positioned. Names are
+ * never 0, which is kept to mean "none".
+ */
+class AudioDevice
+{
+public:
+	virtual ~AudioDevice() { }
+
+	/**
+	 * Creates a buffer from 16-bit mono samples, the data is copied
+	 */
+	virtual unsigned int createBuffer(const char* data, size_t bytes, unsigned int sampleRate) = 0;
+	virtual void deleteBuffer(unsigned int buffer) = 0;
+
+	virtual unsigned int createSource() = 0;
+	virtual void deleteSource(unsigned int source) = 0;
+
+	/**
+	 * Plays a buffer on a source from the start, replacing whatever it
+	 * was playing
+	 */
+	virtual void play(unsigned int source, unsigned int buffer, float gain, bool loop) = 0;
+	virtual void stop(unsigned int source) = 0;
+	virtual bool isPlaying(unsigned int source) = 0;
+
+	virtual void setPosition(unsigned int source, const glm::vec3& position) = 0;
+	virtual void setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up) = 0;
+};
+
+/**
+ * @brief Plays sound effects through the current OpenAL context
+ */
+class OpenALDevice : public AudioDevice
+{
+public:
+	/**
+	 * @param referenceDistance Distance at which sources play at their full gain
+	 * @param maxDistance Distance past which sources stop getting quieter
+	 */
+	OpenALDevice(float referenceDistance = 5.f, float maxDistance = 100.f);
+
+	unsigned int createBuffer(const char* data, size_t bytes, unsigned int sampleRate) override;
+	void deleteBuffer(unsigned int buffer) override;
+
+	unsigned int createSource() override;
+	void deleteSource(unsigned int source) override;
+
+	void play(unsigned int source, unsigned int buffer, float gain, bool loop) override;
+	void stop(unsigned int source) override;
+	bool isPlaying(unsigned int source) override;
+
+	void setPosition(unsigned int source, const glm::vec3& position) override;
+	void setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up) override;
+
+private:
+	float referenceDistance;
+	float maxDistance;
+};
+
+/**
+ * @brief Pretends to play sounds without any audio hardware
+ *
+ * Sounds play for as long as their samples would, as advance() is called.
+ * Used for headless runs and the tests.
+ */
+class NullAudioDevice : public AudioDevice
+{
+public:
+	unsigned int createBuffer(const char* data, size_t bytes, unsigned int sampleRate) override;
+	void deleteBuffer(unsigned int buffer) override;
+
+	unsigned int createSource() override;
+	void deleteSource(unsigned int source) override;
+
+	void play(unsigned int source, unsigned int buffer, float gain, bool loop) override;
+	void stop(unsigned int source) override;
+	bool isPlaying(unsigned int source) override;
+
+	void setPosition(unsigned int source, const glm::vec3& position) override;
+	void setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up) override;
+
+	/**
+	 * Moves playback on by dt seconds, ending sounds that run out
+	 */
+	void advance(float dt);
+
+	size_t getBufferCount() const { return bufferCount; }
+	size_t getSourceCount() const { return sourceCount; }
+	/// Total bytes passed to createBuffer()
+	size_t getUploadedBytes() const { return uploadedBytes; }
+	/// Number of times play() was called
+	size_t getPlayCount() const { return playCount; }
+
+private:
+	struct Buffer
+	{
+		bool alive;
+		float duration;
+	};
+
+	struct Source
+	{
+		bool alive;
+		bool playing;
+		bool loop;
+		float remaining;
+		glm::vec3 position;
+	};
+
+	// Names are indices plus one
+	std::vector<Buffer> buffers;
+	std::vector<Source> sources;
+	size_t bufferCount = 0;
+	size_t sourceCount = 0;
+	size_t uploadedBytes = 0;
+	size_t playCount = 0;
+};
+
+#endif
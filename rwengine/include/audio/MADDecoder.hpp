@@ -0,0 +1,91 @@
+#pragma once
+#ifndef _RWENGINE_MADDECODER_HPP_
+#define _RWENGINE_MADDECODER_HPP_
+
+#include <audio/PCMRingBuffer.hpp>
+#include <mad.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Decodes an MP3 file on its own thread into a ring of PCM samples
+ *
+ * The file is read in small pieces as it's decoded, and decoding waits
+ * while the ring is full, so memory use doesn't depend on the length of
+ * the file. Samples are always interleaved 16-bit stereo; mono files have
+ * their channel duplicated.
+ *
+ * read() may be called from one other thread, which doesn't need to know
+ * anything about the decoder thread.
+ */
+class MADDecoder
+{
+public:
+	/**
+	 * @param bufferSamples Size of the PCM ring, in samples
+	 */
+	MADDecoder(size_t bufferSamples = 1 << 17);
+	~MADDecoder();
+
+	/**
+	 * Opens a file and starts decoding it, closing any open file first
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * Stops decoding and closes the file
+	 */
+	void close();
+
+	/**
+	 * Reads up to count decoded samples, returns how many were read
+	 */
+	size_t read(int16_t* samples, size_t count);
+
+	/**
+	 * Returns the number of decoded samples waiting to be read
+	 */
+	size_t available() const { return ring.available(); }
+
+	/**
+	 * Returns true once the whole file is decoded and read
+	 */
+	bool isFinished() const { return finished && ring.available() == 0; }
+
+	/**
+	 * The sample rate of the file, 0 until the first frame is decoded
+	 */
+	unsigned int getSampleRate() const { return sampleRate; }
+
+private:
+	FILE* file;
+	std::vector<unsigned char> input;
+	bool inputEnded;
+	std::vector<int16_t> output;
+
+	PCMRingBuffer ring;
+	std::atomic<unsigned int> sampleRate;
+	std::atomic<bool> finished;
+	std::atomic<bool> stopping;
+
+	std::thread thread;
+	/// Wakes the decoder thread when there's space in the ring
+	std::mutex spaceMutex;
+	std::condition_variable spaceCondition;
+	std::atomic<bool> waitingForSpace;
+
+	void decode();
+
+	static inline signed int scale(mad_fixed_t sample);
+	static mad_flow ms_input(void* user, mad_stream* stream);
+	static mad_flow ms_output(void* user, mad_header const* header, mad_pcm* pcm);
+	static mad_flow ms_error(void* user, mad_stream* stream, mad_frame* frame);
+};
+
+#endif
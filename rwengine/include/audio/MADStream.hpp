@@ -1,51 +1,41 @@
 #pragma once
 #ifndef _MADSTREAM_HPP_
 #define _MADSTREAM_HPP_
-#include <mad.h>
-#include <stdio.h>
-#include <unistd.h>
-#include <sys/stat.h>
-#include <sys/mman.h>
-#include <fcntl.h>
 #include <stdint.h>
 #include <iostream>
 #include <rw/defines.hpp>
 #include <AL/al.h>
 #include <AL/alc.h>
 #include "audio/alCheck.hpp"
+#include "audio/MADDecoder.hpp"
 
 
 #include <vector>
 
+/**
+ * @brief Plays an MP3 through its own OpenAL source as it's decoded
+ *
+ * The file is decoded on a separate thread by a MADDecoder. update() has
+ * to be called regularly to move the decoded samples into OpenAL buffers,
+ * every stream has its own source so any number can play at once.
+ */
 class MADStream
 {
-	mad_decoder mDecoder;
-	unsigned int mMadSampleRate;
-	unsigned int mMadChannels;
-	unsigned char* mFdm;
-	struct stat mStat;
-	unsigned int mReadProgress;
+	MADDecoder mDecoder;
 	std::vector<int16_t> mCurrentSamples;
 
 	/**
-	 * The number of OpenAL buffers is arbitrary, but due to the kind of small
-	 * buffer/audio sample size, we need a bunch of them so the computer can
-	 * keep up with filling them.
+	 * The number of OpenAL buffers is arbitrary, there need to be enough
+	 * queued to cover the time between calls to update().
 	 */
-	constexpr static size_t numALbuffers = 8;
+	constexpr static size_t numALbuffers = 4;
+	/// Samples in each buffer, 4096 stereo frames
+	constexpr static size_t bufferSamples = 4096 * 2;
 	ALuint buffers[numALbuffers];
-	ALuint unqueuedBuffers[numALbuffers];
-	size_t numFreeBuffers = numALbuffers;
-	size_t currentBuffer = 0;
+	std::vector<ALuint> freeBuffers;
 	ALuint alSource;
 
-	bool stopped = false;
-
-	static inline signed int scale(mad_fixed_t sample);
-	static mad_flow ms_header(void* user, mad_header const* header);
-	static mad_flow ms_input(void* user, mad_stream* stream);
-	static mad_flow ms_output(void* user, mad_header const* header, mad_pcm* pcm);
-	static mad_flow ms_error(void* user, mad_stream* stream, mad_frame* frame);
+	bool playing = false;
 
 public:
 
@@ -55,6 +45,13 @@ public:
 	bool openFromFile(const std::string& loc);
 	void play();
 	void stop();
+
+	/**
+	 * Refills the buffers OpenAL has finished playing
+	 */
+	void update();
+
+	bool isPlaying() const { return playing; }
 };
 
 #endif
@@ -0,0 +1,110 @@
+#pragma once
+#ifndef _RWENGINE_PCMRINGBUFFER_HPP_
+#define _RWENGINE_PCMRINGBUFFER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Fixed size queue of PCM samples between one writer and one reader
+ *
+ * The writer and reader may be on different threads without locking: only
+ * the writer moves the write position and only the reader moves the read
+ * position. The positions count samples since the buffer was created, so
+ * a full buffer can be told apart from an empty one.
+ */
+class PCMRingBuffer
+{
+public:
+	/**
+	 * @param capacity Number of samples, rounded up to a power of two
+	 */
+	PCMRingBuffer(size_t capacity)
+		: readPosition(0)
+		, writePosition(0)
+	{
+		size_t size = 1;
+		while( size < capacity ) {
+			size <<= 1;
+		}
+		samples.resize(size);
+		mask = size - 1;
+	}
+
+	size_t capacity() const { return samples.size(); }
+
+	/**
+	 * Returns the number of samples that can be read
+	 */
+	size_t available() const
+	{
+		return writePosition.load(std::memory_order_acquire)
+				- readPosition.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * Returns the number of samples that can be written
+	 */
+	size_t space() const
+	{
+		return capacity() - available();
+	}
+
+	/**
+	 * Writes up to count samples, returns how many were written.
+	 * Only call from the writing thread.
+	 */
+	size_t write(const int16_t* data, size_t count)
+	{
+		size_t write = writePosition.load(std::memory_order_relaxed);
+		size_t read = readPosition.load(std::memory_order_acquire);
+		count = std::min(count, capacity() - (write - read));
+
+		size_t start = write & mask;
+		size_t first = std::min(count, capacity() - start);
+		std::memcpy(&samples[start], data, first * sizeof(int16_t));
+		std::memcpy(&samples[0], data + first, (count - first) * sizeof(int16_t));
+
+		writePosition.store(write + count, std::memory_order_release);
+		return count;
+	}
+
+	/**
+	 * Reads up to count samples, returns how many were read.
+	 * Only call from the reading thread.
+	 */
+	size_t read(int16_t* data, size_t count)
+	{
+		size_t read = readPosition.load(std::memory_order_relaxed);
+		size_t write = writePosition.load(std::memory_order_acquire);
+		count = std::min(count, write - read);
+
+		size_t start = read & mask;
+		size_t first = std::min(count, capacity() - start);
+		std::memcpy(data, &samples[start], first * sizeof(int16_t));
+		std::memcpy(data + first, &samples[0], (count - first) * sizeof(int16_t));
+
+		readPosition.store(read + count, std::memory_order_release);
+		return count;
+	}
+
+	/**
+	 * Discards everything in the buffer. Neither thread may be using it.
+	 */
+	void clear()
+	{
+		readPosition.store(0);
+		writePosition.store(0);
+	}
+
+private:
+	std::vector<int16_t> samples;
+	size_t mask;
+	std::atomic<size_t> readPosition;
+	std::atomic<size_t> writePosition;
+};
+
+#endif
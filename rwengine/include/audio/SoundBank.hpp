@@ -0,0 +1,49 @@
+#pragma once
+#ifndef _RWENGINE_SOUNDBANK_HPP_
+#define _RWENGINE_SOUNDBANK_HPP_
+
+#include <cstddef>
+#include <vector>
+
+class AudioDevice;
+class LoaderSDT;
+
+/**
+ * @brief Audio buffers for the effects in an SDT archive
+ *
+ * Each effect is uploaded the first time it's asked for, straight from the
+ * archive's mapped sample data, and kept until the bank is destroyed.
+ */
+class SoundBank
+{
+public:
+	SoundBank(const LoaderSDT* archive, AudioDevice* device);
+	~SoundBank();
+
+	SoundBank(const SoundBank&) = delete;
+	SoundBank& operator=(const SoundBank&) = delete;
+
+	/**
+	 * Returns the buffer for an effect, uploading it if needed.
+	 * Returns 0 if the effect doesn't exist.
+	 */
+	unsigned int getBuffer(size_t index);
+
+	/// Number of effects in the archive
+	size_t getSoundCount() const { return buffers.size(); }
+
+	/// Number of effects that have been uploaded
+	size_t getLoadedCount() const { return loadedCount; }
+
+	/// Bytes of sample data that have been uploaded
+	size_t getLoadedBytes() const { return loadedBytes; }
+
+private:
+	const LoaderSDT* archive;
+	AudioDevice* device;
+	std::vector<unsigned int> buffers;
+	size_t loadedCount;
+	size_t loadedBytes;
+};
+
+#endif
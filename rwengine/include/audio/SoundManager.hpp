@@ -1,13 +1,19 @@
 #pragma once
 
+#include <audio/AudioDevice.hpp>
+#include <audio/SoundBank.hpp>
+#include <audio/VoicePool.hpp>
+
 #include <sndfile.h>
 #include <AL/al.h>
 #include <AL/alc.h>
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+class LoaderSDT;
 class MADStream;
 
 class SoundManager
@@ -26,6 +32,24 @@ public:
 	bool loadMusic(const std::string& name, const std::string& fileName);
 	void playMusic(const std::string& name);
 	void stopMusic(const std::string& name);
+
+	/**
+	 * Plays sound effects from an SDT archive, which must stay loaded
+	 */
+	void setSoundBank(const LoaderSDT* archive);
+	VoicePool::Handle playEffect(size_t index, const glm::vec3& position, int priority = 0, float gain = 1.f, bool loop = false);
+	void stopEffect(VoicePool::Handle handle);
+	void setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up);
+
+	/// Returns NULL until a sound bank has been set
+	SoundBank* getSoundBank() const { return soundBank.get(); }
+	VoicePool* getVoices() const { return voices.get(); }
+
+	/**
+	 * Feeds the playing music streams and frees finished effect voices,
+	 * call once per frame
+	 */
+	void update();
 	
 	void pause(bool p);
 	
@@ -68,5 +92,9 @@ private:
 
 	std::map<std::string, Sound> sounds;
 	std::map<std::string, MADStream> musics;
+
+	OpenALDevice device;
+	std::unique_ptr<SoundBank> soundBank;
+	std::unique_ptr<VoicePool> voices;
 	std::string backgroundNoise;
 };
@@ -0,0 +1,101 @@
+#pragma once
+#ifndef _RWENGINE_VOICEPOOL_HPP_
+#define _RWENGINE_VOICEPOOL_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class AudioDevice;
+class SoundBank;
+
+/**
+ * @brief Plays positional effects on a fixed number of sources
+ *
+ * When every voice is busy a new effect takes the voice of the least
+ * important one playing: lower priority first, then the furthest from the
+ * listener. If nothing playing is less important the new effect is
+ * dropped, as are effects too far away to be heard at all.
+ */
+class VoicePool
+{
+public:
+	/**
+	 * Refers to one effect played by the pool. Handles of effects that
+	 * have finished or lost their voice are simply ignored.
+	 */
+	struct Handle
+	{
+		uint32_t voice;
+		/// 0 for a handle that refers to nothing
+		uint32_t generation;
+
+		bool isValid() const { return generation != 0; }
+	};
+
+	struct Stats
+	{
+		size_t played = 0;
+		/// Effects that took the voice of another
+		size_t stolen = 0;
+		/// Effects that were out of range or too unimportant to play
+		size_t dropped = 0;
+	};
+
+	/**
+	 * @param voiceCount Number of sources to create
+	 * @param maxDistance Effects further than this from the listener aren't played
+	 */
+	VoicePool(AudioDevice* device, SoundBank* bank, size_t voiceCount = 32, float maxDistance = 100.f);
+	~VoicePool();
+
+	VoicePool(const VoicePool&) = delete;
+	VoicePool& operator=(const VoicePool&) = delete;
+
+	/**
+	 * Starts playing an effect from the bank
+	 * @param priority Higher priority effects can take voices from lower
+	 * @return A handle to the effect, invalid if it wasn't played
+	 */
+	Handle play(size_t sound, const glm::vec3& position, int priority = 0, float gain = 1.f, bool loop = false);
+
+	void stop(Handle handle);
+	bool isPlaying(Handle handle) const;
+	void setPosition(Handle handle, const glm::vec3& position);
+
+	void setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up);
+
+	/**
+	 * Frees the voices of effects that have finished, call once per frame
+	 */
+	void update();
+
+	size_t getVoiceCount() const { return voices.size(); }
+	size_t getActiveCount() const { return voices.size() - freeVoices.size(); }
+	const Stats& getStats() const { return stats; }
+
+private:
+	struct Voice
+	{
+		unsigned int source;
+		uint32_t generation;
+		bool active;
+		int priority;
+		glm::vec3 position;
+	};
+
+	AudioDevice* device;
+	SoundBank* bank;
+	float maxDistance;
+	glm::vec3 listener;
+
+	std::vector<Voice> voices;
+	std::vector<uint32_t> freeVoices;
+	Stats stats;
+
+	Voice* getVoice(Handle handle);
+	void release(uint32_t voice);
+};
+
+#endif
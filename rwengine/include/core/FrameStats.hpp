@@ -0,0 +1,111 @@
+#ifndef _RWENGINE_FRAMESTATS_HPP_
+#define _RWENGINE_FRAMESTATS_HPP_
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace perf
+{
+
+/**
+ * Parts of a frame that are timed separately
+ */
+enum FramePhase
+{
+	/// The whole frame, including presenting it
+	PhaseFrame,
+	/// Game and world update, including physics and script
+	PhaseTick,
+	PhasePhysics,
+	PhaseScript,
+	/// Culling, animating and building the world render list
+	PhaseBuild,
+	PhaseSort,
+	PhaseDraw,
+	FramePhaseCount
+};
+
+/**
+ * Milliseconds spent in each phase of a frame
+ */
+struct FrameTimes
+{
+	std::array<double, FramePhaseCount> phases;
+
+	FrameTimes() { phases.fill(0.0); }
+
+	double& operator[](FramePhase phase) { return phases[phase]; }
+	double operator[](FramePhase phase) const { return phases[phase]; }
+};
+
+/**
+ * Measures the time from construction until stop() is called
+ */
+class PhaseTimer
+{
+	std::chrono::steady_clock::time_point start;
+public:
+	PhaseTimer() : start(std::chrono::steady_clock::now()) { }
+
+	/**
+	 * Returns the milliseconds since the timer started
+	 */
+	double stop() const
+	{
+		return std::chrono::duration<double, std::milli>(
+					std::chrono::steady_clock::now() - start).count();
+	}
+};
+
+/**
+ * Stores the times of every frame in a run, and summarises them
+ * for benchmark reports
+ */
+class FrameStats
+{
+public:
+
+	struct Summary
+	{
+		double mean;
+		double p50;
+		double p95;
+		double p99;
+		double max;
+	};
+
+	static const char* getPhaseName(FramePhase phase);
+
+	void addFrame(const FrameTimes& times) { frames.push_back(times); }
+
+	const std::vector<FrameTimes>& getFrames() const { return frames; }
+
+	size_t getFrameCount() const { return frames.size(); }
+
+	void clear() { frames.clear(); }
+
+	/**
+	 * Returns the mean, percentiles and maximum of a phase over every
+	 * frame, all zero if there are no frames
+	 */
+	Summary summarise(FramePhase phase) const;
+
+	/**
+	 * Writes one line per frame, with a column for each phase
+	 */
+	bool writeCSV(const std::string& path) const;
+
+	/**
+	 * Writes the summary of each phase followed by every frame's times
+	 * @param name Identifies the run in the output
+	 */
+	bool writeJSON(const std::string& path, const std::string& name) const;
+
+private:
+	std::vector<FrameTimes> frames;
+};
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include <glm/glm.hpp>
 
 #include <data/PathData.hpp>
+#include <data/StringTable.hpp>
 
 typedef uint16_t ObjectID;
 
@@ -41,10 +42,15 @@ struct ObjectData : public ObjectInformation
 	static const ObjectClass class_id;
 
 	ObjectData()
-		: ObjectInformation(_class("OBJS")) { }
+		: ObjectInformation(_class("OBJS"))
+		, modelID(StringTable::Empty), lodModelID(StringTable::Empty) { }
 
 	std::string modelName;
 	std::string textureName;
+	/// The lower case model name, as the model is loaded under
+	StringID modelID;
+	/// The lower case name of the LOD model that stands in for this one
+	StringID lodModelID;
 	uint8_t numClumps;
 	float drawDistance[3];
 	int32_t flags;
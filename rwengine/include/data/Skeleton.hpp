@@ -3,6 +3,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -12,6 +13,9 @@ class ModelFrame;
  * 
  * Provides interfaces to modify and query the visibility of model frames,
  * as well as their transformation. Modified by Animator to animate models.
+ *
+ * The data is stored in arrays indexed by frame number, frames that haven't
+ * been given any data use IdentityData.
  */
 class Skeleton
 {
@@ -51,13 +55,27 @@ public:
 	
 	glm::mat4 getMatrix(unsigned int frameIdx) const;
 	glm::mat4 getMatrix(ModelFrame* frame) const;
+
+	/**
+	 * Returns the frame's matrix from the latest animation step, gameplay
+	 * uses this so the result doesn't depend on what has been rendered
+	 */
+	glm::mat4 getCurrentMatrix(unsigned int frameIdx) const;
 	
 	void interpolate(float alpha);
 	
 private:
 	
-	FramesData framedata;
-	TransformData interpolateddata;
+	std::vector<FrameData> framedata;
+	/// Non-zero for frames that have been given data
+	std::vector<uint8_t> hasData;
+
+	std::vector<FrameTransform> interpolateddata;
+	/// Non-zero for frames that had data when last interpolated
+	std::vector<uint8_t> hasInterpolated;
+
+	/// Returns the data for a frame, adding it if necessary
+	FrameData& addFrame(unsigned int frameIdx, const FrameData& initial);
 	
 };
 
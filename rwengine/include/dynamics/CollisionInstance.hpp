@@ -3,24 +3,26 @@
 #define _COLLISIONINSTANCE_HPP_
 
 #include <bullet/btBulletDynamicsCommon.h>
-#include <vector>
+#include <memory>
 #include <string>
 
 class GameObject;
+struct CollisionShape;
 struct DynamicObjectData;
 struct VehicleHandlingInfo;
 
 /**
  * @brief Utility object for managing bullet objects.
  *
- * Stores handles to a btRigidBody and a set of collision shapes
+ * Stores handles to a btRigidBody and the collision shape of its model,
+ * which is shared with every other instance of the model.
  */
 class CollisionInstance
 {
 public:
 
 	CollisionInstance()
-		: body(nullptr), vertArray(nullptr), motionState(nullptr), collisionHeight(0.f)
+		: body(nullptr), motionState(nullptr), collisionHeight(0.f)
 	{ }
 
 	~CollisionInstance();
@@ -31,8 +33,7 @@ public:
 						   VehicleHandlingInfo* handling = nullptr);
 
 	btRigidBody* body;
-	std::vector<btCollisionShape*> shapes;
-	btTriangleIndexVertexArray* vertArray;
+	std::shared_ptr<CollisionShape> shape;
 	btMotionState* motionState;
 
 	float collisionHeight;
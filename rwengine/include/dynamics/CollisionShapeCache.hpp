@@ -0,0 +1,138 @@
+#pragma once
+#ifndef _RWENGINE_COLLISIONSHAPECACHE_HPP_
+#define _RWENGINE_COLLISIONSHAPECACHE_HPP_
+
+#include <bullet/btBulletDynamicsCommon.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct CollisionModel;
+
+/**
+ * @brief Bullet shapes built from a collision model
+ *
+ * The shapes don't depend on where they are placed, so one is shared by
+ * every body using the model.
+ */
+struct CollisionShape
+{
+	btCompoundShape* compound;
+	/// Boxes, spheres and the mesh, in the compound
+	std::vector<btCollisionShape*> children;
+	btTriangleIndexVertexArray* vertArray;
+	btBvhTriangleMeshShape* mesh;
+	/// Memory holding a BVH read from the cache, the mesh doesn't own it
+	void* bvhBuffer;
+	btOptimizedBvh* loadedBvh;
+	/// Hash of the collision model's mesh, that the BVH was built from
+	uint64_t meshHash;
+	/// Distance from the lowest to the highest point of the shapes
+	float height;
+
+	CollisionShape();
+	~CollisionShape();
+
+	CollisionShape(const CollisionShape&) = delete;
+	CollisionShape& operator=(const CollisionShape&) = delete;
+};
+
+/**
+ * @brief Builds each model's collision shape once, and shares it
+ *
+ * A shape is deleted when the last object using it lets go of it.
+ *
+ * Building the BVH of a mesh is the most expensive part of a shape, so
+ * BVHs are kept after their shape is deleted and used when it's built
+ * again. They can be written to a cache file and read back the next time
+ * the game starts.
+ */
+class CollisionShapeCache
+{
+public:
+
+	/**
+	 * @param models The collision models to build shapes from. Shapes point
+	 * at the models' vertex data, so must not outlive them.
+	 */
+	CollisionShapeCache(const std::map<std::string, std::unique_ptr<CollisionModel>>& models);
+
+	/**
+	 * Returns the shape for a model, building it if it isn't cached
+	 * @return nullptr if there's no collision model with the name
+	 */
+	std::shared_ptr<CollisionShape> get(const std::string& modelName);
+
+	/**
+	 * Returns true if the shape for a model is in use
+	 */
+	bool hasShape(const std::string& modelName) const;
+
+	/**
+	 * Returns the number of shapes in use
+	 */
+	size_t size() const { return entries->shapes.size(); }
+
+	/**
+	 * Returns the number of mesh BVHs built since the cache was created,
+	 * rather than read from the cache file
+	 */
+	size_t getBuiltBvhCount() const { return builtBvhs; }
+
+	/**
+	 * Reads BVHs written by saveCache. They are used when building the
+	 * shapes for the same meshes.
+	 *
+	 * Returns false if the cache file is missing or invalid.
+	 */
+	bool loadCache(const std::string& path);
+
+	/**
+	 * Writes the BVHs of the shapes in use, the BVHs of deleted shapes and
+	 * the ones read by loadCache to a cache file
+	 */
+	bool saveCache(const std::string& path) const;
+
+private:
+	/// A serialised BVH, and the mesh it was built from
+	struct CachedBvh
+	{
+		uint64_t meshHash;
+		std::string data;
+	};
+
+	/**
+	 * Shared with the shapes' deleters, so a shape can be deleted after
+	 * the cache without touching it
+	 */
+	struct Entries
+	{
+		std::unordered_map<std::string, std::weak_ptr<CollisionShape>> shapes;
+
+		/// BVHs read by loadCache or kept from deleted shapes
+		std::unordered_map<std::string, CachedBvh> bvhs;
+
+		/// Forgets a shape that's being deleted, keeping its BVH
+		void release(const std::string& modelName, const CollisionShape& shape);
+	};
+
+	const std::map<std::string, std::unique_ptr<CollisionModel>>& models;
+
+	std::shared_ptr<Entries> entries;
+
+	size_t builtBvhs;
+
+	std::shared_ptr<CollisionShape> build(const std::string& modelName, const CollisionModel& model);
+
+	/// Sets up the mesh with its BVH from the cache, returns false if it can't
+	bool useCachedBvh(const std::string& modelName, uint64_t meshHash, CollisionShape& shape);
+
+	static uint64_t hashMesh(const CollisionModel& model);
+
+	static bool serialiseBvh(btOptimizedBvh* bvh, std::string& out);
+};
+
+#endif
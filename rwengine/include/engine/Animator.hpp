@@ -2,6 +2,10 @@
 #ifndef _ANIMATOR_HPP_
 #define _ANIMATOR_HPP_
 #include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -13,6 +17,40 @@ class ModelFrame;
 
 class Skeleton;
 
+/**
+ * @brief Finds the bones of an animation that move each of a model's
+ * frames, once per model and animation
+ *
+ * Every Animator of a model shares the bindings. They're guarded by a
+ * mutex, since animators tick in parallel.
+ */
+class AnimationBindingCache
+{
+public:
+	/**
+	 * The bone that moves each of the model's frames, in frame order.
+	 * Frames the animation doesn't move are left out.
+	 */
+	typedef std::vector<std::pair<AnimationBone*, unsigned int>> Binding;
+
+	/**
+	 * Returns the binding of an animation to a model, finding it by frame
+	 * name the first time. The binding is kept until the model is removed.
+	 */
+	const Binding& get(const Model* model, const Animation* animation);
+
+	/**
+	 * Forgets a model's bindings, call it before deleting the model
+	 */
+	void removeModel(const Model* model);
+
+	size_t getBindingCount(const Model* model) const;
+
+private:
+	mutable std::mutex mutex;
+	std::unordered_map<const Model*, std::map<const Animation*, Binding>> bindings;
+};
+
 /**
  * @brief calculates animation frame matrices, as well as procedural frame
  * animation.
@@ -21,18 +59,11 @@ class Skeleton;
  * the animation to the animator. This sets the configuration to use for the
  * animation, such as it's speed and time.
  *
- * The Animator will blend all active animations together.
+ * The Animator will blend all active animations together, each slot is
+ * blended over the slots before it by its weight.
  */
 class Animator
 {
-	/**
-	 * @brief Stores data required to animate a model frame
-	 */
-	struct BoneInstanceData
-	{
-		unsigned int frameIndex;
-	};
-
 	/**
 	 * @brief The AnimationState struct stores information about playing animations
 	 */
@@ -45,7 +76,22 @@ class Animator
 		float speed;
 		/// Automatically restart
 		bool repeat;
-		std::map<AnimationBone*, BoneInstanceData> boneInstances;
+		/// How much the animation replaces the slots before it, from 0 to 1
+		float weight;
+		/// Found the first time the animation is ticked, shared by the model
+		const AnimationBindingCache::Binding* bones;
+		/// Parallel to bones
+		std::vector<size_t> cursors;
+	};
+
+	/**
+	 * @brief Frame transforms, kept in separate arrays so blending works
+	 * through contiguous values
+	 */
+	struct Pose
+	{
+		std::vector<glm::vec3> translations;
+		std::vector<glm::quat> rotations;
 	};
 
 	/**
@@ -58,14 +104,41 @@ class Animator
 	 */
 	Skeleton* skeleton;
 
+	/**
+	 * @brief Where the model's bindings are kept, ownBindings if no cache
+	 * was given
+	 */
+	AnimationBindingCache* bindings;
+	std::unique_ptr<AnimationBindingCache> ownBindings;
+
 	/**
 	 * @brief Currently playing animations
 	 */
 	std::vector<AnimationState> animations;
 
+	/**
+	 * @brief Blended transform of each model frame
+	 */
+	Pose pose;
+	/// Non-zero for frames an animation has moved this tick
+	std::vector<uint8_t> animated;
+
+	/**
+	 * @brief Transforms of one animation, parallel to its bones
+	 */
+	Pose samples;
+
+	void bindBones(AnimationState& state);
+	void sampleBones(AnimationState& state, float time);
+	void blendBones(const AnimationState& state);
+
 public:
 
-	Animator(Model* model, Skeleton* skeleton);
+	/**
+	 * @param bindings Shared with other animators, usually GameData's. The
+	 * animator keeps its own if it's null.
+	 */
+	Animator(Model* model, Skeleton* skeleton, AnimationBindingCache* bindings = nullptr);
 
 	Animation* getAnimation(unsigned int slot)
 	{
@@ -82,7 +155,19 @@ public:
 		{
 			animations.resize(slot+1);
 		}
-		animations[slot] = { anim, 0.f, speed, repeat, {} };
+		animations[slot] = { anim, 0.f, speed, repeat, 1.f, nullptr, {} };
+	}
+
+	/**
+	 * Sets how much the animation in the slot replaces the slots before it
+	 */
+	void setAnimationWeight(unsigned int slot, float weight)
+	{
+		RW_CHECK(slot < animations.size(), "Slot out of range");
+		if (slot < animations.size())
+		{
+			animations[slot].weight = weight;
+		}
 	}
 
 	void setAnimationSpeed(unsigned int slot, float speed)
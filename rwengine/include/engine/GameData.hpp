@@ -10,17 +10,23 @@ class Logger;
 #include <loaders/LoaderDFF.hpp>
 #include <loaders/LoaderIDE.hpp>
 #include <loaders/LoaderIFP.hpp>
+#include <loaders/LoaderSDT.hpp>
 #include <loaders/WeatherLoader.hpp>
+#include <loaders/WorldCache.hpp>
 #include <objects/VehicleInfo.hpp>
 #include <data/CollisionModel.hpp>
+#include <dynamics/CollisionShapeCache.hpp>
+#include <engine/Animator.hpp>
 #include <data/GameTexts.hpp>
 #include <data/ZoneData.hpp>
 
 #include <audio/MADStream.hpp>
 #include <gl/TextureData.hpp>
+#include <gl/TextureUploadQueue.hpp>
 #include <platform/FileIndex.hpp>
 
 #include <memory>
+#include <unordered_map>
 
 struct DynamicObjectData;
 struct WeaponData;
@@ -45,6 +51,18 @@ private:
 	
 	Logger* logger;
 	WorkContext* workContext;
+
+	/// WorldCache::hashObjects of objectTypes, kept until another IDE loads
+	uint64_t objectTypesHash;
+	bool objectTypesHashed;
+
+	uint64_t getObjectTypesHash();
+
+	/**
+	 * Returns the file in worldCachePath for an IPL, named after its path
+	 * relative to the data directory
+	 */
+	std::string getWorldCachePath(const std::string& path) const;
 public:
 
 	/**
@@ -98,6 +116,14 @@ public:
 	 * Loads the Zones from a zon/IPL file
 	 */
 	bool loadZone(const std::string& path);
+
+	/**
+	 * Reads an IPL file into a WorldCache. The binary copy in
+	 * worldCachePath is used if it's up to date, otherwise the text is
+	 * parsed and the copy is written.
+	 * @return false if the IPL file can't be read
+	 */
+	bool loadWorldCache(const std::string& path, WorldCache& cache);
 		
 	void loadCarcols(const std::string& path);
 
@@ -119,8 +145,10 @@ public:
 	
 	/**
 	 * Loads a GTA3.dat file with the name path
+	 * @param locationsOnly Only record the IDE and IPL files, without
+	 * loading the collisions and textures it lists
 	 */
-	void parseDAT(const std::string& path);
+	void parseDAT(const std::string& path, bool locationsOnly = false);
 	
 	/**
 	 * Attempts to load a TXD, or does nothing if it has already been loaded
@@ -150,13 +178,23 @@ public:
 	bool loadAudioStream(const std::string& name);
 	bool loadAudioClip(const std::string& name, const std::string& fileName);
 
+	/**
+	 * Loads the sound effect archive, sfx.sdt and sfx.raw
+	 */
+	bool loadSoundEffects();
+
 	void loadSplash(const std::string& name);
 
 	FileHandle openFile(const std::string& name);
 
 	TextureData::Handle findTexture( const std::string& name, const std::string& alpha = "" )
 	{
-		return textures[{name, alpha}];
+		return textures[textureKey(name, alpha)];
+	}
+
+	TextureData::Handle findTexture( TextureKey key )
+	{
+		return textures[key];
 	}
 	
 	FileIndex index;
@@ -172,6 +210,12 @@ public:
 	std::map<std::string, std::string> iplLocations;
 	std::map<std::string, std::string> ideLocations;
 
+	/**
+	 * Directory to keep the binary copies of IPL files in, nothing is
+	 * cached if it's empty
+	 */
+	std::string worldCachePath;
+
 	/**
 	 * Map of loaded archives
 	 */
@@ -187,7 +231,22 @@ public:
 	 */
 	std::map<ObjectID, ObjectInformationPtr> objectTypes;
 
-	uint16_t findModelObject(const std::string model);
+	/**
+	 * The OBJS definitions in objectTypes by their ObjectData::modelID
+	 */
+	std::unordered_map<StringID, ObjectID> modelObjects;
+
+	/**
+	 * Finds the ID of the object definition for a model, ignoring case
+	 * @return The ID, or -1 if there isn't one
+	 */
+	int findModelObject(const std::string model);
+
+	/**
+	 * Interns a model name in lowercase, the form models and
+	 * modelObjects are keyed by
+	 */
+	static StringID modelID(const std::string& name);
 
 	template<class T> std::shared_ptr<T> findObjectType(ObjectID id)
 	{
@@ -227,29 +286,50 @@ public:
 	WeatherLoader weatherLoader;
 
 	/**
-	 * Loaded models
+	 * Loaded models, by the modelID of the name they were loaded as
+	 */
+	std::unordered_map<StringID, ResourceHandle<Model>::Ref> models;
+
+	/**
+	 * Loaded textures, by the key of their name and alpha name
 	 */
-	std::map<std::string, ResourceHandle<Model>::Ref> models;
+	TextureArchive textures;
 
 	/**
-	 * Loaded textures (Textures are ID by name and alpha pairs)
+	 * Textures decoded by asynchronous loadTXD calls, waiting to be uploaded
 	 */
-	std::map<std::pair<std::string, std::string>, TextureData::Handle> textures;
+	TextureUploadQueue textureUploads;
 
 	/**
 	 * Texture atlases.
 	 */
 	std::vector<TextureAtlas*> atlases;
 
+	/**
+	 * Sound effects, the samples stay mapped while the game runs
+	 */
+	LoaderSDT soundEffects;
+
     /**
      * Loaded Animations
      */
     AnimationSet animations;
 
+	/**
+	 * The bones of each animation bound to each model, shared by every
+	 * object's Animator
+	 */
+	AnimationBindingCache animationBindings;
+
 	/**
 	 * CollisionModel data.
 	 */
 	std::map<std::string,  std::unique_ptr<CollisionModel>> collisions;
+
+	/**
+	 * Physics shapes built from the collision models
+	 */
+	CollisionShapeCache collisionShapes;
 	
 	/**
 	 * DynamicObjectData 
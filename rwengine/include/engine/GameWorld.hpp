@@ -10,10 +10,12 @@ class GameState;
 
 #include <ai/AIGraphNode.hpp>
 #include <ai/AIGraph.hpp>
+#include <ai/RoutePlanner.hpp>
 #include <audio/SoundManager.hpp>
 
 class CutsceneObject;
 class WorkContext;
+class StreamingManager;
 #include <objects/ObjectTypes.hpp>
 
 class GameObject;
@@ -23,6 +25,9 @@ class VehicleObject;
 class PickupObject;
 
 #include <render/VisualFX.hpp>
+#include <engine/SpatialIndex.hpp>
+#include <engine/WorldQuery.hpp>
+#include <engine/ObjectPool.hpp>
 #include <data/ObjectData.hpp>
 
 struct BlipData;
@@ -38,6 +43,7 @@ struct WeaponScan;
 
 #include <vector>
 #include <set>
+#include <unordered_map>
 #include <random>
 #include <array>
 
@@ -115,6 +121,14 @@ public:
 	 */
 	void destroyObject(GameObject* object);
 
+	/**
+	 * Updates every object: first tickParallel for all of them across the
+	 * work context, then tick for each object in turn, then tickAnimation
+	 * for all of them across the work context. Objects created during the
+	 * update are first updated on the next call.
+	 */
+	void tickObjects(float dt);
+
 	/**
 	 * @brief Put an object on the deletion queue.
 	 */
@@ -122,6 +136,8 @@ public:
 
 	/**
 	 * @brief Destroys all objects on the destruction queue.
+	 *
+	 * Collision shapes no longer used by any object are then released.
 	 */
 	void destroyQueuedObjects();
 
@@ -181,36 +197,14 @@ public:
 	 */
 	ChaseCoordinator chase;
 
-	/**
-	 * Each object type is allocated from a pool. This object helps manage
-	 * the individual pools.
-	 */
-	struct ObjectPool
-	{
-		std::map<GameObjectID, GameObject*> objects;
-		
-		/**
-		 * Allocates the game object a GameObjectID and inserts it into
-		 * the pool
-		 */
-		void insert(GameObject* object);
-
-		/**
-		 * Removes a game object from this pool
-		 */
-		void remove(GameObject* object);
-
-		/**
-		 * Finds a game object if it exists in this pool
-		 */
-		GameObject* find(GameObjectID id) const;
-	};
-
 	/**
 	 * Stores all game objects
 	 */
 	std::vector<GameObject*> allObjects;
 
+	/**
+	 * Each object type has its own pool of GameObjectIDs
+	 */
 	ObjectPool pedestrianPool;
 	ObjectPool instancePool;
 	ObjectPool vehiclePool;
@@ -230,40 +224,80 @@ public:
 	GameObject *getBlipTarget(const BlipData &blip) const;
 
 	/**
-	 * Stores objects within a grid cell, and their maximum
-	 * bounding radius
+	 * Finds objects by location, contains every object except for
+	 * cutscene objects
 	 */
-	struct GridCell
-	{
-		/**
-		 * Static instances within this grid cell
-		 */
-		std::set<GameObject*> instances;
-		float boundingRadius = 0.f;
-	};
-	std::array<GridCell, WORLD_GRID_CELLS> worldGrid;
+	SpatialIndex spatialIndex;
+
+	/**
+	 * Area and nearest object queries on spatialIndex, for scripts and AI
+	 */
+	WorldQuery query;
 
 	/**
-	 * returns true if the given object should be stored
-	 * within the grid
+	 * returns true if the given object won't move, and can be stored
+	 * with the static objects in the spatial index
 	 */
-	bool shouldBeOnGrid(GameObject* object);
-	void addToGrid(GameObject* object);
+	bool isStaticObject(GameObject* object);
 
 	/**
-	 * Returns the grid coordinates for a world coordinates
+	 * Adds an object to the spatial index
 	 */
-	glm::ivec2 worldToGrid(const glm::vec2& world);
+	void addToIndex(GameObject* object);
 
 	/**
-	 * Map of Model Names to Instances
+	 * Updates an indexed object's radius, call after changing its model
 	 */
-	std::map<std::string, InstanceObject*> modelInstances;
+	void updateIndex(GameObject* object);
+
+	/**
+	 * Updates the index radius of objects whose models have loaded since
+	 * they were indexed
+	 */
+	void updateUnloadedModels();
+
+	/**
+	 * Returns the radius around an object's position that contains
+	 * everything rendered for it
+	 */
+	float getIndexRadius(GameObject* object);
+
+	/**
+	 * The first instance of each model, by ObjectData::modelID
+	 */
+	std::unordered_map<StringID, InstanceObject*> modelInstances;
+
+	/**
+	 * Instances whose LOD is in an IPL that hasn't been placed yet
+	 */
+	std::vector<InstanceObject*> unlinkedLODs;
+
+	/**
+	 * Indexed vehicles, characters and other dynamic objects whose model
+	 * hadn't loaded yet, so their radius is only an estimate
+	 */
+	std::vector<GameObject*> unloadedModelObjects;
+
+	/**
+	 * Adds object to unloadedModelObjects if its model hasn't loaded
+	 */
+	void waitForModel(GameObject* object);
+
+	/**
+	 * Loads instance models and textures around the camera. When it's set
+	 * createInstance leaves them for the streaming manager to load.
+	 */
+	StreamingManager* streaming;
 
 	/**
 	 * AI Graph
 	 */
 	AIGraph aigraph;
+
+	/**
+	 * Routes between the nodes of aigraph, for scripts and AI
+	 */
+	RoutePlanner routes;
 	
 	/**
 	 * Visual Effects
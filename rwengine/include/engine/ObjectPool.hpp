@@ -0,0 +1,81 @@
+#pragma once
+#ifndef _RWENGINE_OBJECTPOOL_HPP_
+#define _RWENGINE_OBJECTPOOL_HPP_
+
+#include <objects/ObjectTypes.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class GameObject;
+
+/**
+ * @brief Hands out GameObjectIDs for one type of object and finds objects
+ * by their ID
+ *
+ * IDs come from a slot map: the low bits select a slot and the high bits
+ * count how many times that slot has been reused. A script or save that
+ * keeps an ID after its object is destroyed won't find whatever takes the
+ * slot next. The first ID of each slot is its index plus one, the same
+ * IDs the pool has always given out, so existing saves still load.
+ *
+ * Live objects are kept packed together for iteration, in no particular
+ * order.
+ */
+class ObjectPool
+{
+public:
+	static const unsigned int kSlotBits = 20;
+	static const GameObjectID kSlotMask = (1u << kSlotBits) - 1;
+	/// Generations wrap before the sign bit, script variables are signed
+	static const GameObjectID kGenerationMask = (1u << (31 - kSlotBits)) - 1;
+
+	typedef std::vector<GameObject*>::const_iterator const_iterator;
+
+	/**
+	 * Allocates the game object a GameObjectID and inserts it into
+	 * the pool. An object that already has an ID (e.g. from a save) keeps
+	 * it, replacing any other object with the same ID. An ID with no slot
+	 * bits is invalid and replaced with a new one.
+	 */
+	void insert(GameObject* object);
+
+	/**
+	 * Removes a game object from this pool
+	 */
+	void remove(GameObject* object);
+
+	/**
+	 * Finds a game object if it exists in this pool
+	 */
+	GameObject* find(GameObjectID id) const;
+
+	size_t size() const { return objects.size(); }
+	bool empty() const { return objects.empty(); }
+
+	const_iterator begin() const { return objects.begin(); }
+	const_iterator end() const { return objects.end(); }
+
+private:
+	struct Slot
+	{
+		GameObject* object;
+		GameObjectID generation;
+		/// Index of the object in objects
+		uint32_t dense;
+	};
+
+	std::vector<Slot> slots;
+	/// May hold slots that were since taken by an explicit ID, they're skipped
+	std::vector<uint32_t> freeSlots;
+
+	std::vector<GameObject*> objects;
+	/// The slot of each entry in objects
+	std::vector<uint32_t> objectSlots;
+
+	uint32_t allocateSlot();
+	void removeSlot(uint32_t slot);
+};
+
+#endif
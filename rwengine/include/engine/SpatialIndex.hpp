@@ -0,0 +1,154 @@
+#pragma once
+#ifndef _RWENGINE_SPATIALINDEX_HPP_
+#define _RWENGINE_SPATIALINDEX_HPP_
+#include <render/ViewFrustum.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class GameObject;
+
+/**
+ * @brief Finds the objects in an area of the world
+ *
+ * Objects that don't move are stored in a loose quadtree. Each level
+ * halves the size of the nodes, and every node's bounds are twice its size
+ * so an object only has to fit its radius to be stored at that level.
+ * The nodes are kept in one array, and each node keeps its objects in
+ * one contiguous list.
+ *
+ * Objects that move are kept in a uniform grid, refresh() moves them into
+ * the cells for their current positions.
+ *
+ * Neither structure limits height, objects are only divided on x and y.
+ */
+class SpatialIndex
+{
+public:
+
+	/**
+	 * @param worldSize Width of the square area centered on the origin
+	 * @param depth Number of levels in the static tree
+	 * @param cellSize Width of the cells for dynamic objects
+	 */
+	SpatialIndex(float worldSize, unsigned int depth, float cellSize);
+
+	/**
+	 * Adds an object at its current position
+	 * @param radius Radius around the position containing the object
+	 * @param isStatic true if the object won't move
+	 */
+	void insert(GameObject* object, float radius, bool isStatic);
+
+	/**
+	 * Removes an object, does nothing if it isn't indexed
+	 */
+	void remove(GameObject* object);
+
+	/**
+	 * Re-indexes an object at its current position with a new radius
+	 */
+	void update(GameObject* object, float radius);
+
+	/**
+	 * Moves every dynamic object to the cell for its current position
+	 */
+	void refresh();
+
+	/**
+	 * Appends every object that might intersect the frustum to out
+	 */
+	void queryFrustum(const ViewFrustum& frustum, std::vector<GameObject*>& out) const;
+
+	/**
+	 * Appends every object within radius of center to out
+	 */
+	void queryRadius(const glm::vec3& center, float radius, std::vector<GameObject*>& out) const;
+
+	/**
+	 * Appends every object that might intersect the box to out
+	 */
+	void queryBox(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& out) const;
+
+	bool contains(GameObject* object) const;
+
+	/**
+	 * Returns the number of indexed objects
+	 */
+	size_t size() const { return locations.size(); }
+
+private:
+
+	struct Entry
+	{
+		glm::vec3 center;
+		float radius;
+		GameObject* object;
+	};
+
+	struct Node
+	{
+		std::vector<Entry> entries;
+		/// Number of entries in this node and all of its children
+		uint32_t total = 0;
+		/// Height range of the entries in the node and its children
+		float minZ = 0.f;
+		float maxZ = 0.f;
+	};
+
+	struct Cell
+	{
+		std::vector<Entry> entries;
+	};
+
+	struct Location
+	{
+		bool isStatic;
+		uint32_t bucket;
+		uint32_t index;
+	};
+
+	float worldSize;
+	unsigned int depth;
+	float cellSize;
+	int gridWidth;
+
+	/// Tree nodes ordered by level, then row, then column
+	std::vector<Node> nodes;
+	/// Grid cells, the extra last cell holds objects outside of the grid
+	std::vector<Cell> cells;
+	/// Largest radius of any dynamic object
+	float maxDynamicRadius;
+
+	std::unordered_map<GameObject*, Location> locations;
+
+	struct NodeCoord
+	{
+		unsigned int level;
+		int x;
+		int y;
+	};
+
+	static uint32_t levelOffset(unsigned int level);
+	static uint32_t nodeIndex(const NodeCoord& coord);
+	static NodeCoord nodeCoord(uint32_t index);
+	float nodeSize(unsigned int level) const;
+	NodeCoord nodeForObject(const glm::vec3& center, float radius) const;
+	uint32_t cellForPosition(const glm::vec3& position) const;
+
+	void addStatic(const Entry& entry);
+	void addDynamic(const Entry& entry);
+	void removeFrom(std::vector<Entry>& entries, uint32_t index);
+
+	template<class EntryTest>
+	void queryCells(const glm::vec2& min, const glm::vec2& max, std::vector<GameObject*>& out,
+					const EntryTest& entryTest) const;
+
+	template<class BoundsTest, class EntryTest>
+	void queryTree(const NodeCoord& coord, std::vector<GameObject*>& out,
+				   const BoundsTest& boundsTest, const EntryTest& entryTest) const;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#pragma once
+#ifndef _RWENGINE_STREAMINGMANAGER_HPP_
+#define _RWENGINE_STREAMINGMANAGER_HPP_
+
+#include <data/Model.hpp>
+#include <data/ObjectData.hpp>
+#include <loaders/LoaderTXD.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class GameWorld;
+class GameObject;
+
+/**
+ * @brief Loads the models and textures of the instances near the camera,
+ * and unloads the least recently used ones to stay within a memory budget
+ *
+ * While a world has a streaming manager, createInstance doesn't load the
+ * instance's model or textures. Each update() requests the resources of
+ * the instances within draw distance of the camera, nearest first, and
+ * evicts resources that weren't needed for the longest time while the
+ * resident total is over the budget.
+ *
+ * Only resources the manager loaded itself are evicted, anything loaded
+ * through GameData directly stays resident. A TXD isn't evicted while a
+ * model still holds one of its textures.
+ *
+ * Collision shapes aren't streamed, every instance keeps its physics body.
+ */
+class StreamingManager
+{
+public:
+
+	enum ResourceType
+	{
+		ModelResource,
+		TextureResource,
+		ResourceTypeCount
+	};
+
+	struct Stats
+	{
+		/// Bytes of the resources the manager has loaded, by type
+		size_t residentBytes[ResourceTypeCount];
+		size_t residentCount[ResourceTypeCount];
+		/// Loads started and resources evicted by the last update
+		size_t requested;
+		size_t evicted;
+		/// Loads that haven't finished
+		size_t pending;
+	};
+
+	StreamingManager(GameWorld* world);
+	~StreamingManager();
+
+	void setMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+	size_t getMemoryBudget() const { return memoryBudget; }
+
+	/**
+	 * Sets how far from the camera to look for instances. Instances are
+	 * only streamed in when they're also within their draw distance.
+	 */
+	void setStreamingRadius(float radius) { streamingRadius = radius; }
+
+	/**
+	 * Requests the resources needed around position and evicts the least
+	 * recently used ones if the budget is exceeded
+	 */
+	void update(const glm::vec3& position);
+
+	const Stats& getStats() const { return stats; }
+
+	/**
+	 * Returns the total bytes of every resident resource the manager loaded
+	 */
+	size_t getResidentBytes() const;
+
+	/**
+	 * Takes over a model that was loaded by something else, so it's
+	 * evicted like the ones the manager loads. It counts as needed by the
+	 * last update.
+	 * @param bytes The memory it uses, counted against the budget
+	 * @return false if the model isn't loaded or is already managed
+	 */
+	bool adoptModel(const ModelRef& model, size_t bytes);
+
+	/**
+	 * Takes over a TXD that was loaded by something else, as adoptModel
+	 * @param name The TXD's name, without the extension
+	 * @param textureNames The keys of its textures in the texture archive
+	 */
+	bool adoptTextures(const std::string& name,
+					   const std::vector<TextureArchive::key_type>& textureNames,
+					   size_t bytes);
+
+	static const char* getResourceTypeName(ResourceType type);
+
+private:
+	enum State
+	{
+		Unloaded,
+		Loading,
+		Resident,
+		Failed,
+		/// Loaded by something else, never evicted
+		Pinned
+	};
+
+	struct Resource
+	{
+		ResourceType type;
+		std::string name;
+		State state;
+		size_t bytes;
+		/// The update it was last needed in
+		uint64_t lastUsed;
+
+		ModelRef model;
+
+		/// The textures from a TXD, set by its load job
+		std::vector<TextureArchive::key_type> textureNames;
+	};
+	typedef std::shared_ptr<Resource> ResourceRef;
+
+	class LoadTexturesJob;
+
+	GameWorld* world;
+	size_t memoryBudget;
+	float streamingRadius;
+	uint64_t updateCount;
+	Stats stats;
+
+	/// Where the last scan for nearby instances was made
+	glm::vec3 scanPosition;
+	bool scanned;
+
+	std::unordered_map<ResourceHandle<Model>*, ResourceRef> models;
+	std::unordered_map<std::string, ResourceRef> textures;
+	/// Each object's TXD, so its name isn't built for every instance
+	std::unordered_map<const ObjectData*, ResourceRef> objectTextures;
+	std::vector<ResourceRef> loading;
+
+	/// Reused between updates
+	std::vector<GameObject*> nearbyObjects;
+	std::vector<std::pair<float, ResourceRef>> requests;
+
+	ResourceRef findModel(const ModelRef& model);
+	ResourceRef findTextures(const ObjectData* object);
+	ResourceRef findTextures(const std::string& name);
+
+	/// Makes a pinned resource resident, as if the manager had loaded it
+	bool adopt(Resource& resource, size_t bytes);
+
+	/// Requests the resources of the instances around position
+	void scan(const glm::vec3& position);
+
+	void request(const ResourceRef& resource);
+
+	/// Moves finished loads to resident, returns true if any finished
+	bool pollLoading();
+
+	void evict();
+	bool canEvict(const Resource& resource) const;
+	void unload(Resource& resource);
+
+	static size_t getModelBytes(const Model& model);
+};
+
+#endif
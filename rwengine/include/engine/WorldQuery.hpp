@@ -0,0 +1,109 @@
+#pragma once
+#ifndef _RWENGINE_WORLDQUERY_HPP_
+#define _RWENGINE_WORLDQUERY_HPP_
+
+#include <engine/SpatialIndex.hpp>
+#include <objects/GameObject.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+/**
+ * @brief Finds objects by area for scripts and AI
+ *
+ * Queries test object positions, like the script opcodes they answer.
+ * The SpatialIndex narrows each search down to the objects nearby, so
+ * only objects in the index are found: cutscene objects and projectiles
+ * aren't. Moving objects are found where the index last saw them, plus
+ * their radius.
+ *
+ * Results are gathered in a scratch list, so a WorldQuery must only be
+ * used from one thread.
+ */
+class WorldQuery
+{
+public:
+	/**
+	 * @brief Restricts a query to some types of object, and optionally one model
+	 */
+	struct Filter
+	{
+		/// Bits of (1 << GameObject::Type)
+		uint32_t types;
+		bool anyModel;
+		ObjectID model;
+		/// StringTable::Empty matches any model name
+		StringID modelName;
+
+		/// Matches every object
+		Filter()
+			: types(~0u), anyModel(true), model(0), modelName(StringTable::Empty) { }
+
+		Filter(std::initializer_list<GameObject::Type> typeList)
+			: types(0), anyModel(true), model(0), modelName(StringTable::Empty)
+		{
+			for( auto type : typeList ) {
+				types |= 1u << type;
+			}
+		}
+
+		/// Only matches objects created from the definition with this ID
+		Filter& withModel(ObjectID id)
+		{
+			anyModel = false;
+			model = id;
+			return *this;
+		}
+
+		/**
+		 * Only matches objects whose definition uses this model, see
+		 * GameData::modelID. Several definitions can share a model.
+		 */
+		Filter& withModelID(StringID name)
+		{
+			modelName = name;
+			return *this;
+		}
+
+		bool matches(GameObject* object) const
+		{
+			return (types & (1u << object->type())) != 0
+					&& (anyModel || object->getModelID() == model)
+					&& (modelName == StringTable::Empty || object->getModelName() == modelName);
+		}
+	};
+
+	WorldQuery(const SpatialIndex& index);
+
+	/**
+	 * Appends the objects with positions inside the box to out
+	 */
+	void box(const glm::vec3& min, const glm::vec3& max, const Filter& filter,
+			 std::vector<GameObject*>& out) const;
+
+	/**
+	 * Returns true if any object has its position inside the box
+	 */
+	bool anyInBox(const glm::vec3& min, const glm::vec3& max, const Filter& filter) const;
+
+	/**
+	 * Appends the objects with positions within radius of center to out
+	 */
+	void sphere(const glm::vec3& center, float radius, const Filter& filter,
+				std::vector<GameObject*>& out) const;
+
+	/**
+	 * Appends up to count objects within maxDistance of center to out,
+	 * nearest first
+	 */
+	void nearest(const glm::vec3& center, size_t count, float maxDistance, const Filter& filter,
+				 std::vector<GameObject*>& out) const;
+
+private:
+	const SpatialIndex& index;
+	mutable std::vector<GameObject*> candidates;
+};
+
+#endif
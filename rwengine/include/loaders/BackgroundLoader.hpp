@@ -31,6 +31,11 @@ public:
 			resourceRef->resource = loader.loadFromMemory(data);
 			resourceRef->state = RW::Loaded;
 		}
+
+		if( resourceRef->resource == nullptr )
+		{
+			resourceRef->state = RW::Failed;
+		}
 	}
 private:
 	FileIndex* index;
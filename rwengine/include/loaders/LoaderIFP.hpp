@@ -17,6 +17,24 @@ struct AnimationKeyframe
 	int id;
 };
 
+/**
+ * @brief A unit quaternion stored as four 16-bit fixed point components,
+ * half the size of a glm::quat
+ */
+struct AnimationRotation
+{
+	int16_t x, y, z, w;
+
+	static AnimationRotation pack(const glm::quat& q);
+	glm::quat unpack() const;
+};
+
+/**
+ * @brief The keyframes of one bone, stored as separate tracks
+ *
+ * Only the tracks used by the bone's type are filled: R00 bones have no
+ * positions, and only RTS bones have scales.
+ */
 struct AnimationBone
 {
     std::string name;
@@ -31,10 +49,47 @@ struct AnimationBone
     };
 
     Data type;
-    std::vector<AnimationKeyframe> frames;
 
-    AnimationKeyframe getInterpolatedKeyframe(float time);
-	AnimationKeyframe getKeyframe(float time);
+	/// Keyframe start times, in order
+	std::vector<float> times;
+	std::vector<AnimationRotation> rotations;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> scales;
+
+	/**
+	 * Appends a keyframe, keeping the tracks the bone's type uses
+	 */
+	void addKeyframe(const AnimationKeyframe& keyframe);
+
+	size_t getKeyframeCount() const { return times.size(); }
+
+	AnimationKeyframe getKeyframe(size_t index) const;
+
+    AnimationKeyframe getInterpolatedKeyframe(float time) const;
+
+	/**
+	 * Interpolates the keyframes around time, starting the search from
+	 * cursor. Start the cursor at 0; it's left at the keyframe that was
+	 * found, so playing forwards only steps past the keyframes in between.
+	 */
+	AnimationKeyframe getInterpolatedKeyframe(float time, size_t& cursor) const;
+
+	/**
+	 * Interpolates only the rotation and position, which is all the
+	 * Animator needs. R00 bones give a zero position.
+	 */
+	void interpolate(float time, size_t& cursor, glm::quat& rotation, glm::vec3& position) const;
+
+	/**
+	 * Returns the index of the first keyframe at or after time, or the
+	 * number of keyframes if they all start before it
+	 */
+	size_t findKeyframe(float time, size_t& cursor) const;
+
+	/**
+	 * Returns the bytes used by the keyframe tracks
+	 */
+	size_t getMemoryUsage() const;
 };
 
 /**
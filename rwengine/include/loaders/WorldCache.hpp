@@ -0,0 +1,82 @@
+#pragma once
+#ifndef _RWENGINE_WORLDCACHE_HPP_
+#define _RWENGINE_WORLDCACHE_HPP_
+
+#include <data/ObjectData.hpp>
+#include <data/ZoneData.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class LoaderIPL;
+
+/**
+ * @brief Binary copy of an IPL file, with the instances' LODs resolved
+ *
+ * Parsing the text IPLs and matching every instance to its LOD by model
+ * name is slow, so the result is written to a cache file once and read
+ * back as a block the next time. The cache stores checksums of the text
+ * file and of the object definitions it was built against, and is only
+ * used while both still match.
+ */
+class WorldCache
+{
+public:
+
+	/// The instance has no LOD
+	static const int32_t NoLOD = -1;
+	/// The instance's LOD isn't in the same file, it's found by name
+	static const int32_t ExternalLOD = -2;
+
+	struct Instance
+	{
+		glm::vec3 position;
+		glm::quat rotation;
+		/// Index of the LOD instance in the same file, or NoLOD / ExternalLOD
+		int32_t lod;
+		uint32_t id;
+	};
+
+	/// Checksum of the IPL text
+	uint64_t sourceHash;
+	/// Checksum of the object definitions, see hashObjects
+	uint64_t objectHash;
+
+	std::vector<Instance> instances;
+	std::vector<ZoneData> zones;
+
+	WorldCache();
+
+	/**
+	 * Builds the cache from a parsed IPL file
+	 * @param sourceHash The checksum of the file, from hashFile
+	 * @param objectHash The checksum of objects, from hashObjects
+	 * @param objects The object definitions to resolve LODs with
+	 */
+	static WorldCache build(const LoaderIPL& ipl, uint64_t sourceHash, uint64_t objectHash,
+							const std::map<ObjectID, ObjectInformationPtr>& objects);
+
+	/**
+	 * Reads a cache file, returns false if it's missing or invalid
+	 */
+	bool load(const std::string& path);
+
+	bool save(const std::string& path) const;
+
+	/**
+	 * Calculates the checksum of a file's contents
+	 * @return false if the file can't be read
+	 */
+	static bool hashFile(const std::string& path, uint64_t& hash);
+
+	/**
+	 * Calculates the checksum of the parts of the object definitions that
+	 * a cache depends on
+	 */
+	static uint64_t hashObjects(const std::map<ObjectID, ObjectInformationPtr>& objects);
+};
+
+#endif
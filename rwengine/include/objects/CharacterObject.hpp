@@ -141,8 +141,14 @@ public:
 
 	Type type() { return Character; }
 
+	ObjectID getModelID() const { return ped ? ped->ID : 0; }
+
+	void tickParallel(float dt);
+
 	void tick(float dt);
 
+	void tickAnimation(float dt);
+
 	const CharacterState& getCurrentState() const { return currentState; }
 	CharacterState& getCurrentState(){ return currentState; }
 
@@ -20,6 +20,8 @@ public:
 
 	void tick(float dt);
 
+	void tickAnimation(float dt);
+
 	void setParentActor(GameObject* parent, ModelFrame* bone);
 
 	GameObject* getParentActor() const
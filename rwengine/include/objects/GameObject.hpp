@@ -95,6 +95,18 @@ public:
 	 * @return one of Type
 	 */
 	virtual Type type() { return Unknown; }
+
+	/**
+	 * @brief The ID of the object definition this was created from
+	 * @return The definition's ID, or 0 for objects without one
+	 */
+	virtual ObjectID getModelID() const { return 0; }
+
+	/**
+	 * @brief The model name of the object definition, see ObjectData::modelID
+	 * @return The interned lowercase name, or StringTable::Empty
+	 */
+	virtual StringID getModelName() const { return StringTable::Empty; }
 	
 	virtual void setPosition(const glm::vec3& pos);
 
@@ -152,8 +164,32 @@ public:
 
 	virtual bool isInWater() const { return inWater; }
 
+	/**
+	 * @brief Works out the object's update, such as what its AI does next
+	 *
+	 * Called for every object at once from several threads, before any
+	 * object's tick(). It may read the world, physics and other objects,
+	 * but must not change anything outside of this object.
+	 */
+	virtual void tickParallel(float /*dt*/) { }
+
+	/**
+	 * @brief Applies the object's update to the world
+	 *
+	 * Called after tickParallel, for one object at a time in the order
+	 * objects were created.
+	 */
 	virtual void tick(float dt) = 0;
 
+	/**
+	 * @brief Advances the object's animation
+	 *
+	 * Called for every object at once from several threads, after every
+	 * object's tick(), so animations started by tick() play this frame.
+	 * It must not change anything outside of this object.
+	 */
+	virtual void tickAnimation(float /*dt*/) { }
+
 	/**
 	 * @brief Function used to modify the last transform
 	 * @param newPos
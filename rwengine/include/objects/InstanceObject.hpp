@@ -27,8 +27,14 @@ public:
 
 	Type type() { return Instance; }
 
+	ObjectID getModelID() const { return object ? object->ID : 0; }
+
+	StringID getModelName() const { return object ? object->modelID : StringTable::Empty; }
+
 	void tick(float dt);
 
+	void tickAnimation(float dt);
+
 	void changeModel(std::shared_ptr<ObjectData> incoming);
 
 	glm::vec3 getPosition() const override;
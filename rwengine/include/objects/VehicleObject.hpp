@@ -60,6 +60,8 @@ public:
 
 	Type type() { return Vehicle; }
 
+	ObjectID getModelID() const { return vehicle ? vehicle->ID : 0; }
+
 	void setSteeringAngle(float);
 
 	float getSteeringAngle() const;
@@ -10,6 +10,7 @@ class Logger;
 #include <vector>
 
 #include <render/ViewCamera.hpp>
+#include <core/FrameStats.hpp>
 
 #include <render/OpenGLRenderer.hpp>
 #include "MapRenderer.hpp"
@@ -96,7 +97,12 @@ class GameRenderer
 
 public:
 	
-	GameRenderer(Logger* log, GameData* data);
+	/**
+	 * Creates a GameRenderer that draws with backend, or with a new
+	 * OpenGLRenderer if backend is null. If the backend is headless no
+	 * GL resources are created, and renderWorld only draws objects.
+	 */
+	GameRenderer(Logger* log, GameData* data, Renderer* backend = nullptr);
 	~GameRenderer();
 	
 	/** Number of culling events */
@@ -191,6 +197,9 @@ public:
 	Renderer::ProfileInfo profSky;
 	Renderer::ProfileInfo profWater;
 	Renderer::ProfileInfo profEffects;
+
+	/// CPU time of the last renderWorld, only the Build, Sort and Draw phases are set
+	perf::FrameTimes worldTimes;
 };
 
 #endif
@@ -44,6 +44,9 @@ private:
 	DrawBuffer circle;
 	
 	Renderer::ShaderProgram* rectProg;
+
+	/// The radarXX texture for each block of the map
+	std::vector<TextureKey> radarTiles;
 	
 	void drawBlip(const glm::vec2& map, const glm::mat4& view, const MapInfo& mi, const std::string& texture, float heading = 0.f, float size = 18.f);
 };
@@ -0,0 +1,93 @@
+#ifndef _RWENGINE_NULLRENDERER_HPP_
+#define _RWENGINE_NULLRENDERER_HPP_
+#include <render/OpenGLRenderer.hpp>
+
+/**
+ * @brief Renderer that doesn't draw anything
+ *
+ * Goes through the same state tracking and batching as other renderers,
+ * but records draws instead of sending them to a GPU. Used to run and
+ * measure the rendering pipeline without a GL context.
+ */
+class NullRenderer : public Renderer
+{
+public:
+
+	/// A draw that would have been issued
+	struct DrawRecord
+	{
+		DrawBuffer* dbuff;
+		/// First texture bound for the draw, or 0
+		GLuint texture;
+		size_t count;
+		size_t instances;
+	};
+
+	NullRenderer();
+
+	bool isHeadless() const override { return true; }
+
+	std::string getIDString() const override;
+
+	ShaderProgram* createShader(const std::string& vert, const std::string& frag) override;
+	void useProgram(ShaderProgram* p) override;
+	void setProgramBlockBinding(ShaderProgram* p, const std::string& name, GLint point) override;
+	void setUniformTexture(ShaderProgram* p, const std::string& name, GLint tex) override;
+	void setUniform(ShaderProgram* p, const std::string& name, const glm::mat4& m) override;
+	void setUniform(ShaderProgram* p, const std::string& name, const glm::vec4& v) override;
+	void setUniform(ShaderProgram* p, const std::string& name, const glm::vec3& v) override;
+	void setUniform(ShaderProgram* p, const std::string& name, const glm::vec2& v) override;
+	void setUniform(ShaderProgram* p, const std::string& name, float f) override;
+
+	void clear(const glm::vec4& colour, bool clearColour, bool clearDepth) override;
+
+	void setSceneParameters(const SceneUniformData& data) override;
+
+	void draw(const glm::mat4& model, DrawBuffer* draw, const DrawParameters& p) override;
+	void drawArrays(const glm::mat4& model, DrawBuffer* draw, const DrawParameters& p) override;
+
+	void pushDebugGroup(const std::string& title) override;
+	const ProfileInfo& popDebugGroup() override;
+
+	void swap() override;
+
+	/**
+	 * Returns the draws issued since the last swap, in order
+	 */
+	const std::vector<DrawRecord>& getDraws() const { return draws; }
+
+	/**
+	 * Returns the number of instances drawn since the last swap
+	 */
+	size_t getInstanceCount() const { return instanceCounter; }
+
+	/**
+	 * Returns the object data uploaded since the last swap, if
+	 * setRecordObjectData is enabled
+	 */
+	const std::vector<ObjectUniformData>& getObjectData() const { return objectData; }
+
+	/**
+	 * Controls whether uploaded object data is kept, disabled by default
+	 */
+	void setRecordObjectData(bool record) { recordObjectData = record; }
+
+protected:
+	void bindDrawBuffer(DrawBuffer* dbuff) override;
+	void bindTexture(GLuint unit, GLuint tex) override;
+	void applyBlend(bool enable) override;
+	void applyDepthWrite(bool enable) override;
+	void writeObjectData(const ObjectUniformData* data, size_t count) override;
+	void drawElementsInstanced(DrawBuffer* draw, const DrawParameters& p, size_t instances) override;
+
+private:
+	std::vector<DrawRecord> draws;
+	std::vector<ObjectUniformData> objectData;
+	size_t instanceCounter;
+	bool recordObjectData;
+	ProfileInfo profile;
+
+	void record(DrawBuffer* draw, const DrawParameters& p, size_t instances);
+};
+
+#endif
@@ -8,6 +8,7 @@
 #include <objects/GameObject.hpp>
 #include <engine/GameWorld.hpp>
 #include <gl/DrawBuffer.hpp>
+#include <data/Model.hpp>
 
 class ProjectileObject;
 class PickupObject;
@@ -17,6 +18,10 @@ class PickupObject;
  *
  * Determines what parts of an object are within a camera frustum and exports
  * a list of things to render for the object.
+ *
+ * Several ObjectRenderers may build lists at the same time, as long as
+ * each object is only built by one of them. Game data is only read while
+ * building, any changes are deferred until resolveTextures().
  */
 class ObjectRenderer
 {
@@ -34,16 +39,32 @@ public:
 	/**
 	 * @brief buildRenderList
 	 *
-	 * Exports rendering instructions for an object
+	 * Exports rendering instructions for an object. The object's skeleton
+	 * should already be interpolated for the frame.
 	 */
 	void buildRenderList(GameObject* object, RenderList& outList);
 
+	/**
+	 * @brief resolveTextures
+	 *
+	 * Stores textures that were found while building render lists in
+	 * their materials, so they don't need to be found again. Must not be
+	 * called while any ObjectRenderer is building a list.
+	 */
+	void resolveTextures();
+
 private:
 	GameWorld* m_world;
 	const ViewCamera& m_camera;
 	float m_renderAlpha;
 	GLuint m_errorTexture;
 
+	/// Textures found for materials that haven't been stored yet
+	std::vector<std::pair<Model::Texture*, TextureData::Handle>> m_resolvedTextures;
+
+	TextureData::Handle findTexture(TextureKey key) const;
+	Model* findModel(StringID name) const;
+
 	void renderInstance(InstanceObject *instance, RenderList& outList);
 	void renderCharacter(CharacterObject *pedestrian, RenderList& outList);
 	void renderVehicle(VehicleObject *vehicle, RenderList& outList);
@@ -7,6 +7,9 @@
 #include <gl/GeometryBuffer.hpp>
 #include <glm/vec2.hpp>
 
+#include <initializer_list>
+#include <vector>
+
 typedef uint64_t RenderKey;
 
 // Maximum depth of debug group stack
@@ -40,7 +43,41 @@ class Renderer
 {
 public:
 
-	typedef std::vector<GLuint> Textures;
+	/// Maximum number of texture units used by a draw
+	enum { MaxTextures = 4 };
+
+	/// Maximum number of instances in one draw, the size of the ObjectData block
+	enum { MaxBatchInstances = 128 };
+
+	/**
+	 * @brief The Textures struct lists the textures for a draw
+	 *
+	 * The names are stored inline, so that copying DrawParameters never
+	 * allocates. Can be assigned from a braced list of names.
+	 */
+	struct Textures
+	{
+		GLuint names[MaxTextures];
+		GLuint count;
+
+		Textures()
+			: count(0)
+		{ }
+
+		Textures(std::initializer_list<GLuint> list)
+			: count(0)
+		{
+			RW_CHECK(list.size() <= MaxTextures, "Too many textures for draw");
+			for( GLuint name : list ) {
+				if( count < MaxTextures ) {
+					names[count++] = name;
+				}
+			}
+		}
+
+		size_t size() const { return count; }
+		GLuint operator[](size_t i) const { return names[i]; }
+	};
 
 	/**
 	 * @brief The DrawParameters struct stores drawing state
@@ -86,39 +123,94 @@ public:
 	 * @brief The RenderInstruction struct Generic Rendering instruction
 	 *
 	 * These are generated by the ObjectRenderer, and passed in to the
-	 * OpenGLRenderer by GameRenderer.
+	 * OpenGLRenderer by GameRenderer. The model matrix is stored in the
+	 * owning RenderList, so instructions are plain data that can be
+	 * sorted and copied without allocating.
 	 */
 	struct RenderInstruction
 	{
 		RenderKey sortKey;
-		// Ideally, this would just be an index into a buffer that contains the matrix
-		glm::mat4 model;
+		/// Index of the model matrix in RenderList::matrices
+		uint32_t matrix;
 		DrawBuffer* dbuff;
 		Renderer::DrawParameters drawInfo;
 
 		RenderInstruction(
 				RenderKey key,
-				const glm::mat4& model,
+				uint32_t matrix,
 				DrawBuffer* dbuff,
 				const Renderer::DrawParameters& dp)
 			: sortKey(key)
-			, model(model)
+			, matrix(matrix)
 			, dbuff(dbuff)
 			, drawInfo(dp)
 		{
 
 		}
 	};
-	typedef std::vector<RenderInstruction> RenderList;
+
+	/**
+	 * @brief The RenderList struct holds the instructions for a frame
+	 * and the matrices they refer to.
+	 */
+	struct RenderList
+	{
+		std::vector<RenderInstruction> instructions;
+		std::vector<glm::mat4> matrices;
+
+		/// Adds an instruction, storing model in the matrix arena
+		void add(RenderKey key,
+				 const glm::mat4& model,
+				 DrawBuffer* dbuff,
+				 const Renderer::DrawParameters& dp)
+		{
+			instructions.emplace_back(key, uint32_t(matrices.size()), dbuff, dp);
+			matrices.push_back(model);
+		}
+
+		/// Appends the instructions of another list, after ours
+		void append(const RenderList& other)
+		{
+			auto base = uint32_t(matrices.size());
+			matrices.insert(matrices.end(), other.matrices.begin(), other.matrices.end());
+			instructions.reserve(instructions.size() + other.instructions.size());
+			for( auto ri : other.instructions ) {
+				ri.matrix += base;
+				instructions.push_back(ri);
+			}
+		}
+
+		const glm::mat4& getMatrix(const RenderInstruction& ri) const
+		{
+			return matrices[ri.matrix];
+		}
+
+		void reserve(size_t count)
+		{
+			instructions.reserve(count);
+			matrices.reserve(count);
+		}
+
+		void clear()
+		{
+			instructions.clear();
+			matrices.clear();
+		}
+
+		size_t size() const { return instructions.size(); }
+	};
 
 
+	/// One entry of the ObjectData block, padded to its std140 array stride
 	struct ObjectUniformData {
 		glm::mat4 model;
 		glm::vec4 colour;
 		float diffuse;
 		float ambient;
 		float visibility;
+		float padding;
 	};
+	static_assert(sizeof(ObjectUniformData) == 96, "ObjectUniformData must match the shader layout");
 
 	struct SceneUniformData {
 		glm::mat4 projection;
@@ -137,6 +229,12 @@ public:
 
 	virtual std::string getIDString() const = 0;
 
+	/**
+	 * Returns true if this renderer doesn't draw to a GL context. Code
+	 * that calls GL directly must be skipped when this is set.
+	 */
+	virtual bool isHeadless() const { return false; }
+
 	virtual ShaderProgram* createShader(const std::string& vert, const std::string& frag) = 0;
 
 	virtual void useProgram(ShaderProgram* p) = 0;
@@ -157,19 +255,27 @@ public:
 	virtual void draw(const glm::mat4& model, DrawBuffer* draw, const DrawParameters& p) = 0;
 	virtual void drawArrays(const glm::mat4& model, DrawBuffer* draw, const DrawParameters& p) = 0;
 
-	virtual void drawBatched(const RenderList& list) = 0;
+	/**
+	 * Draws every instruction in the list, in order. Consecutive
+	 * instructions that use the same buffer, index range, textures and
+	 * state are combined into instanced draws.
+	 */
+	void drawBatched(const RenderList& list);
 
 	void setViewport(const glm::ivec2& vp);
 	const glm::ivec2& getViewport() const { return viewport; }
 
 	const glm::mat4& get2DProjection() const { return projection2D; }
 
-	virtual void invalidate() = 0;
+	/**
+	 * Forgets the cached state, for after something else has changed it.
+	 */
+	virtual void invalidate();
 
 	/**
 	 * Resets all per-frame counters.
 	 */
-	void swap();
+	virtual void swap();
 	
 	/**
 	 * Returns the number of draw calls issued for the current frame.
@@ -177,6 +283,16 @@ public:
 	int getDrawCount();
 	int getTextureCount();
 	int getBufferCount();
+	/**
+	 * Returns the number of blending and depth write changes for the
+	 * current frame.
+	 */
+	int getStateChangeCount();
+	/**
+	 * Returns the number of bytes of uniform data uploaded for the
+	 * current frame.
+	 */
+	size_t getUploadedBytes();
 	
 	const SceneUniformData& getSceneData() const;
 
@@ -207,6 +323,9 @@ public:
 	 */
 	virtual const ProfileInfo& popDebugGroup() = 0;
 
+	Renderer();
+	virtual ~Renderer() { }
+
 private:
 	glm::ivec2 viewport;
 	glm::mat4 projection2D;
@@ -214,7 +333,43 @@ protected:
 	int drawCounter;
 	int textureCounter;
 	int bufferCounter;
+	int stateCounter;
+	size_t uploadCounter;
 	SceneUniformData lastSceneData;
+
+	void setDrawState(const glm::mat4& model, DrawBuffer* draw, const DrawParameters& p);
+
+	// State Cache, only changes are passed on to the implementation
+	DrawBuffer* currentDbuff;
+	std::map<GLuint,GLuint> currentTextures;
+	bool blendEnabled;
+	bool depthWriteEnabled;
+
+	void useDrawBuffer(DrawBuffer* dbuff);
+	void useTexture(GLuint unit, GLuint tex);
+	void setBlend(bool enable);
+	void setDepthWrite(bool enable);
+
+	/**
+	 * Uploads per object data to the ObjectData block, as the data for
+	 * the next draw.
+	 */
+	void uploadObjectData(const ObjectUniformData* data, size_t count);
+
+	virtual void bindDrawBuffer(DrawBuffer* dbuff) = 0;
+	virtual void bindTexture(GLuint unit, GLuint tex) = 0;
+	virtual void applyBlend(bool enable) = 0;
+	virtual void applyDepthWrite(bool enable) = 0;
+	virtual void writeObjectData(const ObjectUniformData* data, size_t count) = 0;
+	/**
+	 * Draws instances of the elements in p, the instances use
+	 * consecutive entries of the last uploaded object data.
+	 */
+	virtual void drawElementsInstanced(DrawBuffer* draw, const DrawParameters& p, size_t instances) = 0;
+
+private:
+	/// Reused between calls to drawBatched
+	std::vector<ObjectUniformData> batchData;
 };
 
 class OpenGLRenderer : public Renderer
@@ -263,26 +418,23 @@ public:
 
 	void setSceneParameters(const SceneUniformData &data);
 
-	void setDrawState(const glm::mat4& model, DrawBuffer* draw, const DrawParameters& p);
-
 	void draw(const glm::mat4& model, DrawBuffer* draw, const DrawParameters& p);
 	void drawArrays(const glm::mat4& model, DrawBuffer* draw, const DrawParameters& p);
 
-	void drawBatched(const RenderList& list) override;
-
-	void invalidate();
+	void invalidate() override;
 
 	virtual void pushDebugGroup(const std::string& title);
 	virtual const ProfileInfo& popDebugGroup();
 
-private:
-	DrawBuffer* currentDbuff;
-
-	void useDrawBuffer(DrawBuffer* dbuff);
-
-	std::map<GLuint,GLuint> currentTextures;
-	void useTexture(GLuint unit, GLuint tex);
+protected:
+	void bindDrawBuffer(DrawBuffer* dbuff) override;
+	void bindTexture(GLuint unit, GLuint tex) override;
+	void applyBlend(bool enable) override;
+	void applyDepthWrite(bool enable) override;
+	void writeObjectData(const ObjectUniformData* data, size_t count) override;
+	void drawElementsInstanced(DrawBuffer* draw, const DrawParameters& p, size_t instances) override;
 
+private:
 	OpenGLShaderProgram* currentProgram;
 
 	GLuint currentUBO;
@@ -293,6 +445,7 @@ private:
 			currentUBO = buffer;
 		}
 		glBufferData(GL_UNIFORM_BUFFER, sizeof(T), &data, GL_DYNAMIC_DRAW);
+		uploadCounter += sizeof(T);
 #if RW_PROFILER
 		if( currentDebugDepth > 0 )
 		{
@@ -301,41 +454,16 @@ private:
 #endif
 	}
 
+	/// Object data is streamed through a ring of blocks in UBOObject
 	GLuint UBOObject;
-	GLuint maxObjectEntries;
-	GLuint currentObjectEntry;
-	GLuint entryAlignment;
+	/// Size of the ObjectData block
+	GLuint objectBlockSize;
+	/// Distance between blocks, respecting the UBO offset alignment
+	GLuint objectBlockStride;
+	GLuint objectBlockCount;
+	GLuint currentObjectBlock;
 	GLuint UBOScene;
 
-	// State Cache
-	bool blendEnabled;
-	bool depthWriteEnabled;
-
-	// Set state
-	void setBlend(bool enable)
-	{
-		/// @todo set blendEnabled, currently not possible because other functions keep trashing the state
-#if 0
-		if (enable && !blendEnabled) {
-			glEnable(GL_BLEND);
-			blendEnabled = enable;
-		} else if(!enable && blendEnabled) {
-			glDisable(GL_BLEND);
-			blendEnabled = enable;
-		}
-#else
-		glEnable(GL_BLEND);
-#endif
-	}
-
-	void setDepthWrite(bool enable)
-	{
-		if (enable != depthWriteEnabled) {
-			glDepthMask(enable ? GL_TRUE : GL_FALSE);
-			depthWriteEnabled = enable;
-		}
-	}
-
 	// Debug group profiling timers
 	ProfileInfo profileInfo[MAX_DEBUG_DEPTH];
 	GLuint debugQuery;
@@ -0,0 +1,16 @@
+#ifndef _RWENGINE_RENDERLISTSORT_HPP_
+#define _RWENGINE_RENDERLISTSORT_HPP_
+#include <render/OpenGLRenderer.hpp>
+
+class WorkContext;
+
+/**
+ * @brief Sorts a RenderList by ascending sort key
+ *
+ * This is a stable radix sort over the bytes of the key, bytes that are
+ * the same for every instruction are skipped. If work is provided large
+ * lists are split between its workers, the result is the same either way.
+ */
+void sortRenderList(RenderList& list, WorkContext* work = nullptr);
+
+#endif
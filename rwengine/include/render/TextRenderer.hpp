@@ -2,6 +2,9 @@
 #include <engine/GameData.hpp>
 #include "OpenGLRenderer.hpp"
 
+#include <list>
+#include <unordered_map>
+
 #define GAME_FONTS 3
 #define GAME_GLYPHS 192
 
@@ -9,8 +12,8 @@ class GameRenderer;
 /**
  * @brief Handles rendering of bitmap font textures.
  * 
- * In future, strings textures might be cached to improve performance, but
- * for now, we just render each glyph on it's own quad
+ * Each glyph is drawn on its own quad. The quads of recently drawn texts
+ * are kept uploaded, so static text isn't laid out again every frame.
  */
 class TextRenderer
 {
@@ -56,20 +59,103 @@ public:
 		float widthFrac;
 	};
 	
+	struct TextVertex
+	{
+		glm::vec2 position;
+		glm::vec2 texcoord;
+		glm::vec3 colour;
+
+		static const AttributeList vertex_attributes() {
+			return {
+				{ATRS_Position, 2, sizeof(TextVertex),  0ul},
+				{ATRS_TexCoord, 2, sizeof(TextVertex),  0ul + sizeof(glm::vec2)},
+				{ATRS_Colour, 3, sizeof(TextVertex),  0ul + sizeof(glm::vec2) * 2},
+			};
+		}
+	};
+
+	/**
+	 * The glyph quads of a text, relative to its screen position
+	 */
+	struct TextLayout
+	{
+		std::vector<TextVertex> vertices;
+		float width;
+		float height;
+		/// Size of the last glyph, used to pad the background
+		glm::vec2 glyphSize;
+	};
+
+	/**
+	 * Lays out the glyphs of a text, applying its markup. Only the text,
+	 * font, size, wrap width and base colour are used, the position,
+	 * alignment and background are applied when it's drawn.
+	 */
+	static void layoutText( const TextInfo& ti, bool forceColour, TextLayout& layout );
+
+	/**
+	 * @brief Keeps the layouts of the most recently drawn texts
+	 *
+	 * A layout is found again when the text, font, size, wrap width, base
+	 * colour and forceColour all match. Once there are as many layouts as
+	 * the capacity a new one replaces the least recently used, reusing its
+	 * vertex buffers.
+	 */
+	class LayoutCache
+	{
+	public:
+		struct Entry
+		{
+			size_t hash;
+			TextInfo key;
+			bool forceColour;
+			TextLayout layout;
+			/// The layout's vertices, uploaded when it's first drawn
+			GeometryBuffer gb;
+			DrawBuffer db;
+			bool uploaded;
+		};
+
+		struct Stats
+		{
+			size_t hits;
+			size_t misses;
+		};
+
+		LayoutCache(size_t capacity = 256);
+
+		/**
+		 * Returns the entry for a text, laying it out if it isn't cached
+		 */
+		Entry& get( const TextInfo& ti, bool forceColour );
+
+		size_t size() const { return entries.size(); }
+		const Stats& getStats() const { return stats; }
+
+	private:
+		size_t capacity;
+		/// Most recently used first
+		std::list<Entry> entries;
+		std::unordered_map<size_t, std::list<Entry>::iterator> index;
+		Stats stats;
+	};
+
 	TextRenderer(GameRenderer* renderer);
 	~TextRenderer();
 	
 	void setFontTexture( int index, const std::string& font );
 	
 	void renderText( const TextInfo& ti, bool forceColour = false );
+
+	const LayoutCache& getLayoutCache() const { return layouts; }
 	
 private:
 	std::string fonts[GAME_FONTS];
-	GlyphInfo glyphData[GAME_GLYPHS];
+	/// The textures of fonts, found when each font is first drawn
+	TextureData::Handle fontTextures[GAME_FONTS];
 
 	GameRenderer* renderer;
 	Renderer::ShaderProgram* textShader;
-	
-	GeometryBuffer gb;
-	DrawBuffer db;
+
+	LayoutCache layouts;
 };
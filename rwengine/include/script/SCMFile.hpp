@@ -23,7 +23,7 @@ public:
 	};
 
 	SCMFile()
-		: _data(nullptr), _target(NoTarget),
+		: _data(nullptr), _size(0), _target(NoTarget),
 		  mainSize(0), missionLargestSize(0)
 	{}
 
@@ -36,6 +36,11 @@ public:
 
 	SCMByte* data() const { return _data; }
 
+	/**
+	 * Returns the size of the file in bytes
+	 */
+	unsigned int getSize() const { return _size; }
+
 	template<class T> T read(unsigned int offset) const
 	{
 		return *(T*)(_data+offset);
@@ -58,6 +63,7 @@ public:
 private:
 
 	SCMByte* _data;
+	unsigned int _size;
 
 	SCMTarget _target;
 
@@ -11,10 +11,12 @@
 #include <list>
 #include <set>
 #include <array>
+#include <utility>
 
 #define SCM_NEGATE_CONDITIONAL_MASK 0x8000
 #define SCM_CONDITIONAL_MASK_PASSED 0xFF
 #define SCM_THREAD_LOCAL_SIZE 256
+#define SCM_OPCODE_COUNT 0x8000
 
 /* Maxium size value that can be stored in each memory address.
  * Changing this will break saves.
@@ -259,6 +261,11 @@ public:
 	 * @brief executes threads until they are all in waiting state.
 	 */
 	void execute(float dt);
+
+	/**
+	 * Returns the number of distinct instructions decoded so far
+	 */
+	size_t getDecodedInstructionCount() const { return instructions.size(); }
 	
 private:
 	SCMFile* _file;
@@ -268,6 +275,35 @@ private:
 
 	std::list<SCMThread> _activeThreads;
 
+	/**
+	 * An instruction and its parameters, decoded the first time
+	 * its address is executed
+	 */
+	struct SCMInstruction
+	{
+		ScriptFunctionMeta* code;
+		/// Opcode without the negation flag
+		SCMOpcode opcode;
+		bool isNegatedConditional;
+		/// Address of the following instruction
+		SCMThread::pc_t next;
+		SCMParams parameters;
+		/// Parameters that refer to thread locals, and their variable index
+		std::uint8_t localCount;
+		std::array<std::pair<std::uint8_t, std::uint16_t>, SCMParams::MaxParameters> locals;
+		/// The thread whose locals the parameters point to
+		const SCMThread* localsThread;
+	};
+
+	/// Functions for every opcode, indexed by opcode
+	std::vector<ScriptFunctionMeta*> opcodeTable;
+	std::vector<SCMInstruction> instructions;
+	/// Index + 1 into instructions for each address, 0 until it's decoded
+	std::vector<std::uint32_t> instructionIndex;
+
+	SCMInstruction& getInstruction(SCMThread& t, SCMThread::pc_t pc);
+	SCMInstruction decodeInstruction(SCMThread& t, SCMThread::pc_t pc);
+
 	void executeThread(SCMThread& t, int msPassed);
 
 	SCMBreakpointInfo* findBreakpoint(SCMThread& t, SCMThread::pc_t pc);
@@ -20,7 +20,17 @@ public:
 	
 	void bind(ScriptFunctionID id,
 	          ScriptFunction func,
-	          bool conditional,
+	          int args,
+	          const std::string& name,
+	          const std::string& desc
+	);
+
+	/**
+	 * Binds a conditional function, its result is stored in the thread's
+	 * condition result
+	 */
+	void bind(ScriptFunctionID id,
+	          ScriptFunctionBoolean func,
 	          int args,
 	          const std::string& name,
 	          const std::string& desc
@@ -33,16 +43,10 @@ private:
 	std::map<ScriptFunctionID, ScriptFunctionMeta> functions;
 };
 
-template<class Tret> ScriptFunction conditional_facade(Tret(*f)(const ScriptArguments&)) { return f; }
-template<> ScriptFunction conditional_facade<bool>(bool(*f)(const ScriptArguments&));
-
-template<class Tret> bool is_conditional(Tret(*)(const ScriptArguments&)) { return false; }
-template<> bool is_conditional<bool>(bool(*f)(const ScriptArguments&));
-
 // Macro to automatically use function name.
 #define bindFunction(id, func, argc, desc) \
-	bind(id, conditional_facade(func), is_conditional(func), argc, #func, desc)
+	bind(id, func, argc, #func, desc)
 #define bindUnimplemented(id, func, argc, desc) \
-	bind(id, 0, false, argc, #func, desc)
+	bind(id, ScriptFunction(nullptr), argc, #func, desc)
 
 #endif
@@ -3,11 +3,13 @@
 #define _SCRIPTTYPES_HPP_
 #include <rw/defines.hpp>
 
+#include <array>
 #include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
 #include <functional>
+#include <stdexcept>
 
 class PickupObject;
 class CutsceneObject;
@@ -84,7 +86,53 @@ struct SCMOpcodeParameter {
 	}
 };
 
-typedef std::vector<SCMOpcodeParameter> SCMParams;
+/**
+ * Stores an instruction's parameters inline, without allocating
+ */
+class SCMParams
+{
+public:
+	/// More than any opcode takes, including the locals passed to new threads
+	enum { MaxParameters = 20 };
+
+	typedef const SCMOpcodeParameter* const_iterator;
+
+	SCMParams() : count(0) { }
+
+	void push_back(const SCMOpcodeParameter& parameter)
+	{
+		RW_CHECK(count < MaxParameters, "Too many parameters");
+		if( count < MaxParameters ) {
+			parameters[count++] = parameter;
+		}
+	}
+
+	void clear() { count = 0; }
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	SCMOpcodeParameter& back() { return parameters[count - 1]; }
+	const SCMOpcodeParameter& back() const { return parameters[count - 1]; }
+
+	SCMOpcodeParameter& operator[](size_t i) { return parameters[i]; }
+	const SCMOpcodeParameter& operator[](size_t i) const { return parameters[i]; }
+
+	const SCMOpcodeParameter& at(size_t i) const
+	{
+		if( i >= count ) {
+			throw std::out_of_range("SCMParams::at");
+		}
+		return parameters[i];
+	}
+
+	const_iterator begin() const { return parameters.data(); }
+	const_iterator end() const { return parameters.data() + count; }
+
+private:
+	std::array<SCMOpcodeParameter, MaxParameters> parameters;
+	size_t count;
+};
 
 class ScriptArguments
 {
@@ -124,13 +172,15 @@ template<> GameObject* ScriptArguments::getObject<PickupObject>(unsigned int arg
 /** Special player-index returning function */
 template<> GameObject* ScriptArguments::getObject<PlayerController>(unsigned int arg) const;
 
-typedef std::function<void (const ScriptArguments&)> ScriptFunction;
-typedef std::function<bool (const ScriptArguments&)> ScriptFunctionBoolean;
+typedef void (*ScriptFunction)(const ScriptArguments&);
+typedef bool (*ScriptFunctionBoolean)(const ScriptArguments&);
 typedef uint16_t ScriptFunctionID;
 
 struct ScriptFunctionMeta
 {
 	ScriptFunction function;
+	/** Set instead of function for conditional opcodes */
+	ScriptFunctionBoolean condition;
 	int arguments;
 	bool conditional;
 	/** API name for this function */
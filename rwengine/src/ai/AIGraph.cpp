@@ -2,7 +2,30 @@
 #include <objects/GameObject.hpp>
 #include <ai/AIGraphNode.hpp>
 #include <glm/gtx/norm.hpp>
-#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float kLowerCoord = -(WORLD_GRID_SIZE)/2.f;
+
+	/// The grid cell of a world coordinate, cells on the edge hold anything beyond it
+	int worldToGrid(float world)
+	{
+		float cell = std::floor((world - kLowerCoord) / WORLD_CELL_SIZE);
+		return int(glm::clamp(cell, 0.f, float(WORLD_GRID_WIDTH - 1)));
+	}
+
+	size_t gridIndex(const glm::vec3& world)
+	{
+		return worldToGrid(world.x) * WORLD_GRID_WIDTH + worldToGrid(world.y);
+	}
+}
+
+AIGraph::AIGraph()
+	: revision(0)
+{
+}
 
 AIGraph::~AIGraph()
 {
@@ -23,14 +46,14 @@ void AIGraph::createPathNodes(const glm::vec3& position, const glm::quat& rotati
 		glm::vec3 nodePosition = position + (rotation * node.position);
 
 		if( node.type == PathNode::EXTERNAL ) {
-			for( size_t rn = 0; rn < externalNodes.size(); ++rn ) {
-				auto& realNode = externalNodes[rn];
-				auto d = glm::distance2(realNode->position, nodePosition);
-				if( d < 1.f ) {
-					pathNodes.push_back(realNode);
+			// Paths share external nodes where they meet
+			forEachNodeNear(gridNodes, nodePosition, 1.f, [&](AIGraphNode* realNode) {
+				if( ainode == nullptr && glm::distance2(realNode->position, nodePosition) < 1.f ) {
 					ainode = realNode;
-					break;
 				}
+			});
+			if( ainode ) {
+				pathNodes.push_back(ainode);
 			}
 		}
 		
@@ -45,24 +68,17 @@ void AIGraph::createPathNodes(const glm::vec3& position, const glm::quat& rotati
 			ainode->position = nodePosition;
 			ainode->external = node.type == PathNode::EXTERNAL;
 			ainode->disabled = false;
+			ainode->index = nodes.size();
 
 			pathNodes.push_back(ainode);
 			nodes.push_back(ainode);
 
+			allGridNodes[gridIndex(ainode->position)].push_back(ainode);
+
 			if( ainode->external )
 			{
 				externalNodes.push_back(ainode);
-				
-				// Determine which grid cell this node falls into
-				float lowerCoord = -(WORLD_GRID_SIZE)/2.f;
-				auto gridrel = glm::vec2(ainode->position) - glm::vec2(lowerCoord, lowerCoord);
-				auto gridcoord = glm::floor(gridrel / glm::vec2(WORLD_CELL_SIZE));
-				if( gridcoord.x < 0 || gridcoord.y < 0 || gridcoord.x >= WORLD_GRID_WIDTH || gridcoord.y >= WORLD_GRID_WIDTH )
-				{
-					std::cout << "Warning: Node outside of grid at coord " << gridcoord.x << " " << gridcoord.y << std::endl;
-				}
-				auto index = (gridcoord.x * WORLD_GRID_WIDTH) + gridcoord.y;
-				gridNodes[index].push_back(ainode);
+				gridNodes[gridIndex(ainode->position)].push_back(ainode);
 			}
 		}
 	}
@@ -76,41 +92,98 @@ void AIGraph::createPathNodes(const glm::vec3& position, const glm::quat& rotati
 			next->connections.push_back(node);
 		}
 	}
-}
 
-glm::ivec2 worldToGrid(const glm::vec2& world)
-{
-	static const float lowerCoord = -(WORLD_GRID_SIZE)/2.f;
-	return glm::ivec2((world - glm::vec2(lowerCoord)) / glm::vec2(WORLD_CELL_SIZE));
+	revision++;
 }
 
-void AIGraph::gatherExternalNodesNear(const glm::vec3& center, const float radius, std::vector< AIGraphNode* >& nodes)
+template<class Function>
+void AIGraph::forEachNodeNear(const NodeGrid& grid, const glm::vec3& center, float radius,
+							  const Function& function)
 {
 	// the bounds end up covering more than might fit
-	auto planecoords = glm::vec2(center);
-	auto minWorld = planecoords - glm::vec2(radius);
-	auto maxWorld = planecoords + glm::vec2(radius);
-	auto minGrid = worldToGrid(minWorld);
-	auto maxGrid = worldToGrid(maxWorld);
+	int minX = worldToGrid(center.x - radius);
+	int maxX = worldToGrid(center.x + radius);
+	int minY = worldToGrid(center.y - radius);
+	int maxY = worldToGrid(center.y + radius);
 
-	for( int x = minGrid.x; x <= maxGrid.x; ++x )
+	for( int x = minX; x <= maxX; ++x )
 	{
-		for( int y = minGrid.y; y <= maxGrid.y; ++y )
+		for( int y = minY; y <= maxY; ++y )
 		{
-			int i = (x * WORLD_GRID_WIDTH) + y;
-			if( i < 0 || i >= (int)gridNodes.size() )
+			for( AIGraphNode* node : grid[(x * WORLD_GRID_WIDTH) + y] )
 			{
-				continue;
+				function(node);
 			}
-			auto& external = gridNodes[i];
-			for ( AIGraphNode* node : external )
-			{
-				if ( glm::distance2( center, node->position ) < radius*radius )
-				{
-					nodes.push_back( node );
-				}
+		}
+	}
+}
+
+bool AIGraph::coversGrid(const glm::vec3& center, float radius)
+{
+	return worldToGrid(center.x - radius) == 0 && worldToGrid(center.y - radius) == 0
+			&& worldToGrid(center.x + radius) == WORLD_GRID_WIDTH - 1
+			&& worldToGrid(center.y + radius) == WORLD_GRID_WIDTH - 1;
+}
+
+void AIGraph::gatherExternalNodesNear(const glm::vec3& center, const float radius, std::vector< AIGraphNode* >& nodes)
+{
+	forEachNodeNear(gridNodes, center, radius, [&](AIGraphNode* node) {
+		if ( glm::distance2( center, node->position ) < radius*radius )
+		{
+			nodes.push_back( node );
+		}
+	});
+}
+
+void AIGraph::gatherNodesNear(const glm::vec3& center, float radius, std::vector<AIGraphNode*>& out,
+							  unsigned int types) const
+{
+	forEachNodeNear(allGridNodes, center, radius, [&](AIGraphNode* node) {
+		if( (types & typeBit(node->type)) && glm::distance(center, node->position) <= radius ) {
+			out.push_back(node);
+		}
+	});
+}
+
+void AIGraph::findNearestNodes(const glm::vec3& center, size_t count, float maxDistance,
+							   std::vector<AIGraphNode*>& out, unsigned int types) const
+{
+	if( count == 0 ) {
+		return;
+	}
+
+	// Widen the search a cell at a time until enough are found
+	std::vector<std::pair<float, AIGraphNode*>> found;
+	float radius = std::min(float(WORLD_CELL_SIZE), maxDistance);
+	for( ;; ) {
+		found.clear();
+		forEachNodeNear(allGridNodes, center, radius, [&](AIGraphNode* node) {
+			float distance = glm::distance(center, node->position);
+			if( (types & typeBit(node->type)) && distance <= radius ) {
+				found.push_back({ distance, node });
 			}
+		});
+
+		if( found.size() >= count || radius >= maxDistance ) {
+			break;
 		}
+		// Once every cell is searched only the limit is left to lift
+		radius = coversGrid(center, radius) ? maxDistance : std::min(radius * 2.f, maxDistance);
+	}
+
+	count = std::min(count, found.size());
+	std::partial_sort(found.begin(), found.begin() + count, found.end(),
+		[](const std::pair<float, AIGraphNode*>& a, const std::pair<float, AIGraphNode*>& b) {
+			return a.first < b.first;
+		});
+	for( size_t i = 0; i < count; ++i ) {
+		out.push_back(found[i].second);
 	}
 }
 
+AIGraphNode* AIGraph::findNearestNode(const glm::vec3& center, unsigned int types, float maxDistance) const
+{
+	std::vector<AIGraphNode*> nearest;
+	findNearestNodes(center, 1, maxDistance, nearest, types);
+	return nearest.empty() ? nullptr : nearest[0];
+}
@@ -1,6 +1,13 @@
 #include <ai/DefaultAIController.hpp>
 #include <objects/CharacterObject.hpp>
 #include <engine/GameWorld.hpp>
+#include <rw/defines.hpp>
+
+DefaultAIController::DefaultAIController(CharacterObject* character)
+	: CharacterController(character)
+	, randomEngine(character->engine->randomEngine())
+{
+}
 
 glm::vec3 DefaultAIController::getTargetPosition()
 {
@@ -17,8 +24,10 @@ glm::vec3 DefaultAIController::getTargetPosition()
 
 const float followRadius = 5.f;
 
-void DefaultAIController::update(float dt)
+void DefaultAIController::plan(float dt)
 {
+	RW_UNUSED(dt);
+
 	switch(currentGoal)
 	{
 		case FollowLeader:
@@ -64,11 +73,12 @@ void DefaultAIController::update(float dt)
 				{
 					// Assign the next target node
 					auto lastTarget = targetNode;
-					std::random_device rd;
-					std::default_random_engine re(rd());
-					std::uniform_int_distribution<> d(0, lastTarget->connections.size()-1);
-					targetNode = lastTarget->connections.at(d(re));
-					setNextActivity(new Activities::GoTo(targetNode->position));
+					if( ! lastTarget->connections.empty() )
+					{
+						std::uniform_int_distribution<> d(0, lastTarget->connections.size()-1);
+						targetNode = lastTarget->connections.at(d(randomEngine));
+						setNextActivity(new Activities::GoTo(targetNode->position));
+					}
 				}
 				else if ( getCurrentActivity() == nullptr )
 				{
@@ -79,23 +89,10 @@ void DefaultAIController::update(float dt)
 			{
 				// We need to pick an initial node
 				auto& graph = getCharacter()->engine->aigraph;
-				AIGraphNode* node = nullptr;
-				float mindist = std::numeric_limits<float>::max();
-				for( auto n : graph.nodes )
-				{
-					float d = glm::distance( n->position, getCharacter()->getPosition() );
-					if( d < mindist )
-					{
-						node = n;
-						mindist = d;
-					}
-				}
-				targetNode = node;
+				targetNode = graph.findNearestNode(getCharacter()->getPosition());
 			}
 		}
 		break;
 		default: break;
 	}
-	
-	CharacterController::update(dt);
 }
@@ -45,19 +45,12 @@ void PlayerController::enterNearestVehicle()
 {
 	if(! character->getCurrentVehicle()) {
 		auto world = character->engine;
-		VehicleObject* nearest = nullptr; float d = 10.f;
+		std::vector<GameObject*> nearest;
+		world->query.nearest(character->getPosition(), 1, 10.f, {GameObject::Vehicle}, nearest);
 
-		for( auto& p : world->vehiclePool.objects ) {
-			auto object = p.second;
-			float vd = glm::length( character->getPosition() - object->getPosition());
-			if( vd < d ) {
-				d = vd;
-				nearest = static_cast<VehicleObject*>(object);
-			}
-		}
-
-		if( nearest ) {
-			setNextActivity(new Activities::EnterVehicle(nearest, 0));
+		if( ! nearest.empty() ) {
+			auto vehicle = static_cast<VehicleObject*>(nearest[0]);
+			setNextActivity(new Activities::EnterVehicle(vehicle, 0));
 		}
 	}
 }
@@ -0,0 +1,519 @@
+#include <ai/RoutePlanner.hpp>
+#include <ai/AIGraph.hpp>
+#include <job/WorkContext.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	const uint32_t kNoNode = std::numeric_limits<uint32_t>::max();
+	const float kInfinity = std::numeric_limits<float>::infinity();
+
+	/// Open list entries, ordered with the lowest cost on top
+	typedef std::pair<float, uint32_t> OpenNode;
+	typedef std::vector<OpenNode> OpenList;
+
+	void pushOpen(OpenList& open, float cost, uint32_t node)
+	{
+		open.push_back({ cost, node });
+		std::push_heap(open.begin(), open.end(), std::greater<OpenNode>());
+	}
+
+	OpenNode popOpen(OpenList& open)
+	{
+		std::pop_heap(open.begin(), open.end(), std::greater<OpenNode>());
+		auto top = open.back();
+		open.pop_back();
+		return top;
+	}
+}
+
+/**
+ * The graph's connections in compressed rows, node n connects to
+ * edgeTargets[edgeBegin[n]] up to edgeTargets[edgeBegin[n + 1]]
+ */
+struct RoutePlanner::Network
+{
+	std::vector<uint32_t> edgeBegin;
+	std::vector<uint32_t> edgeTargets;
+	std::vector<float> edgeCosts;
+
+	std::vector<float> x, y, z;
+	std::vector<uint8_t> types;
+	std::vector<AIGraphNode*> nodes;
+
+	size_t size() const { return nodes.size(); }
+
+	float distance(uint32_t a, uint32_t b) const
+	{
+		float dx = x[a] - x[b], dy = y[a] - y[b], dz = z[a] - z[b];
+		return std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+};
+
+/**
+ * The scratch state of one search at a time, the labels of each node are
+ * reset lazily by comparing their stamp with the current search
+ */
+struct RoutePlanner::Search
+{
+	enum Side
+	{
+		Forward = 0,
+		Reverse = 1
+	};
+
+	const Network* network;
+	const std::vector<uint8_t>* disabled;
+
+	uint32_t current;
+	std::vector<uint32_t> stamps[2];
+	std::vector<float> costs[2];
+	std::vector<uint32_t> parents[2];
+	std::vector<uint8_t> closed[2];
+	OpenList open[2];
+
+	uint32_t start, goal;
+	uint8_t type;
+	size_t expanded;
+
+	Search()
+		: network(nullptr), disabled(nullptr), current(0), start(0), goal(0), type(0), expanded(0)
+	{
+	}
+
+	/**
+	 * Finds the route from one node index to another, appending the
+	 * indices along it to path
+	 */
+	bool find(const Network& net, const std::vector<uint8_t>& flags, Algorithm algorithm,
+			  uint32_t from, uint32_t to, std::vector<uint32_t>& path)
+	{
+		network = &net;
+		disabled = &flags;
+		if( stamps[Forward].size() < net.size() ) {
+			for( int side = 0; side < 2; ++side ) {
+				stamps[side].resize(net.size(), 0);
+				costs[side].resize(net.size());
+				parents[side].resize(net.size());
+				closed[side].resize(net.size());
+			}
+		}
+
+		if( flags[to] && to != from ) {
+			return false;
+		}
+		if( net.types[to] != net.types[from] ) {
+			return false;
+		}
+		if( algorithm == Bidirectional ) {
+			return bidirectional(from, to, path);
+		}
+		return aStar(from, to, path);
+	}
+
+	void begin(uint32_t from, uint32_t to)
+	{
+		if( ++current == 0 ) {
+			for( int side = 0; side < 2; ++side ) {
+				std::fill(stamps[side].begin(), stamps[side].end(), 0);
+			}
+			current = 1;
+		}
+		open[Forward].clear();
+		open[Reverse].clear();
+		start = from;
+		goal = to;
+		type = network->types[from];
+	}
+
+	void label(int side, uint32_t node)
+	{
+		if( stamps[side][node] != current ) {
+			stamps[side][node] = current;
+			costs[side][node] = kInfinity;
+			parents[side][node] = kNoNode;
+			closed[side][node] = false;
+		}
+	}
+
+	float cost(int side, uint32_t node) const
+	{
+		return stamps[side][node] == current ? costs[side][node] : kInfinity;
+	}
+
+	bool passable(uint32_t node) const
+	{
+		return node == start || (network->types[node] == type && ! (*disabled)[node]);
+	}
+
+	/// Appends the nodes from the start of side's search to node
+	void tracePath(int side, uint32_t node, std::vector<uint32_t>& path) const
+	{
+		size_t first = path.size();
+		for( ; node != kNoNode; node = parents[side][node] ) {
+			path.push_back(node);
+		}
+		if( side == Forward ) {
+			std::reverse(path.begin() + first, path.end());
+		}
+	}
+
+	bool aStar(uint32_t from, uint32_t to, std::vector<uint32_t>& path)
+	{
+		begin(from, to);
+		label(Forward, from);
+		costs[Forward][from] = 0.f;
+		pushOpen(open[Forward], network->distance(from, to), from);
+
+		while( ! open[Forward].empty() ) {
+			uint32_t node = popOpen(open[Forward]).second;
+			if( closed[Forward][node] ) {
+				continue;
+			}
+			closed[Forward][node] = true;
+			expanded++;
+
+			if( node == to ) {
+				tracePath(Forward, node, path);
+				return true;
+			}
+
+			float nodeCost = costs[Forward][node];
+			for( uint32_t e = network->edgeBegin[node]; e < network->edgeBegin[node + 1]; ++e ) {
+				uint32_t next = network->edgeTargets[e];
+				if( ! passable(next) ) {
+					continue;
+				}
+				label(Forward, next);
+				float nextCost = nodeCost + network->edgeCosts[e];
+				if( nextCost < costs[Forward][next] ) {
+					costs[Forward][next] = nextCost;
+					parents[Forward][next] = node;
+					pushOpen(open[Forward], nextCost + network->distance(next, to), next);
+				}
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * The forward search's potential, the reverse search uses the negative
+	 * of it so both searches see the same reduced edge costs
+	 */
+	float potential(uint32_t node) const
+	{
+		return (network->distance(node, goal) - network->distance(node, start)) * 0.5f;
+	}
+
+	/// The lowest key on side's open list, skipping nodes already closed
+	float topKey(int side)
+	{
+		auto& list = open[side];
+		while( ! list.empty() && closed[side][list.front().second] ) {
+			popOpen(list);
+		}
+		return list.empty() ? kInfinity : list.front().first;
+	}
+
+	bool bidirectional(uint32_t from, uint32_t to, std::vector<uint32_t>& path)
+	{
+		begin(from, to);
+		label(Forward, from);
+		costs[Forward][from] = 0.f;
+		pushOpen(open[Forward], potential(from), from);
+		label(Reverse, to);
+		costs[Reverse][to] = 0.f;
+		pushOpen(open[Reverse], -potential(to), to);
+
+		// The shortest route through a node labelled by both searches
+		float best = (from == to) ? 0.f : kInfinity;
+		uint32_t meeting = (from == to) ? from : kNoNode;
+
+		for( ;; ) {
+			float forwardKey = topKey(Forward);
+			float reverseKey = topKey(Reverse);
+			if( forwardKey + reverseKey >= best ) {
+				break;
+			}
+
+			int side = forwardKey <= reverseKey ? Forward : Reverse;
+			int other = 1 - side;
+			uint32_t node = popOpen(open[side]).second;
+			closed[side][node] = true;
+			expanded++;
+
+			float nodeCost = costs[side][node];
+			float sign = side == Forward ? 1.f : -1.f;
+			for( uint32_t e = network->edgeBegin[node]; e < network->edgeBegin[node + 1]; ++e ) {
+				uint32_t next = network->edgeTargets[e];
+				if( ! passable(next) ) {
+					continue;
+				}
+				label(side, next);
+				float nextCost = nodeCost + network->edgeCosts[e];
+				if( nextCost < costs[side][next] ) {
+					costs[side][next] = nextCost;
+					parents[side][next] = node;
+					pushOpen(open[side], nextCost + sign * potential(next), next);
+				}
+
+				float through = costs[side][next] + cost(other, next);
+				if( through < best ) {
+					best = through;
+					meeting = next;
+				}
+			}
+		}
+
+		if( meeting == kNoNode ) {
+			return false;
+		}
+		tracePath(Forward, meeting, path);
+		path.pop_back();
+		tracePath(Reverse, meeting, path);
+		return true;
+	}
+};
+
+/**
+ * Searches a snapshot of the network on a worker, the planner caches the
+ * result when it completes
+ */
+class RoutePlanner::RouteJob : public WorkJob
+{
+	RoutePlanner* planner;
+	NetworkPtr network;
+	DisabledPtr disabled;
+	std::unique_ptr<Search> search;
+	uint32_t generation;
+	uint32_t start, goal;
+	Algorithm algorithm;
+	Callback callback;
+
+	bool found;
+	Route route;
+
+public:
+	RouteJob(WorkContext* context, RoutePlanner* planner, uint32_t start, uint32_t goal,
+			 Algorithm algorithm, const Callback& callback)
+		: WorkJob(context)
+		, planner(planner)
+		, network(planner->network)
+		, disabled(planner->disabled)
+		, search(planner->takeSearch())
+		, generation(planner->cacheGeneration)
+		, start(start)
+		, goal(goal)
+		, algorithm(algorithm)
+		, callback(callback)
+		, found(false)
+	{
+	}
+
+	void work()
+	{
+		std::vector<uint32_t> path;
+		found = search->find(*network, *disabled, algorithm, start, goal, path);
+		route.reserve(path.size());
+		for( auto node : path ) {
+			route.push_back(network->nodes[node]);
+		}
+	}
+
+	void complete()
+	{
+		planner->returnSearch(std::move(search));
+		if( generation == planner->cacheGeneration ) {
+			planner->cacheRoute(routeKey(start, goal), found, route);
+		}
+		callback(route);
+	}
+};
+
+RoutePlanner::RoutePlanner(const AIGraph& graph, size_t cacheSize)
+	: graph(graph)
+	, networkRevision(0)
+	, capacity(cacheSize)
+	, cacheGeneration(0)
+	, stats{ 0, 0, 0 }
+{
+}
+
+RoutePlanner::~RoutePlanner()
+{
+}
+
+void RoutePlanner::updateNetwork()
+{
+	if( network && networkRevision == graph.revision ) {
+		return;
+	}
+
+	auto built = std::make_shared<Network>();
+	size_t count = graph.nodes.size();
+	built->nodes = graph.nodes;
+	built->x.reserve(count);
+	built->y.reserve(count);
+	built->z.reserve(count);
+	built->types.reserve(count);
+	built->edgeBegin.reserve(count + 1);
+
+	for( auto node : graph.nodes ) {
+		built->x.push_back(node->position.x);
+		built->y.push_back(node->position.y);
+		built->z.push_back(node->position.z);
+		built->types.push_back(node->type);
+	}
+
+	for( uint32_t n = 0; n < count; ++n ) {
+		built->edgeBegin.push_back(built->edgeTargets.size());
+		for( auto next : graph.nodes[n]->connections ) {
+			built->edgeTargets.push_back(next->index);
+			built->edgeCosts.push_back(built->distance(n, next->index));
+		}
+	}
+	built->edgeBegin.push_back(built->edgeTargets.size());
+
+	network = built;
+	networkRevision = graph.revision;
+	refreshDisabled();
+}
+
+void RoutePlanner::refreshDisabled()
+{
+	clearCache();
+	if( ! network ) {
+		return;
+	}
+
+	// Searches still running keep the flags they started with
+	auto flags = std::make_shared<std::vector<uint8_t>>(network->size());
+	for( size_t n = 0; n < network->size(); ++n ) {
+		(*flags)[n] = network->nodes[n]->disabled;
+	}
+	disabled = flags;
+}
+
+void RoutePlanner::clearCache()
+{
+	entries.clear();
+	index.clear();
+	cacheGeneration++;
+}
+
+std::unique_ptr<RoutePlanner::Search> RoutePlanner::takeSearch()
+{
+	if( spareSearches.empty() ) {
+		return std::unique_ptr<Search>(new Search);
+	}
+	auto search = std::move(spareSearches.back());
+	spareSearches.pop_back();
+	return search;
+}
+
+void RoutePlanner::returnSearch(std::unique_ptr<Search> search)
+{
+	stats.expanded += search->expanded;
+	search->expanded = 0;
+	spareSearches.push_back(std::move(search));
+}
+
+bool RoutePlanner::inNetwork(AIGraphNode* node) const
+{
+	return node != nullptr && node->index < network->size() && network->nodes[node->index] == node;
+}
+
+bool RoutePlanner::findCached(uint64_t key, bool& found, Route& out)
+{
+	auto it = index.find(key);
+	if( it == index.end() ) {
+		stats.misses++;
+		return false;
+	}
+
+	stats.hits++;
+	auto entry = it->second;
+	entries.splice(entries.begin(), entries, entry);
+	found = entry->found;
+	out.insert(out.end(), entry->route.begin(), entry->route.end());
+	return true;
+}
+
+void RoutePlanner::cacheRoute(uint64_t key, bool found, const Route& route)
+{
+	if( capacity == 0 ) {
+		return;
+	}
+
+	auto it = index.find(key);
+	if( it != index.end() ) {
+		entries.erase(it->second);
+		index.erase(it);
+	}
+
+	entries.push_front({ key, found, route });
+	index[key] = entries.begin();
+
+	while( entries.size() > capacity )
+	{
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
+
+bool RoutePlanner::findRoute(AIGraphNode* start, AIGraphNode* goal, Route& out, Algorithm algorithm)
+{
+	updateNetwork();
+	if( ! inNetwork(start) || ! inNetwork(goal) ) {
+		return false;
+	}
+
+	auto key = routeKey(start->index, goal->index);
+	bool found = false;
+	if( findCached(key, found, out) ) {
+		return found;
+	}
+
+	std::vector<uint32_t> path;
+	auto search = takeSearch();
+	found = search->find(*network, *disabled, algorithm, start->index, goal->index, path);
+	returnSearch(std::move(search));
+
+	Route route;
+	route.reserve(path.size());
+	for( auto node : path ) {
+		route.push_back(network->nodes[node]);
+	}
+	cacheRoute(key, found, route);
+	out.insert(out.end(), route.begin(), route.end());
+	return found;
+}
+
+bool RoutePlanner::findRoute(const glm::vec3& start, const glm::vec3& goal, AIGraphNode::NodeType type,
+							 Route& out, Algorithm algorithm)
+{
+	auto startNode = graph.findNearestNode(start, AIGraph::typeBit(type));
+	auto goalNode = graph.findNearestNode(goal, AIGraph::typeBit(type));
+	return findRoute(startNode, goalNode, out, algorithm);
+}
+
+void RoutePlanner::findRouteAsync(WorkContext* work, AIGraphNode* start, AIGraphNode* goal,
+								  const Callback& callback, Algorithm algorithm)
+{
+	updateNetwork();
+	if( ! inNetwork(start) || ! inNetwork(goal) ) {
+		callback(Route());
+		return;
+	}
+
+	Route route;
+	bool found = false;
+	if( findCached(routeKey(start->index, goal->index), found, route) ) {
+		callback(route);
+		return;
+	}
+
+	work->queueJob(new RouteJob(work, this, start->index, goal->index, algorithm, callback));
+}
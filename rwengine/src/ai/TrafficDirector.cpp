@@ -9,6 +9,64 @@
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtx/norm.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+	/**
+	 * Pedestrian positions bucketed into square cells at least as wide as
+	 * the distance tested, so a node only looks at the cells around it
+	 */
+	class PedestrianHash
+	{
+	public:
+		PedestrianHash(float cellSize)
+			: cellSize(cellSize) { }
+
+		void insert(const glm::vec3& position)
+		{
+			cells[key(cellCoord(position.x), cellCoord(position.y))].push_back(position);
+		}
+
+		bool anyWithin(const glm::vec3& position, float distance) const
+		{
+			int cx = cellCoord(position.x);
+			int cy = cellCoord(position.y);
+			float distance2 = distance * distance;
+			for( int x = cx - 1; x <= cx + 1; ++x ) {
+				for( int y = cy - 1; y <= cy + 1; ++y ) {
+					auto it = cells.find(key(x, y));
+					if( it == cells.end() ) {
+						continue;
+					}
+					for( auto& ped : it->second ) {
+						if( glm::distance2(position, ped) <= distance2 ) {
+							return true;
+						}
+					}
+				}
+			}
+			return false;
+		}
+
+	private:
+		float cellSize;
+		std::unordered_map<uint64_t, std::vector<glm::vec3>> cells;
+
+		int cellCoord(float world) const
+		{
+			return int(std::floor(world / cellSize));
+		}
+
+		static uint64_t key(int x, int y)
+		{
+			return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+		}
+	};
+}
+
 TrafficDirector::TrafficDirector(AIGraph* g, GameWorld* w)
 : graph( g ), world( w ), pedDensity(1.f), carDensity(1.f),
 maximumPedestrians(20), maximumCars(10)
@@ -24,32 +82,22 @@ std::vector< AIGraphNode* > TrafficDirector::findAvailableNodes(AIGraphNode::Nod
 	graph->gatherExternalNodesNear(near, radius, available);
 
 	float density = type == AIGraphNode::Vehicle ? carDensity : pedDensity;
-	float minDist = (10.f / density) * (10.f / density);
+	float minDist = 10.f / density;
 
-	// Determine if anything in the open set is blocked
-	for ( auto it = available.begin(); it != available.end(); )
+	// Find the pedestrians near any of the nodes once, rather than per node
+	std::vector<GameObject*> nearby;
+	world->query.sphere(near, radius + minDist, { GameObject::Character }, nearby);
+	PedestrianHash peds(minDist);
+	for ( auto obj : nearby )
 	{
-		bool blocked = false;
-		for ( auto obj : world->pedestrianPool.objects )
-		{
-			// Sanity check
-			if ( glm::distance2( (*it)->position, obj.second->getPosition() ) <= minDist )
-			{
-				blocked = true;
-				break;
-			}
-		}
-		
-		if ( blocked )
-		{
-			it = available.erase( it );
-		}
-		else
-		{
-			it++;
-		}
+		peds.insert(obj->getPosition());
 	}
 
+	// Determine if anything in the open set is blocked
+	available.erase( std::remove_if( available.begin(), available.end(),
+		[&]( AIGraphNode* node ) { return peds.anyWithin( node->position, minDist ); } ),
+		available.end() );
+
 	return available;
 }
 
@@ -68,7 +116,7 @@ void TrafficDirector::setDensity(AIGraphNode::NodeType type, float density)
 
 std::vector<GameObject*> TrafficDirector::populateNearby(const glm::vec3& center, float radius, int maxSpawn)
 {
-	int availablePeds = maximumPedestrians - world->pedestrianPool.objects.size();
+	int availablePeds = maximumPedestrians - world->pedestrianPool.size();
 
 	std::vector<GameObject*> created;
 
@@ -0,0 +1,158 @@
+#include "audio/AudioDevice.hpp"
+#include "audio/alCheck.hpp"
+#include <rw/defines.hpp>
+
+#include <AL/al.h>
+
+OpenALDevice::OpenALDevice(float referenceDistance, float maxDistance)
+	: referenceDistance(referenceDistance)
+	, maxDistance(maxDistance)
+{
+}
+
+unsigned int OpenALDevice::createBuffer(const char* data, size_t bytes, unsigned int sampleRate)
+{
+	ALuint buffer = 0;
+	alCheck(alGenBuffers(1, &buffer));
+	alCheck(alBufferData(buffer, AL_FORMAT_MONO16, data, bytes, sampleRate));
+	return buffer;
+}
+
+void OpenALDevice::deleteBuffer(unsigned int buffer)
+{
+	alCheck(alDeleteBuffers(1, &buffer));
+}
+
+unsigned int OpenALDevice::createSource()
+{
+	ALuint source = 0;
+	alCheck(alGenSources(1, &source));
+	alCheck(alSourcef(source, AL_PITCH, 1));
+	alCheck(alSourcef(source, AL_REFERENCE_DISTANCE, referenceDistance));
+	alCheck(alSourcef(source, AL_MAX_DISTANCE, maxDistance));
+	alCheck(alSource3f(source, AL_VELOCITY, 0, 0, 0));
+	return source;
+}
+
+void OpenALDevice::deleteSource(unsigned int source)
+{
+	alCheck(alSourceStop(source));
+	alCheck(alDeleteSources(1, &source));
+}
+
+void OpenALDevice::play(unsigned int source, unsigned int buffer, float gain, bool loop)
+{
+	alCheck(alSourceStop(source));
+	alCheck(alSourcei(source, AL_BUFFER, buffer));
+	alCheck(alSourcef(source, AL_GAIN, gain));
+	alCheck(alSourcei(source, AL_LOOPING, loop ? AL_TRUE : AL_FALSE));
+	alCheck(alSourcePlay(source));
+}
+
+void OpenALDevice::stop(unsigned int source)
+{
+	alCheck(alSourceStop(source));
+}
+
+bool OpenALDevice::isPlaying(unsigned int source)
+{
+	ALint state = 0;
+	alCheck(alGetSourcei(source, AL_SOURCE_STATE, &state));
+	return state == AL_PLAYING;
+}
+
+void OpenALDevice::setPosition(unsigned int source, const glm::vec3& position)
+{
+	alCheck(alSource3f(source, AL_POSITION, position.x, position.y, position.z));
+}
+
+void OpenALDevice::setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up)
+{
+	ALfloat orientation[] = { forward.x, forward.y, forward.z, up.x, up.y, up.z };
+	alCheck(alListener3f(AL_POSITION, position.x, position.y, position.z));
+	alCheck(alListenerfv(AL_ORIENTATION, orientation));
+}
+
+unsigned int NullAudioDevice::createBuffer(const char* data, size_t bytes, unsigned int sampleRate)
+{
+	RW_UNUSED(data);
+	float duration = sampleRate > 0 ? (bytes / 2) / float(sampleRate) : 0.f;
+	buffers.push_back({ true, duration });
+	bufferCount++;
+	uploadedBytes += bytes;
+	return buffers.size();
+}
+
+void NullAudioDevice::deleteBuffer(unsigned int buffer)
+{
+	if (buffer > 0 && buffer <= buffers.size() && buffers[buffer - 1].alive) {
+		buffers[buffer - 1].alive = false;
+		bufferCount--;
+	}
+}
+
+unsigned int NullAudioDevice::createSource()
+{
+	sources.push_back({ true, false, false, 0.f, glm::vec3() });
+	sourceCount++;
+	return sources.size();
+}
+
+void NullAudioDevice::deleteSource(unsigned int source)
+{
+	if (source > 0 && source <= sources.size() && sources[source - 1].alive) {
+		sources[source - 1].alive = false;
+		sources[source - 1].playing = false;
+		sourceCount--;
+	}
+}
+
+void NullAudioDevice::play(unsigned int source, unsigned int buffer, float gain, bool loop)
+{
+	RW_UNUSED(gain);
+	if (source == 0 || source > sources.size() || buffer == 0 || buffer > buffers.size()) {
+		return;
+	}
+
+	auto& s = sources[source - 1];
+	s.playing = true;
+	s.loop = loop;
+	s.remaining = buffers[buffer - 1].duration;
+	playCount++;
+}
+
+void NullAudioDevice::stop(unsigned int source)
+{
+	if (source > 0 && source <= sources.size()) {
+		sources[source - 1].playing = false;
+	}
+}
+
+bool NullAudioDevice::isPlaying(unsigned int source)
+{
+	return source > 0 && source <= sources.size() && sources[source - 1].playing;
+}
+
+void NullAudioDevice::setPosition(unsigned int source, const glm::vec3& position)
+{
+	if (source > 0 && source <= sources.size()) {
+		sources[source - 1].position = position;
+	}
+}
+
+void NullAudioDevice::setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up)
+{
+	RW_UNUSED(position);
+	RW_UNUSED(forward);
+	RW_UNUSED(up);
+}
+
+void NullAudioDevice::advance(float dt)
+{
+	for (auto& s : sources) {
+		if (s.playing && ! s.loop) {
+			s.remaining -= dt;
+			s.playing = s.remaining > 0.f;
+		}
+	}
+}
@@ -0,0 +1,201 @@
+#include "audio/MADDecoder.hpp"
+#include <rw/defines.hpp>
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	/// Bytes of the file read at a time
+	const size_t kInputSize = 16 * 1024;
+}
+
+inline signed int MADDecoder::scale(mad_fixed_t sample)
+{
+	/* round */
+	sample += (1L << (MAD_F_FRACBITS - 16));
+
+	/* clip */
+	if (sample >= MAD_F_ONE) {
+		sample = MAD_F_ONE - 1;
+	} else if (sample < -MAD_F_ONE) {
+		sample = -MAD_F_ONE;
+	}
+
+	/* quantize */
+	return sample >> (MAD_F_FRACBITS + 1 - 16);
+}
+
+mad_flow MADDecoder::ms_input(void* user, mad_stream* stream)
+{
+	MADDecoder* self = static_cast<MADDecoder*>(user);
+
+	if (self->stopping || self->inputEnded) {
+		return MAD_FLOW_STOP;
+	}
+
+	// Keep the part of a frame that didn't fit in the last read
+	size_t kept = 0;
+	if (stream->next_frame) {
+		kept = stream->bufend - stream->next_frame;
+		std::memmove(self->input.data(), stream->next_frame, kept);
+	}
+
+	size_t length = kept + fread(self->input.data() + kept, 1, kInputSize - kept, self->file);
+
+	if (feof(self->file)) {
+		// libmad needs some padding after the last frame to decode it
+		std::memset(self->input.data() + length, 0, MAD_BUFFER_GUARD);
+		length += MAD_BUFFER_GUARD;
+		self->inputEnded = true;
+	}
+
+	if (length == 0) {
+		return MAD_FLOW_STOP;
+	}
+
+	mad_stream_buffer(stream, self->input.data(), length);
+
+	return MAD_FLOW_CONTINUE;
+}
+
+mad_flow MADDecoder::ms_output(void* user, mad_header const* header, mad_pcm* pcm)
+{
+	MADDecoder* self = static_cast<MADDecoder*>(user);
+
+	self->sampleRate = header->samplerate;
+
+	mad_fixed_t const* left = pcm->samples[0];
+	mad_fixed_t const* right = pcm->channels > 1 ? pcm->samples[1] : pcm->samples[0];
+
+	auto& output = self->output;
+	output.resize(pcm->length * 2);
+	for (unsigned int s = 0; s < pcm->length; ++s) {
+		output[s * 2 + 0] = scale(left[s]);
+		output[s * 2 + 1] = scale(right[s]);
+	}
+
+	size_t written = 0;
+	while (written < output.size()) {
+		written += self->ring.write(output.data() + written, output.size() - written);
+		if (written == output.size()) {
+			break;
+		}
+
+		// Wait for the reader to make some space
+		std::unique_lock<std::mutex> lock(self->spaceMutex);
+		self->waitingForSpace = true;
+		// Pairs with the fence in read(): either the reader sees the flag,
+		// or the space it freed is seen here
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		self->spaceCondition.wait(lock, [&] {
+			return self->stopping || self->ring.space() > 0;
+		});
+		self->waitingForSpace = false;
+
+		if (self->stopping) {
+			return MAD_FLOW_STOP;
+		}
+	}
+
+	return MAD_FLOW_CONTINUE;
+}
+
+mad_flow MADDecoder::ms_error(void* user, mad_stream* stream, mad_frame* frame)
+{
+	RW_UNUSED(user);
+	RW_UNUSED(frame);
+
+	// Things like ID3 tags lose sync for a frame, decoding can carry on
+	if (MAD_RECOVERABLE(stream->error)) {
+		return MAD_FLOW_CONTINUE;
+	}
+
+	std::cerr << "libmad error: " << mad_stream_errorstr(stream) << std::endl;
+	return MAD_FLOW_BREAK;
+}
+
+MADDecoder::MADDecoder(size_t bufferSamples)
+	: file(nullptr)
+	, input(kInputSize + MAD_BUFFER_GUARD)
+	, inputEnded(false)
+	, ring(bufferSamples)
+	, sampleRate(0)
+	, finished(true)
+	, stopping(false)
+	, waitingForSpace(false)
+{
+}
+
+MADDecoder::~MADDecoder()
+{
+	close();
+}
+
+bool MADDecoder::open(const std::string& path)
+{
+	close();
+
+	file = fopen(path.c_str(), "rb");
+	if (file == nullptr) {
+		std::cerr << "Unable to open " << path << std::endl;
+		return false;
+	}
+
+	inputEnded = false;
+	sampleRate = 0;
+	finished = false;
+	stopping = false;
+	thread = std::thread(&MADDecoder::decode, this);
+
+	return true;
+}
+
+void MADDecoder::close()
+{
+	if (thread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(spaceMutex);
+			stopping = true;
+		}
+		spaceCondition.notify_one();
+		thread.join();
+	}
+
+	if (file) {
+		fclose(file);
+		file = nullptr;
+	}
+
+	ring.clear();
+	finished = true;
+}
+
+size_t MADDecoder::read(int16_t* samples, size_t count)
+{
+	size_t read = ring.read(samples, count);
+
+	// The ring's release store of the read position could otherwise be
+	// ordered after the load of the flag, missing a decoder about to wait
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (read > 0 && waitingForSpace) {
+		// Taking the lock makes sure the decoder is waiting before waking it
+		{
+			std::lock_guard<std::mutex> lock(spaceMutex);
+		}
+		spaceCondition.notify_one();
+	}
+
+	return read;
+}
+
+void MADDecoder::decode()
+{
+	mad_decoder decoder;
+	mad_decoder_init(&decoder, this,
+		ms_input, 0, 0, ms_output, ms_error, 0);
+	mad_decoder_run(&decoder, MAD_DECODER_MODE_SYNC);
+	mad_decoder_finish(&decoder);
+
+	finished = true;
+}
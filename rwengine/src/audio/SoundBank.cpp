@@ -0,0 +1,44 @@
+#include "audio/SoundBank.hpp"
+#include "audio/AudioDevice.hpp"
+
+#include <loaders/LoaderSDT.hpp>
+
+SoundBank::SoundBank(const LoaderSDT* archive, AudioDevice* device)
+	: archive(archive)
+	, device(device)
+	, buffers(archive->getAssetCount(), 0)
+	, loadedCount(0)
+	, loadedBytes(0)
+{
+}
+
+SoundBank::~SoundBank()
+{
+	for (unsigned int buffer : buffers) {
+		if (buffer != 0) {
+			device->deleteBuffer(buffer);
+		}
+	}
+}
+
+unsigned int SoundBank::getBuffer(size_t index)
+{
+	if (index >= buffers.size()) {
+		return 0;
+	}
+
+	unsigned int& buffer = buffers[index];
+	if (buffer == 0) {
+		const char* samples = archive->getSampleData(index);
+		if (samples == nullptr) {
+			return 0;
+		}
+
+		auto& info = archive->getAssetInfoByIndex(index);
+		buffer = device->createBuffer(samples, info.size, info.sampleRate);
+		loadedCount++;
+		loadedBytes += info.size;
+	}
+
+	return buffer;
+}
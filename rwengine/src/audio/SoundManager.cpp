@@ -2,7 +2,6 @@
 #include <audio/MADStream.hpp>
 
 #include "audio/alCheck.hpp"
-#include "audio/MADStream.hpp"
 
 #include <array>
 #include <iostream>
@@ -165,6 +164,49 @@ void SoundManager::stopMusic(const std::string& name)
 	}
 }
 
+void SoundManager::setSoundBank(const LoaderSDT* archive)
+{
+	// The voices may be playing buffers from the old bank
+	voices.reset();
+	soundBank.reset(new SoundBank(archive, &device));
+	voices.reset(new VoicePool(&device, soundBank.get()));
+}
+
+VoicePool::Handle SoundManager::playEffect(size_t index, const glm::vec3& position, int priority, float gain, bool loop)
+{
+	if (voices) {
+		return voices->play(index, position, priority, gain, loop);
+	}
+	return { 0, 0 };
+}
+
+void SoundManager::stopEffect(VoicePool::Handle handle)
+{
+	if (voices) {
+		voices->stop(handle);
+	}
+}
+
+void SoundManager::setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up)
+{
+	if (voices) {
+		voices->setListener(position, forward, up);
+	} else {
+		device.setListener(position, forward, up);
+	}
+}
+
+void SoundManager::update()
+{
+	for (auto& music : musics) {
+		music.second.update();
+	}
+
+	if (voices) {
+		voices->update();
+	}
+}
+
 void SoundManager::pause(bool p)
 {
 	if (backgroundNoise.length() > 0) {
@@ -0,0 +1,135 @@
+#include "audio/VoicePool.hpp"
+#include "audio/AudioDevice.hpp"
+#include "audio/SoundBank.hpp"
+
+VoicePool::VoicePool(AudioDevice* device, SoundBank* bank, size_t voiceCount, float maxDistance)
+	: device(device)
+	, bank(bank)
+	, maxDistance(maxDistance)
+{
+	voices.reserve(voiceCount);
+	freeVoices.reserve(voiceCount);
+	for (size_t v = 0; v < voiceCount; ++v) {
+		voices.push_back({ device->createSource(), 1, false, 0, glm::vec3() });
+		// Hand out the first voices first
+		freeVoices.push_back(voiceCount - 1 - v);
+	}
+}
+
+VoicePool::~VoicePool()
+{
+	for (auto& voice : voices) {
+		device->deleteSource(voice.source);
+	}
+}
+
+VoicePool::Handle VoicePool::play(size_t sound, const glm::vec3& position, int priority, float gain, bool loop)
+{
+	float distance2 = glm::dot(position - listener, position - listener);
+	unsigned int buffer = 0;
+	if (distance2 > maxDistance * maxDistance || (buffer = bank->getBuffer(sound)) == 0) {
+		stats.dropped++;
+		return { 0, 0 };
+	}
+
+	uint32_t index;
+	if ( ! freeVoices.empty()) {
+		index = freeVoices.back();
+		freeVoices.pop_back();
+	} else {
+		// Find the least important voice that's less important than this
+		Voice* victim = nullptr;
+		float victimDistance2 = 0.f;
+		for (auto& voice : voices) {
+			auto offset = voice.position - listener;
+			float d2 = glm::dot(offset, offset);
+			bool lessImportant = voice.priority < priority
+					|| (voice.priority == priority && d2 > distance2);
+			if ( ! lessImportant) {
+				continue;
+			}
+			if (victim == nullptr || voice.priority < victim->priority
+					|| (voice.priority == victim->priority && d2 > victimDistance2)) {
+				victim = &voice;
+				victimDistance2 = d2;
+			}
+		}
+
+		if (victim == nullptr) {
+			stats.dropped++;
+			return { 0, 0 };
+		}
+
+		index = victim - voices.data();
+		release(index);
+		freeVoices.pop_back();
+		stats.stolen++;
+	}
+
+	Voice& voice = voices[index];
+	voice.active = true;
+	voice.priority = priority;
+	voice.position = position;
+	device->setPosition(voice.source, position);
+	device->play(voice.source, buffer, gain, loop);
+	stats.played++;
+
+	return { index, voice.generation };
+}
+
+void VoicePool::stop(Handle handle)
+{
+	if (getVoice(handle)) {
+		release(handle.voice);
+	}
+}
+
+bool VoicePool::isPlaying(Handle handle) const
+{
+	return handle.voice < voices.size()
+			&& voices[handle.voice].active
+			&& voices[handle.voice].generation == handle.generation;
+}
+
+void VoicePool::setPosition(Handle handle, const glm::vec3& position)
+{
+	if (Voice* voice = getVoice(handle)) {
+		voice->position = position;
+		device->setPosition(voice->source, position);
+	}
+}
+
+void VoicePool::setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up)
+{
+	listener = position;
+	device->setListener(position, forward, up);
+}
+
+void VoicePool::update()
+{
+	for (uint32_t v = 0; v < voices.size(); ++v) {
+		if (voices[v].active && ! device->isPlaying(voices[v].source)) {
+			release(v);
+		}
+	}
+}
+
+VoicePool::Voice* VoicePool::getVoice(Handle handle)
+{
+	if (isPlaying(handle)) {
+		return &voices[handle.voice];
+	}
+	return nullptr;
+}
+
+void VoicePool::release(uint32_t v)
+{
+	Voice& voice = voices[v];
+	device->stop(voice.source);
+	voice.active = false;
+	// Handles to the old effect stop matching, 0 is kept for invalid handles
+	if (++voice.generation == 0) {
+		voice.generation = 1;
+	}
+	freeVoices.push_back(v);
+}
@@ -0,0 +1,128 @@
+#include <core/FrameStats.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace perf
+{
+
+namespace
+{
+	const char* kPhaseNames[FramePhaseCount] = {
+		"frame",
+		"tick",
+		"physics",
+		"script",
+		"build",
+		"sort",
+		"draw",
+	};
+
+	std::string escapeJSON(const std::string& text)
+	{
+		std::string escaped;
+		for( char c : text ) {
+			if( c == '"' || c == '\\' ) {
+				escaped += '\\';
+			}
+			escaped += c;
+		}
+		return escaped;
+	}
+
+	/// Nearest-rank percentile of sorted values
+	double percentile(const std::vector<double>& sorted, double p)
+	{
+		size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+		return sorted[std::max<size_t>(rank, 1) - 1];
+	}
+}
+
+const char* FrameStats::getPhaseName(FramePhase phase)
+{
+	return kPhaseNames[phase];
+}
+
+FrameStats::Summary FrameStats::summarise(FramePhase phase) const
+{
+	if( frames.empty() ) {
+		return { 0.0, 0.0, 0.0, 0.0, 0.0 };
+	}
+
+	std::vector<double> values;
+	values.reserve(frames.size());
+	double total = 0.0;
+	for( auto& frame : frames ) {
+		values.push_back(frame[phase]);
+		total += frame[phase];
+	}
+	std::sort(values.begin(), values.end());
+
+	return {
+		total / values.size(),
+		percentile(values, 50.0),
+		percentile(values, 95.0),
+		percentile(values, 99.0),
+		values.back()
+	};
+}
+
+bool FrameStats::writeCSV(const std::string& path) const
+{
+	std::ofstream out(path);
+	if( ! out ) {
+		return false;
+	}
+
+	out << "index";
+	for( int p = 0; p < FramePhaseCount; ++p ) {
+		out << "," << kPhaseNames[p];
+	}
+	out << "\n";
+
+	for( size_t f = 0; f < frames.size(); ++f ) {
+		out << f;
+		for( double time : frames[f].phases ) {
+			out << "," << time;
+		}
+		out << "\n";
+	}
+
+	return static_cast<bool>(out);
+}
+
+bool FrameStats::writeJSON(const std::string& path, const std::string& name) const
+{
+	std::ofstream out(path);
+	if( ! out ) {
+		return false;
+	}
+
+	out << "{\n\t\"name\": \"" << escapeJSON(name) << "\",\n"
+		<< "\t\"frames\": " << frames.size() << ",\n"
+		<< "\t\"summary\": {\n";
+	for( int p = 0; p < FramePhaseCount; ++p ) {
+		auto summary = summarise(static_cast<FramePhase>(p));
+		out << "\t\t\"" << kPhaseNames[p] << "\": {"
+			<< " \"mean\": " << summary.mean
+			<< ", \"p50\": " << summary.p50
+			<< ", \"p95\": " << summary.p95
+			<< ", \"p99\": " << summary.p99
+			<< ", \"max\": " << summary.max << " }"
+			<< (p + 1 < FramePhaseCount ? ",\n" : "\n");
+	}
+	out << "\t},\n\t\"times\": [\n";
+	for( size_t f = 0; f < frames.size(); ++f ) {
+		out << "\t\t[";
+		for( int p = 0; p < FramePhaseCount; ++p ) {
+			out << (p > 0 ? ", " : "") << frames[f].phases[p];
+		}
+		out << (f + 1 < frames.size() ? "],\n" : "]\n");
+	}
+	out << "\t]\n}\n";
+
+	return static_cast<bool>(out);
+}
+
+}
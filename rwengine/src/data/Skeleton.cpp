@@ -12,85 +12,82 @@ Skeleton::Skeleton()
 
 void Skeleton::setAllData(const Skeleton::FramesData& data)
 {
-	framedata = data;
+	framedata.clear();
+	hasData.clear();
+	for(auto& d : data)
+	{
+		addFrame(d.first, d.second);
+	}
 }
 
 const Skeleton::FrameData& Skeleton::getData(unsigned int frameIdx) const
 {
-	auto fdit = framedata.find(frameIdx);
-	if( fdit == framedata.end() )
+	if( frameIdx >= framedata.size() || ! hasData[frameIdx] )
 	{
 		return Skeleton::IdentityData;
 	}
 	
-	return fdit->second;
+	return framedata[frameIdx];
 }
 
 void Skeleton::setData(unsigned int frameIdx, const Skeleton::FrameData& data)
 {
-	framedata[frameIdx] = data;
+	addFrame(frameIdx, data) = data;
 }
 
 void Skeleton::setEnabled(ModelFrame* frame, bool enabled)
 {
-	auto fdit = framedata.find(frame->getIndex());
-	if( fdit != framedata.end() )
-	{
-		fdit->second.enabled = enabled;
-	}
-	else
-	{
-		FrameTransform tf { frame->getDefaultTranslation(), glm::quat_cast(frame->getDefaultRotation()) };
-		framedata.insert(
-			{frame->getIndex(),
-				{ tf, tf, enabled }
-			}
-		);
-	}
+	FrameTransform tf { frame->getDefaultTranslation(), glm::quat_cast(frame->getDefaultRotation()) };
+	addFrame(frame->getIndex(), { tf, tf, enabled }).enabled = enabled;
 }
 
 void Skeleton::setEnabled(unsigned int frameIdx, bool enabled)
 {
-	auto fdit = framedata.find(frameIdx);
-	if( fdit == framedata.end() )
+	addFrame(frameIdx, { Skeleton::IdentityTransform, Skeleton::IdentityTransform, enabled })
+			.enabled = enabled;
+}
+
+Skeleton::FrameData& Skeleton::addFrame(unsigned int frameIdx, const FrameData& initial)
+{
+	if( frameIdx >= framedata.size() )
 	{
-		framedata.insert(
-			{ frameIdx, { Skeleton::IdentityTransform, Skeleton::IdentityTransform, enabled } }
-		);
+		framedata.resize(frameIdx + 1, Skeleton::IdentityData);
+		hasData.resize(frameIdx + 1, 0);
 	}
-	else
+	if( ! hasData[frameIdx] )
 	{
-		fdit->second.enabled = enabled;
+		framedata[frameIdx] = initial;
+		hasData[frameIdx] = 1;
 	}
+	return framedata[frameIdx];
 }
 
 const Skeleton::FrameTransform& Skeleton::getInterpolated(unsigned int frameIdx) const
 {
-	auto itit = interpolateddata.find(frameIdx);
-	if( itit == interpolateddata.end() )
+	if( frameIdx >= interpolateddata.size() || ! hasInterpolated[frameIdx] )
 	{
 		return Skeleton::IdentityTransform;
 	}
 	
-	return itit->second;
+	return interpolateddata[frameIdx];
 }
 
 void Skeleton::interpolate(float alpha)
 {
-	interpolateddata.clear();
+	interpolateddata.resize(framedata.size());
+	hasInterpolated = hasData;
 	
-	for(auto i = framedata.begin(); i != framedata.end(); ++i)
+	for(size_t i = 0; i < framedata.size(); ++i)
 	{
-		auto& t2 = i->second.a.translation;
-		auto& t1 = i->second.b.translation;
+		if( ! hasData[i] ) continue;
+
+		auto& t2 = framedata[i].a.translation;
+		auto& t1 = framedata[i].b.translation;
 		
-		auto& r2 = i->second.a.rotation;
-		auto& r1 = i->second.b.rotation;
+		auto& r2 = framedata[i].a.rotation;
+		auto& r1 = framedata[i].b.rotation;
 		
-		interpolateddata.insert({
-			i->first,
-			{ glm::mix(t1, t2, alpha), glm::slerp(r1, r2, alpha) }
-		});
+		interpolateddata[i] = { glm::mix(t1, t2, alpha), glm::slerp(r1, r2, alpha) };
 	}
 }
 
@@ -106,15 +103,28 @@ glm::mat4 Skeleton::getMatrix(unsigned int frameIdx) const
 	return m;
 }
 
+glm::mat4 Skeleton::getCurrentMatrix(unsigned int frameIdx) const
+{
+	const FrameTransform& ft = getData(frameIdx).a;
+
+	glm::mat4 m;
+
+	m = glm::translate( m, ft.translation );
+	m = m * glm::mat4_cast( ft.rotation );
+
+	return m;
+}
+
 glm::mat4 Skeleton::getMatrix(ModelFrame* frame) const
 {
-	auto itit = interpolateddata.find(frame->getIndex());
-	if( itit != interpolateddata.end() )
+	unsigned int frameIdx = frame->getIndex();
+	if( frameIdx < interpolateddata.size() && hasInterpolated[frameIdx] )
 	{
+		auto& ft = interpolateddata[frameIdx];
 		glm::mat4 m;
 		
-		m = glm::translate( m, itit->second.translation );
-		m = m * glm::mat4_cast( itit->second.rotation );
+		m = glm::translate( m, ft.translation );
+		m = m * glm::mat4_cast( ft.rotation );
 		
 		return m;
 	}
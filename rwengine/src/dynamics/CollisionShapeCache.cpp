@@ -0,0 +1,337 @@
+#include <dynamics/CollisionShapeCache.hpp>
+#include <data/CollisionModel.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+	const char kCacheMagic[4] = { 'R', 'W', 'C', 'S' };
+	const uint32_t kCacheVersion = 1;
+	/// deSerializeInPlace needs the BVH data aligned like this
+	const unsigned int kBvhAlignment = 16;
+
+	/// Reads values from a cache file buffer, failing at the end of the data
+	class CacheReader
+	{
+		const std::string& buffer;
+		size_t cursor;
+
+	public:
+		CacheReader(const std::string& data)
+			: buffer(data), cursor(0) { }
+
+		template<class T> bool read(T& value)
+		{
+			if( buffer.size() - cursor < sizeof(T) ) {
+				return false;
+			}
+			memcpy(&value, buffer.data() + cursor, sizeof(T));
+			cursor += sizeof(T);
+			return true;
+		}
+
+		bool read(std::string& value)
+		{
+			uint32_t length;
+			if( ! read(length) || buffer.size() - cursor < length ) {
+				return false;
+			}
+			value.assign(buffer.data() + cursor, length);
+			cursor += length;
+			return true;
+		}
+	};
+
+	template<class T> void write(std::ostream& out, const T& value)
+	{
+		out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void write(std::ostream& out, const std::string& value)
+	{
+		write<uint32_t>(out, value.size());
+		out.write(value.data(), value.size());
+	}
+}
+
+CollisionShape::CollisionShape()
+	: compound(nullptr), vertArray(nullptr), mesh(nullptr)
+	, bvhBuffer(nullptr), loadedBvh(nullptr), meshHash(0), height(0.f)
+{
+}
+
+CollisionShape::~CollisionShape()
+{
+	delete compound;
+	for( btCollisionShape* shape : children ) {
+		delete shape;
+	}
+	delete vertArray;
+	if( loadedBvh ) {
+		// Constructed in the buffer by deSerializeInPlace
+		loadedBvh->~btOptimizedBvh();
+	}
+	if( bvhBuffer ) {
+		btAlignedFree(bvhBuffer);
+	}
+}
+
+CollisionShapeCache::CollisionShapeCache(const std::map<std::string, std::unique_ptr<CollisionModel>>& models)
+	: models(models)
+	, entries(new Entries)
+	, builtBvhs(0)
+{
+}
+
+std::shared_ptr<CollisionShape> CollisionShapeCache::get(const std::string& modelName)
+{
+	auto it = entries->shapes.find(modelName);
+	if( it != entries->shapes.end() ) {
+		if( auto shape = it->second.lock() ) {
+			return shape;
+		}
+	}
+
+	auto modelit = models.find(modelName);
+	if( modelit == models.end() ) {
+		return nullptr;
+	}
+
+	auto shape = build(modelName, *modelit->second);
+	entries->shapes[modelName] = shape;
+	return shape;
+}
+
+bool CollisionShapeCache::hasShape(const std::string& modelName) const
+{
+	return entries->shapes.find(modelName) != entries->shapes.end();
+}
+
+void CollisionShapeCache::Entries::release(const std::string& modelName, const CollisionShape& shape)
+{
+	shapes.erase(modelName);
+
+	// BVHs read from the cache are already kept
+	if( shape.mesh && ! shape.loadedBvh ) {
+		CachedBvh bvh;
+		bvh.meshHash = shape.meshHash;
+		if( serialiseBvh(shape.mesh->getOptimizedBvh(), bvh.data) ) {
+			bvhs[modelName] = std::move(bvh);
+		}
+	}
+}
+
+std::shared_ptr<CollisionShape> CollisionShapeCache::build(const std::string& modelName, const CollisionModel& model)
+{
+	std::weak_ptr<Entries> owner = entries;
+	std::shared_ptr<CollisionShape> shape(new CollisionShape, [owner, modelName](CollisionShape* released) {
+		if( auto cacheEntries = owner.lock() ) {
+			cacheEntries->release(modelName, *released);
+		}
+		delete released;
+	});
+	shape->compound = new btCompoundShape;
+
+	float colMin = std::numeric_limits<float>::max(),
+			colMax = std::numeric_limits<float>::lowest();
+
+	// Boxes
+	for( size_t i = 0; i < model.boxes.size(); ++i ) {
+		auto& box = model.boxes[i];
+		auto size = (box.max - box.min) / 2.f;
+		auto mid = (box.min + box.max) / 2.f;
+		btCollisionShape* bshape = new btBoxShape( btVector3(size.x, size.y, size.z)  );
+		btTransform t; t.setIdentity();
+		t.setOrigin(btVector3(mid.x, mid.y, mid.z));
+		shape->compound->addChildShape(t, bshape);
+
+		colMin = std::min(colMin, mid.z - size.z);
+		colMax = std::max(colMax, mid.z + size.z);
+
+		shape->children.push_back(bshape);
+	}
+
+	// Spheres
+	for( size_t i = 0; i < model.spheres.size(); ++i ) {
+		auto& sphere = model.spheres[i];
+		btCollisionShape* sshape = new btSphereShape(sphere.radius);
+		btTransform t; t.setIdentity();
+		t.setOrigin(btVector3(sphere.center.x, sphere.center.y, sphere.center.z));
+		shape->compound->addChildShape(t, sshape);
+
+		colMin = std::min(colMin, sphere.center.z - sphere.radius);
+		colMax = std::max(colMax, sphere.center.z + sphere.radius);
+
+		shape->children.push_back(sshape);
+	}
+
+	if( model.vertices.size() > 0 && model.indices.size() >= 3 ) {
+		shape->vertArray = new btTriangleIndexVertexArray(
+					model.indices.size()/3,
+					(int*) model.indices.data(),
+					sizeof(uint32_t)*3,
+					model.vertices.size(),
+					(btScalar*) &(model.vertices[0].x),
+				sizeof(glm::vec3));
+
+		shape->meshHash = hashMesh(model);
+		if( ! useCachedBvh(modelName, shape->meshHash, *shape) ) {
+			shape->mesh = new btBvhTriangleMeshShape(shape->vertArray, true);
+			builtBvhs++;
+		}
+		shape->mesh->setMargin(0.05f);
+		btTransform t; t.setIdentity();
+		shape->compound->addChildShape(t, shape->mesh);
+
+		shape->children.push_back(shape->mesh);
+	}
+
+	shape->height = colMax - colMin;
+
+	return shape;
+}
+
+bool CollisionShapeCache::useCachedBvh(const std::string& modelName, uint64_t meshHash, CollisionShape& shape)
+{
+	auto it = entries->bvhs.find(modelName);
+	if( it == entries->bvhs.end() ) {
+		return false;
+	}
+
+	// The entry is kept, so it's still saved and used if the shape is built again
+	const CachedBvh& cached = it->second;
+	if( cached.meshHash != meshHash ) {
+		return false;
+	}
+
+	void* buffer = btAlignedAlloc(cached.data.size(), kBvhAlignment);
+	memcpy(buffer, cached.data.data(), cached.data.size());
+	btOptimizedBvh* bvh = btOptimizedBvh::deSerializeInPlace(buffer, cached.data.size(), false);
+	if( bvh == nullptr ) {
+		btAlignedFree(buffer);
+		return false;
+	}
+
+	shape.bvhBuffer = buffer;
+	shape.loadedBvh = bvh;
+	shape.mesh = new btBvhTriangleMeshShape(shape.vertArray, true, false);
+	shape.mesh->setOptimizedBvh(bvh);
+	return true;
+}
+
+uint64_t CollisionShapeCache::hashMesh(const CollisionModel& model)
+{
+	// FNV-1a over the vertices and indices
+	uint64_t hash = 14695981039346656037ull;
+	auto hashBytes = [&](const void* data, size_t size) {
+		auto bytes = static_cast<const uint8_t*>(data);
+		for( size_t i = 0; i < size; ++i ) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+	};
+	hashBytes(model.vertices.data(), model.vertices.size() * sizeof(glm::vec3));
+	hashBytes(model.indices.data(), model.indices.size() * sizeof(uint32_t));
+	return hash;
+}
+
+bool CollisionShapeCache::serialiseBvh(btOptimizedBvh* bvh, std::string& out)
+{
+	if( bvh == nullptr ) {
+		return false;
+	}
+
+	unsigned int size = bvh->calculateSerializeBufferSize();
+	void* aligned = btAlignedAlloc(size, kBvhAlignment);
+	bool serialised = bvh->serializeInPlace(aligned, size, false);
+	out.assign(static_cast<char*>(aligned), size);
+	btAlignedFree(aligned);
+	return serialised;
+}
+
+bool CollisionShapeCache::loadCache(const std::string& path)
+{
+	std::ifstream cachefile(path.c_str(), std::ios_base::binary);
+	if( ! cachefile.is_open() ) {
+		return false;
+	}
+
+	std::string data(
+				(std::istreambuf_iterator<char>(cachefile)),
+				std::istreambuf_iterator<char>());
+	CacheReader reader(data);
+
+	char magic[4];
+	uint32_t version, count;
+	if( ! reader.read(magic) || memcmp(magic, kCacheMagic, 4) != 0 ||
+		! reader.read(version) || version != kCacheVersion ||
+		! reader.read(count) ) {
+		return false;
+	}
+
+	std::unordered_map<std::string, CachedBvh> loaded;
+	for( uint32_t i = 0; i < count; ++i ) {
+		std::string name;
+		CachedBvh bvh;
+		if( ! reader.read(name) || ! reader.read(bvh.meshHash) ||
+			! reader.read(bvh.data) ) {
+			return false;
+		}
+		loaded[name] = std::move(bvh);
+	}
+
+	entries->bvhs = std::move(loaded);
+	return true;
+}
+
+bool CollisionShapeCache::saveCache(const std::string& path) const
+{
+	std::ofstream cachefile(path.c_str(), std::ios_base::binary | std::ios_base::trunc);
+	if( ! cachefile.is_open() ) {
+		return false;
+	}
+
+	// Shapes in use that built their BVH, they replace any older entries
+	std::unordered_map<std::string, CachedBvh> built;
+	for( auto& entry : entries->shapes ) {
+		auto shape = entry.second.lock();
+		if( ! shape || ! shape->mesh || shape->loadedBvh ) {
+			continue;
+		}
+		CachedBvh& bvh = built[entry.first];
+		bvh.meshHash = shape->meshHash;
+		if( ! serialiseBvh(shape->mesh->getOptimizedBvh(), bvh.data) ) {
+			return false;
+		}
+	}
+
+	uint32_t count = built.size();
+	for( auto& entry : entries->bvhs ) {
+		if( built.find(entry.first) == built.end() ) {
+			count++;
+		}
+	}
+
+	write(cachefile, kCacheMagic);
+	write(cachefile, kCacheVersion);
+	write(cachefile, count);
+
+	for( auto& entry : built ) {
+		write(cachefile, entry.first);
+		write(cachefile, entry.second.meshHash);
+		write(cachefile, entry.second.data);
+	}
+
+	for( auto& entry : entries->bvhs ) {
+		if( built.find(entry.first) != built.end() ) {
+			continue;
+		}
+		write(cachefile, entry.first);
+		write(cachefile, entry.second.meshHash);
+		write(cachefile, entry.second.data);
+	}
+
+	return cachefile.good();
+}
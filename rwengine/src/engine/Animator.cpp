@@ -4,10 +4,51 @@
 #include <data/Skeleton.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-Animator::Animator(Model* model, Skeleton* skeleton)
+const AnimationBindingCache::Binding& AnimationBindingCache::get(const Model* model, const Animation* animation)
+{
+	std::lock_guard<std::mutex> lock( mutex );
+
+	auto& modelBindings = bindings[model];
+	auto it = modelBindings.find(animation);
+	if( it == modelBindings.end() )
+	{
+		Binding binding;
+		for( unsigned int f = 0; f < model->frames.size(); ++f )
+		{
+			auto bit = animation->bones.find( model->frames[f]->getName() );
+			if( bit != animation->bones.end() && bit->second->getKeyframeCount() > 0 )
+			{
+				binding.push_back({ bit->second, f });
+			}
+		}
+		it = modelBindings.insert({ animation, std::move(binding) }).first;
+	}
+
+	return it->second;
+}
+
+void AnimationBindingCache::removeModel(const Model* model)
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	bindings.erase(model);
+}
+
+size_t AnimationBindingCache::getBindingCount(const Model* model) const
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	auto it = bindings.find(model);
+	return it != bindings.end() ? it->second.size() : 0;
+}
+
+Animator::Animator(Model* model, Skeleton* skeleton, AnimationBindingCache* bindings)
 	: model(model)
 	, skeleton(skeleton)
+	, bindings(bindings)
 {
+	if( this->bindings == nullptr ) {
+		ownBindings.reset(new AnimationBindingCache);
+		this->bindings = ownBindings.get();
+	}
 }
 
 void Animator::tick(float dt)
@@ -16,29 +57,19 @@ void Animator::tick(float dt)
 		return;
 	}
 
-	struct BoneTransform
-	{
-		glm::vec3 translation;
-		glm::quat rotation;
-	};
+	size_t frameCount = model->frames.size();
+	pose.translations.resize(frameCount);
+	pose.rotations.resize(frameCount);
+	animated.assign(frameCount, 0);
 
 	// Blend all active animations together
-	std::map<unsigned int, BoneTransform> blendFrames;
-
 	for (AnimationState& state : animations)
 	{
 		RW_CHECK(state.animation != nullptr, "AnimationState with no animation");
 		if (state.animation == nullptr) continue;
 
-		if (state.boneInstances.size() == 0) {
-			for( unsigned int f = 0; f < model->frames.size(); ++f )
-			{
-				auto bit = state.animation->bones.find( model->frames[f]->getName() );
-				if( bit != state.animation->bones.end() )
-				{
-					state.boneInstances.insert( { bit->second, { f } } );
-				}
-			}
+		if (state.bones == nullptr) {
+			bindBones(state);
 		}
 
 		state.time = state.time + dt;
@@ -53,53 +84,73 @@ void Animator::tick(float dt)
 			animTime = fmod(animTime, state.animation->duration);
 		}
 
-		for( auto& b : state.boneInstances )
-		{
-			if (b.first->frames.size() == 0) continue;
-			auto kf = b.first->getInterpolatedKeyframe(animTime);
-
-			BoneTransform xform;
-			if(b.first->type == AnimationBone::R00 ) {
-				xform.rotation = kf.rotation;
-			}
-			else if(b.first->type == AnimationBone::RT0) {
-				xform.rotation = kf.rotation;
-				xform.translation = kf.position;
-			}
-			else {
-				xform.rotation = kf.rotation;
-				xform.translation = kf.position;
-			}
-
-#if 0
-			auto prevAnim = blendFrames.find(b.second.frameIndex);
-			if (prevAnim != blendFrames.end())
-			{
-				prevAnim->second.translation += xform.translation;
-				prevAnim->second.rotation *= xform.rotation;
-			}
-			else
-			{
-				blendFrames[b.second.frameIndex] = xform;
-			}
-#else
-			blendFrames[b.second.frameIndex] = xform;
-#endif
-		}
+		sampleBones(state, animTime);
+		blendBones(state);
 	}
 
-	for (auto& p : blendFrames)
+	for (unsigned int f = 0; f < frameCount; ++f)
 	{
-		auto& data = skeleton->getData(p.first);
+		if (! animated[f]) continue;
+
+		auto& data = skeleton->getData(f);
 		Skeleton::FrameData fd;
 		fd.b = data.a;
 		fd.enabled = data.enabled;
 
-		fd.a.translation = model->frames[p.first]->getDefaultTranslation()
-				+ p.second.translation;
-		fd.a.rotation = p.second.rotation;
+		fd.a.translation = model->frames[f]->getDefaultTranslation()
+				+ pose.translations[f];
+		fd.a.rotation = pose.rotations[f];
+
+		skeleton->setData(f, fd);
+	}
+}
+
+void Animator::bindBones(AnimationState& state)
+{
+	state.bones = &bindings->get(model, state.animation);
+	state.cursors.assign(state.bones->size(), 0);
+}
+
+void Animator::sampleBones(AnimationState& state, float time)
+{
+	size_t count = state.bones->size();
+	samples.translations.resize(count);
+	samples.rotations.resize(count);
 
-		skeleton->setData(p.first, fd);
+	for( size_t i = 0; i < count; ++i )
+	{
+		(*state.bones)[i].first->interpolate(time, state.cursors[i],
+											 samples.rotations[i], samples.translations[i]);
+	}
+}
+
+void Animator::blendBones(const AnimationState& state)
+{
+	size_t count = state.bones->size();
+	float weight = glm::clamp(state.weight, 0.f, 1.f);
+
+	if( weight >= 1.f ) {
+		for( size_t i = 0; i < count; ++i )
+		{
+			unsigned int f = (*state.bones)[i].second;
+			pose.translations[f] = samples.translations[i];
+			pose.rotations[f] = samples.rotations[i];
+			animated[f] = 1;
+		}
+		return;
+	}
+
+	for( size_t i = 0; i < count; ++i )
+	{
+		unsigned int f = (*state.bones)[i].second;
+		if( ! animated[f] ) {
+			// Nothing before this slot moved the frame, so blend from its rest pose
+			pose.translations[f] = glm::vec3(0.f);
+			pose.rotations[f] = glm::quat_cast(model->frames[f]->getDefaultRotation());
+			animated[f] = 1;
+		}
+		pose.translations[f] = glm::mix(pose.translations[f], samples.translations[i], weight);
+		pose.rotations[f] = glm::slerp(pose.rotations[f], samples.rotations[i], weight);
 	}
 }
 
@@ -82,7 +82,9 @@ std::string fixPath(std::string path) {
 
 
 GameData::GameData(Logger* log, WorkContext* work, const std::string& path)
-: datpath(path), logger(log), workContext(work), engine(nullptr)
+: datpath(path), logger(log), workContext(work)
+, objectTypesHash(0), objectTypesHashed(false), engine(nullptr)
+, collisionShapes(collisions)
 {
 }
 
@@ -118,9 +120,11 @@ void GameData::load()
 	loadWeaponDAT(datpath+"/data/weapon.dat");
 
 	loadIFP("ped.ifp");
+
+	loadSoundEffects();
 }
 
-void GameData::parseDAT(const std::string& path)
+void GameData::parseDAT(const std::string& path, bool locationsOnly)
 {
 	std::ifstream datfile(path.c_str());
 	
@@ -143,6 +147,10 @@ void GameData::parseDAT(const std::string& path)
 				{
 					addIDE(line.substr(space+1));
 				}
+				else if(locationsOnly && cmd != "IPL")
+				{
+					continue;
+				}
 				else if(cmd == "SPLASH")
 				{
 					splash = line.substr(space+1);
@@ -197,7 +205,20 @@ bool GameData::loadObjects(const std::string& name)
 	LoaderIDE idel;
 	
 	if(idel.load(path)) {
-		objectTypes.insert(idel.objects.begin(), idel.objects.end());
+		objectTypesHashed = false;
+		for( auto& object : idel.objects ) {
+			// Earlier definitions win, as with inserting them all at once
+			if( ! objectTypes.insert(object).second ) {
+				continue;
+			}
+			if( object.second->class_type == ObjectData::class_id ) {
+				auto name = static_cast<ObjectData*>(object.second.get())->modelID;
+				auto it = modelObjects.find(name);
+				if( it == modelObjects.end() || object.first < it->second ) {
+					modelObjects[name] = object.first;
+				}
+			}
+		}
 	}
 	else {
 		logger->error("Data", "Failed to load IDE " + path);
@@ -206,24 +227,20 @@ bool GameData::loadObjects(const std::string& name)
 	return false;
 }
 
-#include <strings.h>
-uint16_t GameData::findModelObject(const std::string model)
-{
-	// Dear C++ Why do I have to resort to strcasecmp this isn't C.
-	auto defit = std::find_if(objectTypes.begin(), objectTypes.end(),
-							  [&](const decltype(objectTypes)::value_type& d)
-							  {
-								  if(d.second->class_type == ObjectInformation::_class("OBJS"))
-								  {
-									  auto dat = static_cast<ObjectData*>(d.second.get());
-									  return strcasecmp(dat->modelName.c_str(), model.c_str()) == 0;
-								  }
-								  return false;
-							  });
-	if( defit != objectTypes.end() ) return defit->first;
+int GameData::findModelObject(const std::string model)
+{
+	auto it = modelObjects.find(modelID(model));
+	if( it != modelObjects.end() ) return it->second;
 	return -1;
 }
 
+StringID GameData::modelID(const std::string& name)
+{
+	std::string lowerName(name);
+	std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+	return StringTable::get().intern(lowerName);
+}
+
 void GameData::loadCOL(const size_t zone, const std::string& name)
 {
 	RW_UNUSED(zone);
@@ -252,14 +269,14 @@ void GameData::loadIPL(const std::string& name)
 
 bool GameData::loadZone(const std::string& path)
 {
-	LoaderIPL ipll;
+	WorldCache ipl;
 	
-	if( ipll.load(path)) {
-		if( ipll.zones.size() > 0) {
-			for(auto& z : ipll.zones) {
+	if( loadWorldCache(path, ipl) ) {
+		if( ipl.zones.size() > 0) {
+			for(auto& z : ipl.zones) {
 				zones.insert({z.name, z});
 			}
-			logger->info("Data", "Loaded " + std::to_string(ipll.zones.size()) + " zones from " + path);
+			logger->info("Data", "Loaded " + std::to_string(ipl.zones.size()) + " zones from " + path);
 			return true;
 		}
 	}
@@ -270,6 +287,63 @@ bool GameData::loadZone(const std::string& path)
 	return false;
 }
 
+bool GameData::loadWorldCache(const std::string& path, WorldCache& cache)
+{
+	uint64_t sourceHash;
+	if( ! WorldCache::hashFile(path, sourceHash) ) {
+		return false;
+	}
+
+	std::string cachePath;
+	if( ! worldCachePath.empty() ) {
+		cachePath = getWorldCachePath(path);
+		if( cache.load(cachePath) && cache.sourceHash == sourceHash &&
+			cache.objectHash == getObjectTypesHash() ) {
+			return true;
+		}
+	}
+
+	LoaderIPL ipll;
+	if( ! ipll.load(path) ) {
+		return false;
+	}
+
+	cache = WorldCache::build(ipll, sourceHash, getObjectTypesHash(), objectTypes);
+
+	if( ! cachePath.empty() && ! cache.save(cachePath) ) {
+		logger->warning("Data", "Unable to write world cache " + cachePath);
+	}
+
+	return true;
+}
+
+uint64_t GameData::getObjectTypesHash()
+{
+	if( ! objectTypesHashed ) {
+		objectTypesHash = WorldCache::hashObjects(objectTypes);
+		objectTypesHashed = true;
+	}
+	return objectTypesHash;
+}
+
+std::string GameData::getWorldCachePath(const std::string& path) const
+{
+	std::string name = path;
+	if( ! datpath.empty() && name.compare(0, datpath.size(), datpath) == 0 ) {
+		name = name.substr(datpath.size());
+	}
+
+	// Flatten the directories so files with the same name don't collide
+	for( auto& c : name ) {
+		if( c == '/' || c == '\\' ) {
+			c = '_';
+		}
+	}
+	name.erase(0, name.find_first_not_of('_'));
+
+	return worldCachePath + "/" + name + ".bin";
+}
+
 enum ColSection {
 	Unknown,
 	COL,
@@ -424,12 +498,11 @@ void GameData::loadTXD(const std::string& name, bool async)
 
 	loadedFiles[name] = true;
 
-	auto j = new LoadTextureArchiveJob(workContext, &index, textures, name);
-
 	if( async ) {
-		workContext->queueJob( j );
+		workContext->queueJob( new LoadTextureArchiveJob(workContext, &index, textures, name, &textureUploads) );
 	}
 	else {
+		auto j = new LoadTextureArchiveJob(workContext, &index, textures, name);
 		j->work();
 		j->complete();
 		delete j;
@@ -439,17 +512,25 @@ void GameData::loadTXD(const std::string& name, bool async)
 void GameData::loadDFF(const std::string& name, bool async)
 {
 	auto realname = name.substr(0, name.size() - 4);
-	if( models.find(realname) != models.end() ) {
+	auto id = modelID(realname);
+	auto it = models.find(id);
+	if( it != models.end() && it->second->state != RW::Unloaded ) {
 		return;
 	}
 
 	// Before starting the job make sure the file isn't loaded again.
 	loadedFiles.insert({name, true});
 
-	models[realname] = ModelRef( new ResourceHandle<Model>(realname) );
+	if( it != models.end() ) {
+		// Reuse the handle, instances still refer to it
+		it->second->state = RW::Loading;
+	}
+	else {
+		models[id] = ModelRef( new ResourceHandle<Model>(realname) );
+	}
 	
 	auto job = new BackgroundLoaderJob<Model, LoaderDFF> 
-	{ workContext, &this->index, name, models[realname] };
+	{ workContext, &this->index, name, models[id] };
 
 	if( async ) {
 		workContext->queueJob( job  );
@@ -528,6 +609,20 @@ bool GameData::loadAudioClip(const std::string& name, const std::string& fileNam
 	return true;
 }
 
+bool GameData::loadSoundEffects()
+{
+	// The loader wants the path without an extension
+	auto sdtPath = findPathRealCase(datpath + "/audio/", "sfx.sdt");
+	auto basePath = sdtPath.substr(0, sdtPath.size() - 4);
+
+	if ( ! soundEffects.load(basePath)) {
+		logger->error("Data", "Failed to load sound effects " + sdtPath);
+		return false;
+	}
+
+	return true;
+}
+
 void GameData::loadSplash(const std::string &name)
 {
 	std::string lower(name);
@@ -1,10 +1,11 @@
 #include <engine/GameWorld.hpp>
 #include <engine/GameData.hpp>
 #include <engine/GameState.hpp>
+#include <engine/StreamingManager.hpp>
 
 #include <core/Logger.hpp>
 
-#include <loaders/LoaderIPL.hpp>
+#include <loaders/WorldCache.hpp>
 #include <loaders/LoaderIDE.hpp>
 #include <ai/DefaultAIController.hpp>
 #include <ai/TrafficDirector.hpp>
@@ -24,6 +25,16 @@
 #include <data/CutsceneData.hpp>
 #include <loaders/LoaderCutsceneDAT.hpp>
 
+namespace
+{
+	// The deepest static nodes are 62.5m wide
+	constexpr unsigned int kSpatialIndexDepth = 7;
+	constexpr float kDynamicCellSize = 50.f;
+	constexpr float kMinimumDynamicRadius = 2.f;
+	/// Most objects have little to do in parallel, so share them out in bulk
+	constexpr size_t kTickChunkSize = 64;
+}
+
 class WorldCollisionDispatcher : public btCollisionDispatcher
 {
 public:
@@ -78,7 +89,12 @@ public:
 };
 
 GameWorld::GameWorld(Logger* log, WorkContext* work, GameData* dat)
-	: logger(log), data(dat), randomEngine(rand()),
+	: logger(log), data(dat),
+	  spatialIndex(WORLD_GRID_SIZE, kSpatialIndexDepth, kDynamicCellSize),
+	  query(spatialIndex),
+	  streaming(nullptr),
+	  routes(aigraph),
+	  randomEngine(rand()),
 	  _work( work ),
 	  paused(false)
 {
@@ -94,6 +110,10 @@ GameWorld::GameWorld(Logger* log, WorkContext* work, GameData* dat)
 	gContactProcessedCallback = ContactProcessedCallback;
 	dynamicsWorld->setInternalTickCallback(PhysicsTickCallback, this);
 
+	if( data->soundEffects.getAssetCount() > 0 ) {
+		sound.setSoundBank(&data->soundEffects);
+	}
+
 	// Populate inventory items
 	for( auto& w : data->weaponData ) {
 		inventoryItems.push_back(
@@ -109,6 +129,8 @@ GameWorld::~GameWorld()
 		delete p;
 	}
 
+	delete streaming;
+
 	delete dynamicsWorld;
 	delete solver;
 	delete broadphase;
@@ -122,27 +144,48 @@ bool GameWorld::placeItems(const std::string& name)
 {
 	std::string path = name;
 	
-	LoaderIPL ipll;
+	WorldCache ipl;
 
-	if(ipll.load(path))
+	if(data->loadWorldCache(path, ipl))
 	{
-		// Find the object.
-		for( size_t i = 0; i < ipll.m_instances.size(); ++i) {
-			std::shared_ptr<InstanceData> inst = ipll.m_instances[i];
-			if(! createInstance(inst->id, inst->pos, inst->rot)) {
-				logger->error("World", "No object data for instance " + std::to_string(inst->id) + " in " + path);
+		std::vector<InstanceObject*> placed;
+		placed.reserve(ipl.instances.size());
+
+		for( auto& inst : ipl.instances ) {
+			auto instance = createInstance(inst.id, inst.position, inst.rotation);
+			if( ! instance ) {
+				logger->error("World", "No object data for instance " + std::to_string(inst.id) + " in " + path);
 			}
+			placed.push_back(instance);
 		}
-		
-		// Attempt to Associate LODs.
-		for(auto& p: instancePool.objects) {
-			auto object = p.second;
-			InstanceObject* instance = static_cast<InstanceObject*>(object);
-			if( !instance->object->LOD ) {
-				auto lodInstit = modelInstances.find("LOD" + instance->object->modelName.substr(3));
-				if( lodInstit != modelInstances.end() ) {
-					instance->LODinstance = lodInstit->second;
-				}
+
+		// LODs in the same file are already resolved to an index
+		for( size_t i = 0; i < placed.size(); ++i ) {
+			auto instance = placed[i];
+			int32_t lod = ipl.instances[i].lod;
+			if( instance == nullptr || lod == WorldCache::NoLOD ) {
+				continue;
+			}
+			if( lod == WorldCache::ExternalLOD ) {
+				unlinkedLODs.push_back(instance);
+			}
+			else if( placed[lod] ) {
+				instance->LODinstance = placed[lod];
+				spatialIndex.update(instance, getIndexRadius(instance));
+			}
+		}
+
+		// Attempt to associate LODs placed by other files
+		for( auto it = unlinkedLODs.begin(); it != unlinkedLODs.end(); ) {
+			auto instance = *it;
+			auto lodInstit = modelInstances.find(instance->object->lodModelID);
+			if( lodInstit != modelInstances.end() ) {
+				instance->LODinstance = lodInstit->second;
+				spatialIndex.update(instance, getIndexRadius(instance));
+				it = unlinkedLODs.erase(it);
+			}
+			else {
+				++it;
 			}
 		}
 		
@@ -168,17 +211,23 @@ InstanceObject *GameWorld::createInstance(const uint16_t id, const glm::vec3& po
 		std::transform(std::begin(modelname), std::end(modelname), std::begin(modelname), tolower);
 		std::transform(std::begin(texturename), std::end(texturename), std::begin(texturename), tolower);
 
-		// Ensure the relevant data is loaded.
-		if(! oi->modelName.empty()) {
-			if( modelname != "null" ) {
-				data->loadDFF(modelname + ".dff", false);
+		// Ensure the relevant data is loaded, unless it's streamed in later.
+		if( streaming == nullptr ) {
+			if(! oi->modelName.empty()) {
+				if( modelname != "null" ) {
+					data->loadDFF(modelname + ".dff", false);
+				}
+			}
+			if(! texturename.empty()) {
+				data->loadTXD(texturename + ".txd", true);
 			}
-		}
-		if(! texturename.empty()) {
-			data->loadTXD(texturename + ".txd", true);
 		}
 
-		ModelRef m = data->models[modelname];
+		ModelRef& m = data->models[oi->modelID];
+		if( ! m && streaming != nullptr && ! modelname.empty() && modelname != "null" ) {
+			m = ModelRef( new ResourceHandle<Model>(modelname) );
+			m->state = RW::Unloaded;
+		}
 
 		// Check for dynamic data.
 		auto dyit = data->dynamicObjectData.find(oi->modelName);
@@ -202,14 +251,10 @@ InstanceObject *GameWorld::createInstance(const uint16_t id, const glm::vec3& po
 
 		instancePool.insert(instance);
         allObjects.push_back(instance);
-
-		if( shouldBeOnGrid(instance) )
-		{
-			addToGrid( instance );
-		}
+		addToIndex(instance);
 
 		modelInstances.insert({
-			oi->modelName,
+			oi->modelID,
 			instance
 		});
 
@@ -228,16 +273,16 @@ void GameWorld::createTraffic(const glm::vec3& near)
 
 void GameWorld::cleanupTraffic(const glm::vec3& focus)
 {
-	for ( auto& p : pedestrianPool.objects )
+	for ( auto object : pedestrianPool )
 	{
-		if ( p.second->getLifetime() != GameObject::TrafficLifetime )
+		if ( object->getLifetime() != GameObject::TrafficLifetime )
 		{
 			continue;
 		}
 		
-		if ( glm::distance( focus, p.second->getPosition() ) >= 100.f )
+		if ( glm::distance( focus, object->getPosition() ) >= 100.f )
 		{
-			destroyObjectQueued( p.second );
+			destroyObjectQueued( object );
 		}
 	}
 	destroyQueuedObjects();
@@ -307,7 +352,7 @@ CutsceneObject *GameWorld::createCutsceneObject(const uint16_t id, const glm::ve
 	}
 
 
-	ModelRef m = data->models[modelname];
+	ModelRef m = data->models[GameData::modelID(modelname)];
 
 	auto instance = new CutsceneObject(
 		this,
@@ -355,7 +400,7 @@ VehicleObject *GameWorld::createVehicle(const uint16_t id, const glm::vec3& pos,
 			}
 		}
 		
-		ModelRef& m = data->models[vti->modelName];
+		ModelRef& m = data->models[GameData::modelID(vti->modelName)];
 		auto model = m->resource;
 		auto info = data->vehicleInfo.find(vti->handlingID);
 		if(model && info != data->vehicleInfo.end()) {
@@ -383,6 +428,7 @@ VehicleObject *GameWorld::createVehicle(const uint16_t id, const glm::vec3& pos,
 
 		vehiclePool.insert( vehicle );
         allObjects.push_back( vehicle );
+		addToIndex(vehicle);
 
 		return vehicle;
 	}
@@ -417,7 +463,7 @@ CharacterObject* GameWorld::createPedestrian(const uint16_t id, const glm::vec3&
 			data->loadTXD(texturename + ".txd");
 		}
 
-		ModelRef m = data->models[modelname];
+		ModelRef m = data->models[GameData::modelID(modelname)];
 
 		if(m && m->resource) {
 			auto ped = new CharacterObject( this, pos, rot, m, pt );
@@ -425,6 +471,7 @@ CharacterObject* GameWorld::createPedestrian(const uint16_t id, const glm::vec3&
 			new DefaultAIController(ped);
 			pedestrianPool.insert( ped );
             allObjects.push_back( ped );
+			addToIndex(ped);
 			return ped;
 		}
 	}
@@ -444,7 +491,7 @@ CharacterObject* GameWorld::createPlayer(const glm::vec3& pos, const glm::quat&
 		data->loadDFF(modelname + ".dff");
 		data->loadTXD(texturename + ".txd");
 
-		ModelRef m = data->models[modelname];
+		ModelRef m = data->models[GameData::modelID(modelname)];
 
 		if(m && m->resource) {
 			auto ped = new CharacterObject( this, pos, rot, m, nullptr );
@@ -453,6 +500,7 @@ CharacterObject* GameWorld::createPlayer(const glm::vec3& pos, const glm::quat&
 			players.push_back(new PlayerController(ped));
 			pedestrianPool.insert(ped);
             allObjects.push_back( ped );
+			addToIndex(ped);
 			return ped;
 		}
 	}
@@ -485,45 +533,12 @@ PickupObject* GameWorld::createPickup(const glm::vec3& pos, int id, int type)
 
 	pickupPool.insert(pickup);
 	allObjects.push_back(pickup);
+	addToIndex(pickup);
 
 	return pickup;
 }
 
-void GameWorld::ObjectPool::insert(GameObject* object)
-{
-	if( object->getGameObjectID() == 0 )
-	{
-		// Find the lowest free GameObjectID.
-		GameObjectID availID = 1;
-		for( auto& p : objects )
-		{
-			if( p.first == availID ) availID++;
-		}
-
-		object->setGameObjectID( availID );
-	}
-	objects[object->getGameObjectID()] = object;
-}
-
-GameObject* GameWorld::ObjectPool::find(GameObjectID id) const
-{
-	auto it = objects.find( id );
-	return (it == objects.end())? nullptr : it->second;
-}
-
-void GameWorld::ObjectPool::remove(GameObject* object)
-{
-	if( object )
-	{
-		auto it = objects.find(object->getGameObjectID());
-		if( it != objects.end() ) {
-			it = objects.erase(it);
-		}
-	}
-}
-
-
-GameWorld::ObjectPool& GameWorld::getTypeObjectPool(GameObject* object)
+ObjectPool& GameWorld::getTypeObjectPool(GameObject* object)
 {
 	switch( object->type() ) {
 		case GameObject::Character:
@@ -561,14 +576,17 @@ GameObject*GameWorld::getBlipTarget(const BlipData& blip) const
 
 void GameWorld::destroyObject(GameObject* object)
 {
-	auto coord = worldToGrid(glm::vec2(object->getPosition()));
-	if( coord.x < 0 || coord.y < 0 || coord.x >= WORLD_GRID_WIDTH || coord.y >= WORLD_GRID_WIDTH )
-	{
-		return;
+	spatialIndex.remove(object);
+
+	if( object->type() == GameObject::Instance ) {
+		unlinkedLODs.erase(
+					std::remove(unlinkedLODs.begin(), unlinkedLODs.end(), object),
+					unlinkedLODs.end());
 	}
-	auto index = (coord.x * WORLD_GRID_WIDTH) + coord.y;
-	worldGrid[index].instances.erase(object);
-	
+	unloadedModelObjects.erase(
+				std::remove(unloadedModelObjects.begin(), unloadedModelObjects.end(), object),
+				unloadedModelObjects.end());
+
 	auto& pool = getTypeObjectPool(object);
 	pool.remove(object);
 
@@ -588,6 +606,31 @@ void GameWorld::destroyObjectQueued(GameObject *object)
 		deletionQueue.insert(object);
 }
 
+void GameWorld::tickObjects(float dt)
+{
+	updateUnloadedModels();
+
+	size_t count = allObjects.size();
+
+	_work->parallelFor(count, kTickChunkSize, [&](size_t begin, size_t end) {
+		for( size_t i = begin; i < end; ++i ) {
+			allObjects[i]->_updateLastTransform();
+			allObjects[i]->tickParallel(dt);
+		}
+	});
+
+	// Anything that changes the world happens in the same order every time
+	for( size_t i = 0; i < count; ++i ) {
+		allObjects[i]->tick(dt);
+	}
+
+	_work->parallelFor(count, kTickChunkSize, [&](size_t begin, size_t end) {
+		for( size_t i = begin; i < end; ++i ) {
+			allObjects[i]->tickAnimation(dt);
+		}
+	});
+}
+
 void GameWorld::destroyQueuedObjects()
 {
 	while( !deletionQueue.empty() ) {
@@ -596,40 +639,89 @@ void GameWorld::destroyQueuedObjects()
 	}
 }
 
-bool GameWorld::shouldBeOnGrid(GameObject* object)
+bool GameWorld::isStaticObject(GameObject* object)
 {
 	if( object->type() != GameObject::Instance )
 	{
-		// Only static instances currently.
 		return false;
 	}
 	auto instance = static_cast<InstanceObject*>(object);
 	return instance->body == nullptr || instance->body->body->isStaticObject();
 }
 
-void GameWorld::addToGrid(GameObject* object)
+void GameWorld::addToIndex(GameObject* object)
 {
-	auto coord = worldToGrid(glm::vec2(object->getPosition()));
-	if( coord.x < 0 || coord.y < 0 || coord.x >= WORLD_GRID_WIDTH || coord.y >= WORLD_GRID_WIDTH )
-	{
+	spatialIndex.insert(object, getIndexRadius(object), isStaticObject(object));
+	waitForModel(object);
+}
+
+void GameWorld::updateIndex(GameObject* object)
+{
+	spatialIndex.update(object, getIndexRadius(object));
+	waitForModel(object);
+}
+
+void GameWorld::waitForModel(GameObject* object)
+{
+	// The streaming manager updates instances as it loads their models
+	if( object->type() == GameObject::Instance || ! object->model
+			|| object->model->state != RW::Loading ) {
 		return;
 	}
-	auto index = (coord.x * WORLD_GRID_WIDTH) + coord.y;
-	worldGrid[index].instances.insert(object);
-	if( object->model->resource )
-	{
-		float cellhalf = WORLD_CELL_SIZE/2.f;
-		auto world = glm::vec3(glm::vec2(coord) * glm::vec2(WORLD_CELL_SIZE) - glm::vec2(WORLD_GRID_SIZE/2.f) + glm::vec2(cellhalf), 0.f);
-		auto offset = world - object->getPosition();
-		float maxRadius = glm::length(offset) + object->model->resource->getBoundingRadius();
-		worldGrid[index].boundingRadius = std::max(worldGrid[index].boundingRadius, maxRadius);
+	if( std::find(unloadedModelObjects.begin(), unloadedModelObjects.end(), object)
+			== unloadedModelObjects.end() ) {
+		unloadedModelObjects.push_back(object);
 	}
 }
 
-glm::ivec2 GameWorld::worldToGrid(const glm::vec2& world)
+void GameWorld::updateUnloadedModels()
 {
-	static const float lowerCoord = -(WORLD_GRID_SIZE)/2.f;
-	return glm::ivec2((world - glm::vec2(lowerCoord)) / glm::vec2(WORLD_CELL_SIZE));
+	for( auto it = unloadedModelObjects.begin(); it != unloadedModelObjects.end(); ) {
+		auto object = *it;
+		if( object->model && object->model->state == RW::Loading ) {
+			++it;
+			continue;
+		}
+		spatialIndex.update(object, getIndexRadius(object));
+		it = unloadedModelObjects.erase(it);
+	}
+}
+
+float GameWorld::getIndexRadius(GameObject* object)
+{
+	float radius = 0.f;
+	if( object->model && object->model->resource )
+	{
+		radius = object->model->resource->getBoundingRadius();
+	}
+	else if( object->model )
+	{
+		// Streamed models aren't loaded yet, their collision is close enough
+		auto collision = data->collisions.find(object->model->name);
+		if( collision != data->collisions.end() )
+		{
+			radius = glm::length(collision->second->center) + collision->second->radius;
+		}
+	}
+
+	if( object->type() == GameObject::Instance )
+	{
+		// Distant instances draw their LOD model in its place
+		auto lod = static_cast<InstanceObject*>(object)->LODinstance;
+		if( lod && lod->model && lod->model->resource )
+		{
+			float lodRadius = glm::distance(lod->getPosition(), object->getPosition())
+					+ lod->model->resource->getBoundingRadius();
+			radius = std::max(radius, lodRadius);
+		}
+	}
+	else
+	{
+		// Leaves room for things attached to the object, like weapons
+		radius = std::max(radius, kMinimumDynamicRadius);
+	}
+
+	return radius;
 }
 
 VisualFX* GameWorld::createEffect(VisualFX::EffectType type)
@@ -817,8 +909,7 @@ void GameWorld::PhysicsTickCallback(btDynamicsWorld *physWorld, btScalar timeSte
 {
 	GameWorld* world = static_cast<GameWorld*>(physWorld->getWorldUserInfo());
 
-	for( auto& p : world->vehiclePool.objects ) {
-		GameObject* object = p.second;
+	for( auto object : world->vehiclePool ) {
 		static_cast<VehicleObject*>(object)->tickPhysics(timeStep);
 	}
 }
@@ -872,8 +963,8 @@ void GameWorld::startCutscene()
 
 void GameWorld::clearCutscene()
 {
-	for(auto& p : cutscenePool.objects) {
-		destroyObjectQueued(p.second);
+	for(auto object : cutscenePool) {
+		destroyObjectQueued(object);
 	}
 
 	if (cutsceneAudio.length() > 0) {
@@ -934,6 +1025,7 @@ void GameWorld::disableAIPaths(AIGraphNode::NodeType type, const glm::vec3& min,
 			}
 		}
 	}
+	routes.refreshDisabled();
 }
 
 void GameWorld::enableAIPaths(AIGraphNode::NodeType type, const glm::vec3& min, const glm::vec3& max)
@@ -954,6 +1046,7 @@ void GameWorld::enableAIPaths(AIGraphNode::NodeType type, const glm::vec3& min,
 			}
 		}
 	}
+	routes.refreshDisabled();
 }
 
 void GameWorld::drawAreaIndicator(AreaIndicatorInfo::AreaIndicatorType type, glm::vec3 position, glm::vec3 radius)
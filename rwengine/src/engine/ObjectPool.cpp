@@ -0,0 +1,89 @@
+#include <engine/ObjectPool.hpp>
+#include <objects/GameObject.hpp>
+#include <rw/defines.hpp>
+
+void ObjectPool::insert(GameObject* object)
+{
+	GameObjectID id = object->getGameObjectID();
+	uint32_t slot;
+
+	// An ID without a slot can't be kept, so it gets a new one
+	if( (id & kSlotMask) == 0 ) {
+		RW_CHECK(id == 0, "GameObjectID without a slot");
+		slot = allocateSlot();
+		id = (slots[slot].generation << kSlotBits) | (slot + 1);
+		object->setGameObjectID(id);
+	}
+	else {
+		slot = (id & kSlotMask) - 1;
+
+		// Slots skipped over are free for later objects
+		if( slot >= slots.size() ) {
+			for( uint32_t s = slot; s-- > slots.size(); ) {
+				freeSlots.push_back(s);
+			}
+			slots.resize(slot + 1, { nullptr, 0, 0 });
+		}
+
+		if( slots[slot].object ) {
+			removeSlot(slot);
+		}
+		slots[slot].generation = (id >> kSlotBits) & kGenerationMask;
+	}
+
+	slots[slot].object = object;
+	slots[slot].dense = objects.size();
+	objects.push_back(object);
+	objectSlots.push_back(slot);
+}
+
+void ObjectPool::remove(GameObject* object)
+{
+	if( object ) {
+		uint32_t slot = (object->getGameObjectID() & kSlotMask) - 1;
+		if( slot < slots.size() && slots[slot].object == object ) {
+			removeSlot(slot);
+			// IDs that refer to the old object no longer match
+			slots[slot].generation = (slots[slot].generation + 1) & kGenerationMask;
+			freeSlots.push_back(slot);
+		}
+	}
+}
+
+GameObject* ObjectPool::find(GameObjectID id) const
+{
+	uint32_t slot = (id & kSlotMask) - 1;
+	if( slot < slots.size() && slots[slot].generation == (id >> kSlotBits) ) {
+		return slots[slot].object;
+	}
+	return nullptr;
+}
+
+uint32_t ObjectPool::allocateSlot()
+{
+	while( ! freeSlots.empty() ) {
+		uint32_t slot = freeSlots.back();
+		freeSlots.pop_back();
+		if( slots[slot].object == nullptr ) {
+			return slot;
+		}
+	}
+
+	RW_CHECK(slots.size() < kSlotMask, "ObjectPool is out of slots");
+	slots.push_back({ nullptr, 0, 0 });
+	return slots.size() - 1;
+}
+
+void ObjectPool::removeSlot(uint32_t slot)
+{
+	// Move the last object into the hole to keep them packed
+	uint32_t dense = slots[slot].dense;
+	uint32_t last = objects.size() - 1;
+	objects[dense] = objects[last];
+	objectSlots[dense] = objectSlots[last];
+	slots[objectSlots[dense]].dense = dense;
+	objects.pop_back();
+	objectSlots.pop_back();
+
+	slots[slot].object = nullptr;
+}
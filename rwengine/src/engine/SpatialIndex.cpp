@@ -0,0 +1,315 @@
+#include <engine/SpatialIndex.hpp>
+#include <objects/GameObject.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+SpatialIndex::SpatialIndex(float worldSize, unsigned int depth, float cellSize)
+	: worldSize(worldSize)
+	, depth(std::max(depth, 1u))
+	, cellSize(cellSize)
+	, gridWidth(std::max(int(std::ceil(worldSize / cellSize)), 1))
+	, nodes(levelOffset(this->depth))
+	, cells(gridWidth * gridWidth + 1)
+	, maxDynamicRadius(0.f)
+{
+}
+
+template<class BoundsTest, class EntryTest>
+void SpatialIndex::queryTree(const NodeCoord& coord, std::vector<GameObject*>& out,
+							 const BoundsTest& boundsTest, const EntryTest& entryTest) const
+{
+	const Node& node = nodes[nodeIndex(coord)];
+	if( node.total == 0 ) {
+		return;
+	}
+
+	// The root also holds objects outside the world, so it's never rejected
+	if( coord.level > 0 ) {
+		float size = nodeSize(coord.level);
+		glm::vec2 center = glm::vec2(-worldSize / 2.f)
+				+ (glm::vec2(coord.x, coord.y) + glm::vec2(0.5f)) * size;
+		glm::vec3 min(center - glm::vec2(size), node.minZ);
+		glm::vec3 max(center + glm::vec2(size), node.maxZ);
+		if( ! boundsTest(min, max) ) {
+			return;
+		}
+	}
+
+	for( auto& entry : node.entries ) {
+		if( entryTest(entry) ) {
+			out.push_back(entry.object);
+		}
+	}
+
+	if( coord.level + 1 < depth ) {
+		for( int c = 0; c < 4; ++c ) {
+			queryTree({ coord.level + 1, coord.x * 2 + (c & 1), coord.y * 2 + (c >> 1) },
+					  out, boundsTest, entryTest);
+		}
+	}
+}
+
+template<class EntryTest>
+void SpatialIndex::queryCells(const glm::vec2& min, const glm::vec2& max, std::vector<GameObject*>& out,
+							  const EntryTest& entryTest) const
+{
+	auto testCell = [&](const Cell& cell) {
+		for( auto& entry : cell.entries ) {
+			if( entryTest(entry) ) {
+				out.push_back(entry.object);
+			}
+		}
+	};
+
+	// Entries are bucketed by their centers, so pad the search by their size
+	float lower = -worldSize / 2.f;
+	int minX = std::max(int(std::floor((min.x - maxDynamicRadius - lower) / cellSize)), 0);
+	int minY = std::max(int(std::floor((min.y - maxDynamicRadius - lower) / cellSize)), 0);
+	int maxX = std::min(int(std::floor((max.x + maxDynamicRadius - lower) / cellSize)), gridWidth - 1);
+	int maxY = std::min(int(std::floor((max.y + maxDynamicRadius - lower) / cellSize)), gridWidth - 1);
+	for( int y = minY; y <= maxY; ++y ) {
+		for( int x = minX; x <= maxX; ++x ) {
+			testCell(cells[y * gridWidth + x]);
+		}
+	}
+	testCell(cells.back());
+}
+
+void SpatialIndex::insert(GameObject* object, float radius, bool isStatic)
+{
+	if( contains(object) ) {
+		remove(object);
+	}
+
+	Entry entry { object->getPosition(), radius, object };
+	if( isStatic ) {
+		addStatic(entry);
+	}
+	else {
+		addDynamic(entry);
+	}
+}
+
+void SpatialIndex::remove(GameObject* object)
+{
+	auto it = locations.find(object);
+	if( it == locations.end() ) {
+		return;
+	}
+	Location location = it->second;
+	locations.erase(it);
+
+	if( ! location.isStatic ) {
+		removeFrom(cells[location.bucket].entries, location.index);
+		return;
+	}
+
+	removeFrom(nodes[location.bucket].entries, location.index);
+
+	// Only the counts shrink, height ranges stay conservative until emptied
+	NodeCoord coord = nodeCoord(location.bucket);
+	for( ;; ) {
+		Node& node = nodes[nodeIndex(coord)];
+		node.total--;
+		if( node.total == 0 ) {
+			node.minZ = node.maxZ = 0.f;
+		}
+		if( coord.level == 0 ) {
+			break;
+		}
+		coord = { coord.level - 1, coord.x / 2, coord.y / 2 };
+	}
+}
+
+void SpatialIndex::update(GameObject* object, float radius)
+{
+	auto it = locations.find(object);
+	if( it == locations.end() ) {
+		return;
+	}
+	bool isStatic = it->second.isStatic;
+	remove(object);
+	insert(object, radius, isStatic);
+}
+
+void SpatialIndex::refresh()
+{
+	for( uint32_t c = 0; c < cells.size(); ++c ) {
+		auto& entries = cells[c].entries;
+		for( uint32_t i = 0; i < entries.size(); ) {
+			Entry& entry = entries[i];
+			entry.center = entry.object->getPosition();
+			uint32_t target = cellForPosition(entry.center);
+			if( target == c ) {
+				i++;
+				continue;
+			}
+			// The last entry takes this slot, so look at i again
+			Entry moved = entry;
+			removeFrom(entries, i);
+			cells[target].entries.push_back(moved);
+			locations[moved.object] = { false, target, uint32_t(cells[target].entries.size() - 1) };
+		}
+	}
+}
+
+void SpatialIndex::queryFrustum(const ViewFrustum& frustum, std::vector<GameObject*>& out) const
+{
+	queryTree({ 0, 0, 0 }, out,
+		[&](const glm::vec3& min, const glm::vec3& max) {
+			glm::vec3 halfSize = (max - min) * 0.5f;
+			return frustum.intersects(min + halfSize, glm::length(halfSize));
+		},
+		[&](const Entry& entry) {
+			return frustum.intersects(entry.center, entry.radius);
+		});
+
+	for( auto& cell : cells ) {
+		for( auto& entry : cell.entries ) {
+			if( frustum.intersects(entry.center, entry.radius) ) {
+				out.push_back(entry.object);
+			}
+		}
+	}
+}
+
+void SpatialIndex::queryRadius(const glm::vec3& center, float radius, std::vector<GameObject*>& out) const
+{
+	auto entryTest = [&](const Entry& entry) {
+		return glm::distance(entry.center, center) <= radius + entry.radius;
+	};
+	queryTree({ 0, 0, 0 }, out,
+		[&](const glm::vec3& min, const glm::vec3& max) {
+			glm::vec3 closest = glm::clamp(center, min, max);
+			return glm::distance(closest, center) <= radius;
+		},
+		entryTest);
+
+	queryCells(glm::vec2(center) - glm::vec2(radius), glm::vec2(center) + glm::vec2(radius),
+			   out, entryTest);
+}
+
+void SpatialIndex::queryBox(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& out) const
+{
+	auto entryTest = [&](const Entry& entry) {
+		glm::vec3 closest = glm::clamp(entry.center, min, max);
+		return glm::distance(closest, entry.center) <= entry.radius;
+	};
+	queryTree({ 0, 0, 0 }, out,
+		[&](const glm::vec3& nodeMin, const glm::vec3& nodeMax) {
+			return glm::all(glm::lessThanEqual(nodeMin, max))
+					&& glm::all(glm::lessThanEqual(min, nodeMax));
+		},
+		entryTest);
+
+	queryCells(glm::vec2(min), glm::vec2(max), out, entryTest);
+}
+
+bool SpatialIndex::contains(GameObject* object) const
+{
+	return locations.find(object) != locations.end();
+}
+
+uint32_t SpatialIndex::levelOffset(unsigned int level)
+{
+	// Sum of 4^l for every level above this one
+	return ((1u << (2 * level)) - 1) / 3;
+}
+
+uint32_t SpatialIndex::nodeIndex(const NodeCoord& coord)
+{
+	return levelOffset(coord.level) + coord.y * (1 << coord.level) + coord.x;
+}
+
+SpatialIndex::NodeCoord SpatialIndex::nodeCoord(uint32_t index)
+{
+	unsigned int level = 0;
+	while( levelOffset(level + 1) <= index ) {
+		level++;
+	}
+	int width = 1 << level;
+	uint32_t local = index - levelOffset(level);
+	return { level, int(local % width), int(local / width) };
+}
+
+float SpatialIndex::nodeSize(unsigned int level) const
+{
+	return worldSize / float(1 << level);
+}
+
+SpatialIndex::NodeCoord SpatialIndex::nodeForObject(const glm::vec3& center, float radius) const
+{
+	float half = worldSize / 2.f;
+	if( center.x < -half || center.y < -half || center.x >= half || center.y >= half ) {
+		// The root has no bounds, so anything outside the world lives there
+		return { 0, 0, 0 };
+	}
+
+	// Nodes are loose by half their size on each side
+	unsigned int level = 0;
+	while( level + 1 < depth && radius <= nodeSize(level + 1) / 2.f ) {
+		level++;
+	}
+
+	int width = 1 << level;
+	float size = nodeSize(level);
+	int x = std::min(int((center.x + half) / size), width - 1);
+	int y = std::min(int((center.y + half) / size), width - 1);
+	return { level, x, y };
+}
+
+uint32_t SpatialIndex::cellForPosition(const glm::vec3& position) const
+{
+	float half = worldSize / 2.f;
+	int x = int(std::floor((position.x + half) / cellSize));
+	int y = int(std::floor((position.y + half) / cellSize));
+	if( x < 0 || y < 0 || x >= gridWidth || y >= gridWidth ) {
+		return cells.size() - 1;
+	}
+	return y * gridWidth + x;
+}
+
+void SpatialIndex::addStatic(const Entry& entry)
+{
+	NodeCoord coord = nodeForObject(entry.center, entry.radius);
+	uint32_t index = nodeIndex(coord);
+	nodes[index].entries.push_back(entry);
+	locations[entry.object] = { true, index, uint32_t(nodes[index].entries.size() - 1) };
+
+	float minZ = entry.center.z - entry.radius;
+	float maxZ = entry.center.z + entry.radius;
+	for( ;; ) {
+		Node& node = nodes[nodeIndex(coord)];
+		if( node.total == 0 ) {
+			node.minZ = minZ;
+			node.maxZ = maxZ;
+		}
+		else {
+			node.minZ = std::min(node.minZ, minZ);
+			node.maxZ = std::max(node.maxZ, maxZ);
+		}
+		node.total++;
+		if( coord.level == 0 ) {
+			break;
+		}
+		coord = { coord.level - 1, coord.x / 2, coord.y / 2 };
+	}
+}
+
+void SpatialIndex::addDynamic(const Entry& entry)
+{
+	uint32_t cell = cellForPosition(entry.center);
+	cells[cell].entries.push_back(entry);
+	locations[entry.object] = { false, cell, uint32_t(cells[cell].entries.size() - 1) };
+	maxDynamicRadius = std::max(maxDynamicRadius, entry.radius);
+}
+
+void SpatialIndex::removeFrom(std::vector<Entry>& entries, uint32_t index)
+{
+	if( index + 1 < entries.size() ) {
+		entries[index] = entries.back();
+		locations[entries[index].object].index = index;
+	}
+	entries.pop_back();
+}
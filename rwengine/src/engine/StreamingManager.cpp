@@ -0,0 +1,424 @@
+#include <engine/StreamingManager.hpp>
+#include <engine/GameData.hpp>
+#include <engine/GameWorld.hpp>
+#include <objects/InstanceObject.hpp>
+#include <job/WorkContext.hpp>
+
+#include <algorithm>
+
+namespace
+{
+	const size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+	const float kDefaultStreamingRadius = 1000.f;
+	/// Instances are loaded a little before they're in draw distance
+	const float kStreamingMargin = 50.f;
+	/// How far the camera moves before looking for instances again
+	const float kRescanDistance = 5.f;
+	/// Loads in progress at once, the rest wait so the nearest go first
+	const size_t kMaxPendingLoads = 32;
+
+	const char* kResourceTypeNames[StreamingManager::ResourceTypeCount] = {
+		"models",
+		"textures",
+	};
+}
+
+/**
+ * Decodes a TXD on a worker and queues its textures for upload
+ */
+class StreamingManager::LoadTexturesJob : public WorkJob
+{
+	ResourceRef resource;
+	GameData* data;
+	FileHandle file;
+	std::vector<DecodedTexture> decoded;
+
+public:
+	LoadTexturesJob(WorkContext* context, GameData* data, const ResourceRef& resource)
+		: WorkJob(context), resource(resource), data(data)
+	{ }
+
+	void work()
+	{
+		file = data->index.openFile(resource->name + ".txd");
+		if( file ) {
+			TextureLoader loader;
+			loader.decode(file, decoded);
+		}
+	}
+
+	void complete()
+	{
+		if( ! file ) {
+			resource->state = Failed;
+			return;
+		}
+
+		resource->bytes = 0;
+		for( auto& texture : decoded ) {
+			// Mipmaps add another third
+			resource->bytes += texture.pixels.size() * 4 / 3;
+			resource->textureNames.push_back(textureKey(texture.name, texture.alpha));
+			if( ! texture.alpha.empty() ) {
+				resource->textureNames.push_back(textureKey(texture.name));
+			}
+		}
+
+		// The textures are added to the archive as they're uploaded
+		data->textureUploads.add(std::move(decoded), data->textures);
+		resource->state = Resident;
+	}
+};
+
+StreamingManager::StreamingManager(GameWorld* world)
+	: world(world)
+	, memoryBudget(kDefaultMemoryBudget)
+	, streamingRadius(kDefaultStreamingRadius)
+	, updateCount(0)
+	, stats{ {0, 0}, {0, 0}, 0, 0, 0 }
+	, scanned(false)
+{
+}
+
+StreamingManager::~StreamingManager()
+{
+}
+
+const char* StreamingManager::getResourceTypeName(ResourceType type)
+{
+	return kResourceTypeNames[type];
+}
+
+size_t StreamingManager::getResidentBytes() const
+{
+	size_t total = 0;
+	for( int t = 0; t < ResourceTypeCount; ++t ) {
+		total += stats.residentBytes[t];
+	}
+	return total;
+}
+
+void StreamingManager::update(const glm::vec3& position)
+{
+	updateCount++;
+	stats.requested = 0;
+	stats.evicted = 0;
+
+	bool finished = pollLoading();
+
+	if( ! scanned || finished ||
+		glm::distance(position, scanPosition) > kRescanDistance ) {
+		scan(position);
+	}
+
+	evict();
+
+	stats.pending = loading.size();
+}
+
+StreamingManager::ResourceRef StreamingManager::findModel(const ModelRef& model)
+{
+	auto it = models.find(model.get());
+	if( it != models.end() ) {
+		return it->second;
+	}
+
+	if( model->name.empty() || model->name == "null" ) {
+		return models[model.get()] = nullptr;
+	}
+
+	ResourceRef resource(new Resource{ ModelResource, model->name, Unloaded, 0, 0, model, {} });
+	if( model->state == RW::Failed ) {
+		resource->state = Failed;
+	}
+	else if( model->state != RW::Unloaded ) {
+		resource->state = Pinned;
+	}
+	return models[model.get()] = resource;
+}
+
+StreamingManager::ResourceRef StreamingManager::findTextures(const ObjectData* object)
+{
+	auto it = objectTextures.find(object);
+	if( it != objectTextures.end() ) {
+		return it->second;
+	}
+
+	std::string name = object->textureName;
+	std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+	if( name.empty() ) {
+		return objectTextures[object] = nullptr;
+	}
+
+	return objectTextures[object] = findTextures(name);
+}
+
+StreamingManager::ResourceRef StreamingManager::findTextures(const std::string& name)
+{
+	auto& resource = textures[name];
+	if( ! resource ) {
+		resource.reset(new Resource{ TextureResource, name, Unloaded, 0, 0, nullptr, {} });
+		auto& loaded = world->data->loadedFiles;
+		if( loaded.find(name + ".txd") != loaded.end() ) {
+			resource->state = Pinned;
+		}
+	}
+	return resource;
+}
+
+bool StreamingManager::adoptModel(const ModelRef& model, size_t bytes)
+{
+	auto resource = findModel(model);
+	if( ! resource || model->resource == nullptr ) {
+		return false;
+	}
+	return adopt(*resource, bytes);
+}
+
+bool StreamingManager::adoptTextures(const std::string& name,
+									 const std::vector<TextureArchive::key_type>& textureNames,
+									 size_t bytes)
+{
+	auto resource = findTextures(name);
+	if( ! adopt(*resource, bytes) ) {
+		return false;
+	}
+	resource->textureNames = textureNames;
+	return true;
+}
+
+bool StreamingManager::adopt(Resource& resource, size_t bytes)
+{
+	if( resource.state != Pinned ) {
+		return false;
+	}
+
+	resource.state = Resident;
+	resource.bytes = bytes;
+	resource.lastUsed = updateCount;
+	stats.residentBytes[resource.type] += bytes;
+	stats.residentCount[resource.type]++;
+	return true;
+}
+
+void StreamingManager::scan(const glm::vec3& position)
+{
+	scanPosition = position;
+	scanned = true;
+
+	nearbyObjects.clear();
+	world->spatialIndex.queryRadius(position, streamingRadius, nearbyObjects);
+
+	requests.clear();
+	for( GameObject* object : nearbyObjects ) {
+		if( object->type() != GameObject::Instance ) {
+			continue;
+		}
+		auto instance = static_cast<InstanceObject*>(object);
+		if( ! instance->model || ! instance->object ) {
+			continue;
+		}
+
+		float distance = glm::distance(instance->getPosition(), position);
+		if( distance > instance->object->drawDistance[0] + kStreamingMargin ) {
+			continue;
+		}
+
+		auto model = findModel(instance->model);
+		auto txd = findTextures(instance->object.get());
+		for( auto& resource : { model, txd } ) {
+			if( ! resource ) {
+				continue;
+			}
+			resource->lastUsed = updateCount;
+			if( resource->state == Unloaded ) {
+				requests.push_back({ distance, resource });
+			}
+		}
+
+		// The instance was indexed before its model's size was known
+		if( model && model->state == Resident && model->lastUsed == updateCount ) {
+			world->spatialIndex.update(instance, world->getIndexRadius(instance));
+		}
+	}
+
+	std::sort(requests.begin(), requests.end(),
+			  [](const std::pair<float, ResourceRef>& a, const std::pair<float, ResourceRef>& b) {
+				  return a.first < b.first;
+			  });
+
+	for( auto& entry : requests ) {
+		if( loading.size() >= kMaxPendingLoads ) {
+			break;
+		}
+		if( entry.second->state == Unloaded ) {
+			request(entry.second);
+		}
+	}
+}
+
+void StreamingManager::request(const ResourceRef& resource)
+{
+	auto data = world->data;
+	resource->state = Loading;
+	loading.push_back(resource);
+	stats.requested++;
+
+	if( resource->type == ModelResource ) {
+		data->loadDFF(resource->name + ".dff", true);
+	}
+	else {
+		// Stops GameData::loadTXD loading it again
+		data->loadedFiles[resource->name + ".txd"] = true;
+		world->_work->queueJob(new LoadTexturesJob(world->_work, data, resource));
+	}
+}
+
+bool StreamingManager::pollLoading()
+{
+	bool finished = false;
+	for( auto it = loading.begin(); it != loading.end(); ) {
+		auto& resource = **it;
+		if( resource.type == ModelResource && resource.state == Loading ) {
+			if( resource.model->state == RW::Loaded ) {
+				resource.state = Resident;
+				resource.bytes = getModelBytes(*resource.model->resource);
+			}
+			else if( resource.model->state == RW::Failed ) {
+				resource.state = Failed;
+			}
+		}
+
+		if( resource.state == Loading ) {
+			++it;
+			continue;
+		}
+
+		if( resource.state == Resident ) {
+			stats.residentBytes[resource.type] += resource.bytes;
+			stats.residentCount[resource.type]++;
+		}
+		finished = true;
+		it = loading.erase(it);
+	}
+	return finished;
+}
+
+void StreamingManager::evict()
+{
+	if( getResidentBytes() <= memoryBudget ) {
+		return;
+	}
+
+	std::vector<Resource*> candidates;
+	for( auto& entry : models ) {
+		if( entry.second && entry.second->state == Resident ) {
+			candidates.push_back(entry.second.get());
+		}
+	}
+	for( auto& entry : textures ) {
+		if( entry.second->state == Resident ) {
+			candidates.push_back(entry.second.get());
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(),
+			  [](const Resource* a, const Resource* b) {
+				  return a->lastUsed < b->lastUsed;
+			  });
+
+	for( Resource* resource : candidates ) {
+		if( getResidentBytes() <= memoryBudget ) {
+			break;
+		}
+		// Everything left is needed where the camera is now
+		if( resource->lastUsed == updateCount ) {
+			break;
+		}
+		if( canEvict(*resource) ) {
+			unload(*resource);
+			stats.evicted++;
+		}
+	}
+}
+
+bool StreamingManager::canEvict(const Resource& resource) const
+{
+	if( resource.type == ModelResource ) {
+		return resource.model->resource != nullptr;
+	}
+
+	// Every texture has to be uploaded, and only referenced by the archive
+	auto& archive = world->data->textures;
+	std::vector<std::pair<TextureData::Handle, long>> handles;
+	for( auto& name : resource.textureNames ) {
+		auto it = archive.find(name);
+		if( it == archive.end() || ! it->second ) {
+			return false;
+		}
+		auto handle = std::find_if(handles.begin(), handles.end(),
+								   [&](const std::pair<TextureData::Handle, long>& h) {
+									   return h.first == it->second;
+								   });
+		if( handle == handles.end() ) {
+			handles.push_back({ it->second, 1 });
+		}
+		else {
+			handle->second++;
+		}
+	}
+
+	for( auto& handle : handles ) {
+		// One more for the copy in handles
+		if( handle.first.use_count() > handle.second + 1 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void StreamingManager::unload(Resource& resource)
+{
+	auto data = world->data;
+	stats.residentBytes[resource.type] -= resource.bytes;
+	stats.residentCount[resource.type]--;
+
+	if( resource.type == ModelResource ) {
+		data->animationBindings.removeModel(resource.model->resource);
+		delete resource.model->resource;
+		resource.model->resource = nullptr;
+		resource.model->state = RW::Unloaded;
+		data->loadedFiles.erase(resource.name + ".dff");
+	}
+	else {
+		for( auto& name : resource.textureNames ) {
+			auto it = data->textures.find(name);
+			if( it == data->textures.end() ) {
+				continue;
+			}
+			if( it->second.use_count() == 1 ) {
+				GLuint texture = it->second->getName();
+				glDeleteTextures(1, &texture);
+			}
+			data->textures.erase(it);
+		}
+		resource.textureNames.clear();
+		data->loadedFiles.erase(resource.name + ".txd");
+	}
+
+	resource.bytes = 0;
+	resource.state = Unloaded;
+}
+
+size_t StreamingManager::getModelBytes(const Model& model)
+{
+	size_t bytes = 0;
+	for( auto& geometry : model.geometries ) {
+		bytes += geometry->gbuff.getCount() * sizeof(Model::GeometryVertex);
+		for( auto& subgeom : geometry->subgeom ) {
+			// The indices are kept in memory and in a buffer
+			bytes += subgeom.indices.size() * sizeof(uint32_t) * 2;
+		}
+	}
+	return bytes;
+}
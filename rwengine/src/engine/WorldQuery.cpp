@@ -0,0 +1,90 @@
+#include <engine/WorldQuery.hpp>
+
+#include <algorithm>
+
+namespace
+{
+	/// First radius tried by nearest(), it grows until enough are found
+	const float kNearestStartRadius = 32.f;
+
+	bool insideBox(const glm::vec3& position, const glm::vec3& min, const glm::vec3& max)
+	{
+		return glm::all(glm::greaterThanEqual(position, min))
+				&& glm::all(glm::lessThanEqual(position, max));
+	}
+}
+
+WorldQuery::WorldQuery(const SpatialIndex& index)
+	: index(index)
+{
+}
+
+void WorldQuery::box(const glm::vec3& min, const glm::vec3& max, const Filter& filter,
+					 std::vector<GameObject*>& out) const
+{
+	candidates.clear();
+	index.queryBox(min, max, candidates);
+	for( auto object : candidates ) {
+		if( filter.matches(object) && insideBox(object->getPosition(), min, max) ) {
+			out.push_back(object);
+		}
+	}
+}
+
+bool WorldQuery::anyInBox(const glm::vec3& min, const glm::vec3& max, const Filter& filter) const
+{
+	candidates.clear();
+	index.queryBox(min, max, candidates);
+	return std::any_of(candidates.begin(), candidates.end(), [&](GameObject* object) {
+		return filter.matches(object) && insideBox(object->getPosition(), min, max);
+	});
+}
+
+void WorldQuery::sphere(const glm::vec3& center, float radius, const Filter& filter,
+						std::vector<GameObject*>& out) const
+{
+	candidates.clear();
+	index.queryRadius(center, radius, candidates);
+	for( auto object : candidates ) {
+		if( filter.matches(object) && glm::distance(object->getPosition(), center) <= radius ) {
+			out.push_back(object);
+		}
+	}
+}
+
+void WorldQuery::nearest(const glm::vec3& center, size_t count, float maxDistance, const Filter& filter,
+						 std::vector<GameObject*>& out) const
+{
+	if( count == 0 ) {
+		return;
+	}
+
+	// Search a small area first, most callers want something close by
+	std::vector<std::pair<float, GameObject*>> found;
+	float radius = std::min(kNearestStartRadius, maxDistance);
+	for( ;; ) {
+		candidates.clear();
+		index.queryRadius(center, radius, candidates);
+		found.clear();
+		for( auto object : candidates ) {
+			float distance = glm::distance(object->getPosition(), center);
+			if( distance <= radius && filter.matches(object) ) {
+				found.push_back({ distance, object });
+			}
+		}
+
+		if( found.size() >= count || radius >= maxDistance ) {
+			break;
+		}
+		radius = std::min(radius * 4.f, maxDistance);
+	}
+
+	count = std::min(count, found.size());
+	std::partial_sort(found.begin(), found.begin() + count, found.end(),
+		[](const std::pair<float, GameObject*>& a, const std::pair<float, GameObject*>& b) {
+			return a.first < b.first;
+		});
+	for( size_t i = 0; i < count; ++i ) {
+		out.push_back(found[i].second);
+	}
+}
@@ -10,11 +10,13 @@
 
 void WeaponItem::fireHitscan(CharacterObject* owner)
 {
+	// The skeleton is only interpolated when the owner is drawn, so use
+	// the animation's latest pose
 	auto handFrame = owner->model->resource->findFrame("srhand");
 	glm::mat4 handMatrix;
 	if( handFrame ) {
 		while( handFrame->getParent() ) {
-			handMatrix = owner->skeleton->getMatrix(handFrame->getIndex()) * handMatrix;
+			handMatrix = owner->skeleton->getCurrentMatrix(handFrame->getIndex()) * handMatrix;
 			handFrame = handFrame->getParent();
 		}
 	}
@@ -127,6 +129,7 @@ void WeaponItem::fireProjectile(CharacterObject* owner)
 	auto& pool = owner->engine->getTypeObjectPool( projectile );
 	pool.insert(projectile);
 	owner->engine->allObjects.push_back(projectile);
+	owner->engine->addToIndex(projectile);
 }
 
 void WeaponItem::primary(CharacterObject* owner)
@@ -94,6 +94,13 @@ bool LoaderIDE::load(const std::string &filename)
 					objs->LOD = true;
 				}
 
+				std::string lowerName = modelName;
+				std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+				objs->modelID = StringTable::get().intern(lowerName);
+				if( ! objs->LOD && lowerName.size() >= 3 ) {
+					objs->lodModelID = StringTable::get().intern("lod" + lowerName.substr(3));
+				}
+
 				objects.insert({objs->ID, objs});
 				break;
 			}
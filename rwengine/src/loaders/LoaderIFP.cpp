@@ -1,65 +1,132 @@
 #include <loaders/LoaderIFP.hpp>
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 
-bool findKeyframes(float t, AnimationBone* bone, AnimationKeyframe& f1, AnimationKeyframe& f2, float& alpha)
+namespace
 {
-	for(size_t f = 0; f < bone->frames.size(); ++f ) {
-		if( t <= bone->frames[f].starttime ) {
-			f2 = bone->frames[f];
+	const float kRotationScale = 32767.f;
 
-			if( f == 0 ) {
-				if( bone->frames.size() != 1 ) {
-					f1 = bone->frames.back();
-				}
-				else {
-					f1 = f2;
-				}
-			}
-			else {
-				f1 = bone->frames[f-1];
-			}
+	int16_t packComponent(float c)
+	{
+		return static_cast<int16_t>(std::round(glm::clamp(c, -1.f, 1.f) * kRotationScale));
+	}
+}
 
-			float tdiff = (f2.starttime - f1.starttime);
-			if( tdiff == 0.f ) {
-				alpha = 1.f;
-			}
-			else {
-				alpha = glm::clamp((t - f1.starttime) / tdiff, 0.f, 1.f);
-			}
+AnimationRotation AnimationRotation::pack(const glm::quat& q)
+{
+	return { packComponent(q.x), packComponent(q.y), packComponent(q.z), packComponent(q.w) };
+}
 
-			return true;
-		}
+glm::quat AnimationRotation::unpack() const
+{
+	return glm::quat(w / kRotationScale, x / kRotationScale, y / kRotationScale, z / kRotationScale);
+}
+
+void AnimationBone::addKeyframe(const AnimationKeyframe& keyframe)
+{
+	times.push_back(keyframe.starttime);
+	rotations.push_back(AnimationRotation::pack(keyframe.rotation));
+	if( type != R00 ) {
+		positions.push_back(keyframe.position);
+	}
+	if( type == RTS ) {
+		scales.push_back(keyframe.scale);
 	}
-	return false;
 }
 
-AnimationKeyframe AnimationBone::getInterpolatedKeyframe(float time)
+AnimationKeyframe AnimationBone::getKeyframe(size_t index) const
 {
-	AnimationKeyframe f1, f2;
-	float alpha;
+	return {
+		rotations[index].unpack(),
+		positions.empty() ? glm::vec3(0.f, 0.f, 0.f) : positions[index],
+		scales.empty() ? glm::vec3(1.f, 1.f, 1.f) : scales[index],
+		times[index],
+		int(index)
+	};
+}
 
-	if( findKeyframes(time, this, f1, f2, alpha) ) {
-		return {
-			glm::normalize(glm::slerp(f1.rotation, f2.rotation, alpha)),
-					glm::mix(f1.position, f2.position, alpha),
-					glm::mix(f1.scale, f2.scale, alpha),
-					time,
-					std::max(f1.id, f2.id)
-		};
+size_t AnimationBone::findKeyframe(float time, size_t& cursor) const
+{
+	// Keyframes are in time order, so moving forwards from the cursor
+	// works until the time goes backwards.
+	if( cursor > times.size() || (cursor > 0 && time <= times[cursor-1]) ) {
+		cursor = std::lower_bound(times.begin(), times.end(), time) - times.begin();
+		return cursor;
 	}
 
-	return frames.back();
+	while( cursor < times.size() && time > times[cursor] ) {
+		cursor++;
+	}
+	return cursor;
 }
 
-AnimationKeyframe AnimationBone::getKeyframe(float time)
+AnimationKeyframe AnimationBone::getInterpolatedKeyframe(float time) const
 {
-	for(size_t f = 0; f < frames.size(); ++f ) {
-		if( time >= frames[f].starttime ) {
-			return frames[f];
-		}
+	// Past the end, so the keyframe is found with a binary search
+	size_t cursor = times.size() + 1;
+	return getInterpolatedKeyframe(time, cursor);
+}
+
+AnimationKeyframe AnimationBone::getInterpolatedKeyframe(float time, size_t& cursor) const
+{
+	size_t f = findKeyframe(time, cursor);
+	if( f == times.size() ) {
+		return getKeyframe(times.size() - 1);
 	}
-	return frames.back();
+
+	size_t f1 = f > 0 ? f - 1 : (times.size() != 1 ? times.size() - 1 : f);
+
+	float alpha;
+	float tdiff = (times[f] - times[f1]);
+	if( tdiff == 0.f ) {
+		alpha = 1.f;
+	}
+	else {
+		alpha = glm::clamp((time - times[f1]) / tdiff, 0.f, 1.f);
+	}
+
+	auto k1 = getKeyframe(f1);
+	auto k2 = getKeyframe(f);
+	return {
+		glm::normalize(glm::slerp(k1.rotation, k2.rotation, alpha)),
+				glm::mix(k1.position, k2.position, alpha),
+				glm::mix(k1.scale, k2.scale, alpha),
+				time,
+				int(std::max(f1, f))
+	};
+}
+
+void AnimationBone::interpolate(float time, size_t& cursor, glm::quat& rotation, glm::vec3& position) const
+{
+	size_t f = findKeyframe(time, cursor);
+	size_t f1;
+	float alpha;
+	if( f == times.size() ) {
+		f = f1 = times.size() - 1;
+		alpha = 1.f;
+	}
+	else {
+		f1 = f > 0 ? f - 1 : (times.size() != 1 ? times.size() - 1 : f);
+		float tdiff = (times[f] - times[f1]);
+		alpha = tdiff == 0.f ? 1.f : glm::clamp((time - times[f1]) / tdiff, 0.f, 1.f);
+	}
+
+	rotation = glm::normalize(glm::slerp(rotations[f1].unpack(), rotations[f].unpack(), alpha));
+	if( positions.empty() ) {
+		position = glm::vec3(0.f, 0.f, 0.f);
+	}
+	else {
+		position = glm::mix(positions[f1], positions[f], alpha);
+	}
+}
+
+size_t AnimationBone::getMemoryUsage() const
+{
+	return times.capacity() * sizeof(float)
+			+ rotations.capacity() * sizeof(AnimationRotation)
+			+ positions.capacity() * sizeof(glm::vec3)
+			+ scales.capacity() * sizeof(glm::vec3);
 }
 
 bool LoaderIFP::loadFromMemory(char *data)
@@ -90,7 +157,8 @@ bool LoaderIFP::loadFromMemory(char *data)
 
 			AnimationBone* bonedata = new AnimationBone;
 			bonedata->name = frames->name;
-			bonedata->frames.reserve(frames->frames);
+			bonedata->times.reserve(frames->frames);
+			bonedata->rotations.reserve(frames->frames);
 
 			data_offs += ((8+frames->base.size) - sizeof(ANIM));
 
@@ -104,44 +172,35 @@ bool LoaderIFP::loadFromMemory(char *data)
 				for( int d = 0; d < frames->frames; ++d ) {
 					glm::quat q = glm::conjugate(*read<glm::quat>(data, dataI));
 					time = *read<float>(data,dataI);
-					bonedata->frames.push_back({
-												   q,
-												   glm::vec3(0.f, 0.f, 0.f),
-												   glm::vec3(1.f, 1.f, 1.f),
-												   time,
-												   d
-											   });
+					bonedata->rotations.push_back(AnimationRotation::pack(q));
+					bonedata->times.push_back(time);
 				}
 			}
 			else if(type == "KRT0") {
 				bonedata->type = AnimationBone::RT0;
+				bonedata->positions.reserve(frames->frames);
 				for( int d = 0; d < frames->frames; ++d ) {
 					glm::quat q = glm::conjugate(*read<glm::quat>(data, dataI));
 					glm::vec3 p = *read<glm::vec3>(data, dataI);
 					time = *read<float>(data,dataI);
-					bonedata->frames.push_back({
-												   q,
-												   p,
-												   glm::vec3(1.f, 1.f, 1.f),
-												   time,
-												   d
-											   });
+					bonedata->rotations.push_back(AnimationRotation::pack(q));
+					bonedata->positions.push_back(p);
+					bonedata->times.push_back(time);
 				}
 			}
 			else if(type == "KRTS") {
 				bonedata->type = AnimationBone::RTS;
+				bonedata->positions.reserve(frames->frames);
+				bonedata->scales.reserve(frames->frames);
 				for( int d = 0; d < frames->frames; ++d ) {
 					glm::quat q = glm::conjugate(*read<glm::quat>(data, dataI));
 					glm::vec3 p = *read<glm::vec3>(data, dataI);
 					glm::vec3 s = *read<glm::vec3>(data, dataI);
 					time = *read<float>(data,dataI);
-					bonedata->frames.push_back({
-												   q,
-												   p,
-												   s,
-												   time,
-												   d
-											   });
+					bonedata->rotations.push_back(AnimationRotation::pack(q));
+					bonedata->positions.push_back(p);
+					bonedata->scales.push_back(s);
+					bonedata->times.push_back(time);
 				}
 			}
 
@@ -0,0 +1,269 @@
+#include <loaders/WorldCache.hpp>
+#include <loaders/LoaderIPL.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	const char kCacheMagic[4] = { 'R', 'W', 'I', 'P' };
+	const uint32_t kCacheVersion = 1;
+
+	static_assert(sizeof(WorldCache::Instance) == 36,
+				  "WorldCache::Instance is written as a block and must not contain padding");
+
+	/// FNV-1a, continuing from hash
+	uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		auto bytes = static_cast<const uint8_t*>(data);
+		for( size_t i = 0; i < size; ++i ) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	const uint64_t kHashSeed = 14695981039346656037ull;
+
+	bool readFile(const std::string& path, std::string& data)
+	{
+		std::ifstream file(path.c_str(), std::ios_base::binary | std::ios_base::ate);
+		if( ! file.is_open() ) {
+			return false;
+		}
+		data.resize(file.tellg());
+		file.seekg(0);
+		file.read(&data[0], data.size());
+		return static_cast<bool>(file);
+	}
+
+	/// Reads values from a cache file buffer, failing at the end of the data
+	class CacheReader
+	{
+		const std::string& buffer;
+		size_t cursor;
+
+	public:
+		CacheReader(const std::string& data)
+			: buffer(data), cursor(0) { }
+
+		template<class T> bool read(T& value)
+		{
+			if( buffer.size() - cursor < sizeof(T) ) {
+				return false;
+			}
+			memcpy(&value, buffer.data() + cursor, sizeof(T));
+			cursor += sizeof(T);
+			return true;
+		}
+
+		bool read(std::string& value)
+		{
+			uint32_t length;
+			if( ! read(length) || buffer.size() - cursor < length ) {
+				return false;
+			}
+			value.assign(buffer.data() + cursor, length);
+			cursor += length;
+			return true;
+		}
+
+		template<class T> bool read(std::vector<T>& values, uint32_t count)
+		{
+			if( (buffer.size() - cursor) / sizeof(T) < count ) {
+				return false;
+			}
+			values.resize(count);
+			memcpy(values.data(), buffer.data() + cursor, count * sizeof(T));
+			cursor += count * sizeof(T);
+			return true;
+		}
+	};
+
+	template<class T> void write(std::ostream& out, const T& value)
+	{
+		out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void write(std::ostream& out, const std::string& value)
+	{
+		write<uint32_t>(out, value.size());
+		out.write(value.data(), value.size());
+	}
+
+	ObjectData* findObjectData(const std::map<ObjectID, ObjectInformationPtr>& objects, ObjectID id)
+	{
+		auto it = objects.find(id);
+		if( it == objects.end() || it->second->class_type != ObjectData::class_id ) {
+			return nullptr;
+		}
+		return static_cast<ObjectData*>(it->second.get());
+	}
+}
+
+const int32_t WorldCache::NoLOD;
+const int32_t WorldCache::ExternalLOD;
+
+WorldCache::WorldCache()
+	: sourceHash(0), objectHash(0)
+{
+}
+
+WorldCache WorldCache::build(const LoaderIPL& ipl, uint64_t sourceHash, uint64_t objectHash,
+							 const std::map<ObjectID, ObjectInformationPtr>& objects)
+{
+	WorldCache cache;
+	cache.sourceHash = sourceHash;
+	cache.objectHash = objectHash;
+	cache.zones = ipl.zones;
+	cache.instances.reserve(ipl.m_instances.size());
+
+	std::unordered_set<std::string> modelNames;
+	for( auto& object : objects ) {
+		if( object.second->class_type == ObjectData::class_id ) {
+			modelNames.insert(static_cast<ObjectData*>(object.second.get())->modelName);
+		}
+	}
+
+	// The first instance of each model in this file
+	std::unordered_map<std::string, int32_t> fileInstances;
+	for( size_t i = 0; i < ipl.m_instances.size(); ++i ) {
+		auto object = findObjectData(objects, ipl.m_instances[i]->id);
+		if( object ) {
+			fileInstances.insert({object->modelName, static_cast<int32_t>(i)});
+		}
+	}
+
+	for( auto& inst : ipl.m_instances ) {
+		int32_t lod = NoLOD;
+		auto object = findObjectData(objects, inst->id);
+		if( object && ! object->LOD && object->modelName.size() >= 3 ) {
+			auto lodName = "LOD" + object->modelName.substr(3);
+			auto it = fileInstances.find(lodName);
+			if( it != fileInstances.end() ) {
+				lod = it->second;
+			}
+			else if( modelNames.find(lodName) != modelNames.end() ) {
+				lod = ExternalLOD;
+			}
+		}
+
+		cache.instances.push_back({
+			inst->pos,
+			inst->rot,
+			lod,
+			static_cast<uint32_t>(inst->id)
+		});
+	}
+
+	return cache;
+}
+
+bool WorldCache::load(const std::string& path)
+{
+	std::string data;
+	if( ! readFile(path, data) ) {
+		return false;
+	}
+	CacheReader reader(data);
+
+	char magic[4];
+	uint32_t version, instanceCount, zoneCount;
+	uint64_t source, objects;
+	std::vector<Instance> loadedInstances;
+	if( ! reader.read(magic) || memcmp(magic, kCacheMagic, 4) != 0 ||
+		! reader.read(version) || version != kCacheVersion ||
+		! reader.read(source) || ! reader.read(objects) ||
+		! reader.read(instanceCount) ||
+		! reader.read(loadedInstances, instanceCount) ||
+		! reader.read(zoneCount) ) {
+		return false;
+	}
+
+	for( auto& instance : loadedInstances ) {
+		if( instance.lod < ExternalLOD || instance.lod >= static_cast<int32_t>(instanceCount) ) {
+			return false;
+		}
+	}
+
+	std::vector<ZoneData> loadedZones;
+	for( uint32_t z = 0; z < zoneCount; ++z ) {
+		ZoneData zone;
+		int32_t type, island;
+		if( ! reader.read(zone.name) || ! reader.read(type) ||
+			! reader.read(zone.min) || ! reader.read(zone.max) ||
+			! reader.read(island) ) {
+			return false;
+		}
+		zone.type = type;
+		zone.island = island;
+		for( int i = 0; i < ZONE_GANG_COUNT; i++ ) {
+			zone.gangCarDensityDay[i] =
+			zone.gangCarDensityNight[i] =
+			zone.gangDensityDay[i] =
+			zone.gangDensityNight[i] = 0;
+		}
+		zone.pedGroupDay = 0;
+		zone.pedGroupNight = 0;
+		loadedZones.push_back(zone);
+	}
+
+	sourceHash = source;
+	objectHash = objects;
+	instances = std::move(loadedInstances);
+	zones = std::move(loadedZones);
+	return true;
+}
+
+bool WorldCache::save(const std::string& path) const
+{
+	std::ofstream cachefile(path.c_str(), std::ios_base::binary | std::ios_base::trunc);
+	if( ! cachefile.is_open() ) {
+		return false;
+	}
+
+	write(cachefile, kCacheMagic);
+	write(cachefile, kCacheVersion);
+	write(cachefile, sourceHash);
+	write(cachefile, objectHash);
+
+	write<uint32_t>(cachefile, instances.size());
+	cachefile.write(reinterpret_cast<const char*>(instances.data()),
+					instances.size() * sizeof(Instance));
+
+	write<uint32_t>(cachefile, zones.size());
+	for( auto& zone : zones ) {
+		write(cachefile, zone.name);
+		write<int32_t>(cachefile, zone.type);
+		write(cachefile, zone.min);
+		write(cachefile, zone.max);
+		write<int32_t>(cachefile, zone.island);
+	}
+
+	return cachefile.good();
+}
+
+bool WorldCache::hashFile(const std::string& path, uint64_t& hash)
+{
+	std::string data;
+	if( ! readFile(path, data) ) {
+		return false;
+	}
+	hash = hashBytes(kHashSeed, data.data(), data.size());
+	return true;
+}
+
+uint64_t WorldCache::hashObjects(const std::map<ObjectID, ObjectInformationPtr>& objects)
+{
+	uint64_t hash = kHashSeed;
+	for( auto& object : objects ) {
+		hash = hashBytes(hash, &object.first, sizeof(object.first));
+		if( object.second->class_type == ObjectData::class_id ) {
+			auto data = static_cast<ObjectData*>(object.second.get());
+			hash = hashBytes(hash, data->modelName.data(), data->modelName.size() + 1);
+			hash = hashBytes(hash, &data->LOD, sizeof(data->LOD));
+		}
+	}
+	return hash;
+}
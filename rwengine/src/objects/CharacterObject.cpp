@@ -66,7 +66,7 @@ CharacterObject::CharacterObject(GameWorld* engine, const glm::vec3& pos, const
 
 	if(model) {
 		skeleton = new Skeleton;
-		animator = new Animator(model->resource, skeleton);
+		animator = new Animator(model->resource, skeleton, &engine->data->animationBindings);
 
 		createActor();
 	}
@@ -243,10 +243,6 @@ glm::vec3 CharacterObject::updateMovementAnimation(float dt)
 				glm::vec3 b = rootBone->getInterpolatedKeyframe(animTime+step).position;
 				glm::vec3 d = (b-a);
 				animTranslate.y += d.y;
-
-				Skeleton::FrameData fd = skeleton->getData(root->getIndex());
-				fd.a.translation.y = 0.f;
-				skeleton->setData(root->getIndex(), fd);
 			}
 		}
 	}
@@ -254,13 +250,19 @@ glm::vec3 CharacterObject::updateMovementAnimation(float dt)
 	return animTranslate;
 }
 
+void CharacterObject::tickParallel(float dt)
+{
+	if(controller) {
+		controller->plan(dt);
+	}
+}
+
 void CharacterObject::tick(float dt)
 {
 	if(controller) {
 		controller->update(dt);
 	}
 
-	animator->tick(dt);
 	updateCharacter(dt);
 
 	// Ensure the character doesn't need to be reset
@@ -269,6 +271,29 @@ void CharacterObject::tick(float dt)
 	}
 }
 
+void CharacterObject::tickAnimation(float dt)
+{
+	animator->tick(dt);
+
+	if (motionBlockedByActivity || getCurrentVehicle()) {
+		return;
+	}
+
+	// The character is moved by updateMovementAnimation, not the root bone
+	Animation* movementAnimation = animator->getAnimation(AnimIndexMovement);
+	if (movementAnimation && movementAnimation != animations.idle
+			&& ! model->resource->frames[0]->getChildren().empty())
+	{
+		ModelFrame* root = model->resource->frames[0]->getChildren()[0];
+		if (movementAnimation->bones.find(root->getName()) != movementAnimation->bones.end())
+		{
+			Skeleton::FrameData fd = skeleton->getData(root->getIndex());
+			fd.a.translation.y = 0.f;
+			skeleton->setData(root->getIndex(), fd);
+		}
+	}
+}
+
 #include <algorithm>
 void CharacterObject::changeCharacterModel(const std::string &name)
 {
@@ -279,7 +304,7 @@ void CharacterObject::changeCharacterModel(const std::string &name)
 	engine->data->loadTXD(modelName + ".txd");
 
 	auto& models = engine->data->models;
-	auto mfind = models.find(modelName);
+	auto mfind = models.find(GameData::modelID(modelName));
 	if( mfind != models.end() ) {
 		model = mfind->second;
 	}
@@ -291,7 +316,9 @@ void CharacterObject::changeCharacterModel(const std::string &name)
 	}
 
 	skeleton = new Skeleton;
-	animator = new Animator(model->resource, skeleton);
+	animator = new Animator(model->resource, skeleton, &engine->data->animationBindings);
+
+	engine->updateIndex(this);
 }
 
 void CharacterObject::updateCharacter(float dt)
@@ -541,23 +568,9 @@ void CharacterObject::setJumpSpeed(float speed)
 
 void CharacterObject::resetToAINode()
 {
-	auto nodes = engine->aigraph.nodes;
 	bool vehicleNode = !! getCurrentVehicle();
-	AIGraphNode* nearest = nullptr; float d = std::numeric_limits<float>::max();
-	for(auto it = nodes.begin(); it != nodes.end(); ++it) {
-		if(vehicleNode) {
-			if((*it)->type == AIGraphNode::Pedestrian) continue;
-		}
-		else {
-			if((*it)->type == AIGraphNode::Vehicle) continue;
-		}
-		
-		float dist = glm::length((*it)->position - getPosition());
-		if(dist < d) {
-			nearest = *it;
-			d = dist;
-		}
-	}
+	auto nearest = engine->aigraph.findNearestNode(getPosition(),
+		AIGraph::typeBit(vehicleNode ? AIGraphNode::Vehicle : AIGraphNode::Pedestrian));
 	
 	if(nearest) {
 		if(vehicleNode) {
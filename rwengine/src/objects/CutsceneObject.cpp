@@ -1,5 +1,7 @@
 #include <objects/CutsceneObject.hpp>
 #include <engine/Animator.hpp>
+#include <engine/GameData.hpp>
+#include <engine/GameWorld.hpp>
 #include <data/Skeleton.hpp>
 
 CutsceneObject::CutsceneObject(GameWorld *engine, const glm::vec3 &pos, const glm::quat& rot, const ModelRef& model)
@@ -8,7 +10,7 @@ CutsceneObject::CutsceneObject(GameWorld *engine, const glm::vec3 &pos, const gl
 	, _bone(nullptr)
 {
 	skeleton = new Skeleton;
-	animator = new Animator(model->resource, skeleton);
+	animator = new Animator(model->resource, skeleton, &engine->data->animationBindings);
 }
 
 CutsceneObject::~CutsceneObject()
@@ -16,6 +18,11 @@ CutsceneObject::~CutsceneObject()
 }
 
 void CutsceneObject::tick(float dt)
+{
+	RW_UNUSED(dt);
+}
+
+void CutsceneObject::tickAnimation(float dt)
 {
 	animator->tick(dt);
 }
@@ -42,6 +42,8 @@ InstanceObject::~InstanceObject()
 
 void InstanceObject::tick(float dt)
 {
+	RW_UNUSED(dt);
+
 	if( dynamics && body ) {
 		if( body->body->isStaticObject() ) {
 			if( _enablePhysics ) {
@@ -115,7 +117,10 @@ void InstanceObject::tick(float dt)
 			}
 		}
 	}
+}
 
+void InstanceObject::tickAnimation(float dt)
+{
 	if( animator ) animator->tick(dt);
 }
 
@@ -48,7 +48,10 @@ void ProjectileObject::explode()
 		const float damageSize = 5.f;
 		const float damage = _info.weapon->damage;
 
-		for(auto& o : engine->allObjects) {
+		std::vector<GameObject*> nearby;
+		engine->spatialIndex.queryRadius(getPosition(), damageSize, nearby);
+
+		for(auto& o : nearby) {
 			if( o == this ) continue;
 			switch( o->type() ) {
 			case GameObject::Instance:
@@ -18,10 +18,13 @@
 #include <data/Skeleton.hpp>
 #include <objects/CutsceneObject.hpp>
 #include <render/ObjectRenderer.hpp>
+#include <render/RenderListSort.hpp>
+#include <job/WorkContext.hpp>
 
 #include <render/GameShaders.hpp>
 #include <core/Logger.hpp>
 
+#include <algorithm>
 #include <deque>
 #include <cmath>
 #include <glm/gtc/type_ptr.hpp>
@@ -30,6 +33,8 @@
 #include <core/Profiler.hpp>
 
 const size_t skydomeSegments = 8, skydomeRows = 10;
+// Number of objects built into each partial render list
+constexpr size_t kRenderListChunkSize = 256;
 constexpr uint32_t kMissingTextureBytes[] = {
 	0xFF0000FF, 0xFFFF00FF, 0xFF0000FF, 0xFFFF00FF,
 	0xFFFF00FF, 0xFF0000FF, 0xFFFF00FF, 0xFF0000FF,
@@ -75,13 +80,15 @@ std::vector<VertexP2> sspaceRect = {
 GeometryBuffer ssRectGeom;
 DrawBuffer ssRectDraw;
 
-GameRenderer::GameRenderer(Logger* log, GameData* _data)
+GameRenderer::GameRenderer(Logger* log, GameData* _data, Renderer* backend)
 	: data(_data)
 	, logger(log)
-	, renderer(new OpenGLRenderer)
+	, renderer(backend ? backend : new OpenGLRenderer)
 	, _renderAlpha(0.f)
 	, _renderWorld(nullptr)
 	, cullOverride(false)
+	, framebufferName(0)
+	, m_missingTexture(0)
 	, map(renderer, _data)
 	, water(this)
 	, text(this)
@@ -114,6 +121,11 @@ GameRenderer::GameRenderer(Logger* log, GameData* _data)
 		GameShaders::DefaultPostProcess::VertexShader,
 		GameShaders::DefaultPostProcess::FragmentShader);
 
+	if( renderer->isHeadless() ) {
+		// Everything else is only used to draw with GL
+		return;
+	}
+
 	glGenVertexArrays( 1, &vao );
 
 	glGenTextures(1, &m_missingTexture);
@@ -241,7 +253,9 @@ GameRenderer::GameRenderer(Logger* log, GameData* _data)
 
 GameRenderer::~GameRenderer()
 {
-	glDeleteFramebuffers(1, &framebufferName);
+	if( framebufferName != 0 ) {
+		glDeleteFramebuffers(1, &framebufferName);
+	}
 }
 
 float mix(uint8_t a, uint8_t b, float num)
@@ -266,9 +280,14 @@ void GameRenderer::renderWorld(GameWorld* world, const ViewCamera &camera, float
 	// Store the input camera,
 	_camera = camera;
 
-	setupRender();
+	// Only objects are drawn without a GL context
+	bool headless = renderer->isHeadless();
 
-	glBindVertexArray( vao );
+	if (! headless) {
+		setupRender();
+
+		glBindVertexArray( vao );
+	}
 
 	float tod = world->getHour() + world->getMinute()/60.f;
 
@@ -327,39 +346,89 @@ void GameRenderer::renderWorld(GameWorld* world, const ViewCamera &camera, float
 
 	RW_PROFILE_BEGIN("RenderList");
 
-	// This is sequential at the moment, it should be easy to make it
-	// run in parallel with a good threading system.
-	RenderList renderList;
-	// Naive optimisation, assume 10% hitrate
-	renderList.reserve(world->allObjects.size() * 0.5f);
+	perf::PhaseTimer buildTimer;
+
+	RW_PROFILE_BEGIN("Cull");
+	// Only objects that might be in view are built into the render list
+	std::vector<GameObject*> objects;
+	objects.reserve(world->allObjects.size() / 4);
+	world->spatialIndex.queryFrustum((cullOverride ? cullingCamera : _camera).frustum, objects);
+	// Cutscene objects aren't indexed, they follow their parent's skeleton
+	for (auto object : world->cutscenePool) {
+		objects.push_back(object);
+	}
+	RW_PROFILE_END();
+
+	RW_PROFILE_BEGIN("Animate");
+	// Cutscene objects are attached to other object's skeletons, so every
+	// skeleton must be ready before building any of the lists.
+	for (auto object : objects) {
+		if (object->skeleton) {
+			object->skeleton->interpolate(_renderAlpha);
+		}
+	}
+	RW_PROFILE_END();
 
 	RW_PROFILE_BEGIN("Build");
 
-	ObjectRenderer objectRenderer(_renderWorld,
-					  (cullOverride ? cullingCamera : _camera),
-					  _renderAlpha,
-					  getMissingTexture());
+	// Each chunk of objects is built into its own list by its own renderer
+	size_t chunkCount = (objects.size() + kRenderListChunkSize - 1) / kRenderListChunkSize;
+	std::vector<RenderList> chunkLists(chunkCount);
+	std::vector<ObjectRenderer> objectRenderers;
+	objectRenderers.reserve(chunkCount);
+	for (size_t c = 0; c < chunkCount; ++c) {
+		objectRenderers.emplace_back(_renderWorld,
+									 (cullOverride ? cullingCamera : _camera),
+									 _renderAlpha,
+									 getMissingTexture());
+	}
+
+	auto buildChunk = [&](size_t begin, size_t end) {
+		size_t c = begin / kRenderListChunkSize;
+		// Naive optimisation, assume 50% hitrate
+		chunkLists[c].reserve((end - begin) / 2);
+		for (size_t i = begin; i < end; ++i) {
+			objectRenderers[c].buildRenderList(objects[i], chunkLists[c]);
+		}
+	};
+
+	if (world->_work) {
+		world->_work->parallelFor(objects.size(), kRenderListChunkSize, buildChunk);
+	}
+	else {
+		for (size_t begin = 0; begin < objects.size(); begin += kRenderListChunkSize) {
+			buildChunk(begin, std::min(begin + kRenderListChunkSize, objects.size()));
+		}
+	}
 
-	// World Objects
-	for (auto object : world->allObjects) {
-		objectRenderer.buildRenderList(object, renderList);
+	// Merge in chunk order so the list doesn't depend on thread timing
+	size_t instructionCount = 0;
+	for (auto& list : chunkLists) {
+		instructionCount += list.size();
+	}
+	RenderList renderList;
+	renderList.reserve(instructionCount);
+	for (size_t c = 0; c < chunkCount; ++c) {
+		objectRenderers[c].resolveTextures();
+		renderList.append(chunkLists[c]);
 	}
 	RW_PROFILE_END();
 
+	worldTimes[perf::PhaseBuild] = buildTimer.stop();
+
 	renderer->pushDebugGroup("Objects");
 	renderer->pushDebugGroup("RenderList");
 
-	// Also parallelizable
 	RW_PROFILE_BEGIN("Sort");
-	std::sort(renderList.begin(), renderList.end(),
-			  [](const Renderer::RenderInstruction& a,
-				 const Renderer::RenderInstruction&b) {
-					return a.sortKey < b.sortKey;
-				});
+	perf::PhaseTimer sortTimer;
+	sortRenderList(renderList, world->_work);
+	worldTimes[perf::PhaseSort] = sortTimer.stop();
 	RW_PROFILE_END();
 
 	RW_PROFILE_BEGIN("Draw");
+	perf::PhaseTimer drawTimer;
 	renderer->drawBatched(renderList);
+	worldTimes[perf::PhaseDraw] = drawTimer.stop();
 	RW_PROFILE_END();
 
 	renderer->popDebugGroup();
@@ -367,11 +436,17 @@ void GameRenderer::renderWorld(GameWorld* world, const ViewCamera &camera, float
 
 	RW_PROFILE_END();
 
+	if (headless) {
+		return;
+	}
+
 	// Render arrows above anything that isn't radar only (or hidden)
-	ModelRef& arrowModel = world->data->models["arrow"];
+	static const StringID arrowName = StringTable::get().intern("arrow");
+	static const TextureKey arrowTexName = textureKey("copblue");
+	ModelRef& arrowModel = world->data->models[arrowName];
 	if( arrowModel && arrowModel->resource )
 	{
-		auto arrowTex = world->data->textures[{"copblue",""}];
+		auto arrowTex = world->data->textures[arrowTexName];
 		auto arrowFrame = arrowModel->resource->findFrame( "arrow" );
 		for( auto& blip : world->state->radarBlips )
 		{
@@ -545,12 +620,10 @@ void GameRenderer::renderGeometry(Model* model, size_t g, const glm::mat4& model
 				auto tex = mat.textures[0].texture;
 				if( ! tex )
 				{
-					auto& tC = mat.textures[0].name;
-					auto& tA = mat.textures[0].alphaName;
-					tex = data->findTexture(tC, tA);
+					tex = data->findTexture(mat.textures[0].key);
 					if( ! tex )
 					{
-						//logger->warning("Renderer", "Missing texture: " + tC + " " + tA);
+						//logger->warning("Renderer", "Missing texture: " + mat.textures[0].name);
 					}
 					mat.textures[0].texture = tex;
 				}
@@ -172,7 +172,8 @@ layout(std140) uniform SceneData {
 	float fogEnd;
 };
 
-layout(std140) uniform ObjectData {
+// One entry per instance, MaxBatchInstances in OpenGLRenderer.hpp
+struct ObjectEntry {
 	mat4 model;
 	vec4 colour;
 	float diffusefac;
@@ -180,12 +181,25 @@ layout(std140) uniform ObjectData {
 	float visibility;
 };
 
+layout(std140) uniform ObjectData {
+	ObjectEntry objects[128];
+};
+
+flat out vec4 ObjectColour;
+flat out float AmbientFactor;
+flat out float Visibility;
+
 void main()
 {
+	ObjectEntry object = objects[gl_InstanceID];
+	ObjectColour = object.colour;
+	AmbientFactor = object.ambientfac;
+	Visibility = object.visibility;
+
 	Normal = normal;
 	TexCoords = texCoords;
 	Colour = _colour;
-	vec4 worldspace = model * vec4(position, 1.0);
+	vec4 worldspace = object.model * vec4(position, 1.0);
 	vec4 viewspace = view * worldspace;
 	gl_Position = projection * viewspace;
 
@@ -214,13 +228,9 @@ layout(std140) uniform SceneData {
 	float fogEnd;
 };
 
-layout(std140) uniform ObjectData {
-	mat4 model;
-	vec4 colour;
-	float diffusefac;
-	float ambientfac;
-	float visibility;
-};
+flat in vec4 ObjectColour;
+flat in float AmbientFactor;
+flat in float Visibility;
 
 // Ordered dithering matrix used to implement thresholded
 // screen-door transparency to fade objects without blending
@@ -237,10 +247,10 @@ void main()
 {
 	// Only the visibility parameter invokes the screen door.
 	vec4 diffuse = Colour;
-	diffuse.rgb += ambient.rgb*ambientfac;
-	diffuse *= colour;
+	diffuse.rgb += ambient.rgb*AmbientFactor;
+	diffuse *= ObjectColour;
 	diffuse *= texture(tex, TexCoords);
-	if(visibility <= filterMatrix[int(gl_FragCoord.x)%4][int(gl_FragCoord.y)%4]) discard;
+	if(Visibility <= filterMatrix[int(gl_FragCoord.x)%4][int(gl_FragCoord.y)%4]) discard;
 	if(diffuse.a <= alphaThreshold) discard;
 	float fog = 1.0 - clamp( (fogEnd-WorldSpace.w)/(fogEnd-fogStart), 0.0, 1.0 );
 	fragOut = vec4(mix(diffuse.rgb, fogColor.rgb, fog), diffuse.a);
@@ -267,13 +277,9 @@ layout(std140) uniform SceneData {
 	float fogEnd;
 };
 
-layout(std140) uniform ObjectData {
-	mat4 model;
-	vec4 colour;
-	float diffusefac;
-	float ambientfac;
-	float visibility;
-};
+flat in vec4 ObjectColour;
+flat in float AmbientFactor;
+flat in float Visibility;
 
 #define ALPHA_DISCARD_THRESHOLD 0.01
 
@@ -284,7 +290,7 @@ void main()
 	if(c.a <= ALPHA_DISCARD_THRESHOLD) discard;
 	float fogZ = (gl_FragCoord.z / gl_FragCoord.w);
 	float fogfac = clamp( (fogStart-fogZ)/(fogEnd-fogStart), 0.0, 1.0 );
-	vec4 tint = vec4(colour.rgb, visibility);
+	vec4 tint = vec4(ObjectColour.rgb, Visibility);
 	outColour = c * tint;
 })";
 
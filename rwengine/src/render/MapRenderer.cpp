@@ -43,6 +43,22 @@ void main()
 MapRenderer::MapRenderer(Renderer* renderer, GameData* _data)
 : data(_data), renderer(renderer)
 {
+	rectProg = renderer->createShader(
+		MapVertexShader,
+		MapFragmentShader
+	);
+
+	renderer->setUniform(rectProg, "colour", glm::vec4(1.f));
+
+	for( int m = 0; m < MAP_BLOCK_SIZE; ++m ) {
+		std::string num = (m < 10 ? "0" : "");
+		radarTiles.push_back(textureKey("radar" + num + std::to_string(m)));
+	}
+
+	if( renderer->isHeadless() ) {
+		return;
+	}
+
 	rectGeom.uploadVertices<VertexP2>({
 		{-.5f,  .5f},
 		{ .5f,  .5f},
@@ -63,13 +79,6 @@ MapRenderer::MapRenderer(Renderer* renderer, GameData* _data)
 	circleGeom.uploadVertices(circleVerts);
 	circle.addGeometry(&circleGeom);
 	circle.setFaceType(GL_TRIANGLE_FAN);
-	
-	rectProg = renderer->createShader(
-		MapVertexShader,
-		MapFragmentShader
-	);
-	
-	renderer->setUniform(rectProg, "colour", glm::vec4(1.f));
 }
 
 #define GAME_MAP_SIZE 4000
@@ -127,9 +136,7 @@ void MapRenderer::draw(GameWorld* world, const MapInfo& mi)
 
 	for( int m = 0; m < MAP_BLOCK_SIZE; ++m )
 	{
-		std::string num = (m < 10 ? "0" : "");
-		std::string name = "radar" + num +  std::to_string(m);
-		auto texture = world->data->textures[{name,""}];
+		auto texture = world->data->textures[radarTiles[m]];
 		
 		glBindTexture(GL_TEXTURE_2D, texture->getName());
 		
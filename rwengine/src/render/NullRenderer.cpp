@@ -0,0 +1,157 @@
+#include <render/NullRenderer.hpp>
+
+NullRenderer::NullRenderer()
+	: instanceCounter(0)
+	, recordObjectData(false)
+	, profile()
+{
+}
+
+std::string NullRenderer::getIDString() const
+{
+	return "Null Renderer";
+}
+
+Renderer::ShaderProgram* NullRenderer::createShader(const std::string& vert, const std::string& frag)
+{
+	RW_UNUSED(vert);
+	RW_UNUSED(frag);
+	return new ShaderProgram;
+}
+
+void NullRenderer::useProgram(Renderer::ShaderProgram* p)
+{
+	RW_UNUSED(p);
+}
+
+void NullRenderer::setProgramBlockBinding(Renderer::ShaderProgram* p, const std::string& name, GLint point)
+{
+	RW_UNUSED(p);
+	RW_UNUSED(name);
+	RW_UNUSED(point);
+}
+
+void NullRenderer::setUniformTexture(Renderer::ShaderProgram* p, const std::string& name, GLint tex)
+{
+	RW_UNUSED(p);
+	RW_UNUSED(name);
+	RW_UNUSED(tex);
+}
+
+void NullRenderer::setUniform(Renderer::ShaderProgram* p, const std::string& name, const glm::mat4& m)
+{
+	RW_UNUSED(p);
+	RW_UNUSED(name);
+	RW_UNUSED(m);
+}
+
+void NullRenderer::setUniform(Renderer::ShaderProgram* p, const std::string& name, const glm::vec4& v)
+{
+	RW_UNUSED(p);
+	RW_UNUSED(name);
+	RW_UNUSED(v);
+}
+
+void NullRenderer::setUniform(Renderer::ShaderProgram* p, const std::string& name, const glm::vec3& v)
+{
+	RW_UNUSED(p);
+	RW_UNUSED(name);
+	RW_UNUSED(v);
+}
+
+void NullRenderer::setUniform(Renderer::ShaderProgram* p, const std::string& name, const glm::vec2& v)
+{
+	RW_UNUSED(p);
+	RW_UNUSED(name);
+	RW_UNUSED(v);
+}
+
+void NullRenderer::setUniform(Renderer::ShaderProgram* p, const std::string& name, float f)
+{
+	RW_UNUSED(p);
+	RW_UNUSED(name);
+	RW_UNUSED(f);
+}
+
+void NullRenderer::clear(const glm::vec4& colour, bool clearColour, bool clearDepth)
+{
+	RW_UNUSED(colour);
+	RW_UNUSED(clearColour);
+	RW_UNUSED(clearDepth);
+}
+
+void NullRenderer::setSceneParameters(const Renderer::SceneUniformData& data)
+{
+	lastSceneData = data;
+	uploadCounter += sizeof(data);
+}
+
+void NullRenderer::draw(const glm::mat4& model, DrawBuffer* draw, const Renderer::DrawParameters& p)
+{
+	setDrawState(model, draw, p);
+	record(draw, p, 1);
+}
+
+void NullRenderer::drawArrays(const glm::mat4& model, DrawBuffer* draw, const Renderer::DrawParameters& p)
+{
+	setDrawState(model, draw, p);
+	record(draw, p, 1);
+}
+
+void NullRenderer::pushDebugGroup(const std::string& title)
+{
+	RW_UNUSED(title);
+}
+
+const Renderer::ProfileInfo& NullRenderer::popDebugGroup()
+{
+	return profile;
+}
+
+void NullRenderer::swap()
+{
+	Renderer::swap();
+	draws.clear();
+	objectData.clear();
+	instanceCounter = 0;
+}
+
+void NullRenderer::bindDrawBuffer(DrawBuffer* dbuff)
+{
+	RW_UNUSED(dbuff);
+}
+
+void NullRenderer::bindTexture(GLuint unit, GLuint tex)
+{
+	RW_UNUSED(unit);
+	RW_UNUSED(tex);
+}
+
+void NullRenderer::applyBlend(bool enable)
+{
+	RW_UNUSED(enable);
+}
+
+void NullRenderer::applyDepthWrite(bool enable)
+{
+	RW_UNUSED(enable);
+}
+
+void NullRenderer::writeObjectData(const ObjectUniformData* data, size_t count)
+{
+	if( recordObjectData ) {
+		objectData.insert(objectData.end(), data, data + count);
+	}
+}
+
+void NullRenderer::drawElementsInstanced(DrawBuffer* draw, const Renderer::DrawParameters& p, size_t instances)
+{
+	record(draw, p, instances);
+}
+
+void NullRenderer::record(DrawBuffer* draw, const Renderer::DrawParameters& p, size_t instances)
+{
+	GLuint texture = p.textures.size() > 0 ? p.textures[0] : 0;
+	draws.push_back({ draw, texture, p.count, instances });
+	instanceCounter += instances;
+}
@@ -22,11 +22,31 @@ constexpr float kVehicleDrawDistanceFactor = kDrawDistanceFactor;
 constexpr float kPedestrianDrawDistanceFactor = kDrawDistanceFactor;
 #endif
 
-RenderKey createKey(bool transparent, float normalizedDepth, Renderer::Textures& textures)
+/// Shared models looked up every frame
+const StringID kWeaponsModel = StringTable::get().intern("weapons");
+const StringID kWheelsModel = StringTable::get().intern("wheels");
+
+RenderKey createKey(bool transparent,
+					float normalizedDepth,
+					const Renderer::Textures& textures,
+					DrawBuffer* dbuff,
+					unsigned int start)
 {
-	return ((transparent?0x1:0x0) << 31)
-			| uint32_t(0x7FFFFF * (transparent? 1.f - normalizedDepth : normalizedDepth)) << 8
-			| uint8_t(0xFF & (textures.size() > 0 ? textures[0] : 0)) << 0;
+	RenderKey texture = textures.size() > 0 ? textures[0] : 0;
+	RenderKey depth = RenderKey(0xFFFFFF * glm::clamp(normalizedDepth, 0.f, 1.f));
+
+	if( transparent ) {
+		// Back to front
+		return (RenderKey(1) << 63)
+				| (0xFFFFFF - depth) << 32
+				| (texture & 0xFFFFFFFF);
+	}
+
+	// Keep draws of the same texture and geometry together so they can be batched
+	return (texture & 0x7FFF) << 48
+			| RenderKey(dbuff->getVAOName() & 0xFFFF) << 32
+			| RenderKey(start & 0xFF) << 24
+			| depth;
 }
 
 void ObjectRenderer::renderGeometry(Model* model,
@@ -62,15 +82,17 @@ void ObjectRenderer::renderGeometry(Model* model,
 				auto tex = mat.textures[0].texture;
 				if( ! tex )
 				{
-					auto& tC = mat.textures[0].name;
-					auto& tA = mat.textures[0].alphaName;
-					tex = m_world->data->findTexture(tC, tA);
+					tex = findTexture(mat.textures[0].key);
 					if( ! tex )
 					{
-						//logger->warning("Renderer", "Missing texture: " + tC + " " + tA);
+						//logger->warning("Renderer", "Missing texture: " + mat.textures[0].name);
 						dp.textures = { m_errorTexture };
 					}
-					mat.textures[0].texture = tex;
+					else
+					{
+						// Other renderers may be reading this material, see resolveTextures()
+						m_resolvedTextures.push_back({ &mat.textures[0], tex });
+					}
 				}
 				if( tex )
 				{
@@ -110,12 +132,13 @@ void ObjectRenderer::renderGeometry(Model* model,
 		glm::vec3 position(modelMatrix[3]);
 		float distance = glm::length(m_camera.position - position);
 		float depth = (distance - m_camera.frustum.near) / (m_camera.frustum.far - m_camera.frustum.near);
-		outList.emplace_back(
-							  createKey(isTransparent, depth * depth, dp.textures),
-							  modelMatrix,
-							  &model->geometries[g]->dbuff,
-							  dp
-						  );
+		outList.add(
+					createKey(isTransparent, depth * depth, dp.textures,
+							  &model->geometries[g]->dbuff, dp.start),
+					modelMatrix,
+					&model->geometries[g]->dbuff,
+					dp
+				);
 	}
 }
 bool ObjectRenderer::renderFrame(Model* m,
@@ -170,12 +193,12 @@ void ObjectRenderer::renderItem(InventoryItem *item,
 	}
 
 	std::shared_ptr<ObjectData> odata = m_world->data->findObjectType<ObjectData>(item->getModelID());
-	auto weapons = m_world->data->models["weapons"];
-	if( weapons && weapons->resource ) {
-		auto itemModel = weapons->resource->findFrame(odata->modelName + "_l0");
+	auto weapons = findModel(kWeaponsModel);
+	if( weapons ) {
+		auto itemModel = weapons->findFrame(odata->modelName + "_l0");
 		auto matrix = glm::inverse(itemModel->getTransform());
 		if(itemModel) {
-			renderFrame(weapons->resource,
+			renderFrame(weapons,
 						itemModel,
 						modelMatrix * matrix,
 						nullptr,
@@ -376,7 +399,7 @@ void ObjectRenderer::renderVehicle(VehicleObject *vehicle,
 	for( size_t w = 0; w < vehicle->info->wheels.size(); ++w) {
 		auto woi = m_world->data->findObjectType<ObjectData>(vehicle->vehicle->wheelModelID);
 		if( woi ) {
-			Model* wheelModel = m_world->data->models["wheels"]->resource;
+			Model* wheelModel = findModel(kWheelsModel);
 			auto& wi = vehicle->physVehicle->getWheelInfo(w);
 			if( wheelModel ) {
 				// Construct our own matrix so we can use the local transform
@@ -436,10 +459,10 @@ void ObjectRenderer::renderPickup(PickupObject *pickup,
 	/// @todo Better determination of is this object a weapon.
 	if( odata->ID >= 170 && odata->ID <= 184 )
 	{
-		auto weapons = m_world->data->models["weapons"];
-		if( weapons && weapons->resource && odata ) {
-			model = weapons->resource;
-			itemModel = weapons->resource->findFrame(odata->modelName + "_l0");
+		auto weapons = findModel(kWeaponsModel);
+		if( weapons && odata ) {
+			model = weapons;
+			itemModel = weapons->findFrame(odata->modelName + "_l0");
 			RW_CHECK(itemModel, "Weapon Frame not present int weapon model");
 			if ( ! itemModel )
 			{
@@ -449,11 +472,10 @@ void ObjectRenderer::renderPickup(PickupObject *pickup,
 	}
 	else
 	{
-		auto handle = m_world->data->models[odata->modelName];
-		RW_CHECK( handle && handle->resource, "Pickup has no model");
-		if ( handle && handle->resource )
+		model = findModel(odata->modelID);
+		RW_CHECK( model, "Pickup has no model");
+		if ( model )
 		{
-			model = handle->resource;
 			itemModel = model->frames[model->rootFrameIdx];
 		}
 	}
@@ -526,16 +548,16 @@ void ObjectRenderer::renderProjectile(ProjectileObject *projectile,
 	glm::mat4 modelMatrix = projectile->getTimeAdjustedTransform(m_renderAlpha);
 
 	auto odata = m_world->data->findObjectType<ObjectData>(projectile->getProjectileInfo().weapon->modelID);
-	auto weapons = m_world->data->models["weapons"];
+	auto weapons = findModel(kWeaponsModel);
 
 	RW_CHECK(weapons, "Weapons model not loaded");
 
-	if( weapons && weapons->resource ) {
-		auto itemModel = weapons->resource->findFrame(odata->modelName + "_l0");
+	if( weapons ) {
+		auto itemModel = weapons->findFrame(odata->modelName + "_l0");
 		auto matrix = glm::inverse(itemModel->getTransform());
 		RW_CHECK(itemModel, "Weapon frame not in model");
 		if(itemModel) {
-			renderFrame(weapons->resource,
+			renderFrame(weapons,
 						itemModel,
 						modelMatrix * matrix,
 						projectile,
@@ -545,13 +567,34 @@ void ObjectRenderer::renderProjectile(ProjectileObject *projectile,
 	}
 }
 
-void ObjectRenderer::buildRenderList(GameObject* object, RenderList& outList)
+TextureData::Handle ObjectRenderer::findTexture(TextureKey key) const
 {
-	if( object->skeleton )
-	{
-		object->skeleton->interpolate(m_renderAlpha);
+	// Don't use GameData::findTexture, it inserts missing names
+	auto& textures = m_world->data->textures;
+	auto it = textures.find(key);
+	return it != textures.end() ? it->second : nullptr;
+}
+
+Model* ObjectRenderer::findModel(StringID name) const
+{
+	auto& models = m_world->data->models;
+	auto it = models.find(name);
+	if( it == models.end() || ! it->second ) {
+		return nullptr;
+	}
+	return it->second->resource;
+}
+
+void ObjectRenderer::resolveTextures()
+{
+	for( auto& resolved : m_resolvedTextures ) {
+		resolved.first->texture = resolved.second;
 	}
+	m_resolvedTextures.clear();
+}
 
+void ObjectRenderer::buildRenderList(GameObject* object, RenderList& outList)
+{
 	// Right now specialized on each object type
 	switch(object->type()) {
 	case GameObject::Instance:
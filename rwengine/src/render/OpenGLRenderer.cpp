@@ -86,11 +86,57 @@ void Renderer::setViewport(const glm::ivec2& vp)
 	projection2D = glm::ortho(0.f, (float)viewport.x, (float)viewport.y, 0.f, -1.f, 1.f);
 }
 
+namespace
+{
+	// Number of ObjectData blocks streamed through before the buffer is orphaned
+	constexpr GLuint kObjectBlockCount = 64;
+
+	bool canBatch(const Renderer::RenderInstruction& a, const Renderer::RenderInstruction& b)
+	{
+		const auto& pa = a.drawInfo;
+		const auto& pb = b.drawInfo;
+		if( a.dbuff != b.dbuff || pa.start != pb.start || pa.count != pb.count
+				|| pa.blend != pb.blend || pa.depthWrite != pb.depthWrite
+				|| pa.textures.size() != pb.textures.size() ) {
+			return false;
+		}
+		for( size_t t = 0; t < pa.textures.size(); ++t ) {
+			if( pa.textures[t] != pb.textures[t] ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	Renderer::ObjectUniformData createObjectData(const glm::mat4& model, const Renderer::DrawParameters& p)
+	{
+		Renderer::ObjectUniformData data;
+		data.model = model;
+		data.colour = glm::vec4(p.colour.r/255.f, p.colour.g/255.f, p.colour.b/255.f, p.colour.a/255.f);
+		data.diffuse = 1.f;
+		data.ambient = 1.f;
+		data.visibility = p.visibility;
+		data.padding = 0.f;
+		return data;
+	}
+}
+
+Renderer::Renderer()
+	: currentDbuff(nullptr)
+	, blendEnabled(false)
+	, depthWriteEnabled(true)
+{
+	swap();
+	batchData.reserve(MaxBatchInstances);
+}
+
 void Renderer::swap()
 {
 	drawCounter = 0;
 	textureCounter = 0;
 	bufferCounter = 0;
+	stateCounter = 0;
+	uploadCounter = 0;
 }
 
 int Renderer::getDrawCount()
@@ -108,89 +154,219 @@ int Renderer::getTextureCount()
 	return textureCounter;
 }
 
+int Renderer::getStateChangeCount()
+{
+	return stateCounter;
+}
+
+size_t Renderer::getUploadedBytes()
+{
+	return uploadCounter;
+}
+
 const Renderer::SceneUniformData& Renderer::getSceneData() const
 {
 	return lastSceneData;
 }
 
-void OpenGLRenderer::useDrawBuffer(DrawBuffer* dbuff)
+void Renderer::useDrawBuffer(DrawBuffer* dbuff)
 {
 	if( dbuff != currentDbuff )
 	{
-		glBindVertexArray(dbuff->getVAOName());
+		bindDrawBuffer(dbuff);
 		currentDbuff = dbuff;
 		bufferCounter++;
-#if RW_PROFILER
-		if( currentDebugDepth > 0 )
-		{
-			profileInfo[currentDebugDepth-1].buffers++;
-		}
-#endif
 	}
 }
 
-void OpenGLRenderer::useTexture(GLuint unit, GLuint tex)
+void Renderer::useTexture(GLuint unit, GLuint tex)
 {
 	if( currentTextures[unit] != tex )
 	{
-		glActiveTexture(GL_TEXTURE0 + unit);
-		glBindTexture(GL_TEXTURE_2D, tex);
+		bindTexture(unit, tex);
 		currentTextures[unit] = tex;
 		textureCounter++;
-#if RW_PROFILER
-		if( currentDebugDepth > 0 )
+	}
+}
+
+void Renderer::setBlend(bool enable)
+{
+	if( enable != blendEnabled ) {
+		blendEnabled = enable;
+		stateCounter++;
+	}
+	/// @todo only apply changes, currently not possible because other functions keep trashing the state
+	applyBlend(enable);
+}
+
+void Renderer::setDepthWrite(bool enable)
+{
+	if( enable != depthWriteEnabled ) {
+		applyDepthWrite(enable);
+		depthWriteEnabled = enable;
+		stateCounter++;
+	}
+}
+
+void Renderer::uploadObjectData(const ObjectUniformData* data, size_t count)
+{
+	writeObjectData(data, count);
+	uploadCounter += sizeof(ObjectUniformData) * count;
+}
+
+void Renderer::setDrawState(const glm::mat4& model, DrawBuffer* draw, const Renderer::DrawParameters& p)
+{
+	useDrawBuffer(draw);
+
+	for( GLuint u = 0; u < p.textures.size(); ++u )
+	{
+		useTexture(u, p.textures[u]);
+	}
+
+	setBlend(p.blend);
+	setDepthWrite(p.depthWrite);
+
+	ObjectUniformData oudata = createObjectData(model, p);
+	uploadObjectData(&oudata, 1);
+
+	drawCounter++;
+}
+
+void Renderer::drawBatched(const RenderList& list)
+{
+	auto& instructions = list.instructions;
+	for( size_t first = 0; first < instructions.size(); )
+	{
+		auto& ri = instructions[first];
+
+		size_t end = first + 1;
+		while( end < instructions.size()
+			   && end - first < MaxBatchInstances
+			   && canBatch(ri, instructions[end]) ) {
+			end++;
+		}
+
+		useDrawBuffer(ri.dbuff);
+		for( GLuint u = 0; u < ri.drawInfo.textures.size(); ++u )
 		{
-			profileInfo[currentDebugDepth-1].textures++;
+			useTexture(u, ri.drawInfo.textures[u]);
 		}
-#endif
+		setBlend(ri.drawInfo.blend);
+		setDepthWrite(ri.drawInfo.depthWrite);
+
+		batchData.clear();
+		for( size_t i = first; i < end; ++i ) {
+			auto& instance = instructions[i];
+			batchData.push_back(createObjectData(list.getMatrix(instance), instance.drawInfo));
+		}
+		uploadObjectData(batchData.data(), batchData.size());
+
+		drawElementsInstanced(ri.dbuff, ri.drawInfo, end - first);
+		drawCounter++;
 
+		first = end;
 	}
 }
 
-void OpenGLRenderer::useProgram(Renderer::ShaderProgram* p)
+void Renderer::invalidate()
 {
-	if( p != currentProgram )
+	currentDbuff = nullptr;
+	currentTextures.clear();
+}
+
+void OpenGLRenderer::bindDrawBuffer(DrawBuffer* dbuff)
+{
+	glBindVertexArray(dbuff->getVAOName());
+#if RW_PROFILER
+	if( currentDebugDepth > 0 )
 	{
-		currentProgram = static_cast<OpenGLShaderProgram*>(p);
-		glUseProgram( currentProgram->getName() );
+		profileInfo[currentDebugDepth-1].buffers++;
 	}
+#endif
 }
 
-#if 0
-template<>
-void OpenGLRenderer::uploadUBO<OpenGLRenderer::ObjectUniformData>(GLuint buffer, const ObjectUniformData& data)
+void OpenGLRenderer::bindTexture(GLuint unit, GLuint tex)
 {
-	if( currentUBO != buffer ) {
-		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
-		currentUBO = buffer;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, tex);
+#if RW_PROFILER
+	if( currentDebugDepth > 0 )
+	{
+		profileInfo[currentDebugDepth-1].textures++;
 	}
-	/*glBindBufferRange(GL_UNIFORM_BUFFER,
-					  2,
-					  UBOObject,
-					  entryAlignment * currentObjectEntry,
-					  sizeof(ObjectUniformData));*/
-	glBufferSubData(GL_UNIFORM_BUFFER,
-					0,
-					sizeof(ObjectUniformData), &data);
+#endif
+}
+
+void OpenGLRenderer::applyBlend(bool enable)
+{
+	RW_UNUSED(enable);
+	glEnable(GL_BLEND);
+}
+
+void OpenGLRenderer::applyDepthWrite(bool enable)
+{
+	glDepthMask(enable ? GL_TRUE : GL_FALSE);
+}
+
+void OpenGLRenderer::writeObjectData(const ObjectUniformData* data, size_t count)
+{
+	if( currentUBO != UBOObject ) {
+		glBindBuffer(GL_UNIFORM_BUFFER, UBOObject);
+		currentUBO = UBOObject;
+	}
+
+	// Orphan the buffer once every block has been used, instead of
+	// waiting for draws that are still reading from it.
+	if( currentObjectBlock == objectBlockCount ) {
+		glBufferData(GL_UNIFORM_BUFFER,
+					 objectBlockStride * objectBlockCount,
+					 NULL,
+					 GL_STREAM_DRAW);
+		currentObjectBlock = 0;
+	}
+
+	GLintptr offset = objectBlockStride * currentObjectBlock;
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(ObjectUniformData) * count, data);
+	glBindBufferRange(GL_UNIFORM_BUFFER, 2, UBOObject, offset, objectBlockSize);
+	currentObjectBlock++;
+
 #if RW_PROFILER
 	if( currentDebugDepth > 0 )
 	{
 		profileInfo[currentDebugDepth-1].uploads++;
 	}
 #endif
-	currentObjectEntry = (currentObjectEntry+1) % maxObjectEntries;
 }
+
+void OpenGLRenderer::drawElementsInstanced(DrawBuffer* draw, const DrawParameters& p, size_t instances)
+{
+	glDrawElementsInstanced(draw->getFaceType(), p.count, GL_UNSIGNED_INT,
+							(void*) (sizeof(RenderIndex) * p.start), instances);
+#if RW_PROFILER
+	if( currentDebugDepth > 0 )
+	{
+		profileInfo[currentDebugDepth-1].draws++;
+		profileInfo[currentDebugDepth-1].primitives += p.count * instances;
+	}
 #endif
+}
+
+void OpenGLRenderer::useProgram(Renderer::ShaderProgram* p)
+{
+	if( p != currentProgram )
+	{
+		currentProgram = static_cast<OpenGLShaderProgram*>(p);
+		glUseProgram( currentProgram->getName() );
+	}
+}
 
 OpenGLRenderer::OpenGLRenderer()
-	: currentDbuff(nullptr)
-	, currentProgram(nullptr)
+	: currentProgram(nullptr)
 	, currentUBO(0)
-	, maxObjectEntries(0)
-	, currentObjectEntry(0)
-	, entryAlignment(0)
-	, blendEnabled(false)
-	, depthWriteEnabled(true)
+	, objectBlockSize(0)
+	, objectBlockStride(0)
+	, objectBlockCount(kObjectBlockCount)
+	, currentObjectBlock(0)
 	, currentDebugDepth(0)
 {
 	// We need to query for some profiling exts.
@@ -200,24 +376,23 @@ OpenGLRenderer::OpenGLRenderer()
 	glGenBuffers(1, &UBOObject);
 
 	glBindBufferBase(GL_UNIFORM_BUFFER, 1, UBOScene);
-	glBindBufferBase(GL_UNIFORM_BUFFER, 2, UBOObject);
-	
-	swap();
 
 	GLint maxUBOSize, UBOAlignment;
 	glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxUBOSize);
 	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &UBOAlignment);
-	entryAlignment = 128;
-	maxObjectEntries = maxUBOSize / entryAlignment;
+	objectBlockSize = sizeof(ObjectUniformData) * MaxBatchInstances;
+	objectBlockStride = ((objectBlockSize + UBOAlignment - 1) / UBOAlignment) * UBOAlignment;
 	std::cout << "Max UBO Size: " << maxUBOSize << std::endl;
 	std::cout << "UBO Alignment: " << UBOAlignment << std::endl;
-	std::cout << "Max batch size: " << maxObjectEntries << std::endl;
+	std::cout << "Max batch size: " << MaxBatchInstances << std::endl;
 
 	glBindBuffer(GL_UNIFORM_BUFFER, UBOObject);
 	glBufferData(GL_UNIFORM_BUFFER,
-				 entryAlignment * maxObjectEntries,
+				 objectBlockStride * objectBlockCount,
 				 NULL,
 				 GL_STREAM_DRAW);
+	currentUBO = UBOObject;
+	glBindBufferRange(GL_UNIFORM_BUFFER, 2, UBOObject, 0, objectBlockSize);
 
 	glGenQueries(1, &debugQuery);
 }
@@ -314,28 +489,9 @@ void OpenGLRenderer::setSceneParameters(const Renderer::SceneUniformData& data)
 	lastSceneData = data;
 }
 
-void OpenGLRenderer::setDrawState(const glm::mat4& model, DrawBuffer* draw, const Renderer::DrawParameters& p)
+void OpenGLRenderer::draw(const glm::mat4& model, DrawBuffer* draw, const Renderer::DrawParameters& p)
 {
-	useDrawBuffer(draw);
-
-	for( GLuint u = 0; u < p.textures.size(); ++u )
-	{
-		useTexture(u, p.textures[u]);
-	}
-
-	setBlend(p.blend);
-	setDepthWrite(p.depthWrite);
-
-	ObjectUniformData oudata {
-		model,
-		glm::vec4(p.colour.r/255.f, p.colour.g/255.f, p.colour.b/255.f, p.colour.a/255.f),
-		1.f,
-		1.f,
-		p.visibility
-	};
-	uploadUBO(UBOObject, oudata);
-
-	drawCounter++;
+	setDrawState(model, draw, p);
 #if RW_PROFILER
 	if( currentDebugDepth > 0 )
 	{
@@ -343,11 +499,6 @@ void OpenGLRenderer::setDrawState(const glm::mat4& model, DrawBuffer* draw, cons
 		profileInfo[currentDebugDepth-1].primitives += p.count;
 	}
 #endif
-}
-
-void OpenGLRenderer::draw(const glm::mat4& model, DrawBuffer* draw, const Renderer::DrawParameters& p)
-{
-	setDrawState(model, draw, p);
 
 	glDrawElements(draw->getFaceType(), p.count, GL_UNSIGNED_INT,
 				   (void*) (sizeof(RenderIndex) * p.start));
@@ -356,67 +507,21 @@ void OpenGLRenderer::draw(const glm::mat4& model, DrawBuffer* draw, const Render
 void OpenGLRenderer::drawArrays(const glm::mat4& model, DrawBuffer* draw, const Renderer::DrawParameters& p)
 {
 	setDrawState(model, draw, p);
-
-	glDrawArrays(draw->getFaceType(), p.start, p.count);
-}
-
-void OpenGLRenderer::drawBatched(const RenderList& list)
-{
-#if 0 // Needs shader changes
-	// Determine how many batches we need to process the entire list
-	auto entries = list.size();
-	glBindBuffer(GL_UNIFORM_BUFFER, UBOObject);
-	for (int b = 0; b < entries; b += maxObjectEntries)
-	{
-		auto toConsume = std::min((GLuint)entries, b + maxObjectEntries) - b;
-		std::vector<ObjectUniformData> uploadBuffer;
-		uploadBuffer.resize(toConsume);
-		for (int d = 0; d < toConsume; ++d)
-		{
-			auto& draw = list[b+d];
-			uploadBuffer[d] = {
-				draw.model,
-				glm::vec4(draw.drawInfo.colour.r/255.f,
-				draw.drawInfo.colour.g/255.f,
-				draw.drawInfo.colour.b/255.f, 1.f),
-				1.f,
-				1.f,
-				draw.drawInfo.colour.a/255.f
-			};
-		}
-		glBufferData(GL_UNIFORM_BUFFER,
-					 toConsume * sizeof(ObjectUniformData),
-					 uploadBuffer.data(),
-					 GL_STREAM_DRAW);
-
-		// Dispatch individual draws
-		for (int d = 0; d < toConsume; ++d)
-		{
-			auto& draw = list[b+d];
-			useDrawBuffer(draw.dbuff);
-
-			for( GLuint u = 0; u < draw.drawInfo.textures.size(); ++u )
-			{
-				useTexture(u, draw.drawInfo.textures[u]);
-			}
-
-			glDrawElements(draw.dbuff->getFaceType(), draw.drawInfo.count, GL_UNSIGNED_INT,
-						   (void*) (sizeof(RenderIndex) * draw.drawInfo.start));
-		}
-	}
-#else
-	for(auto& ri : list)
+#if RW_PROFILER
+	if( currentDebugDepth > 0 )
 	{
-		draw(ri.model, ri.dbuff, ri.drawInfo);
+		profileInfo[currentDebugDepth-1].draws++;
+		profileInfo[currentDebugDepth-1].primitives += p.count;
 	}
 #endif
+
+	glDrawArrays(draw->getFaceType(), p.start, p.count);
 }
 
 void OpenGLRenderer::invalidate()
 {
-	currentDbuff = nullptr;
+	Renderer::invalidate();
 	currentProgram = nullptr;
-	currentTextures.clear();
 	currentUBO = 0;
 }
 
@@ -0,0 +1,100 @@
+#include <render/RenderListSort.hpp>
+#include <job/WorkContext.hpp>
+
+#include <array>
+
+namespace
+{
+	constexpr size_t kRadixBits = 8;
+	constexpr size_t kRadixBuckets = 1 << kRadixBits;
+
+	// Lists smaller than this are sorted on the calling thread only
+	constexpr size_t kParallelSortThreshold = 8192;
+
+	struct SortEntry
+	{
+		RenderKey key;
+		uint32_t index;
+	};
+
+	typedef std::array<size_t, kRadixBuckets> Histogram;
+}
+
+void sortRenderList(RenderList& list, WorkContext* work)
+{
+	auto& instructions = list.instructions;
+	size_t count = instructions.size();
+	if( count < 2 ) {
+		return;
+	}
+
+	std::vector<SortEntry> entries(count);
+	std::vector<SortEntry> scratch(count);
+
+	// Any bit set here differs between at least two keys
+	RenderKey varying = 0;
+	for( size_t i = 0; i < count; ++i ) {
+		entries[i] = { instructions[i].sortKey, uint32_t(i) };
+		varying |= entries[i].key ^ entries[0].key;
+	}
+
+	size_t chunkSize = count;
+	if( work && count >= kParallelSortThreshold ) {
+		size_t threads = work->getWorkerCount() + 1;
+		chunkSize = (count + threads - 1) / threads;
+	}
+	size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+	// Each chunk has its own histogram, then its own output offsets
+	std::vector<Histogram> histograms(chunks);
+
+	auto forEachChunk = [&](const std::function<void(size_t, size_t)>& func) {
+		if( chunks > 1 ) {
+			work->parallelFor(count, chunkSize, func);
+		}
+		else {
+			func(0, count);
+		}
+	};
+
+	for( size_t shift = 0; shift < sizeof(RenderKey) * 8; shift += kRadixBits ) {
+		if( ((varying >> shift) & (kRadixBuckets - 1)) == 0 ) {
+			continue;
+		}
+
+		forEachChunk([&](size_t begin, size_t end) {
+			Histogram& histogram = histograms[begin / chunkSize];
+			histogram.fill(0);
+			for( size_t i = begin; i < end; ++i ) {
+				histogram[(entries[i].key >> shift) & (kRadixBuckets - 1)]++;
+			}
+		});
+
+		// Earlier chunks come first within each bucket, keeping the sort stable
+		size_t offset = 0;
+		for( size_t b = 0; b < kRadixBuckets; ++b ) {
+			for( auto& histogram : histograms ) {
+				size_t n = histogram[b];
+				histogram[b] = offset;
+				offset += n;
+			}
+		}
+
+		forEachChunk([&](size_t begin, size_t end) {
+			Histogram& offsets = histograms[begin / chunkSize];
+			for( size_t i = begin; i < end; ++i ) {
+				scratch[offsets[(entries[i].key >> shift) & (kRadixBuckets - 1)]++] = entries[i];
+			}
+		});
+
+		entries.swap(scratch);
+	}
+
+	// Instructions only refer to their matrix, which doesn't move
+	std::vector<Renderer::RenderInstruction> sorted;
+	sorted.reserve(count);
+	for( auto& entry : entries ) {
+		sorted.push_back(instructions[entry.index]);
+	}
+	instructions.swap(sorted);
+}
@@ -3,6 +3,7 @@
 #include <engine/GameWorld.hpp>
 
 #include <algorithm>
+#include <functional>
 
 /// @todo This is very rough
 int charToIndex(char g)
@@ -92,79 +93,81 @@ void main()
 	outColour = vec4(Colour, a);
 })";
 
-struct TextVertex
-{
-	glm::vec2 position;
-	glm::vec2 texcoord;
-	glm::vec3 colour;
-	
-	static const AttributeList vertex_attributes() {
-		return {
-			{ATRS_Position, 2, sizeof(TextVertex),  0ul},
-			{ATRS_TexCoord, 2, sizeof(TextVertex),  0ul + sizeof(glm::vec2)},
-			{ATRS_Colour, 3, sizeof(TextVertex),  0ul + sizeof(glm::vec2) * 2},
-		};
-	}
-};
-
 TextRenderer::TextInfo::TextInfo()
 : font(0), size(1.f), baseColour({1.f, 1.f, 1.f}), align(Left), wrapX(0)
 {
 
 }
 
-TextRenderer::TextRenderer(GameRenderer* renderer)
-: fonts({}), renderer(renderer)
+namespace
 {
-	textShader = renderer->getRenderer()->createShader(
-		TextVertexShader, TextFragmentShader );
-	
-	for( int g = 0; g < GAME_GLYPHS; g++ )
+	struct GlyphTable
 	{
-		glyphData[g] = { .9f };
-	}
-	
-	glyphData[charToIndex(' ')].widthFrac = 0.4f;
-	glyphData[charToIndex('-')].widthFrac = 0.5f;
-	glyphData[charToIndex('\'')].widthFrac = 0.5f;
-	glyphData[charToIndex('(')].widthFrac = 0.45f;
-	glyphData[charToIndex(')')].widthFrac = 0.45f;
-	glyphData[charToIndex(':')].widthFrac = 0.65f;
-	glyphData[charToIndex('$')].widthFrac = 0.65f;
-
-	for(char g = '0'; g <= '9'; ++g) {
-		glyphData[charToIndex(g)].widthFrac = 0.65f;
-	}
+		TextRenderer::GlyphInfo glyphs[GAME_GLYPHS];
 
-	// Assumes contigious a-z character encoding
-	for(char g = 0; g <= ('z'-'a'); g++)
-	{
-		switch( ('a' + g) )
+		GlyphTable()
 		{
-		case 'i':
-			glyphData[charToIndex('a' + g)].widthFrac = 0.4f;
-			glyphData[charToIndex('A' + g)].widthFrac = 0.4f;
-			break;
-		case 'l':
-			glyphData[charToIndex('a' + g)].widthFrac = 0.5f;
-			glyphData[charToIndex('A' + g)].widthFrac = 0.5f;
-			break;
-		case 'm':
-			glyphData[charToIndex('a' + g)].widthFrac = 1.0f;
-			glyphData[charToIndex('A' + g)].widthFrac = 1.0f;
-			break;
-		case 'w':
-			glyphData[charToIndex('a' + g)].widthFrac = 1.0f;
-			glyphData[charToIndex('A' + g)].widthFrac = 1.0f;
-			break;
-		default:
-			glyphData[charToIndex('a' + g)].widthFrac = 0.7f;
-			glyphData[charToIndex('A' + g)].widthFrac = 0.7f;
-			break;
+			for( int g = 0; g < GAME_GLYPHS; g++ )
+			{
+				glyphs[g] = { .9f };
+			}
+
+			glyphs[charToIndex(' ')].widthFrac = 0.4f;
+			glyphs[charToIndex('-')].widthFrac = 0.5f;
+			glyphs[charToIndex('\'')].widthFrac = 0.5f;
+			glyphs[charToIndex('(')].widthFrac = 0.45f;
+			glyphs[charToIndex(')')].widthFrac = 0.45f;
+			glyphs[charToIndex(':')].widthFrac = 0.65f;
+			glyphs[charToIndex('$')].widthFrac = 0.65f;
+
+			for(char g = '0'; g <= '9'; ++g) {
+				glyphs[charToIndex(g)].widthFrac = 0.65f;
+			}
+
+			// Assumes contigious a-z character encoding
+			for(char g = 0; g <= ('z'-'a'); g++)
+			{
+				switch( ('a' + g) )
+				{
+				case 'i':
+					glyphs[charToIndex('a' + g)].widthFrac = 0.4f;
+					glyphs[charToIndex('A' + g)].widthFrac = 0.4f;
+					break;
+				case 'l':
+					glyphs[charToIndex('a' + g)].widthFrac = 0.5f;
+					glyphs[charToIndex('A' + g)].widthFrac = 0.5f;
+					break;
+				case 'm':
+					glyphs[charToIndex('a' + g)].widthFrac = 1.0f;
+					glyphs[charToIndex('A' + g)].widthFrac = 1.0f;
+					break;
+				case 'w':
+					glyphs[charToIndex('a' + g)].widthFrac = 1.0f;
+					glyphs[charToIndex('A' + g)].widthFrac = 1.0f;
+					break;
+				default:
+					glyphs[charToIndex('a' + g)].widthFrac = 0.7f;
+					glyphs[charToIndex('A' + g)].widthFrac = 0.7f;
+					break;
+				}
+			}
 		}
+	};
+
+	const TextRenderer::GlyphInfo* getGlyphData()
+	{
+		static const GlyphTable table;
+		return table.glyphs;
 	}
 }
 
+TextRenderer::TextRenderer(GameRenderer* renderer)
+: fonts({}), renderer(renderer)
+{
+	textShader = renderer->getRenderer()->createShader(
+		TextVertexShader, TextFragmentShader );
+}
+
 TextRenderer::~TextRenderer()
 {
 
@@ -175,95 +178,152 @@ void TextRenderer::setFontTexture(int index, const std::string& texture)
 	if( index < GAME_FONTS )
 	{
 		fonts[index] = texture;
+		fontTextures[index] = nullptr;
 	}
 }
 
-void TextRenderer::renderText(const TextRenderer::TextInfo& ti, bool forceColour)
+namespace
 {
-	renderer->getRenderer()->pushDebugGroup("Text");
-	renderer->getRenderer()->useProgram(textShader);
-	
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glActiveTexture(GL_TEXTURE0);
-	
+	/**
+	 * Sets colour for a markup code, returns false if it isn't a colour
+	 */
+	bool markupColour(char code, glm::vec3& colour)
+	{
+		switch( code )
+		{
+		case 'g': // Green
+			colour = glm::vec3(glm::u8vec3(90, 157, 102)) * (1/255.f);
+			return true;
+		case 'h': // White
+			colour = glm::vec3(1.f); /// @todo FIXME! Use proper colour!
+			return true;
+		case 'l': // Black
+			colour = glm::vec3(0.f); /// @todo FIXME! Use proper colour!
+			return true;
+		case 'r': // Red
+			colour = glm::vec3(1.f, 0.0f, 0.0f); /// @todo FIXME! Use proper colour!
+			return true;
+		case 'w': // Gray
+			colour = glm::vec3(0.5f); /// @todo FIXME! Use proper colour!
+			return true;
+		case 'y': // Yellow
+			colour = glm::vec3(1.0f, 1.0f, 0.0f); /// @todo FIXME! Use proper colour!
+			return true;
+		}
+		return false;
+	}
+
+	size_t hashText(const TextRenderer::TextInfo& ti, bool forceColour)
+	{
+		size_t hash = std::hash<std::string>()(ti.text);
+		auto combine = [&](size_t value) {
+			hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		};
+		combine(std::hash<int>()(ti.font));
+		combine(std::hash<float>()(ti.size));
+		combine(std::hash<int>()(ti.wrapX));
+		combine((ti.baseColour.r << 16) | (ti.baseColour.g << 8) | ti.baseColour.b);
+		combine(forceColour);
+		return hash;
+	}
+
+	bool sameLayout(const TextRenderer::TextInfo& a, const TextRenderer::TextInfo& b)
+	{
+		return a.font == b.font && a.size == b.size && a.wrapX == b.wrapX
+				&& a.baseColour == b.baseColour && a.text == b.text;
+	}
+}
+
+void TextRenderer::layoutText(const TextInfo& ti, bool forceColour, TextLayout& layout)
+{
+	auto glyphData = getGlyphData();
+	const std::string& text = ti.text;
+
 	glm::vec2 coord( 0.f, 0.f );
-	glm::vec2 alignment = ti.screenPosition;
 	// We should track real size not just chars.
 	auto lineLength = 0;
-	
-	glm::vec2 ss( ti.size );
+	// True while inside a word that's already been checked for wrapping
+	bool inWord = false;
 
+	glm::vec2 ss( ti.size );
 	glm::vec3 colour = glm::vec3(ti.baseColour) * (1/255.f);
-	glm::vec4 colourBG  = glm::vec4(ti.backgroundColour) * (1/255.f);
-	std::vector<TextVertex> geo;
-	
-	float maxWidth = 0.f;
-	float maxHeight = 0.f;
 
-	auto text = ti.text;
-	
+	layout.vertices.clear();
+	layout.width = 0.f;
+	layout.height = 0.f;
+
+	auto addGlyph = [&](int glyph)
+	{
+		if (forceColour) {
+			colour = glm::vec3(ti.baseColour) * (1/255.f);
+		}
+
+		auto& data = glyphData[glyph];
+		auto tex = indexToCoord(ti.font, glyph);
+		
+		ss.x = ti.size * data.widthFrac;
+		tex.z = tex.x + (tex.z - tex.x) * data.widthFrac;
+		lineLength ++;
+
+		glm::vec2 p = coord;
+		coord.x += ss.x;
+		layout.width = std::max(coord.x, layout.width);
+		
+		layout.vertices.push_back({ { p.x,        p.y + ss.y }, {tex.x, tex.w}, colour });
+		layout.vertices.push_back({ { p.x + ss.x, p.y + ss.y }, {tex.z, tex.w}, colour });
+		layout.vertices.push_back({ { p.x,        p.y },        {tex.x, tex.y}, colour });
+		
+		
+		layout.vertices.push_back({ { p.x + ss.x, p.y },        {tex.z, tex.y}, colour });
+		layout.vertices.push_back({ { p.x,        p.y },        {tex.x, tex.y}, colour });
+		layout.vertices.push_back({ { p.x + ss.x, p.y + ss.y }, {tex.z, tex.w}, colour });
+	};
+
+	auto newLine = [&]()
+	{
+		coord.x = 0.f;
+		coord.y += ss.y;
+		layout.height = coord.y + ss.y;
+		lineLength = 0;
+	};
+
 	for (size_t i = 0; i < text.length(); ++i)
 	{
 		char c = text[i];
 
-		// Handle any markup changes.
+		// Handle any markup changes by skipping over the markup.
 		if( c == '~' && text.length() > i + 1 )
 		{
-			switch( text[i+1] )
+			if( markupColour(text[i+1], colour) )
 			{
-			case 'g': // Green
-				text.erase(text.begin()+i, text.begin()+i+3);
-				colour = glm::vec3(glm::u8vec3(90, 157, 102)) * (1/255.f);
-				break;
-			case 'h': // White
-				text.erase(text.begin()+i, text.begin()+i+3);
-				colour = glm::vec3(1.f); /// @todo FIXME! Use proper colour!
-				break;
-			case 'k': { // Key
-				text.erase(text.begin()+i, text.begin()+i+3);
-				// Extract the key name from the /next/ markup
-				auto keyend = text.find('~', i+1);
-				auto keyname = text.substr(i+1, keyend-i-1);
-				// Since we don't have a key map yet, just print out the name
-				text.erase(text.begin()+i, text.begin()+keyend);
-				text.insert(i, keyname);
-				break;
+				i += 2;
+				continue;
 			}
-			case 'l': // Black
-				text.erase(text.begin()+i, text.begin()+i+3);
-				colour = glm::vec3(0.f); /// @todo FIXME! Use proper colour!
-				break;
-			case 'r': // Red
-				text.erase(text.begin()+i, text.begin()+i+3);
-				colour = glm::vec3(1.f, 0.0f, 0.0f); /// @todo FIXME! Use proper colour!
-				break;
-			case 'w': // Gray
-				text.erase(text.begin()+i, text.begin()+i+3);
-				colour = glm::vec3(0.5f); /// @todo FIXME! Use proper colour!
-				break;
-			case 'y': // Yellow
-				text.erase(text.begin()+i, text.begin()+i+3);
-				colour = glm::vec3(1.0f, 1.0f, 0.0f); /// @todo FIXME! Use proper colour!
-				break;
+			else if( text[i+1] == 'k' && text.length() > i + 3 )
+			{
+				// The key name is in the /next/ markup: ~k~~NAME~
+				// Since we don't have a key map yet, just print out the name
+				auto keyend = text.find('~', i + 4);
+				if( keyend == text.npos ) keyend = text.length();
+				for( size_t k = i + 4; k < keyend; ++k )
+				{
+					addGlyph(charToIndex(text[k]));
+				}
+				i = keyend;
+				continue;
 			}
-			
-			c = text[i];
 		}
 
-		if (forceColour) {
-			colour = glm::vec3(ti.baseColour) * (1/255.f);
-		}
-		
 		int glyph = charToIndex(c);
 		if( glyph >= GAME_GLYPHS )
 		{
 			continue;
 		}
 
-		// If we're not at the start of the column, check if the current word
-		// will need to be wrapped
-		if (ti.wrapX > 0 && coord.x > 0.f && !std::isspace(c))
+		// At the start of a word that isn't at the start of the column,
+		// check if the word will need to be wrapped
+		bool space = std::isspace(c);
+		if (ti.wrapX > 0 && coord.x > 0.f && !space && !inWord)
 		{
 			auto wend = std::find_if(std::begin(text)+i,
 									 std::end(text),
@@ -273,52 +333,120 @@ void TextRenderer::renderText(const TextRenderer::TextInfo& ti, bool forceColour
 				auto word = std::distance(std::begin(text)+i, wend);
 				if (lineLength + word >= ti.wrapX)
 				{
-					coord.x = 0;
-					coord.y += ss.y;
-					maxHeight = coord.y + ss.y;
-					lineLength = 0;
+					newLine();
 				}
 			}
 		}
-		
-		auto& data = glyphData[glyph];
-		auto tex = indexToCoord(ti.font, glyph);
-		
-		ss.x = ti.size * data.widthFrac;
-		tex.z = tex.x + (tex.z - tex.x) * data.widthFrac;
+		inWord = !space;
 		
 		// Handle special chars.
 		if( c == '\n' )
 		{
-			coord.x = 0.f;
-			coord.y += ss.y;
-			maxHeight = coord.y + ss.y;
-			lineLength = 0;
+			ss.x = ti.size * glyphData[glyph].widthFrac;
+			newLine();
 			continue;
 		}
-		lineLength ++;
 
-		glm::vec2 p = coord;
-		coord.x += ss.x;
-		maxWidth = std::max(coord.x, maxWidth);
-		
-		geo.push_back({ { p.x,        p.y + ss.y }, {tex.x, tex.w}, colour });
-		geo.push_back({ { p.x + ss.x, p.y + ss.y }, {tex.z, tex.w}, colour });
-		geo.push_back({ { p.x,        p.y },        {tex.x, tex.y}, colour });
-		
-		
-		geo.push_back({ { p.x + ss.x, p.y },        {tex.z, tex.y}, colour });
-		geo.push_back({ { p.x,        p.y },        {tex.x, tex.y}, colour });
-		geo.push_back({ { p.x + ss.x, p.y + ss.y }, {tex.z, tex.w}, colour });
+		addGlyph(glyph);
 	}
+
+	layout.glyphSize = ss;
+}
+
+TextRenderer::LayoutCache::LayoutCache(size_t capacity)
+	: capacity(capacity)
+	, stats{ 0, 0 }
+{
+}
+
+TextRenderer::LayoutCache::Entry& TextRenderer::LayoutCache::get(const TextInfo& ti, bool forceColour)
+{
+	size_t hash = hashText(ti, forceColour);
+
+	auto it = index.find(hash);
+	if( it != index.end() )
+	{
+		auto entry = it->second;
+		if( entry->forceColour == forceColour && sameLayout(entry->key, ti) )
+		{
+			stats.hits++;
+			entries.splice(entries.begin(), entries, entry);
+			return *entry;
+		}
+
+	}
+
+	stats.misses++;
+
+	// Reuse an entry's buffers where possible, texts that change every
+	// frame would otherwise create new ones every frame
+	std::list<Entry>::iterator reused = entries.end();
+	if( it != index.end() )
+	{
+		// A different text with the same hash, replace it
+		reused = it->second;
+		index.erase(it);
+	}
+	else if( ! entries.empty() && entries.size() >= capacity )
+	{
+		reused = std::prev(entries.end());
+		index.erase(reused->hash);
+	}
+
+	if( reused != entries.end() )
+	{
+		entries.splice(entries.begin(), entries, reused);
+	}
+	else
+	{
+		entries.emplace_front();
+	}
+
+	auto& entry = entries.front();
+	entry.hash = hash;
+	entry.key = ti;
+	entry.forceColour = forceColour;
+	entry.uploaded = false;
+	layoutText(ti, forceColour, entry.layout);
+	index[hash] = entries.begin();
+
+	return entry;
+}
+
+void TextRenderer::renderText(const TextRenderer::TextInfo& ti, bool forceColour)
+{
+	auto& entry = layouts.get(ti, forceColour);
+	auto& layout = entry.layout;
+	if( ! entry.uploaded )
+	{
+		// Reused entries already have a buffer set up to draw from
+		bool created = entry.db.getVAOName() == 0;
+		entry.gb.uploadVertices(layout.vertices);
+		if( created ) {
+			entry.db.addGeometry(&entry.gb);
+			entry.db.setFaceType(GL_TRIANGLES);
+		}
+		entry.uploaded = true;
+	}
+
+	renderer->getRenderer()->pushDebugGroup("Text");
+	renderer->getRenderer()->useProgram(textShader);
+	
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glActiveTexture(GL_TEXTURE0);
+	
+	glm::vec2 alignment = ti.screenPosition;
+	glm::vec2 ss = layout.glyphSize;
+	glm::vec4 colourBG  = glm::vec4(ti.backgroundColour) * (1/255.f);
 	
 	if ( ti.align == TextInfo::Right )
 	{
-		alignment.x -= maxWidth;
+		alignment.x -= layout.width;
 	}
 	else if ( ti.align == TextInfo::Center )
 	{
-		alignment.x -= (maxWidth / 2.f);
+		alignment.x -= (layout.width / 2.f);
 	}
 
 	alignment.y -= ti.size * 0.2f;
@@ -330,7 +458,7 @@ void TextRenderer::renderText(const TextRenderer::TextInfo& ti, bool forceColour
 					colourBG,
 					glm::vec4(
 						ti.screenPosition - (ss/3.f),
-						glm::vec2(maxWidth, maxHeight)+(ss/2.f)));
+						glm::vec2(layout.width, layout.height)+(ss/2.f)));
 
 	}
 	
@@ -338,18 +466,17 @@ void TextRenderer::renderText(const TextRenderer::TextInfo& ti, bool forceColour
 	renderer->getRenderer()->setUniformTexture(textShader, "fontTexture", 0);
 	renderer->getRenderer()->setUniform(textShader, "alignment", alignment);
 	
-	gb.uploadVertices(geo);
-	db.addGeometry(&gb);
-	db.setFaceType(GL_TRIANGLES);
-	
 	Renderer::DrawParameters dp;
 	dp.start = 0;
-	dp.count = gb.getCount();
-	auto ftexture = renderer->getData()->findTexture(fonts[ti.font]);
+	dp.count = entry.gb.getCount();
+	auto& ftexture = fontTextures[ti.font];
+	if( ! ftexture ) {
+		ftexture = renderer->getData()->findTexture(fonts[ti.font]);
+	}
 	dp.textures = {ftexture->getName()};
 	dp.depthWrite = false;
 	
-	renderer->getRenderer()->drawArrays(glm::mat4(), &db, dp);
+	renderer->getRenderer()->drawArrays(glm::mat4(), &entry.db, dp);
 
 	renderer->getRenderer()->popDebugGroup();
 }
@@ -23,6 +23,10 @@ WaterRenderer::WaterRenderer(GameRenderer* renderer)
 	
 	renderer->getRenderer()->setUniformTexture(waterProg, "data", 1);
 
+	if( renderer->getRenderer()->isHeadless() ) {
+		return;
+	}
+
 	// Generate grid mesh
 	int gridres = 60;
 	std::vector<glm::vec2> grid;
@@ -3,6 +3,7 @@
 void SCMFile::loadFile(char *data, unsigned int size)
 {
 	_data = new SCMByte[size];
+	_size = size;
 	std::copy(data, data+size, _data);
 
 	// Bytes required to hop over a jump opcode.
@@ -5,6 +5,7 @@
 #include <engine/GameWorld.hpp>
 #include <core/Logger.hpp>
 #include <cstring>
+#include <cstdio>
 
 SCMOpcodes::~SCMOpcodes()
 {
@@ -32,7 +33,117 @@ void ScriptMachine::interuptNext()
     interupt = true;
 }
 
-#include <iostream>
+ScriptMachine::SCMInstruction& ScriptMachine::getInstruction(SCMThread& t, SCMThread::pc_t pc)
+{
+	if( pc >= instructionIndex.size() )
+	{
+		throw IllegalInstruction(0, pc, t.name);
+	}
+
+	if( instructionIndex[pc] == 0 )
+	{
+		instructions.push_back(decodeInstruction(t, pc));
+		instructionIndex[pc] = instructions.size();
+	}
+	return instructions[instructionIndex[pc] - 1];
+}
+
+ScriptMachine::SCMInstruction ScriptMachine::decodeInstruction(SCMThread& t, SCMThread::pc_t pc)
+{
+	SCMInstruction instruction;
+	auto opcode = _file->read<SCMOpcode>(pc);
+
+	instruction.isNegatedConditional = ((opcode & SCM_NEGATE_CONDITIONAL_MASK) == SCM_NEGATE_CONDITIONAL_MASK);
+	opcode = opcode & ~SCM_NEGATE_CONDITIONAL_MASK;
+
+	instruction.code = opcodeTable[opcode];
+	if( instruction.code == nullptr )
+	{
+		throw IllegalInstruction(opcode, pc, t.name);
+	}
+	instruction.opcode = opcode;
+	instruction.localCount = 0;
+	instruction.localsThread = nullptr;
+
+	pc += sizeof(SCMOpcode);
+
+	SCMParams& parameters = instruction.parameters;
+
+	bool hasExtraParameters = instruction.code->arguments < 0;
+	auto requiredParams = std::abs(instruction.code->arguments);
+
+	for( int p = 0; p < requiredParams || hasExtraParameters; ++p ) {
+		auto type_r = _file->read<SCMByte>(pc);
+		auto type = static_cast<SCMType>(type_r);
+
+		if( type_r > 42 ) {
+			// for implicit strings, we need the byte we just read.
+			type = TString;
+		}
+		else {
+			pc += sizeof(SCMByte);
+		}
+
+		parameters.push_back(SCMOpcodeParameter { type, { 0 } });
+		switch(type) {
+		case EndOfArgList:
+			hasExtraParameters = false;
+			break;
+		case TInt8:
+			parameters.back().integer = _file->read<std::int8_t>(pc);
+			pc += sizeof(SCMByte);
+			break;
+		case TInt16:
+			parameters.back().integer = _file->read<std::int16_t>(pc);
+			pc += sizeof(SCMByte) * 2;
+			break;
+		case TGlobal: {
+			auto v = _file->read<std::uint16_t>(pc);
+			parameters.back().globalPtr = globalData.data() + v; //* SCM_VARIABLE_SIZE;
+			if( v >= _file->getGlobalsSize() )
+			{
+				state->world->logger->error("SCM", "Global Out of bounds! "+ std::to_string(v) + " " + std::to_string(_file->getGlobalsSize()));
+			}
+			pc += sizeof(SCMByte) * 2;
+		}
+			break;
+		case TLocal: {
+			// Pointed at the executing thread's locals before each use
+			auto v = _file->read<std::uint16_t>(pc);
+			if( instruction.localCount < SCMParams::MaxParameters )
+			{
+				instruction.locals[instruction.localCount++] = std::make_pair(std::uint8_t(parameters.size() - 1), v);
+			}
+			if( v >= SCM_THREAD_LOCAL_SIZE )
+			{
+				state->world->logger->error("SCM", "Local Out of bounds!");
+			}
+			pc += sizeof(SCMByte) * 2;
+		}
+			break;
+		case TInt32:
+			parameters.back().integer = _file->read<std::int32_t>(pc);
+			pc += sizeof(SCMByte) * 4;
+			break;
+		case TString:
+			std::copy(_file->data()+pc, _file->data()+pc+8,
+					  parameters.back().string);
+			pc += sizeof(SCMByte) * 8;
+			break;
+		case TFloat16:
+			parameters.back().real = _file->read<std::int16_t>(pc) / 16.f;
+			pc += sizeof(SCMByte) * 2;
+			break;
+		default:
+			throw UnknownType(type, pc, t.name);
+			break;
+		};
+	}
+
+	instruction.next = pc;
+	return instruction;
+}
+
 void ScriptMachine::executeThread(SCMThread &t, int msPassed)
 {
 	if( t.wakeCounter > 0 ) {
@@ -43,91 +154,23 @@ void ScriptMachine::executeThread(SCMThread &t, int msPassed)
 	bool hasDebugging = !! bpHandler;
 	
     while( t.wakeCounter == 0 ) {
-        auto pc = t.programCounter;
-        auto opcode = _file->read<SCMOpcode>(pc);
-
-		bool isNegatedConditional = ((opcode & SCM_NEGATE_CONDITIONAL_MASK) == SCM_NEGATE_CONDITIONAL_MASK);
-		opcode = opcode & ~SCM_NEGATE_CONDITIONAL_MASK;
+		SCMInstruction& instruction = getInstruction(t, t.programCounter);
+		ScriptFunctionMeta& code = *instruction.code;
+		auto opcode = instruction.opcode;
+		auto pc = instruction.next;
 
-		ScriptFunctionMeta* foundcode;
-		if( ! _ops->findOpcode(opcode, &foundcode) )
+		// Local parameters still point to the last thread that ran this
+		if( instruction.localsThread != &t )
 		{
-            throw IllegalInstruction(opcode, pc, t.name);
-		}
-		ScriptFunctionMeta& code = *foundcode;
-
-        pc += sizeof(SCMOpcode);
-
-		SCMParams parameters;
-		
-		bool hasExtraParameters = code.arguments < 0;
-		auto requiredParams = std::abs(code.arguments);
-
-		for( int p = 0; p < requiredParams || hasExtraParameters; ++p ) {
-            auto type_r = _file->read<SCMByte>(pc);
-			auto type = static_cast<SCMType>(type_r);
-
-			if( type_r > 42 ) {
-				// for implicit strings, we need the byte we just read.
-				type = TString;
-			}
-			else {
-                pc += sizeof(SCMByte);
-			}
-
-			parameters.push_back(SCMOpcodeParameter { type, { 0 } });
-			switch(type) {
-			case EndOfArgList:
-				hasExtraParameters = false;
-				break;
-			case TInt8:
-				parameters.back().integer = _file->read<std::int8_t>(pc);
-				pc += sizeof(SCMByte);
-				break;
-			case TInt16:
-				parameters.back().integer = _file->read<std::int16_t>(pc);
-				pc += sizeof(SCMByte) * 2;
-				break;
-			case TGlobal: {
-				auto v = _file->read<std::uint16_t>(pc);
-				parameters.back().globalPtr = globalData.data() + v; //* SCM_VARIABLE_SIZE;
-				if( v >= _file->getGlobalsSize() )
-				{
-					state->world->logger->error("SCM", "Global Out of bounds! "+ std::to_string(v) + " " + std::to_string(_file->getGlobalsSize()));
-				}
-				pc += sizeof(SCMByte) * 2;
-			}
-				break;
-			case TLocal: {
-				auto v = _file->read<std::uint16_t>(pc);
-				parameters.back().globalPtr = t.locals.data() + v * SCM_VARIABLE_SIZE;
-				if( v >= SCM_THREAD_LOCAL_SIZE )
-				{
-					state->world->logger->error("SCM", "Local Out of bounds!");
-				}
-				pc += sizeof(SCMByte) * 2;
+			for( std::uint8_t l = 0; l < instruction.localCount; ++l )
+			{
+				auto& local = instruction.locals[l];
+				instruction.parameters[local.first].globalPtr = t.locals.data() + local.second * SCM_VARIABLE_SIZE;
 			}
-				break;
-			case TInt32:
-				parameters.back().integer = _file->read<std::int32_t>(pc);
-				pc += sizeof(SCMByte) * 4;
-				break;
-			case TString:
-                std::copy(_file->data()+pc, _file->data()+pc+8,
-						  parameters.back().string);
-                pc += sizeof(SCMByte) * 8;
-				break;
-			case TFloat16:
-                parameters.back().real = _file->read<std::int16_t>(pc) / 16.f;
-                pc += sizeof(SCMByte) * 2;
-				break;
-			default:
-                throw UnknownType(type, pc, t.name);
-				break;
-			};
+			instruction.localsThread = &t;
 		}
 
-        ScriptArguments sca(&parameters, &t, this);
+        ScriptArguments sca(&instruction.parameters, &t, this);
 
         if( hasDebugging )
         {
@@ -164,8 +207,12 @@ void ScriptMachine::executeThread(SCMThread &t, int msPassed)
         {
 			code.function(sca);
 		}
+		else if(code.condition)
+		{
+			t.conditionResult = code.condition(sca);
+		}
 
-		if(isNegatedConditional) {
+		if(instruction.isNegatedConditional) {
 			t.conditionResult = !t.conditionResult;
 		}
 
@@ -206,7 +253,17 @@ void ScriptMachine::executeThread(SCMThread &t, int msPassed)
 
 ScriptMachine::ScriptMachine(GameState* _state, SCMFile *file, SCMOpcodes *ops)
     : _file(file), _ops(ops), state(_state), interupt(false)
+	, opcodeTable(SCM_OPCODE_COUNT, nullptr)
+	, instructionIndex(file->getSize(), 0)
 {
+	if( _ops )
+	{
+		for( ScriptFunctionID id = 0; id < SCM_OPCODE_COUNT; ++id )
+		{
+			_ops->findOpcode(id, &opcodeTable[id]);
+		}
+	}
+
 	auto globals = _file->getGlobalsSize();
 	globalData.resize(globals);
 	for(size_t i = 0; i < globals; ++i)
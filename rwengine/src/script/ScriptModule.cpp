@@ -1,14 +1,31 @@
 #include <script/ScriptModule.hpp>
 #include <script/ScriptMachine.hpp>
 
-void ScriptModule::bind(ScriptFunctionID id, ScriptFunction func, bool conditional, int args, const std::string& name, const std::string& desc)
+void ScriptModule::bind(ScriptFunctionID id, ScriptFunction func, int args, const std::string& name, const std::string& desc)
 {
 	functions.insert(
 		{ id,
 			{
 				func,
+				nullptr,
 				args,
-				conditional,
+				false,
+				name,
+				desc
+			}
+		}
+	);
+}
+
+void ScriptModule::bind(ScriptFunctionID id, ScriptFunctionBoolean func, int args, const std::string& name, const std::string& desc)
+{
+	functions.insert(
+		{ id,
+			{
+				nullptr,
+				func,
+				args,
+				true,
 				name,
 				desc
 			}
@@ -26,8 +43,3 @@ bool ScriptModule::findOpcode(ScriptFunctionID id, ScriptFunctionMeta** out)
 	*out = &functions[id];
 	return true;
 }
-
-template<> ScriptFunction conditional_facade<bool>(bool(*f)(const ScriptArguments&))
-{ return [=](const ScriptArguments& a) { return a.getThread()->conditionResult = f(a); }; }
-
-template<> bool is_conditional<bool>(bool(*)(const ScriptArguments&)) { return true; }
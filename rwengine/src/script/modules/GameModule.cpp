@@ -419,16 +419,8 @@ bool game_is_car_inside_garage(const ScriptArguments& args)
 	RW_CHECK(garageIndex < static_cast<int>(garages.size()), "Garage index too high");
 	const auto& garage = garages[garageIndex];
 
-	for(auto& v : gw->vehiclePool.objects) {
-		// @todo if this car only accepts mission cars we probably have to filter here / only check for one specific car
-		auto vp = v.second->getPosition();
-		if (vp.x >= garage.min.x && vp.y >= garage.min.y && vp.z >= garage.min.z &&
-		    vp.x <= garage.max.x && vp.y <= garage.max.y && vp.z <= garage.max.z) {
-			return true;
-		}
-	}
-
-	return false;
+	// @todo if this car only accepts mission cars we probably have to filter here / only check for one specific car
+	return gw->query.anyInBox(garage.min, garage.max, {GameObject::Vehicle});
 }
 
 bool game_garage_contains_car(const ScriptArguments& args)
@@ -479,7 +471,7 @@ bool game_special_char_loaded(const ScriptArguments& args)
 {
 	auto chartype = args.getWorld()->data->findObjectType<CharacterData>(args[0].integer);
 	if( chartype ) {
-		auto modelfind = args.getWorld()->data->models.find(chartype->modelName);
+		auto modelfind = args.getWorld()->data->models.find(GameData::modelID(chartype->modelName));
 		if( modelfind != args.getWorld()->data->models.end() && modelfind->second->resource != nullptr ) {
 			return true;
 		}
@@ -1010,24 +1002,17 @@ void game_clear_area(const ScriptArguments& args)
 
 	GameWorld* gw = args.getWorld();
 
-	for(auto& v : gw->vehiclePool.objects)
-	{
-		if( glm::distance(position, v.second->getPosition()) < radius )
-		{
-			gw->destroyObjectQueued(v.second);
-		}
-	}
+	std::vector<GameObject*> found;
+	gw->query.sphere(position, radius, {GameObject::Vehicle, GameObject::Character}, found);
 
-	for(auto& p : gw->pedestrianPool.objects)
+	for(auto object : found)
 	{
 		// Hack: Not sure what other objects are exempt from this opcode
-		if (p.second->getLifetime() == GameObject::PlayerLifetime) {
+		if (object->type() == GameObject::Character &&
+		    object->getLifetime() == GameObject::PlayerLifetime) {
 			continue;
 		}
-		if( glm::distance(position, p.second->getPosition()) < radius )
-		{
-			gw->destroyObjectQueued(p.second);
-		}
+		gw->destroyObjectQueued(object);
 	}
 
 	/// @todo Do we also have to clear all projectiles + particles *in this area*, even if the bool is false?
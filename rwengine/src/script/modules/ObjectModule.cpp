@@ -767,33 +767,14 @@ bool game_objects_in_volume(const ScriptArguments& args)
 	RW_UNUSED(objects);
 	RW_UNUSED(particles);
 	
-	for(auto& object : args.getWorld()->allObjects)
-	{
-		switch( object->type() )
-		{
-			case GameObject::Instance:
-				if( !solids ) continue;
-				break;
-			case GameObject::Character:
-				if( !actors ) continue;
-				break;
-			case GameObject::Vehicle:
-				if( !cars ) continue;
-				break;
-			default:
-				continue;
-		}
-		
-		// Maybe consider object bounds?
-		auto pp = object->getPosition();
-		
-		if( pp.x >= min.x && pp.y >= min.y && pp.z >= min.z &&
-			pp.x <= max.x && pp.y <= max.y && pp.z <= max.z )
-		{
-			return true;
-		}
-	}
-	return false;
+	WorldQuery::Filter filter;
+	filter.types = 0;
+	if( solids ) filter.types |= 1u << GameObject::Instance;
+	if( actors ) filter.types |= 1u << GameObject::Character;
+	if( cars ) filter.types |= 1u << GameObject::Vehicle;
+	
+	// Maybe consider object bounds?
+	return filter.types != 0 && args.getWorld()->query.anyInBox(min, max, filter);
 }
 
 bool game_is_vehicle_in_water(const ScriptArguments& args)
@@ -1031,8 +1012,9 @@ void game_create_object_world(const ScriptArguments& args)
 	if( id < 0 ) {
 		auto& modelname = args.getVM()->getFile()->getModels()[-id];
 		id = args.getWorld()->data->findModelObject(modelname);
-		if( id == (uint16_t)-1 ) {
+		if( id < 0 ) {
 			args.getWorld()->logger->error("SCM", "Failed to find model " + modelname);
+			return;
 		}
 	}
 
@@ -1114,16 +1096,17 @@ void game_set_close_object_visible(const ScriptArguments& args)
 	
 	model = args.getVM()->getFile()->getModels()[modelid];
 	
-	std::transform(model.begin(), model.end(), model.begin(), ::tolower);
+	auto modelname = GameData::modelID(model);
+	if( args.getWorld()->data->modelObjects.count(modelname) == 0 ) {
+		args.getWorld()->logger->error("SCM", "Failed to find model " + model);
+		return;
+	}
 	
-	for(auto& p : args.getWorld()->instancePool.objects) {
-		auto o = p.second;
-		if( !o->model ) continue;
-		if( o->model->name != model ) continue;
-		float d = glm::distance(position, o->getPosition());
-		if( d < radius ) {
-			o->visible = !!args[5].integer;
-		}
+	std::vector<GameObject*> found;
+	args.getWorld()->query.sphere(position, radius,
+		WorldQuery::Filter({GameObject::Instance}).withModelID(modelname), found);
+	for(auto o : found) {
+		o->visible = !!args[5].integer;
 	}
 }
 
@@ -1174,21 +1157,30 @@ void game_change_nearest_model(const ScriptArguments& args)
 	std::transform(newmodel.begin(), newmodel.end(), newmodel.begin(), ::tolower);
 	std::transform(oldmodel.begin(), oldmodel.end(), oldmodel.begin(), ::tolower);
 	
-	auto newobjectid = args.getWorld()->data->findModelObject(newmodel);
-	auto nobj = args.getWorld()->data->findObjectType<ObjectData>(newobjectid);
+	auto& modelObjects = args.getWorld()->data->modelObjects;
+	auto newobject = modelObjects.find(GameData::modelID(newmodel));
+	if( newobject == modelObjects.end() ) {
+		args.getWorld()->logger->error("SCM", "Failed to find model " + newmodel);
+		return;
+	}
+	auto nobj = args.getWorld()->data->findObjectType<ObjectData>(newobject->second);
+	
+	auto oldmodelname = GameData::modelID(oldmodel);
+	if( modelObjects.count(oldmodelname) == 0 ) {
+		args.getWorld()->logger->error("SCM", "Failed to find model " + oldmodel);
+		return;
+	}
+	
+	std::vector<GameObject*> found;
+	args.getWorld()->query.sphere(position, radius,
+		WorldQuery::Filter({GameObject::Instance}).withModelID(oldmodelname), found);
 	
 	/// @todo Objects need to adopt the new object ID, not just the model.
-	for(auto p : args.getWorld()->instancePool.objects) {
-		auto o = p.second;
-		if( !o->model ) continue;
-		if( o->model->name != oldmodel ) continue;
-		float d = glm::distance(position, o->getPosition());
-		if( d < radius ) {
-			args.getWorld()->data->loadDFF(newmodel + ".dff", false);
-			InstanceObject* inst = static_cast<InstanceObject*>(o);
-			inst->changeModel(nobj);
-			inst->model = args.getWorld()->data->models[newmodel];
-		}
+	for(auto o : found) {
+		args.getWorld()->data->loadDFF(newmodel + ".dff", false);
+		InstanceObject* inst = static_cast<InstanceObject*>(o);
+		inst->changeModel(nobj);
+		inst->model = args.getWorld()->data->models[GameData::modelID(newmodel)];
 	}
 }
 
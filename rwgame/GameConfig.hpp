@@ -23,6 +23,11 @@ public:
 	 */
 	bool isValid();
 
+	/**
+	 * @brief getConfigPath Returns the directory the configuration is stored in
+	 */
+	const std::string& getConfigPath() const { return m_configPath; }
+
 	const std::string& getGameDataPath() const { return m_gamePath; }
 	bool getInputInvertY() const { return m_inputInvertY; }
 
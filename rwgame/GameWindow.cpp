@@ -11,11 +11,13 @@ GameWindow::GameWindow() :
 }
 
 
-void GameWindow::create(size_t w, size_t h, bool fullscreen)
+void GameWindow::create(size_t w, size_t h, bool fullscreen, bool hidden)
 {
 	uint32_t style = SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE;
 	if (fullscreen)
 		style |= SDL_WINDOW_FULLSCREEN;
+	if (hidden)
+		style |= SDL_WINDOW_HIDDEN;
 
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
@@ -16,7 +16,11 @@ class GameWindow
 public:
 	GameWindow();
 
-	void create(size_t w, size_t h, bool fullscreen);
+	/**
+	 * Opens the window and its GL context
+	 * @param hidden Create the window without showing it
+	 */
+	void create(size_t w, size_t h, bool fullscreen, bool hidden = false);
 	void close();
 
 	void showCursor();
@@ -13,8 +13,10 @@
 #include <engine/GameState.hpp>
 #include <engine/SaveGame.hpp>
 #include <engine/GameWorld.hpp>
+#include <engine/StreamingManager.hpp>
 #include <render/GameRenderer.hpp>
 #include <render/DebugDraw.hpp>
+#include <render/NullRenderer.hpp>
 
 #include <script/ScriptMachine.hpp>
 #include <script/modules/VMModule.hpp>
@@ -26,6 +28,9 @@
 #include <objects/CharacterObject.hpp>
 #include <objects/VehicleObject.hpp>
 
+#include <cerrno>
+#include <sys/stat.h>
+
 #define MOUSE_SENSITIVITY_SCALE 2.5f
 
 DebugDraw* debug;
@@ -37,7 +42,8 @@ RWGame::RWGame(int argc, char* argv[])
 	, state(nullptr), world(nullptr), renderer(nullptr), script(nullptr),
 	debugScript(false), inFocus(true),
 	showDebugStats(false), showDebugPaths(false), showDebugPhysics(false),
-	accum(0.f), timescale(1.f)
+	accum(0.f), timescale(1.f),
+	fixedTimestep(false), headless(false), frameStats(nullptr)
 {
 	if (!config.isValid())
 	{
@@ -50,6 +56,7 @@ RWGame::RWGame(int argc, char* argv[])
 	bool test = false;
     std::string startSave;
 	std::string benchFile;
+	std::string benchOutput;
 
 	for( int i = 1; i < argc; ++i )
 	{
@@ -85,12 +92,25 @@ RWGame::RWGame(int argc, char* argv[])
 		{
 			benchFile = argv[i+1];
 		}
+		if( strcmp( "--benchmark-output", argv[i]) == 0 && i+1 < argc )
+		{
+			benchOutput = argv[i+1];
+		}
+		if( strcmp( "--fixed-timestep", argv[i]) == 0 )
+		{
+			fixedTimestep = true;
+		}
+		if( strcmp( "--headless", argv[i]) == 0 )
+		{
+			headless = true;
+		}
 	}
 
 	if (SDL_Init(SDL_INIT_VIDEO) < 0)
 		throw std::runtime_error("Failed to initialize SDL2!");
 
-	window.create(w, h, fullscreen);
+	// Textures are still uploaded when headless, so a GL context is needed
+	window.create(w, h, fullscreen, headless);
 	window.hideCursor();
 
 	log.addReciever(&logPrinter);
@@ -103,6 +123,10 @@ RWGame::RWGame(int argc, char* argv[])
 
 	data = new GameData(&log, &work, config.getGameDataPath());
 
+	// Skip walking the data directory if it hasn't changed since last time
+	auto indexCache = config.getConfigPath() + "/fileindex.cache";
+	data->index.loadCache(indexCache);
+
 	// Initalize all the archives.
 	data->loadIMG("/models/gta3");
 	//engine->data.loadIMG("/models/txd");
@@ -110,9 +134,25 @@ RWGame::RWGame(int argc, char* argv[])
 	data->loadTXD("/models/hud.txd");
 	
 	data->load();
+
+	if( ! data->index.saveCache(indexCache) ) {
+		log.warning("Game", "Unable to write file index cache " + indexCache);
+	}
+
+	// Collision meshes' BVHs are read back instead of rebuilt
+	data->collisionShapes.loadCache(config.getConfigPath() + "/collision.cache");
+
+	// IPL files are kept in a binary form once they've been parsed
+	auto worldCache = config.getConfigPath() + "/world";
+	if( mkdir(worldCache.c_str(), 0755) == 0 || errno == EEXIST ) {
+		data->worldCachePath = worldCache;
+	}
+	else {
+		log.warning("Game", "Unable to create world cache directory " + worldCache);
+	}
 	
 	// Initialize renderer
-	renderer = new GameRenderer(&log, data);
+	renderer = new GameRenderer(&log, data, headless ? new NullRenderer : nullptr);
 	
 	// Set up text renderer
 	renderer->text.setFontTexture(0, "pager");
@@ -140,7 +180,7 @@ RWGame::RWGame(int argc, char* argv[])
 	auto loading = new LoadingState(this);
 	if (! benchFile.empty())
 	{
-		loading->setNextState(new BenchmarkState(this, benchFile));
+		loading->setNextState(new BenchmarkState(this, benchFile, benchOutput));
 	}
 	else if( newgame )
 	{
@@ -191,13 +231,22 @@ void RWGame::newGame()
 	state->world = world;
 	world->state = state;
 
+	// Instance models and textures are loaded around the camera as it moves
+	world->streaming = new StreamingManager(world);
+
 	for(std::map<std::string, std::string>::iterator it = world->data->iplLocations.begin();
 		it != world->data->iplLocations.end();
 		++it) {
 		world->data->loadZone(it->second);
 		world->placeItems(it->second);
 	}
-	
+
+	if( data->collisionShapes.getBuiltBvhCount() > 0 ) {
+		auto collisionCache = config.getConfigPath() + "/collision.cache";
+		if( ! data->collisionShapes.saveCache(collisionCache) ) {
+			log.warning("Game", "Unable to write collision cache " + collisionCache);
+		}
+	}
 }
 
 void RWGame::saveGame(const std::string& savename)
@@ -300,6 +349,8 @@ int RWGame::run()
 		State* state = StateManager::get().states.back();
 
 		RW_PROFILE_FRAME_BOUNDARY();
+		perf::PhaseTimer frameTimer;
+		frameTimes = perf::FrameTimes();
 		
 		RW_PROFILE_BEGIN("Input");
 		SDL_Event event;
@@ -340,7 +391,13 @@ int RWGame::run()
 		auto now = clock.now();
 		float timer = std::chrono::duration<float>(now - last_clock_time).count();
 		last_clock_time = now;
-		accum += timer * timescale;
+		if ( fixedTimestep ) {
+			// Run one step every frame, so each run simulates the same thing
+			accum = GAME_TIMESTEP;
+		}
+		else {
+			accum += timer * timescale;
+		}
 
 		RW_PROFILE_BEGIN("Update");
 		if ( accum >= GAME_TIMESTEP ) {
@@ -353,7 +410,9 @@ int RWGame::run()
 			}
 
 			RW_PROFILE_BEGIN("engine");
+			perf::PhaseTimer tickTimer;
 			tick(GAME_TIMESTEP);
+			frameTimes[perf::PhaseTick] = tickTimer.stop();
 			RW_PROFILE_END();
 			
 			accum -= GAME_TIMESTEP;
@@ -373,20 +432,38 @@ int RWGame::run()
 		}
 
 		RW_PROFILE_BEGIN("Render");
+		RW_PROFILE_BEGIN("uploads");
+		data->textureUploads.process();
+		RW_PROFILE_END();
 		RW_PROFILE_BEGIN("engine");
+		// Frames that don't draw the world record no world times
+		renderer->worldTimes = perf::FrameTimes();
 		render(alpha, timer);
 		RW_PROFILE_END();
 
-		RW_PROFILE_BEGIN("state");
-		if (StateManager::get().states.size() > 0) {
-			StateManager::get().draw(renderer);
+		frameTimes[perf::PhaseBuild] = renderer->worldTimes[perf::PhaseBuild];
+		frameTimes[perf::PhaseSort] = renderer->worldTimes[perf::PhaseSort];
+		frameTimes[perf::PhaseDraw] = renderer->worldTimes[perf::PhaseDraw];
+
+		if ( ! headless ) {
+			RW_PROFILE_BEGIN("state");
+			if (StateManager::get().states.size() > 0) {
+				StateManager::get().draw(renderer);
+			}
+			RW_PROFILE_END();
 		}
 		RW_PROFILE_END();
-		RW_PROFILE_END();
 
-		renderProfile();
+		if ( ! headless ) {
+			renderProfile();
 
-		window.swap();
+			window.swap();
+		}
+
+		frameTimes[perf::PhaseFrame] = frameTimer.stop();
+		if ( frameStats ) {
+			frameStats->addFrame(frameTimes);
+		}
 	}
 
     if( httpserver_thread )
@@ -401,6 +478,9 @@ void RWGame::tick(float dt)
 {
 	// Process the Engine's background work.
 	world->_work->update();
+
+	// Keep the music streams fed with decoded audio
+	world->sound.update();
 	
 	State* currState = StateManager::get().states.back();
 
@@ -442,18 +522,20 @@ void RWGame::tick(float dt)
 			}
 		}
 
-		for( auto& object : world->allObjects ) {
-			object->_updateLastTransform();
-			object->tick(dt);
-		}
+		world->tickObjects(dt);
 		
 		world->destroyQueuedObjects();
 
 		state->text.tick(dt);
 
+		perf::PhaseTimer physicsTimer;
 		world->dynamicsWorld->stepSimulation(dt, 2, dt);
+		frameTimes[perf::PhasePhysics] = physicsTimer.stop();
+
+		world->spatialIndex.refresh();
 		
 		if( script ) {
+			perf::PhaseTimer scriptTimer;
 			try {
 				script->execute(dt);
 			}
@@ -462,6 +544,7 @@ void RWGame::tick(float dt)
 				log.error( "Script", ex.what() );
 				throw;
 			}
+			frameTimes[perf::PhaseScript] = scriptTimer.stop();
 		}
 		
 		if ( state->playerObject )
@@ -476,6 +559,14 @@ void RWGame::tick(float dt)
 	// render() needs two cameras to smoothly interpolate between ticks.
 	lastCam = nextCam;
 	nextCam = currState->getCamera();
+
+	if( world->streaming ) {
+		world->streaming->update(nextCam.position);
+	}
+
+	world->sound.setListener(nextCam.position,
+							 nextCam.rotation * glm::vec3(1.f, 0.f, 0.f),
+							 nextCam.rotation * glm::vec3(0.f, 0.f, 1.f));
 }
 
 void RWGame::render(float alpha, float time)
@@ -485,7 +576,9 @@ void RWGame::render(float alpha, float time)
 	getRenderer()->getRenderer()->swap();
 
 	glm::ivec2 windowSize = window.getSize();
-	renderer->setViewport(windowSize.x, windowSize.y);
+	if ( ! headless ) {
+		renderer->setViewport(windowSize.x, windowSize.y);
+	}
 
 	ViewCamera viewCam;
 	viewCam.frustum.fov = glm::radians(90.f);
@@ -545,6 +638,13 @@ void RWGame::render(float alpha, float time)
 		viewCam.frustum.fov *= viewCam.frustum.aspectRatio;
 	}
 
+	if ( headless )
+	{
+		// Only build the render list, there's nothing to draw the rest to
+		renderer->renderWorld(world, viewCam, alpha);
+		return;
+	}
+
 	glEnable(GL_DEPTH_TEST);
 	glClear(GL_DEPTH_BUFFER_BIT|GL_COLOR_BUFFER_BIT);
 
@@ -614,6 +714,33 @@ void RWGame::renderDebugStats(float time, Renderer::ProfileInfo& worldRenderTime
 	ss << " Texture binds: " << renderer->getRenderer()->getTextureCount() << "\n";
 	ss << " Buffer binds: " << renderer->getRenderer()->getBufferCount() << "\n";
 	ss << " World time: " << (worldRenderTime.duration/1000000) << "ms\n";
+	auto& uploads = data->textureUploads.getFrameStats();
+	ss << "Texture uploads: " << uploads.uploaded << " (" << (uploads.uploadedBytes / 1024) << "/"
+	   << (data->textureUploads.getFrameBudget() / 1024) << "KiB, " << uploads.uploadTime << "ms) "
+	   << uploads.pending << " pending (" << (uploads.pendingBytes / 1024) << "KiB)\n";
+	auto& layouts = renderer->text.getLayoutCache();
+	auto lookups = layouts.getStats().hits + layouts.getStats().misses;
+	ss << "Text layouts: " << layouts.size() << " cached, "
+	   << (lookups ? (100 * layouts.getStats().hits / lookups) : 0) << "% hits\n";
+	auto& strings = StringTable::get();
+	ss << "Strings: " << strings.size() << " interned, "
+	   << strings.getLookupCount() << " looked up by name\n";
+	if( auto voices = world->sound.getVoices() ) {
+		ss << "Sound effects: " << voices->getActiveCount() << "/" << voices->getVoiceCount()
+		   << " voices, " << world->sound.getSoundBank()->getLoadedCount() << " loaded\n";
+	}
+	if( world->streaming ) {
+		auto& streaming = world->streaming->getStats();
+		ss << "Streaming: " << (world->streaming->getResidentBytes() / (1024 * 1024)) << "/"
+		   << (world->streaming->getMemoryBudget() / (1024 * 1024)) << "MiB, "
+		   << streaming.pending << " pending\n";
+		for( int t = 0; t < StreamingManager::ResourceTypeCount; ++t ) {
+			auto type = static_cast<StreamingManager::ResourceType>(t);
+			ss << "  " << StreamingManager::getResourceTypeName(type) << ": "
+			   << streaming.residentCount[t] << " ("
+			   << (streaming.residentBytes[t] / 1024) << "KiB)\n";
+		}
+	}
 	for(auto& perf : profGroups)
 	{
 		ss << "  " << perf.first << ": "
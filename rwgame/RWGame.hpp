@@ -6,6 +6,7 @@
 #include <engine/GameWorld.hpp>
 #include <render/GameRenderer.hpp>
 #include <script/ScriptMachine.hpp>
+#include <core/FrameStats.hpp>
 #include <chrono>
 #include "game.hpp"
 
@@ -45,6 +46,14 @@ class RWGame
 
 	float accum;
 	float timescale;
+
+	/// Advance exactly one step per frame, regardless of the real time
+	bool fixedTimestep;
+	/// Nothing is drawn, the world render list is still built
+	bool headless;
+	/// Times of the frame in progress
+	perf::FrameTimes frameTimes;
+	perf::FrameStats* frameStats;
 public:
 
 	RWGame(int argc, char* argv[]);
@@ -92,6 +101,25 @@ public:
 		return config;
 	}
 
+	bool isFixedTimestep() const
+	{
+		return fixedTimestep;
+	}
+
+	bool isHeadless() const
+	{
+		return headless;
+	}
+
+	/**
+	 * Adds the times of every following frame to stats, until it's
+	 * set to nullptr
+	 */
+	void setFrameStats(perf::FrameStats* stats)
+	{
+		frameStats = stats;
+	}
+
 	bool hitWorldRay(glm::vec3 &hit, glm::vec3 &normal, GameObject** object = nullptr)
 	{
 		auto vc = nextCam;
@@ -1,12 +1,14 @@
 #include "benchmarkstate.hpp"
 #include "RWGame.hpp"
 #include <engine/GameState.hpp>
+#include <iomanip>
 
-BenchmarkState::BenchmarkState(RWGame* game, const std::string& benchfile)
+BenchmarkState::BenchmarkState(RWGame* game, const std::string& benchfile, const std::string& output)
 	: State(game)
 	, benchfile(benchfile)
+	, output(output)
 	, benchmarkTime(0.f)
-	, frameCounter(0)
+	, duration(0.f)
 {
 }
 
@@ -25,6 +27,11 @@ void BenchmarkState::enter()
 	game->getWorld()->state->basic.gameHour = clockHour;
 	game->getWorld()->state->basic.gameMinute = clockMinute;
 
+	if (game->isFixedTimestep()) {
+		// Spawning and effects should be the same in every run
+		game->getWorld()->randomEngine.seed(0);
+	}
+
 	float time = 0.f;
 	glm::vec3 tmpPos;
 	while (benchstream)
@@ -58,41 +65,70 @@ void BenchmarkState::enter()
 	}
 
 	std::cout << "Loaded " << track.size() << " points" << std::endl;
+
+	game->setFrameStats(&stats);
 }
 
 void BenchmarkState::exit()
 {
+	game->setFrameStats(nullptr);
+
+	auto frameCount = stats.getFrameCount();
+	// Wall clock time, the track's game time is fixed with --fixed-timestep
+	auto frameTime = stats.summarise(perf::PhaseFrame);
 	std::cout << "Results =============\n"
 			  << "Benchmark: " << benchfile << "\n"
-			  << "Frames: " << frameCounter << "\n"
+			  << "Frames: " << frameCount << "\n"
 			  << "Duration: " << duration << " seconds\n"
-			  << "Avg frametime: " << std::setprecision(3) << (duration/frameCounter)
-			  << " (" << (frameCounter/duration) << " fps)" << std::endl;
+			  << "Avg frametime: " << std::setprecision(3) << frameTime.mean << " ms"
+			  << " (" << (frameTime.mean > 0.0 ? 1000.0 / frameTime.mean : 0.0) << " fps)\n"
+			  << "Phase times (ms): mean p50 p95 p99 max\n";
+	for (int p = 0; p < perf::FramePhaseCount; ++p) {
+		auto phase = static_cast<perf::FramePhase>(p);
+		auto summary = stats.summarise(phase);
+		std::cout << "  " << std::setw(8) << std::left << perf::FrameStats::getPhaseName(phase)
+				  << std::right << std::fixed << std::setprecision(3)
+				  << " " << summary.mean << " " << summary.p50
+				  << " " << summary.p95 << " " << summary.p99
+				  << " " << summary.max << "\n";
+	}
+	std::cout.unsetf(std::ios_base::floatfield);
+	std::cout << std::flush;
+
+	if (! output.empty()) {
+		if (! stats.writeCSV(output + ".csv")) {
+			std::cerr << "Failed to write " << output << ".csv" << std::endl;
+		}
+		if (! stats.writeJSON(output + ".json", benchfile)) {
+			std::cerr << "Failed to write " << output << ".json" << std::endl;
+		}
+	}
 }
 
 void BenchmarkState::tick(float dt)
 {
 	if (track.size() > 0)
 	{
-		TrackPoint& a = track.front();
-		TrackPoint& b = track.back();
-		for (TrackPoint& p : track)
+		// Point at the track rather than copying over its ends
+		const TrackPoint* a = &track.front();
+		const TrackPoint* b = &track.back();
+		for (const TrackPoint& p : track)
 		{
 			if (benchmarkTime < p.time)
 			{
-				b = p;
+				b = &p;
 				break;
 			}
-			a = p;
+			a = &p;
 		}
 		if (benchmarkTime > duration) {
 			StateManager::get().exit();
 		}
-		if (b.time != a.time)
+		if (b->time != a->time)
 		{
-			float alpha = (benchmarkTime - a.time) / (b.time - a.time);
-			trackCam.position = glm::mix(a.position, b.position, alpha);
-			trackCam.rotation = glm::slerp(a.angle, b.angle, alpha);
+			float alpha = (benchmarkTime - a->time) / (b->time - a->time);
+			trackCam.position = glm::mix(a->position, b->position, alpha);
+			trackCam.rotation = glm::slerp(a->angle, b->angle, alpha);
 		}
 		benchmarkTime += dt;
 	}
@@ -100,7 +136,6 @@ void BenchmarkState::tick(float dt)
 
 void BenchmarkState::draw(GameRenderer* r)
 {
-	frameCounter++;
 	State::draw(r);
 }
 
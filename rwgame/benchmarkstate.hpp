@@ -3,6 +3,7 @@
 
 #include <SDL2/SDL_events.h>
 #include "State.hpp"
+#include <core/FrameStats.hpp>
 
 class BenchmarkState : public State
 {
@@ -16,12 +17,14 @@ class BenchmarkState : public State
 	ViewCamera trackCam;
 
 	std::string benchfile;
+	/// Written to output.csv and output.json if not empty
+	std::string output;
 
 	float benchmarkTime;
 	float duration;
-	uint32_t frameCounter;
+	perf::FrameStats stats;
 public:
-	BenchmarkState(RWGame* game, const std::string& benchfile);
+	BenchmarkState(RWGame* game, const std::string& benchfile, const std::string& output = "");
 
 	virtual void enter();
 	virtual void exit();
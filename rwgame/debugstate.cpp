@@ -7,6 +7,7 @@
 #include <engine/GameState.hpp>
 #include <items/InventoryItem.hpp>
 #include <data/WeaponData.hpp>
+#include <algorithm>
 #include <sstream>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/string_cast.hpp>
@@ -100,6 +101,9 @@ Menu* DebugState::createDebugMenu()
 	m->addEntry(Menu::lambda("-Weapons", [=] {
 		this->enterMenu(createWeaponMenu());
 	}, kDebugEntryHeight));
+	m->addEntry(Menu::lambda("-Sound", [=] {
+		this->enterMenu(createSoundMenu());
+	}, kDebugEntryHeight));
 
 	m->addEntry(Menu::lambda("Set Super Jump", [=] {
 		player->setJumpSpeed(20.f);
@@ -200,8 +204,8 @@ Menu* DebugState::createMapMenu()
 		};
 
 		auto gw = game->getWorld();
-		for(auto& i : gw->instancePool.objects) {
-			auto obj = static_cast<InstanceObject*>(i.second);
+		for(auto i : gw->instancePool) {
+			auto obj = static_cast<InstanceObject*>(i);
 			if (std::find(garageDoorModels.begin(), garageDoorModels.end(), obj->model->name) != garageDoorModels.end()) {
 				obj->setSolid(false);
 			}
@@ -270,13 +274,13 @@ Menu* DebugState::createAIMenu()
 	}
 
 	m->addEntry(Menu::lambda("Kill All Peds", [=] {
-		for (auto& p : game->getWorld()->pedestrianPool.objects) {
-			if (p.second->getLifetime() == GameObject::PlayerLifetime) {
+		for (auto p : game->getWorld()->pedestrianPool) {
+			if (p->getLifetime() == GameObject::PlayerLifetime) {
 				continue;
 			}
-			p.second->takeDamage({p.second->getPosition(),
-			                      p.second->getPosition(), 100.f,
-			                      GameObject::DamageInfo::Explosion, 0.f});
+			p->takeDamage({p->getPosition(),
+			               p->getPosition(), 100.f,
+			               GameObject::DamageInfo::Explosion, 0.f});
 		}
 	}, kDebugEntryHeight));
 	return m;
@@ -302,10 +306,52 @@ Menu*DebugState::createWeaponMenu()
 	return m;
 }
 
+Menu* DebugState::createSoundMenu()
+{
+	Menu* m = new Menu(2);
+	m->offset = kDebugMenuOffset;
+
+	m->addEntry(Menu::lambda("Back", [=] {
+		this->enterMenu(createDebugMenu());
+	}, kDebugEntryHeight));
+
+	size_t effectCount = getWorld()->data->soundEffects.getAssetCount();
+	if (effectCount == 0) {
+		return m;
+	}
+	_soundEffect = std::min(_soundEffect, effectCount - 1);
+
+	// Effects are played where the debug camera is
+	m->addEntry(Menu::lambda("Play Effect " + std::to_string(_soundEffect), [=] {
+		getWorld()->sound.playEffect(_soundEffect, _debugCam.position);
+	}, kDebugEntryHeight));
+	m->addEntry(Menu::lambda("Loop Effect " + std::to_string(_soundEffect), [=] {
+		auto& sound = getWorld()->sound;
+		sound.stopEffect(_loopedEffect);
+		_loopedEffect = sound.playEffect(_soundEffect, _debugCam.position, 0, 1.f, true);
+	}, kDebugEntryHeight));
+	m->addEntry(Menu::lambda("Stop Looped Effect", [=] {
+		getWorld()->sound.stopEffect(_loopedEffect);
+		_loopedEffect = VoicePool::Handle{ 0, 0 };
+	}, kDebugEntryHeight));
+	m->addEntry(Menu::lambda("Next Effect", [=] {
+		_soundEffect = (_soundEffect + 1) % effectCount;
+		this->enterMenu(createSoundMenu());
+	}, kDebugEntryHeight));
+	m->addEntry(Menu::lambda("Previous Effect", [=] {
+		_soundEffect = (_soundEffect + effectCount - 1) % effectCount;
+		this->enterMenu(createSoundMenu());
+	}, kDebugEntryHeight));
+
+	return m;
+}
+
 DebugState::DebugState(RWGame* game, const glm::vec3& vp, const glm::quat& vd)
 	: State(game)
 	, _freeLook( false )
 	, _sonicMode( false )
+	, _soundEffect( 0 )
+	, _loopedEffect{ 0, 0 }
 {
 	this->enterMenu(createDebugMenu());
 
@@ -320,7 +366,8 @@ void DebugState::enter()
 
 void DebugState::exit()
 {
-
+	getWorld()->sound.stopEffect(_loopedEffect);
+	_loopedEffect = VoicePool::Handle{ 0, 0 };
 }
 
 void DebugState::tick(float dt)
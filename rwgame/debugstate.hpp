@@ -2,6 +2,7 @@
 #define DEBUGSTATE_HPP
 
 #include <SDL2/SDL_events.h>
+#include <audio/VoicePool.hpp>
 #include "State.hpp"
 
 class DebugState : public State
@@ -13,11 +14,16 @@ class DebugState : public State
 	bool _sonicMode;
 	bool _invertedY;
 
+	/// Sound effect the sound menu plays next, and the one it's looping
+	size_t _soundEffect;
+	VoicePool::Handle _loopedEffect;
+
 	Menu* createDebugMenu();
 	Menu* createMapMenu();
 	Menu* createVehicleMenu();
 	Menu* createAIMenu();
 	Menu* createWeaponMenu();
+	Menu* createSoundMenu();
 
 public:
 	DebugState(RWGame* game, const glm::vec3& vp = {}, const glm::quat& vd = {});
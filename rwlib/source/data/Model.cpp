@@ -5,14 +5,16 @@
 
 
 Model::Geometry::Geometry()
-	: flags(0)
+	: EBO(0), flags(0)
 {
 	
 }
 
 Model::Geometry::~Geometry()
 {
-
+	if( EBO != 0 ) {
+		glDeleteBuffers(1, &EBO);
+	}
 }
 
 ModelFrame::ModelFrame(unsigned int index, ModelFrame* parent, glm::mat3 dR, glm::vec3 dT)
@@ -81,6 +81,8 @@ public:
 	struct Texture {
 		std::string name;
 		std::string alphaName;
+		/// Both names, interned when the model is loaded
+		TextureKey key;
 		TextureData::Handle texture;
 	};
 	
@@ -15,7 +15,9 @@ namespace RW
 		/// Resource has been loaded and is available
 		Loaded = 1,
 		/// Loading the resource failed
-		Failed = 2
+		Failed = 2,
+		/// Resource has been released and can be loaded again
+		Unloaded = 3
 	};
 }
 
@@ -0,0 +1,47 @@
+#include <data/StringTable.hpp>
+
+const StringID StringTable::Empty;
+
+StringTable::StringTable()
+	: lookups(0)
+{
+	ids[""] = Empty;
+	strings.push_back("");
+}
+
+StringTable& StringTable::get()
+{
+	static StringTable table;
+	return table;
+}
+
+StringID StringTable::intern(const std::string& string)
+{
+	lookups++;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = ids.find(string);
+	if( it != ids.end() ) {
+		return it->second;
+	}
+
+	StringID id = strings.size();
+	ids.insert({string, id});
+	strings.push_back(string);
+	return id;
+}
+
+std::string StringTable::getString(StringID id) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if( id >= strings.size() ) {
+		return std::string();
+	}
+	return strings[id];
+}
+
+size_t StringTable::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return strings.size();
+}
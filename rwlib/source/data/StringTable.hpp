@@ -0,0 +1,68 @@
+#pragma once
+#ifndef _RWLIB_STRINGTABLE_HPP_
+#define _RWLIB_STRINGTABLE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A string interned in a StringTable
+ */
+typedef uint32_t StringID;
+
+/**
+ * @brief Hands out a small integer ID for each distinct string
+ *
+ * Model and texture names are interned as they're loaded, and looked up
+ * by ID from then on, so the render loop compares integers rather than
+ * strings. Interning is case sensitive and IDs are never released.
+ *
+ * Loaders intern from worker threads, so every call takes a lock. Keep
+ * the IDs rather than interning the same name again.
+ */
+class StringTable
+{
+public:
+	/// The empty string's ID, in every table
+	static const StringID Empty = 0;
+
+	StringTable();
+
+	/**
+	 * The table every loader shares
+	 */
+	static StringTable& get();
+
+	/**
+	 * Returns the ID for string, adding it if it's new
+	 */
+	StringID intern(const std::string& string);
+
+	/**
+	 * Returns a copy of the string with this ID, or the empty string
+	 * if the ID didn't come from this table
+	 */
+	std::string getString(StringID id) const;
+
+	/**
+	 * Number of distinct strings, including the empty string
+	 */
+	size_t size() const;
+
+	/**
+	 * Number of calls to intern() so far, each hashes the whole string
+	 */
+	size_t getLookupCount() const { return lookups; }
+
+private:
+	mutable std::mutex mutex;
+	std::unordered_map<std::string, StringID> ids;
+	std::vector<std::string> strings;
+	std::atomic<size_t> lookups;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 #include <gl/gl_core_3_3.h>
 #include <glm/glm.hpp>
+#include <data/StringTable.hpp>
 
 #include <memory>
 
@@ -32,3 +33,22 @@ private:
 	glm::ivec2 size;
 	bool hasAlpha;
 };
+
+/**
+ * Identifies a texture by the StringIDs of its name and alpha name
+ */
+typedef uint64_t TextureKey;
+
+inline TextureKey textureKey(StringID name, StringID alpha = StringTable::Empty)
+{
+	return (uint64_t(alpha) << 32) | name;
+}
+
+/**
+ * Interns the names, prefer keeping the key over calling this every frame
+ */
+inline TextureKey textureKey(const std::string& name, const std::string& alpha = "")
+{
+	auto& strings = StringTable::get();
+	return textureKey(strings.intern(name), alpha.empty() ? StringTable::Empty : strings.intern(alpha));
+}
@@ -0,0 +1,70 @@
+#include <gl/TextureUploadQueue.hpp>
+
+#include <chrono>
+#include <limits>
+
+namespace
+{
+	/// A 1024x1024 RGBA texture
+	const size_t kDefaultFrameBudget = 4 * 1024 * 1024;
+}
+
+TextureUploadQueue::TextureUploadQueue(UploadFunction upload)
+	: upload(upload)
+	, frameBudget(kDefaultFrameBudget)
+	, pendingBytes(0)
+	, stats{ 0, 0, 0.0, 0, 0 }
+{
+}
+
+void TextureUploadQueue::add(std::vector<DecodedTexture>&& textures, TextureArchive& archive)
+{
+	for( auto& texture : textures ) {
+		pendingBytes += texture.pixels.size();
+		pending.push_back({ std::move(texture), &archive });
+	}
+	stats.pending = pending.size();
+	stats.pendingBytes = pendingBytes;
+}
+
+void TextureUploadQueue::process()
+{
+	typedef std::chrono::steady_clock Clock;
+	auto begin = Clock::now();
+
+	stats.uploaded = 0;
+	stats.uploadedBytes = 0;
+
+	while( ! pending.empty() ) {
+		size_t size = pending.front().texture.pixels.size();
+		if( stats.uploaded > 0 && stats.uploadedBytes + size > frameBudget ) {
+			break;
+		}
+		uploadNext();
+	}
+
+	stats.uploadTime = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+	stats.pending = pending.size();
+	stats.pendingBytes = pendingBytes;
+}
+
+void TextureUploadQueue::flush()
+{
+	auto budget = frameBudget;
+	frameBudget = std::numeric_limits<size_t>::max();
+	process();
+	frameBudget = budget;
+}
+
+void TextureUploadQueue::uploadNext()
+{
+	auto& next = pending.front();
+	size_t size = next.texture.pixels.size();
+
+	TextureLoader::addToArchive(next.texture, upload(next.texture), *next.archive);
+
+	stats.uploaded++;
+	stats.uploadedBytes += size;
+	pendingBytes -= size;
+	pending.pop_front();
+}
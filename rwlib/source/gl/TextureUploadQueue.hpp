@@ -0,0 +1,87 @@
+#pragma once
+#ifndef _RWLIB_TEXTUREUPLOADQUEUE_HPP_
+#define _RWLIB_TEXTUREUPLOADQUEUE_HPP_
+
+#include <loaders/LoaderTXD.hpp>
+
+#include <deque>
+#include <functional>
+
+/**
+ * @brief Holds decoded textures until they're uploaded to OpenGL
+ *
+ * Uploading a whole TXD at once stalls the frame it arrives in, so
+ * process() only uploads up to a byte budget each frame and leaves the
+ * rest for the next one. Textures are added to their archive once they're
+ * uploaded, until then lookups miss them as if they weren't loaded yet.
+ *
+ * Must only be used from the thread that owns the OpenGL context.
+ */
+class TextureUploadQueue
+{
+public:
+	typedef std::function<TextureData::Handle (const DecodedTexture&)> UploadFunction;
+
+	/**
+	 * What happened in the last call to process()
+	 */
+	struct FrameStats
+	{
+		size_t uploaded;
+		size_t uploadedBytes;
+		/// Milliseconds spent uploading
+		double uploadTime;
+		/// Textures left for the next frame
+		size_t pending;
+		size_t pendingBytes;
+	};
+
+	/**
+	 * @param upload Creates the texture, replaceable so the queue can be
+	 * used without OpenGL
+	 */
+	TextureUploadQueue(UploadFunction upload = &TextureLoader::upload);
+
+	/**
+	 * Sets the number of bytes of pixel data to upload each frame. At least
+	 * one texture is uploaded per frame, however large it is.
+	 */
+	void setFrameBudget(size_t bytes) { frameBudget = bytes; }
+	size_t getFrameBudget() const { return frameBudget; }
+
+	/**
+	 * Queues textures to be added to archive when they're uploaded
+	 */
+	void add(std::vector<DecodedTexture>&& textures, TextureArchive& archive);
+
+	/**
+	 * Uploads queued textures until the frame's budget is used up
+	 */
+	void process();
+
+	/**
+	 * Uploads all of the queued textures
+	 */
+	void flush();
+
+	bool isEmpty() const { return pending.empty(); }
+
+	const FrameStats& getFrameStats() const { return stats; }
+
+private:
+	struct PendingTexture
+	{
+		DecodedTexture texture;
+		TextureArchive* archive;
+	};
+
+	UploadFunction upload;
+	size_t frameBudget;
+	std::deque<PendingTexture> pending;
+	size_t pendingBytes;
+	FrameStats stats;
+
+	void uploadNext();
+};
+
+#endif
@@ -1,40 +1,268 @@
 #include <job/WorkContext.hpp>
 
+#include <algorithm>
+
+namespace
+{
+	/// The worker owning the current thread, if any
+	thread_local LoadWorker* currentWorker = nullptr;
+
+	/// State shared between the threads running one parallelFor
+	struct ParallelRange
+	{
+		const std::function<void(size_t, size_t)>* func;
+		size_t count;
+		size_t chunkSize;
+		size_t chunks;
+		std::atomic<size_t> nextChunk;
+		std::atomic<size_t> remainingChunks;
+		std::mutex doneMutex;
+		std::condition_variable done;
+
+		/// Processes chunks until there are none left to take
+		void run()
+		{
+			size_t c;
+			while( (c = nextChunk++) < chunks ) {
+				size_t begin = c * chunkSize;
+				(*func)(begin, std::min(begin + chunkSize, count));
+
+				if( --remainingChunks == 0 ) {
+					std::lock_guard<std::mutex> guard( doneMutex );
+					done.notify_all();
+				}
+			}
+		}
+	};
+
+	class ParallelRangeJob : public WorkJob
+	{
+		std::shared_ptr<ParallelRange> range;
+
+	public:
+		ParallelRangeJob(WorkContext* context, const std::shared_ptr<ParallelRange>& r)
+			: WorkJob(context, High), range(r) { }
+
+		void work() { range->run(); }
+	};
+}
+
+void LockedCompletionQueue::push(WorkJob* job)
+{
+	std::lock_guard<std::mutex> guard( _mutex );
+	_queue.push(job);
+}
+
+WorkJob* LockedCompletionQueue::pop()
+{
+	std::lock_guard<std::mutex> guard( _mutex );
+	if( _queue.empty() ) {
+		return nullptr;
+	}
+	WorkJob* j = _queue.front();
+	_queue.pop();
+	return j;
+}
+
 void LoadWorker::start()
 {
-	while( _running ) {
-		_context->workNext();
-		std::this_thread::yield();
+	currentWorker = this;
+
+	while( true ) {
+		WorkJob* j = _context->takeJob(this);
+		if( j != nullptr ) {
+			j->work();
+			_context->finishJob(j);
+			continue;
+		}
+
+		if( ! _context->waitForWork() ) {
+			break;
+		}
 	}
 }
 
-void WorkContext::workNext()
+void LoadWorker::push(WorkJob* job)
 {
-	WorkJob* j = nullptr;
+	std::lock_guard<std::mutex> guard( _queueMutex );
+	_queues[job->getPriority()].push_back(job);
+}
+
+WorkJob* LoadWorker::pop(WorkJob::Priority priority)
+{
+	std::lock_guard<std::mutex> guard( _queueMutex );
+	auto& queue = _queues[priority];
+	if( queue.empty() ) {
+		return nullptr;
+	}
+	WorkJob* j = queue.front();
+	queue.pop_front();
+	return j;
+}
 
-	_inMutex.lock();
-	if( ! _workQueue.empty() ) {
-		j = _workQueue.front();
-		_workQueue.pop();
+WorkJob* LoadWorker::steal(WorkJob::Priority priority)
+{
+	std::lock_guard<std::mutex> guard( _queueMutex );
+	auto& queue = _queues[priority];
+	if( queue.empty() ) {
+		return nullptr;
 	}
-	_inMutex.unlock();
+	WorkJob* j = queue.back();
+	queue.pop_back();
+	return j;
+}
 
-	if( j == nullptr ) return;
+WorkContext::WorkContext(unsigned int workers, WorkCompletionQueue* completeQueue)
+	: _completeQueue( completeQueue ? completeQueue : new LockedCompletionQueue )
+	, _nextWorker( 0 )
+	, _queuedJobs( 0 )
+	, _pendingJobs( 0 )
+	, _running( true )
+{
+	if( workers == 0 ) {
+		// Leave a hardware thread for whoever is calling update()
+		unsigned int threads = std::thread::hardware_concurrency();
+		workers = threads > 1 ? threads - 1 : 1;
+	}
 
-	j->work();
+	for( unsigned int w = 0; w < workers; ++w ) {
+		_workers.emplace_back( new LoadWorker(this) );
+	}
 
-	_outMutex.lock();
-	_completeQueue.push(j);
-	_outMutex.unlock();
+	// Only start the threads once every deque exists to be stolen from
+	for( auto& worker : _workers ) {
+		worker->_thread = std::thread( &LoadWorker::start, worker.get() );
+	}
+}
+
+WorkContext::~WorkContext()
+{
+	{
+		std::lock_guard<std::mutex> guard( _sleepMutex );
+		_running = false;
+	}
+	_wakeCondition.notify_all();
+
+	for( auto& worker : _workers ) {
+		worker->_thread.join();
+	}
+
+	// Anything still queued will never run or complete
+	for( auto& worker : _workers ) {
+		for( int p = 0; p < WorkJob::PriorityCount; ++p ) {
+			while( WorkJob* j = worker->pop(WorkJob::Priority(p)) ) {
+				delete j;
+			}
+		}
+	}
+	while( WorkJob* j = _completeQueue->pop() ) {
+		delete j;
+	}
+}
+
+void WorkContext::queueJob(WorkJob* job)
+{
+	++_pendingJobs;
+
+	// Jobs queued by other jobs stay with the worker that queued them
+	LoadWorker* worker = currentWorker;
+	if( worker == nullptr || worker->getContext() != this ) {
+		worker = _workers[ _nextWorker++ % _workers.size() ].get();
+	}
+	worker->push(job);
+
+	{
+		std::lock_guard<std::mutex> guard( _sleepMutex );
+		++_queuedJobs;
+	}
+	_wakeCondition.notify_one();
+}
+
+WorkJob* WorkContext::takeJob(LoadWorker* worker)
+{
+	if( ! _running ) {
+		return nullptr;
+	}
+
+	// Find the worker's position so stealing starts with its neighbour
+	size_t self = 0;
+	while( _workers[self].get() != worker ) {
+		++self;
+	}
+
+	for( int p = 0; p < WorkJob::PriorityCount; ++p ) {
+		auto priority = WorkJob::Priority(p);
+
+		WorkJob* j = worker->pop(priority);
+		for( size_t w = 1; j == nullptr && w < _workers.size(); ++w ) {
+			j = _workers[ (self + w) % _workers.size() ]->steal(priority);
+		}
+
+		if( j != nullptr ) {
+			--_queuedJobs;
+			return j;
+		}
+	}
+
+	return nullptr;
+}
+
+void WorkContext::finishJob(WorkJob* job)
+{
+	_completeQueue->push(job);
+}
+
+bool WorkContext::waitForWork()
+{
+	std::unique_lock<std::mutex> lock( _sleepMutex );
+	_wakeCondition.wait(lock, [this] {
+		return ! _running || _queuedJobs > 0;
+	});
+	return _running;
 }
 
 void WorkContext::update()
 {
-	std::lock_guard<std::mutex> guard( _outMutex );
-	while( ! _completeQueue.empty() ) {
-		WorkJob* j = _completeQueue.front(); _completeQueue.pop();
+	while( WorkJob* j = _completeQueue->pop() ) {
 		j->complete();
 		delete j;
+		--_pendingJobs;
 	}
 }
 
+void WorkContext::parallelFor(size_t count, size_t chunkSize,
+							  const std::function<void(size_t, size_t)>& func)
+{
+	if( count == 0 ) {
+		return;
+	}
+
+	chunkSize = std::max<size_t>(chunkSize, 1);
+	size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+	if( chunks == 1 ) {
+		func(0, count);
+		return;
+	}
+
+	std::shared_ptr<ParallelRange> range( new ParallelRange );
+	range->func = &func;
+	range->count = count;
+	range->chunkSize = chunkSize;
+	range->chunks = chunks;
+	range->nextChunk = 0;
+	range->remainingChunks = chunks;
+
+	// The calling thread takes one share of the work
+	size_t helpers = std::min(chunks - 1, _workers.size());
+	for( size_t h = 0; h < helpers; ++h ) {
+		queueJob(new ParallelRangeJob(this, range));
+	}
+
+	range->run();
+
+	std::unique_lock<std::mutex> lock( range->doneMutex );
+	range->done.wait(lock, [&] {
+		return range->remainingChunks == 0;
+	});
+}
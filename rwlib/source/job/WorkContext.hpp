@@ -3,45 +3,45 @@
 #define _LOADCONTEXT_HPP_
 
 #include <queue>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <functional>
 #include <fstream>
 
 class WorkContext;
 
-class LoadWorker
-{
-	WorkContext* _context;
-
-public:
-
-	bool _running;
-	std::thread _thread;
-	void start();
-
-	LoadWorker( WorkContext* context )
-		: _context( context ), _running(true),
-	_thread( std::bind(&LoadWorker::start, this) ) { }
-
-	~LoadWorker( )
-	{
-		_running = false;
-		_thread.join();
-	}
-};
-
 /**
  * @brief Interface for background work
  */
 class WorkJob
 {
+public:
+
+	/**
+	 * Relative importance of a job, higher priority jobs are always
+	 * taken before lower priority jobs by any worker.
+	 */
+	enum Priority
+	{
+		High = 0,
+		Normal = 1,
+		Low = 2,
+		PriorityCount
+	};
+
+private:
 	WorkContext* _context;
+	Priority _priority;
 
 public:
 
-	WorkJob(WorkContext* context)
-		: _context(context) {}
+	WorkJob(WorkContext* context, Priority priority = Normal)
+		: _context(context), _priority(priority) {}
 
 	virtual ~WorkJob() {}
 
@@ -51,54 +51,143 @@ public:
 	 */
 	WorkContext* getContext() const { return _context; }
 
+	Priority getPriority() const { return _priority; }
+
 	virtual void work() = 0;
 	virtual void complete() {}
 };
 
+/**
+ * @brief Holds jobs that have finished work() until they are completed.
+ *
+ * push() is called from the worker threads, pop() from the thread
+ * calling WorkContext::update()
+ */
+class WorkCompletionQueue
+{
+public:
+	virtual ~WorkCompletionQueue() {}
+
+	virtual void push(WorkJob* job) = 0;
+
+	/// Returns the next finished job, or nullptr if there isn't one
+	virtual WorkJob* pop() = 0;
+};
+
+/**
+ * @brief Default completion queue, a mutex guarded FIFO.
+ */
+class LockedCompletionQueue : public WorkCompletionQueue
+{
+	std::queue<WorkJob*> _queue;
+	std::mutex _mutex;
+
+public:
+	void push(WorkJob* job);
+	WorkJob* pop();
+};
+
+/**
+ * @brief A thread owned by a WorkContext.
+ *
+ * Each worker has a deque for each job priority; it takes work from the
+ * front of its own deques and steals from the back of the others when
+ * it runs out.
+ */
+class LoadWorker
+{
+	WorkContext* _context;
+	std::deque<WorkJob*> _queues[WorkJob::PriorityCount];
+	std::mutex _queueMutex;
+
+public:
+
+	std::thread _thread;
+
+	LoadWorker( WorkContext* context )
+		: _context( context ) { }
+
+	WorkContext* getContext() const { return _context; }
+
+	void start();
+
+	void push(WorkJob* job);
+
+	/// Removes a job of the given priority from the front of the deque
+	WorkJob* pop(WorkJob::Priority priority);
+
+	/// Removes a job of the given priority from the back of the deque
+	WorkJob* steal(WorkJob::Priority priority);
+};
+
 // TODO: refactor everything to remove this.
 class GameWorld;
 
 /**
- * @brief A worker queue that runs work in the background.
+ * @brief A pool of worker threads that runs work in the background.
  *
  * Work is added with queueJob, once it completes the job is added
- * to the _completeQueue to be finalised on the "main" thread.
+ * to the completion queue to be finalised on the "main" thread by update().
+ * Idle workers sleep until more work is queued.
  */
 class WorkContext
 {
-	std::queue<WorkJob*> _workQueue;
-	std::queue<WorkJob*> _completeQueue;
+	std::vector<std::unique_ptr<LoadWorker>> _workers;
+	std::unique_ptr<WorkCompletionQueue> _completeQueue;
 
-	LoadWorker _worker;
+	/// Used to distribute jobs queued from outside the pool
+	std::atomic<unsigned int> _nextWorker;
+	/// Jobs waiting in the worker deques
+	std::atomic<int> _queuedJobs;
+	/// Jobs that have been queued but not yet completed
+	std::atomic<int> _pendingJobs;
 
-	std::mutex _inMutex;
-	std::mutex _outMutex;
+	std::mutex _sleepMutex;
+	std::condition_variable _wakeCondition;
+	std::atomic<bool> _running;
 
 public:
 
-	WorkContext()
-		: _worker(this) { }
+	/**
+	 * @param workers Number of threads to start, 0 picks one thread for
+	 * each hardware thread except the caller's.
+	 * @param completeQueue Where finished jobs wait for update(), the
+	 * default is a LockedCompletionQueue
+	 */
+	WorkContext(unsigned int workers = 0, WorkCompletionQueue* completeQueue = nullptr);
 
-	void queueJob( WorkJob* job )
-	{
-		std::lock_guard<std::mutex> guard(_inMutex);
-		_workQueue.push( job );
-	}
+	~WorkContext();
 
-	// Called by the worker thread - don't touch;
-	void workNext();
+	void queueJob( WorkJob* job );
 
-	const std::queue<WorkJob*> getWorkQueue() const { return _workQueue; }
-	const std::queue<WorkJob*> getCompleteQueue() const { return _completeQueue; }
+	// Called by the worker threads - don't touch;
+	WorkJob* takeJob(LoadWorker* worker);
+	void finishJob(WorkJob* job);
+	bool waitForWork();
 
-	bool isEmpty() {
-		std::lock_guard<std::mutex> guardIn( _inMutex );
-		std::lock_guard<std::mutex> guardOu( _outMutex );
+	size_t getWorkerCount() const { return _workers.size(); }
 
-		return (getWorkQueue().size() + getCompleteQueue().size()) == 0;
+	/// Number of jobs that have been queued but not completed by update()
+	int getPendingJobCount() const { return _pendingJobs; }
+
+	bool isEmpty() const {
+		return _pendingJobs == 0;
 	}
 
+	/**
+	 * Completes all of the jobs that have finished their work.
+	 */
 	void update();
+
+	/**
+	 * Calls func for each chunk of the range [0, count) on the workers,
+	 * and returns once every chunk has been processed. The calling thread
+	 * processes chunks too, so this finishes even if every worker is busy.
+	 *
+	 * The helper jobs queued by this are deleted by a later update().
+	 */
+	void parallelFor(size_t count, size_t chunkSize,
+					 const std::function<void(size_t begin, size_t end)>& func);
 };
 
 #endif
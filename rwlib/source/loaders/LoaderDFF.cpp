@@ -353,7 +353,7 @@ void LoaderDFF::readTexture(Model *model, const RWBStream &stream)
 	std::transform(name.begin(), name.end(), name.begin(), ::tolower );
 	std::transform(alpha.begin(), alpha.end(), alpha.begin(), ::tolower );
 
-	model->geometries.back()->materials.back().textures.push_back({name, alpha, nullptr});
+	model->geometries.back()->materials.back().textures.push_back({name, alpha, textureKey(name, alpha), nullptr});
 }
 
 void LoaderDFF::readGeometryExtension(Model *model, const RWBStream &stream)
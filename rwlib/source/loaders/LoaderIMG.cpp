@@ -1,5 +1,7 @@
 #include <loaders/LoaderIMG.hpp>
+#include <platform/MappedFile.hpp>
 
+#include <algorithm>
 #include <cstring>
 
 LoaderIMG::LoaderIMG()
@@ -59,6 +61,25 @@ bool LoaderIMG::findAssetInfo(const std::string& assetname, LoaderIMGFile& out)
 	return false;
 }
 
+bool LoaderIMG::mapArchive()
+{
+	if( m_mapping ) {
+		return true;
+	}
+
+	std::shared_ptr<MappedFile> mapping( new MappedFile(m_archive) );
+	if( ! mapping->isMapped() ) {
+		return false;
+	}
+
+	// Assets are parsed front to back, so ask for aggressive read-ahead.
+	// This is done once for the whole archive rather than for each asset.
+	mapping->advise(0, mapping->getSize(), MappedFile::Sequential);
+
+	m_mapping = mapping;
+	return true;
+}
+
 char* LoaderIMG::loadToMemory(const std::string& assetname)
 {
 	LoaderIMGFile assetInfo;
@@ -68,7 +89,46 @@ char* LoaderIMG::loadToMemory(const std::string& assetname)
 		std::cerr << "Asset '" << assetname << "' not found!" << std::endl;
 		return nullptr;
 	}
-	
+
+	return readAsset(assetInfo);
+}
+
+FileHandle LoaderIMG::openAsset(const LoaderIMGFile& asset)
+{
+	size_t offset = asset.offset * 2048;
+	size_t length = asset.size * 2048;
+
+	if( m_mapping && offset < m_mapping->getSize() ) {
+		// The last asset may be truncated by the end of the file
+		length = std::min(length, m_mapping->getSize() - offset);
+
+		auto data = m_mapping->getData() + offset;
+		return FileHandle( new FileContentsInfo{ data, length, m_mapping } );
+	}
+
+	char* data = readAsset(asset);
+	if( data == nullptr ) {
+		return nullptr;
+	}
+
+	return FileHandle( new FileContentsInfo{ data, length, nullptr } );
+}
+
+char* LoaderIMG::readAsset(const LoaderIMGFile& assetInfo)
+{
+	if( m_mapping ) {
+		size_t offset = assetInfo.offset * 2048;
+		size_t length = assetInfo.size * 2048;
+		size_t available = offset < m_mapping->getSize() ? m_mapping->getSize() - offset : 0;
+		if( available < length ) {
+			std::cerr << "Error reading asset " << assetInfo.name << std::endl;
+		}
+
+		char* raw_data = new char[length];
+		memcpy(raw_data, m_mapping->getData() + offset, std::min(length, available));
+		return raw_data;
+	}
+
 	std::string imgName = m_archive;
 
 	FILE* fp = fopen(imgName.c_str(), "rb");
@@ -2,10 +2,15 @@
 #ifndef _LOADERIMG_HPP_
 #define _LOADERIMG_HPP_
 
+#include <platform/FileHandle.hpp>
+
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <cstdint>
 
+class MappedFile;
+
 /// \brief Points to one file within the archive
 class LoaderIMGFile
 {
@@ -37,11 +42,22 @@ public:
 	/// Omit the extension in filename so both .dir and .img are loaded when appropriate
 	bool load(const std::string& filename);
 
+	/// Map the whole .img into memory, so assets can be accessed without
+	/// reading them. Returns false if the archive couldn't be mapped.
+	bool mapArchive();
+
+	/// Returns true if mapArchive() has succeeded
+	bool isMapped() const { return m_mapping != nullptr; }
+
 	/// Load a file from the archive to memory and pass a pointer to it
 	/// Warning: Please delete[] the memory in the end.
 	/// Warning: Returns NULL (0) if by any reason it can't load the file
 	char* loadToMemory(const std::string& assetname);
 
+	/// Returns the contents of an asset, pointing directly into the mapped
+	/// archive when the archive is mapped, or a copy read from disk if not.
+	FileHandle openAsset(const LoaderIMGFile& asset);
+
 	/// Writes the contents of assetname to filename
 	bool saveAsset(const std::string& assetname, const std::string& filename);
 
@@ -60,6 +76,11 @@ private:
 	std::string m_archive; ///< Path to the archive being used (no extension)
 
 	std::vector<LoaderIMGFile> m_assets; ///< Asset info of the archive
+
+	std::shared_ptr<MappedFile> m_mapping; ///< Mapping of the .img, shared by copies
+
+	/// Reads the sectors of asset from disk into a new buffer
+	char* readAsset(const LoaderIMGFile& asset);
 };
 
 
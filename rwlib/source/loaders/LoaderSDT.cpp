@@ -51,6 +51,16 @@ bool LoaderSDT::load(const std::string& filename)
 
 		fclose(fp);
 		m_archive = rawName;
+
+		m_raw.reset(new MappedFile(rawName));
+		if (m_raw->isMapped()) {
+			// Effects are picked out one at a time as they're played
+			m_raw->advise(0, m_raw->getSize(), MappedFile::Random);
+		} else {
+			std::cerr << "Unable to map " << rawName << std::endl;
+			m_raw.reset();
+		}
+
 		return true;
 	} else {
 		return false;
@@ -77,46 +87,54 @@ char* LoaderSDT::loadToMemory(size_t index, bool asWave)
 		return nullptr;
 	}
 
-	std::string rawName = m_archive;
+	const char* samples = getSampleData(index);
+	if (samples == nullptr) {
+		std::cerr << "Error reading asset " << std::to_string(index) << std::endl;
+		return nullptr;
+	}
 
-	FILE* fp = fopen(rawName.c_str(), "rb");
-	if (fp) {
-		char* raw_data;
-		char* sample_data;
-		if (asWave) {
-			raw_data = new char[sizeof(WaveHeader) + assetInfo.size];
-
-			WaveHeader* header = reinterpret_cast<WaveHeader*>(raw_data);
-			memcpy(header->chunkId, "RIFF", 4);
-			header->chunkSize = sizeof(WaveHeader) - 8 + assetInfo.size;
-			memcpy(header->format, "WAVE", 4);
-			memcpy(header->fmt.id, "fmt ", 4);
-			header->fmt.size = sizeof(WaveHeader::fmt) - 8;
-			header->fmt.audioFormat = 1; // PCM
-			header->fmt.numChannels = 1; // Mono
-			header->fmt.sampleRate = assetInfo.sampleRate;
-			header->fmt.byteRate = assetInfo.sampleRate * 2;
-			header->fmt.blockAlign = 2;
-			header->fmt.bitsPerSample = 16;
-			memcpy(header->data.id, "data", 4);
-			header->data.size = assetInfo.size;
-
-			sample_data = raw_data + sizeof(WaveHeader);
-		} else {
-			raw_data = new char[assetInfo.size];
-			sample_data = raw_data;
-		}
+	char* raw_data;
+	char* sample_data;
+	if (asWave) {
+		raw_data = new char[sizeof(WaveHeader) + assetInfo.size];
+
+		WaveHeader* header = reinterpret_cast<WaveHeader*>(raw_data);
+		memcpy(header->chunkId, "RIFF", 4);
+		header->chunkSize = sizeof(WaveHeader) - 8 + assetInfo.size;
+		memcpy(header->format, "WAVE", 4);
+		memcpy(header->fmt.id, "fmt ", 4);
+		header->fmt.size = sizeof(WaveHeader::fmt) - 8;
+		header->fmt.audioFormat = 1; // PCM
+		header->fmt.numChannels = 1; // Mono
+		header->fmt.sampleRate = assetInfo.sampleRate;
+		header->fmt.byteRate = assetInfo.sampleRate * 2;
+		header->fmt.blockAlign = 2;
+		header->fmt.bitsPerSample = 16;
+		memcpy(header->data.id, "data", 4);
+		header->data.size = assetInfo.size;
+
+		sample_data = raw_data + sizeof(WaveHeader);
+	} else {
+		raw_data = new char[assetInfo.size];
+		sample_data = raw_data;
+	}
 
-		fseek(fp, assetInfo.offset, SEEK_SET);
-		if (fread(sample_data, 1, assetInfo.size, fp) != assetInfo.size) {
-			std::cerr << "Error reading asset " << std::to_string(index) << std::endl;
-		}
+	memcpy(sample_data, samples, assetInfo.size);
+	return raw_data;
+}
 
-		fclose(fp);
-		return raw_data;
+const char* LoaderSDT::getSampleData(size_t index) const
+{
+	if (index >= m_assets.size() || ! m_raw) {
+		return nullptr;
 	}
-	else
-		return 0;
+
+	const LoaderSDTFile& asset = m_assets[index];
+	if (size_t(asset.offset) + asset.size > m_raw->getSize()) {
+		return nullptr;
+	}
+
+	return m_raw->getData() + asset.offset;
 }
 
 /// Writes the contents of assetname to filename
@@ -2,7 +2,10 @@
 #ifndef _LOADERSDT_HPP_
 #define _LOADERSDT_HPP_
 
+#include <platform/MappedFile.hpp>
+
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <cstdint>
 
@@ -34,10 +37,15 @@ public:
 	/// Construct
 	LoaderSDT();
 
-	/// Load the structure of the archive
+	/// Load the structure of the archive and map the sample data
 	/// Omit the extension in filename
 	bool load(const std::string& filename);
 
+	/// Returns the 16-bit mono PCM of an asset, straight from the mapped
+	/// .RAW file. Valid for as long as the archive is loaded, NULL if the
+	/// asset doesn't exist.
+	const char* getSampleData(size_t index) const;
+
 	/// Load a file from the archive to memory and pass a pointer to it
 	/// Warning: Please delete[] the memory in the end.
 	/// Warning: Returns NULL (0) if by any reason it can't load the file
@@ -61,6 +69,7 @@ private:
 	std::string m_archive; ///< Path to the archive being used (no extension)
 
 	std::vector<LoaderSDTFile> m_assets; ///< Asset info of the archive
+	std::unique_ptr<MappedFile> m_raw; ///< Mapping of the sample data
 };
 
 
@@ -5,6 +5,10 @@
 #include <iostream>
 #include <algorithm>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 GLuint gErrorTextureData[] = { 0xFFFF00FF, 0xFF000000, 0xFF000000, 0xFFFF00FF };
 GLuint gDebugTextureData[] = {0xFF0000FF, 0xFF00FF00};
 GLuint gTextureRed[] = {0xFF0000FF};
@@ -31,145 +35,133 @@ TextureData::Handle getErrorTexture()
 	return tex;
 }
 
-const size_t paletteSize = 1024;
-void processPalette(uint32_t* fullColor, RW::BinaryStreamSection& rootSection)
+namespace
 {
-	uint8_t* dataBase = reinterpret_cast<uint8_t*>(rootSection.raw() + sizeof(RW::BSSectionHeader) + sizeof(RW::BSTextureNative) - 4);
-
-	uint8_t* coldata = (dataBase + paletteSize + sizeof(uint32_t));
-	uint32_t raster_size = *reinterpret_cast<uint32_t*>(dataBase + paletteSize);
-	uint32_t* palette = reinterpret_cast<uint32_t*>(dataBase);
+	const size_t paletteSize = 1024;
 
-	for(size_t j = 0; j < raster_size; ++j)
+	GLenum getWrapMode(uint8_t wrap)
 	{
-		*(fullColor++) = palette[coldata[j]];
-	}
-
-}
-
-TextureData::Handle createTexture(RW::BSTextureNative& texNative, RW::BinaryStreamSection& rootSection)
-{
-	// TODO: Exception handling.
-	if(texNative.platform != 8) {
-		std::cerr << "Unsupported texture platform " << std::dec << texNative.platform << std::endl;
-		return getErrorTexture();
-	}
-
-	bool isPal8 = (texNative.rasterformat & RW::BSTextureNative::FORMAT_EXT_PAL8) == RW::BSTextureNative::FORMAT_EXT_PAL8;
-	bool isFulc = texNative.rasterformat == RW::BSTextureNative::FORMAT_1555 ||
-				texNative.rasterformat == RW::BSTextureNative::FORMAT_8888 ||
-				texNative.rasterformat == RW::BSTextureNative::FORMAT_888;
-	// Export this value
-	bool transparent = !((texNative.rasterformat&RW::BSTextureNative::FORMAT_888) == RW::BSTextureNative::FORMAT_888);
-
-	if(! (isPal8 || isFulc)) {
-		std::cerr << "Unsuported raster format " << std::dec << texNative.rasterformat << std::endl;
-		return getErrorTexture();
+		switch(wrap) {
+		default:
+		case RW::BSTextureNative::WRAP_WRAP:
+			return GL_REPEAT;
+		case RW::BSTextureNative::WRAP_CLAMP:
+			return GL_CLAMP_TO_EDGE;
+		case RW::BSTextureNative::WRAP_MIRROR:
+			return GL_MIRRORED_REPEAT;
+		}
 	}
 
-	GLuint textureName = 0;
-
-	if(isPal8)
+	void decodeRaster(FileHandle& file, RW::BSTextureNative& texNative, RW::BinaryStreamSection& rootSection, DecodedTexture& texture)
 	{
-		std::vector<uint32_t> fullColor(texNative.width * texNative.height);
+		texture.size = glm::ivec2(texNative.width, texNative.height);
+		texture.format = GL_RGBA;
+		texture.type = GL_UNSIGNED_BYTE;
+		texture.valid = false;
+
+		// TODO: Exception handling.
+		if(texNative.platform != 8) {
+			std::cerr << "Unsupported texture platform " << std::dec << texNative.platform << std::endl;
+			return;
+		}
 
-		processPalette(fullColor.data(), rootSection);
+		bool isPal8 = (texNative.rasterformat & RW::BSTextureNative::FORMAT_EXT_PAL8) == RW::BSTextureNative::FORMAT_EXT_PAL8;
+		bool isFulc = texNative.rasterformat == RW::BSTextureNative::FORMAT_1555 ||
+					texNative.rasterformat == RW::BSTextureNative::FORMAT_8888 ||
+					texNative.rasterformat == RW::BSTextureNative::FORMAT_888;
+		// Export this value
+		texture.transparent = !((texNative.rasterformat&RW::BSTextureNative::FORMAT_888) == RW::BSTextureNative::FORMAT_888);
 
-		glGenTextures(1, &textureName);
-		glBindTexture(GL_TEXTURE_2D, textureName);
-		glTexImage2D(
-			GL_TEXTURE_2D, 0, GL_RGBA,
-			texNative.width, texNative.height, 0,
-			GL_RGBA, GL_UNSIGNED_BYTE, fullColor.data()
-		);
-	}
-	else if(isFulc)
-	{
-		auto coldata = rootSection.raw() + sizeof(RW::BSTextureNative);
-		coldata += sizeof(uint32_t);
+		if(! (isPal8 || isFulc)) {
+			std::cerr << "Unsuported raster format " << std::dec << texNative.rasterformat << std::endl;
+			return;
+		}
+
+		const char* fileEnd = file->data + file->length;
+		size_t pixelCount = texNative.width * texNative.height;
 
-		GLenum type = GL_UNSIGNED_BYTE, format = GL_RGBA;
-		switch(texNative.rasterformat)
+		if(isPal8)
 		{
-			case RW::BSTextureNative::FORMAT_1555:
-				format = GL_RGBA;
-				type = GL_UNSIGNED_SHORT_1_5_5_5_REV;
-				break;
-			case RW::BSTextureNative::FORMAT_8888:
-				format = GL_BGRA;
-				//type = GL_UNSIGNED_INT_8_8_8_8_REV;
-				coldata += 8;
-				type = GL_UNSIGNED_BYTE;
-				break;
-			case RW::BSTextureNative::FORMAT_888:
-				format = GL_BGRA;
-				type = GL_UNSIGNED_BYTE;
-				break;
-		default:
-				break;
+			uint8_t* dataBase = reinterpret_cast<uint8_t*>(rootSection.raw() + sizeof(RW::BSSectionHeader) + sizeof(RW::BSTextureNative) - 4);
+			uint32_t* palette = reinterpret_cast<uint32_t*>(dataBase);
+			uint32_t rasterSize = *reinterpret_cast<uint32_t*>(dataBase + paletteSize);
+			uint8_t* coldata = (dataBase + paletteSize + sizeof(uint32_t));
+
+			const char* rasterStart = reinterpret_cast<char*>(coldata);
+			size_t available = rasterStart < fileEnd ? fileEnd - rasterStart : 0;
+			size_t count = std::min<size_t>({ rasterSize, pixelCount, available });
+
+			texture.pixels.resize(pixelCount * sizeof(uint32_t));
+			TextureLoader::expandPalette(palette, coldata, count,
+										 reinterpret_cast<uint32_t*>(texture.pixels.data()));
+		}
+		else
+		{
+			auto coldata = rootSection.raw() + sizeof(RW::BSTextureNative);
+			coldata += sizeof(uint32_t);
+
+			size_t bytesPerPixel = 4;
+			switch(texNative.rasterformat)
+			{
+				case RW::BSTextureNative::FORMAT_1555:
+					texture.format = GL_RGBA;
+					texture.type = GL_UNSIGNED_SHORT_1_5_5_5_REV;
+					bytesPerPixel = 2;
+					break;
+				case RW::BSTextureNative::FORMAT_8888:
+					texture.format = GL_BGRA;
+					//type = GL_UNSIGNED_INT_8_8_8_8_REV;
+					coldata += 8;
+					texture.type = GL_UNSIGNED_BYTE;
+					break;
+				case RW::BSTextureNative::FORMAT_888:
+					texture.format = GL_BGRA;
+					texture.type = GL_UNSIGNED_BYTE;
+					break;
+			default:
+					break;
+			}
+
+			size_t available = coldata < fileEnd ? fileEnd - coldata : 0;
+			texture.pixels.resize(pixelCount * bytesPerPixel);
+			std::copy(coldata, coldata + std::min(texture.pixels.size(), available),
+					  texture.pixels.begin());
 		}
 
-		glGenTextures(1, &textureName);
-		glBindTexture(GL_TEXTURE_2D, textureName);
-		glTexImage2D(
-			GL_TEXTURE_2D, 0, GL_RGBA,
-			texNative.width, texNative.height, 0,
-			format, type, coldata
-		);
-	}
-	else {
-		return getErrorTexture();
-	}
+		switch(texNative.filterflags & 0xFF) {
+		default:
+		case RW::BSTextureNative::FILTER_LINEAR:
+			texture.filter = GL_LINEAR;
+			break;
+		case RW::BSTextureNative::FILTER_NEAREST:
+			texture.filter = GL_NEAREST;
+			break;
+		}
 
-	GLenum texFilter = GL_LINEAR;
-	switch(texNative.filterflags & 0xFF) {
-	default:
-	case RW::BSTextureNative::FILTER_LINEAR:
-		texFilter = GL_LINEAR;
-		break;
-	case RW::BSTextureNative::FILTER_NEAREST:
-		texFilter = GL_NEAREST;
-		break;
+		texture.wrapS = getWrapMode(texNative.wrapU);
+		texture.wrapT = getWrapMode(texNative.wrapV);
+		texture.valid = true;
 	}
+}
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texFilter);
-
-	GLenum texwrap = GL_REPEAT;
-	switch(texNative.wrapU) {
-	default:
-	case RW::BSTextureNative::WRAP_WRAP:
-		texwrap = GL_REPEAT;
-		break;
-	case RW::BSTextureNative::WRAP_CLAMP:
-		texwrap = GL_CLAMP_TO_EDGE;
-		break;
-	case RW::BSTextureNative::WRAP_MIRROR:
-		texwrap = GL_MIRRORED_REPEAT;
-		break;
+void TextureLoader::expandPalette(const uint32_t* palette, const uint8_t* indices, size_t count, uint32_t* out)
+{
+	size_t i = 0;
+#ifdef __AVX2__
+	// Widen 8 indices at a time and gather their colours
+	for( ; i + 8 <= count; i += 8 ) {
+		__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i));
+		__m256i offsets = _mm256_cvtepu8_epi32(packed);
+		__m256i colours = _mm256_i32gather_epi32(reinterpret_cast<const int*>(palette), offsets, 4);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), colours);
 	}
-	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texwrap );
-
-	switch(texNative.wrapV) {
-	default:
-	case RW::BSTextureNative::WRAP_WRAP:
-		texwrap = GL_REPEAT;
-		break;
-	case RW::BSTextureNative::WRAP_CLAMP:
-		texwrap = GL_CLAMP_TO_EDGE;
-		break;
-	case RW::BSTextureNative::WRAP_MIRROR:
-		texwrap = GL_MIRRORED_REPEAT;
-		break;
+#endif
+	for( ; i < count; ++i ) {
+		out[i] = palette[indices[i]];
 	}
-	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texwrap );
-
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	return TextureData::create( textureName, { texNative.width, texNative.height }, transparent );
 }
 
-bool TextureLoader::loadFromMemory(FileHandle file, TextureArchive &inTextures)
+bool TextureLoader::decode(FileHandle file, std::vector<DecodedTexture>& outTextures)
 {
 	auto data = file->data;
 	RW::BinaryStreamSection root(data);
@@ -183,18 +175,64 @@ bool TextureLoader::loadFromMemory(FileHandle file, TextureArchive &inTextures)
 			continue;
 
 		RW::BSTextureNative texNative = rootSection.readStructure<RW::BSTextureNative>();
-		std::string name = std::string(texNative.diffuseName);
-		std::string alpha = std::string(texNative.alphaName);
-		std::transform(name.begin(), name.end(), name.begin(), ::tolower );
-		std::transform(alpha.begin(), alpha.end(), alpha.begin(), ::tolower );
+		DecodedTexture texture;
+		texture.name = std::string(texNative.diffuseName);
+		texture.alpha = std::string(texNative.alphaName);
+		std::transform(texture.name.begin(), texture.name.end(), texture.name.begin(), ::tolower );
+		std::transform(texture.alpha.begin(), texture.alpha.end(), texture.alpha.begin(), ::tolower );
 
-		auto texture = createTexture(texNative, rootSection);
+		decodeRaster(file, texNative, rootSection, texture);
 
-		inTextures[{name, alpha}] = texture;
+		outTextures.push_back(std::move(texture));
+	}
 
-		if( !alpha.empty() ) {
-			inTextures[{name, ""}] = texture;
-		}
+	return true;
+}
+
+TextureData::Handle TextureLoader::upload(const DecodedTexture& texture)
+{
+	if( ! texture.valid ) {
+		return getErrorTexture();
+	}
+
+	GLuint textureName = 0;
+	glGenTextures(1, &textureName);
+	glBindTexture(GL_TEXTURE_2D, textureName);
+	glTexImage2D(
+		GL_TEXTURE_2D, 0, GL_RGBA,
+		texture.size.x, texture.size.y, 0,
+		texture.format, texture.type, texture.pixels.data()
+	);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture.filter);
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture.wrapS );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture.wrapT );
+
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	return TextureData::create( textureName, texture.size, texture.transparent );
+}
+
+void TextureLoader::addToArchive(const DecodedTexture& texture, TextureData::Handle handle, TextureArchive& archive)
+{
+	auto name = StringTable::get().intern(texture.name);
+	archive[textureKey(name, StringTable::get().intern(texture.alpha))] = handle;
+
+	if( !texture.alpha.empty() ) {
+		archive[textureKey(name)] = handle;
+	}
+}
+
+bool TextureLoader::loadFromMemory(FileHandle file, TextureArchive &inTextures)
+{
+	std::vector<DecodedTexture> textures;
+	if( ! decode(file, textures) ) {
+		return false;
+	}
+
+	for( auto& texture : textures ) {
+		addToArchive(texture, upload(texture), inTextures);
 	}
 
 	return true;
@@ -202,26 +240,36 @@ bool TextureLoader::loadFromMemory(FileHandle file, TextureArchive &inTextures)
 
 // TODO Move the Job system out of the loading code
 #include <platform/FileIndex.hpp>
+#include <gl/TextureUploadQueue.hpp>
 
-LoadTextureArchiveJob::LoadTextureArchiveJob(WorkContext *context, FileIndex* index, TextureArchive &inTextures, const std::string &file)
+LoadTextureArchiveJob::LoadTextureArchiveJob(WorkContext *context, FileIndex* index, TextureArchive &inTextures, const std::string &file, TextureUploadQueue* uploadQueue)
 	: WorkJob(context)
 	, archive(inTextures)
 	, fileIndex(index)
 	, _file(file)
+	, uploads(uploadQueue)
 {
 
 }
 
 void LoadTextureArchiveJob::work()
 {
-	data = fileIndex->openFile(_file);
+	auto data = fileIndex->openFile(_file);
+	if( data ) {
+		TextureLoader loader;
+		loader.decode(data, textures);
+	}
 }
 
 void LoadTextureArchiveJob::complete()
 {
 	// TODO error status
-	if(data) {
-		TextureLoader loader;
-		loader.loadFromMemory(data, archive);
+	if( uploads ) {
+		uploads->add(std::move(textures), archive);
+	}
+	else {
+		for( auto& texture : textures ) {
+			TextureLoader::addToArchive(texture, TextureLoader::upload(texture), archive);
+		}
 	}
 }
@@ -8,18 +8,66 @@
 #include <platform/FileHandle.hpp>
 #include <functional>
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 // This might suffice
 #include <gl/TextureData.hpp>
-typedef std::map<std::pair<std::string, std::string>, TextureData::Handle> TextureArchive;
+typedef std::unordered_map<TextureKey, TextureData::Handle> TextureArchive;
 
 class FileIndex;
+class TextureUploadQueue;
+
+/**
+ * @brief A texture's pixels and sampler settings, read from a TXD
+ *
+ * Decoding doesn't touch OpenGL, so it can run on a worker thread and
+ * leave only the upload to the thread with the context.
+ */
+struct DecodedTexture
+{
+	std::string name;
+	std::string alpha;
+	glm::ivec2 size;
+	/// Pixel format and type as passed to glTexImage2D
+	GLenum format;
+	GLenum type;
+	GLenum filter;
+	GLenum wrapS;
+	GLenum wrapT;
+	bool transparent;
+	/// Unsupported textures are replaced by the error texture
+	bool valid;
+	std::vector<uint8_t> pixels;
+};
 
 class TextureLoader
 {
 public:
+	/**
+	 * Decodes and uploads every texture in a TXD
+	 */
 	bool loadFromMemory(FileHandle file, TextureArchive& inTextures);
+
+	/**
+	 * Decodes every texture in a TXD, PAL8 rasters are expanded to RGBA
+	 */
+	bool decode(FileHandle file, std::vector<DecodedTexture>& outTextures);
+
+	/**
+	 * Creates the OpenGL texture for a decoded texture
+	 */
+	static TextureData::Handle upload(const DecodedTexture& texture);
+
+	/**
+	 * Adds an uploaded texture to an archive under its names
+	 */
+	static void addToArchive(const DecodedTexture& texture, TextureData::Handle handle, TextureArchive& archive);
+
+	/**
+	 * Looks up count palette indices, writing the colours to out
+	 */
+	static void expandPalette(const uint32_t* palette, const uint8_t* indices, size_t count, uint32_t* out);
 };
 
 // TODO: refactor this interface to be more like ModelLoader so they can be rolled into one.
@@ -29,10 +77,15 @@ private:
 	TextureArchive& archive;
 	FileIndex* fileIndex;
 	std::string _file;
-	FileHandle data;
+	TextureUploadQueue* uploads;
+	std::vector<DecodedTexture> textures;
 public:
 
-	LoadTextureArchiveJob(WorkContext* context, FileIndex* index, TextureArchive& inTextures, const std::string& file);
+	/**
+	 * The TXD is read and decoded by work(). If uploadQueue is set the textures
+	 * are queued in uploadQueue, otherwise complete() uploads them all.
+	 */
+	LoadTextureArchiveJob(WorkContext* context, FileIndex* index, TextureArchive& inTextures, const std::string& file, TextureUploadQueue* uploadQueue = nullptr);
 
 	void work();
 
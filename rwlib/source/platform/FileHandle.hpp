@@ -4,14 +4,22 @@
 
 /**
  * @brief Contains a pointer to a file's contents.
+ *
+ * If owner is set the contents are a view into memory that owner keeps
+ * alive (such as a mapped archive), otherwise data is owned. Views of a
+ * mapped archive may be written, but the writes are seen by every later
+ * view of the same asset.
  */
 struct FileContentsInfo
 {
 	char* data;
 	size_t length;
+	std::shared_ptr<const void> owner;
 
 	~FileContentsInfo() {
-		delete[] data;
+		if( ! owner ) {
+			delete[] data;
+		}
 	}
 };
 
@@ -2,12 +2,100 @@
 #include <loaders/LoaderIMG.hpp>
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
+namespace
+{
+	const char kCacheMagic[4] = { 'R', 'W', 'F', 'I' };
+	const uint32_t kCacheVersion = 1;
+
+	/// Appends values to a cache file buffer
+	class CacheWriter
+	{
+	public:
+		std::string buffer;
+
+		template<class T> void write(const T& value)
+		{
+			buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void write(const std::string& value)
+		{
+			write<uint32_t>(value.size());
+			buffer.append(value);
+		}
+	};
+
+	/// Reads values from a cache file buffer, failing at the end of the data
+	class CacheReader
+	{
+		const std::string& buffer;
+		size_t cursor;
+
+	public:
+		CacheReader(const std::string& data)
+			: buffer(data), cursor(0) { }
+
+		template<class T> bool read(T& value)
+		{
+			if( buffer.size() - cursor < sizeof(T) ) {
+				return false;
+			}
+			memcpy(&value, buffer.data() + cursor, sizeof(T));
+			cursor += sizeof(T);
+			return true;
+		}
+
+		bool read(std::string& value)
+		{
+			uint32_t length;
+			if( ! read(length) || buffer.size() - cursor < length ) {
+				return false;
+			}
+			value.assign(buffer.data() + cursor, length);
+			cursor += length;
+			return true;
+		}
+
+		/// Reads an element count, which can't be more than the remaining bytes
+		bool readCount(uint32_t& count)
+		{
+			return read(count) && count <= buffer.size() - cursor;
+		}
+	};
+}
+
+const uint32_t FileIndex::EmptySlot;
+
 void FileIndex::indexDirectory(const std::string& directory)
+{
+	if( useCachedSegment(Segment::Directory, directory) ) {
+		return;
+	}
+
+	Segment segment { Segment::Directory, directory, {}, {} };
+	readDirectory(directory, segment, false);
+	addSegment(segment);
+}
+
+void FileIndex::indexTree(const std::string& root)
+{
+	if( useCachedSegment(Segment::Tree, root) ) {
+		return;
+	}
+
+	Segment segment { Segment::Tree, root, {}, {} };
+	readDirectory(root, segment, true);
+	addSegment(segment);
+}
+
+void FileIndex::readDirectory(const std::string& directory, Segment& segment, bool recurse)
 {
 	DIR* dp = opendir(directory.c_str());
 	dirent* ep;
@@ -15,61 +103,49 @@ void FileIndex::indexDirectory(const std::string& directory)
 	if ( dp == NULL ) {
 		throw std::runtime_error("Unable to open directory: " + directory);
 	}
+
+	// Adding or removing files updates the directory's modification time
+	segment.stamps.push_back(stampPath(directory));
+
+	std::vector<std::string> subdirectories;
 	while( (ep = readdir(dp)) )
 	{
 		realName = ep->d_name;
-		lowerName = realName;
-		std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
 		bool isRegularFile = false;
+		bool isDirectory = false;
 		if (ep->d_type != DT_UNKNOWN) {
 			isRegularFile = ep->d_type == DT_REG;
+			isDirectory = ep->d_type == DT_DIR;
 		} else {
 			std::string filepath = directory +"/"+ realName;
 			struct stat filedata;
 			if (stat(filepath.c_str(), &filedata) == 0) {
 				isRegularFile = S_ISREG(filedata.st_mode);
+				isDirectory = S_ISDIR(filedata.st_mode);
 			}
 		}
 		if (isRegularFile) {
-			files[ lowerName ] = {
+			lowerName = realName;
+			std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+			segment.files.push_back({
 				lowerName,
 				realName,
 				directory,
-				""
-			};
+				"",
+				0,
+				0
+			});
+		}
+		else if (recurse && isDirectory && ep->d_name[0] != '.') {
+			subdirectories.push_back(directory +"/"+ realName);
 		}
 	}
 	closedir(dp);
-}
 
-void FileIndex::indexTree(const std::string& root)
-{
-	indexDirectory(root);
-	
-	DIR* dp = opendir(root.c_str());
-	dirent* ep;
-	if ( dp == NULL ) {
-		throw std::runtime_error("Unable to open directory: " + root);
+	// Files in subdirectories take precedence over their parent's
+	for( auto& subdirectory : subdirectories ) {
+		readDirectory(subdirectory, segment, true);
 	}
-	while( (ep = readdir(dp)) )
-	{
-		std::string filepath = root +"/"+ ep->d_name;
-
-		bool isDirectory = false;
-		if (ep->d_type != DT_UNKNOWN) {
-			isDirectory = ep->d_type == DT_DIR;
-		} else {
-			struct stat filedata;
-			if (stat(filepath.c_str(), &filedata) == 0) {
-				isDirectory = S_ISDIR(filedata.st_mode);
-			}
-		}
-
-		if (isDirectory && ep->d_name[0] != '.') {
-			indexTree(filepath);
-		}
-	}
-	closedir(dp);
 }
 
 void FileIndex::indexArchive(const std::string& archive)
@@ -79,98 +155,340 @@ void FileIndex::indexArchive(const std::string& archive)
 	auto directory = archive.substr(0, slash);
 	auto archivebasename = archive.substr(slash+1);
 	auto archivepath = directory + "/" + archivebasename;
-	
-	LoaderIMG img;
-	
-	if( ! img.load( archivepath ) )
-	{
-		throw std::runtime_error("Failed to load IMG archive: " + archivepath);
+
+	if( useCachedSegment(Segment::Archive, archivepath) ) {
+		return;
+	}
+
+	auto& img = getArchive(archivepath);
+
+	// Stamp both halves of the archive, as LoaderIMG does
+	auto baseName = archivepath;
+	auto extpos = baseName.find(".img");
+	if( extpos != std::string::npos ) {
+		baseName.erase(extpos);
 	}
-	
+
+	Segment segment { Segment::Archive, archivepath, {}, {} };
+	segment.stamps.push_back(stampPath(baseName + ".dir"));
+	segment.stamps.push_back(stampPath(baseName + ".img"));
+
 	std::string lowerName;
 	for( size_t i = 0; i < img.getAssetCount(); ++i )
 	{
 		auto& asset = img.getAssetInfoByIndex(i);
-		
+
 		if( asset.size == 0 ) continue;
-		
+
 		lowerName = asset.name;
 		std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
-		
-		files[ lowerName ] = {
+
+		segment.files.push_back({
 			lowerName,
 			asset.name,
 			directory,
-			archivebasename
-		};
+			archivebasename,
+			asset.offset,
+			asset.size
+		});
 	}
+
+	addSegment(segment);
 }
 
 bool FileIndex::findFile(const std::string& filename, FileIndex::IndexData& filedata)
 {
-	auto iterator = files.find( filename );
-	if( iterator == files.end() )
+	auto f = find( filename );
+	if( f == nullptr )
 	{
 		return false;
 	}
-	
-	filedata = iterator->second;
-	
+
+	filedata = *f;
+
 	return true;
 }
 
 FileHandle FileIndex::openFile(const std::string& filename)
 {
-	auto iterator = files.find( filename );
-	if( iterator == files.end() )
+	auto f = find( filename );
+	if( f == nullptr )
 	{
 		return nullptr;
 	}
-	
-	IndexData& f = iterator->second;
-	bool isArchive = !f.archive.empty();
-	
-	auto fsName = f.directory + "/" + f.originalName;
-	
-	char* data = nullptr;
-	size_t length = 0;
-	
+
+	bool isArchive = !f->archive.empty();
+
+	auto fsName = f->directory + "/" + f->originalName;
+
 	if( isArchive )
 	{
-		fsName = f.directory + "/" + f.archive;
-		
-		LoaderIMG img;
-		
-		if( ! img.load(fsName) )
-		{
-			throw std::runtime_error("Failed to load IMG archive: " + fsName);
-		}
-		
+		fsName = f->directory + "/" + f->archive;
+
+		auto& img = getArchive(fsName);
+
 		LoaderIMGFile file;
-		if( img.findAssetInfo(f.originalName, file) )
-		{
-			length = file.size * 2048;
-			data = img.loadToMemory(f.originalName);
+		file.offset = f->offset;
+		file.size = f->size;
+		strncpy(file.name, f->originalName.c_str(), sizeof(file.name) - 1);
+		file.name[sizeof(file.name) - 1] = '\0';
+
+		return img.openAsset(file);
+	}
+
+	std::ifstream dfile(fsName.c_str());
+	if ( ! dfile.is_open()) {
+		throw std::runtime_error("Unable to open file: " + fsName);
+	}
+
+	dfile.seekg(0, std::ios_base::end);
+	size_t length = dfile.tellg();
+	dfile.seekg(0);
+	char* data = new char[length];
+	dfile.read(data, length);
+
+	return FileHandle( new FileContentsInfo{ data, length, nullptr } );
+}
+
+bool FileIndex::loadCache(const std::string& path)
+{
+	std::ifstream cachefile(path.c_str(), std::ios_base::binary);
+	if( ! cachefile.is_open() ) {
+		return false;
+	}
+
+	std::string data(
+				(std::istreambuf_iterator<char>(cachefile)),
+				std::istreambuf_iterator<char>());
+	CacheReader reader(data);
+
+	char magic[4];
+	uint32_t version, segmentCount;
+	if( ! reader.read(magic) || memcmp(magic, kCacheMagic, 4) != 0 ||
+		! reader.read(version) || version != kCacheVersion ||
+		! reader.readCount(segmentCount) ) {
+		return false;
+	}
+
+	std::vector<Segment> loaded(segmentCount);
+	for( auto& segment : loaded ) {
+		uint8_t kind;
+		uint32_t stampCount, fileCount;
+		if( ! reader.read(kind) || ! reader.read(segment.source) ||
+			! reader.readCount(stampCount) ) {
+			return false;
+		}
+		segment.kind = Segment::Kind(kind);
+
+		segment.stamps.resize(stampCount);
+		for( auto& stamp : segment.stamps ) {
+			if( ! reader.read(stamp.path) || ! reader.read(stamp.mtime) ||
+				! reader.read(stamp.size) ) {
+				return false;
+			}
+		}
+
+		if( ! reader.readCount(fileCount) ) {
+			return false;
+		}
+		segment.files.resize(fileCount);
+		for( auto& f : segment.files ) {
+			if( ! reader.read(f.filename) || ! reader.read(f.originalName) ||
+				! reader.read(f.directory) || ! reader.read(f.archive) ||
+				! reader.read(f.offset) || ! reader.read(f.size) ) {
+				return false;
+			}
 		}
 	}
-	else
+
+	cachedSegments = std::move(loaded);
+	return true;
+}
+
+bool FileIndex::saveCache(const std::string& path) const
+{
+	CacheWriter writer;
+	writer.write(kCacheMagic);
+	writer.write(kCacheVersion);
+	writer.write<uint32_t>(segments.size());
+
+	for( auto& segment : segments ) {
+		writer.write<uint8_t>(segment.kind);
+		writer.write(segment.source);
+		writer.write<uint32_t>(segment.stamps.size());
+		for( auto& stamp : segment.stamps ) {
+			writer.write(stamp.path);
+			writer.write(stamp.mtime);
+			writer.write(stamp.size);
+		}
+		writer.write<uint32_t>(segment.files.size());
+		for( auto& f : segment.files ) {
+			writer.write(f.filename);
+			writer.write(f.originalName);
+			writer.write(f.directory);
+			writer.write(f.archive);
+			writer.write(f.offset);
+			writer.write(f.size);
+		}
+	}
+
+	std::ofstream cachefile(path.c_str(), std::ios_base::binary | std::ios_base::trunc);
+	if( ! cachefile.is_open() ) {
+		return false;
+	}
+	cachefile.write(writer.buffer.data(), writer.buffer.size());
+	return cachefile.good();
+}
+
+bool FileIndex::useCachedSegment(Segment::Kind kind, const std::string& source)
+{
+	auto it = std::find_if(cachedSegments.begin(), cachedSegments.end(),
+		[&](const Segment& s) { return s.kind == kind && s.source == source; });
+	if( it == cachedSegments.end() ) {
+		return false;
+	}
+
+	Segment segment = std::move(*it);
+	cachedSegments.erase(it);
+
+	for( auto& stamp : segment.stamps ) {
+		auto current = stampPath(stamp.path);
+		if( current.mtime != stamp.mtime || current.size != stamp.size ) {
+			return false;
+		}
+	}
+
+	addSegment(segment);
+	return true;
+}
+
+void FileIndex::addSegment(Segment& segment)
+{
+	uint32_t s = segments.size();
+	segments.push_back(std::move(segment));
+
+	auto& files = segments.back().files;
+	for( uint32_t f = 0; f < files.size(); ++f ) {
+		insert(hashName(files[f].filename), s, f);
+	}
+}
+
+const FileIndex::IndexData* FileIndex::find(const std::string& filename) const
+{
+	if( slots.empty() ) {
+		return nullptr;
+	}
+
+	uint64_t hash = hashName(filename);
+	size_t mask = slots.size() - 1;
+	for( size_t i = hash & mask; slots[i].segment != EmptySlot; i = (i + 1) & mask )
 	{
-		std::ifstream dfile(fsName.c_str());
-		if ( ! dfile.is_open()) {
-			throw std::runtime_error("Unable to open file: " + fsName);
+		if( slots[i].hash != hash ) {
+			continue;
+		}
+
+		auto& f = segments[slots[i].segment].files[slots[i].file];
+		if( f.filename.size() == filename.size() &&
+			std::equal(filename.begin(), filename.end(), f.filename.begin(),
+				[](char a, char b) { return ::tolower(a) == b; }) ) {
+			return &f;
 		}
+	}
+
+	return nullptr;
+}
 
-		dfile.seekg(0, std::ios_base::end);
-		length = dfile.tellg();
-		dfile.seekg(0);
-		data = new char[length];
-		dfile.read(data, length);
+void FileIndex::insert(uint64_t hash, uint32_t segment, uint32_t file)
+{
+	// Keep the table at most half full
+	if( (usedSlots + 1) * 2 > slots.size() ) {
+		growTable();
 	}
-	
-	if( data == nullptr )
+
+	auto& filename = segments[segment].files[file].filename;
+	size_t mask = slots.size() - 1;
+	size_t i = hash & mask;
+	for( ; slots[i].segment != EmptySlot; i = (i + 1) & mask )
 	{
-		return nullptr;
+		auto& existing = segments[slots[i].segment].files[slots[i].file];
+		if( slots[i].hash == hash && existing.filename == filename ) {
+			break;
+		}
+	}
+
+	if( slots[i].segment == EmptySlot ) {
+		usedSlots++;
+	}
+	slots[i] = { hash, segment, file };
+}
+
+void FileIndex::growTable()
+{
+	std::vector<Slot> old( std::max<size_t>(slots.size() * 2, 1024), Slot { 0, EmptySlot, 0 } );
+	std::swap(old, slots);
+
+	size_t mask = slots.size() - 1;
+	for( auto& slot : old ) {
+		if( slot.segment == EmptySlot ) {
+			continue;
+		}
+		size_t i = slot.hash & mask;
+		while( slots[i].segment != EmptySlot ) {
+			i = (i + 1) & mask;
+		}
+		slots[i] = slot;
+	}
+}
+
+uint64_t FileIndex::hashName(const std::string& name)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	for( char c : name ) {
+		hash ^= uint8_t(::tolower(c));
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+FileIndex::SourceStamp FileIndex::stampPath(const std::string& path)
+{
+	SourceStamp stamp { path, -1, -1 };
+
+	struct stat filedata;
+	if( stat(path.c_str(), &filedata) == 0 ) {
+#if defined(RW_OSX)
+		stamp.mtime = int64_t(filedata.st_mtimespec.tv_sec) * 1000000000 + filedata.st_mtimespec.tv_nsec;
+#else
+		stamp.mtime = int64_t(filedata.st_mtim.tv_sec) * 1000000000 + filedata.st_mtim.tv_nsec;
+#endif
+		stamp.size = filedata.st_size;
 	}
-	
-	return FileHandle( new FileContentsInfo{ data, length } );
+
+	return stamp;
+}
+
+LoaderIMG& FileIndex::getArchive(const std::string& path)
+{
+	std::lock_guard<std::mutex> guard( archiveMutex );
+
+	auto it = archives.find( path );
+	if( it != archives.end() )
+	{
+		return it->second;
+	}
+
+	LoaderIMG img;
+	if( ! img.load( path ) )
+	{
+		throw std::runtime_error("Failed to load IMG archive: " + path);
+	}
+
+	// Falls back to reading assets from disk if the mapping fails
+	if( mapArchives )
+	{
+		img.mapArchive();
+	}
+
+	return archives.insert({ path, img }).first->second;
 }
@@ -1,9 +1,20 @@
 #pragma once
 #include "FileHandle.hpp"
+#include <loaders/LoaderIMG.hpp>
 
 #include <string>
+#include <vector>
 #include <map>
+#include <mutex>
+#include <cstdint>
 
+/**
+ * @brief Maps case-insensitive filenames to files on disk or in archives.
+ *
+ * Files are kept in an open addressing hash table keyed on the hash of
+ * the lowercase filename. The index can be written to a cache file, so
+ * that later runs don't need to walk the directory tree or read archives.
+ */
 class FileIndex
 {
 public:
@@ -18,26 +29,40 @@ public:
 		std::string directory;
 		/// The archive filename (if applicable)
 		std::string archive;
+		/// Offset of the file within the archive, in sectors
+		uint32_t offset;
+		/// Size of the file within the archive, in sectors
+		uint32_t size;
 	};
 
+	FileIndex()
+		: usedSlots(0), mapArchives(true) { }
+
+	/**
+	 * Controls whether archives are memory mapped. When enabled, files
+	 * opened from an archive point directly into the mapping instead
+	 * of being read into a new buffer.
+	 */
+	void setMapArchives(bool map) { mapArchives = map; }
+
 	/**
 	 * Adds the files contained within the given directory to the
 	 * file index.
 	 */
 	void indexDirectory(const std::string& directory);
-	
+
 	/**
 	 * Adds the files contained within the given directory tree to the
 	 * file index.
 	 */
 	void indexTree(const std::string& root);
-	
+
 	/**
 	 * Adds the files contained within the given Archive file to the
 	 * file index.
 	 */
 	void indexArchive(const std::string& archive);
-	
+
 	/**
 	 * Returns true if the file identified by filename is found within
 	 * the file index. If the file is found, the filedata parameter
@@ -51,6 +76,97 @@ public:
 	 */
 	FileHandle openFile(const std::string& filename);
 
+	/**
+	 * Returns the number of unique filenames in the index
+	 */
+	size_t getFileCount() const { return usedSlots; }
+
+	/**
+	 * Reads an index cache written by saveCache. Subsequent calls to
+	 * indexDirectory, indexTree and indexArchive will use the cached
+	 * files instead of reading the filesystem, as long as the
+	 * directories or archive haven't been modified since.
+	 *
+	 * Returns false if the cache file is missing or invalid.
+	 */
+	bool loadCache(const std::string& path);
+
+	/**
+	 * Writes everything that has been indexed so far to a cache file
+	 */
+	bool saveCache(const std::string& path) const;
+
 private:
-	std::map<std::string, IndexData> files;
-};
\ No newline at end of file
+	/// Modification stamp for a directory or file that files were indexed from
+	struct SourceStamp
+	{
+		std::string path;
+		int64_t mtime;
+		int64_t size;
+	};
+
+	/// The files added by one call to indexDirectory, indexTree or indexArchive
+	struct Segment
+	{
+		enum Kind
+		{
+			Directory = 0,
+			Tree = 1,
+			Archive = 2
+		};
+
+		Kind kind;
+		std::string source;
+		std::vector<SourceStamp> stamps;
+		std::vector<IndexData> files;
+	};
+
+	/// Hash table slot, refers to a file in segments
+	struct Slot
+	{
+		uint64_t hash;
+		uint32_t segment;
+		uint32_t file;
+	};
+
+	/// Marks a Slot as unused
+	static const uint32_t EmptySlot = UINT32_MAX;
+
+	std::vector<Segment> segments;
+	std::vector<Slot> slots;
+	size_t usedSlots;
+
+	/// Segments read by loadCache that haven't been used yet
+	std::vector<Segment> cachedSegments;
+
+	/// Archives that have been indexed, kept open for openFile
+	std::map<std::string, LoaderIMG> archives;
+	std::mutex archiveMutex;
+	bool mapArchives;
+
+	/**
+	 * Returns the loaded archive at path, loading it if required.
+	 * Throws if the archive can't be loaded.
+	 */
+	LoaderIMG& getArchive(const std::string& path);
+
+	/// Adds the files in directory to the segment, and all subdirectories if recurse is set
+	void readDirectory(const std::string& directory, Segment& segment, bool recurse);
+
+	/// Adds a segment's files to the table, replacing any with the same name
+	void addSegment(Segment& segment);
+
+	/// Moves a valid cached segment for the source into the index
+	bool useCachedSegment(Segment::Kind kind, const std::string& source);
+
+	const IndexData* find(const std::string& filename) const;
+
+	void insert(uint64_t hash, uint32_t segment, uint32_t file);
+
+	void growTable();
+
+	/// Returns the hash of the lowercase of name
+	static uint64_t hashName(const std::string& name);
+
+	static SourceStamp stampPath(const std::string& path);
+};
@@ -0,0 +1,64 @@
+#include <platform/MappedFile.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+MappedFile::MappedFile(const std::string& path)
+	: data(nullptr)
+	, size(0)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if( fd == -1 ) {
+		return;
+	}
+
+	struct stat filedata;
+	if( fstat(fd, &filedata) == 0 && filedata.st_size > 0 ) {
+		void* mapping = mmap(nullptr, filedata.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if( mapping != MAP_FAILED ) {
+			data = static_cast<char*>(mapping);
+			size = filedata.st_size;
+		}
+	}
+
+	// The mapping keeps its own reference to the file
+	close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+	if( data != nullptr ) {
+		munmap(data, size);
+	}
+}
+
+void MappedFile::advise(size_t offset, size_t length, Access access) const
+{
+	if( data == nullptr || offset >= size ) {
+		return;
+	}
+
+	static const size_t pageSize = sysconf(_SC_PAGESIZE);
+
+	size_t start = offset - (offset % pageSize);
+	size_t end = std::min(offset + length, size);
+
+	int advice = MADV_NORMAL;
+	switch( access ) {
+	case WillNeed:
+		advice = MADV_WILLNEED;
+		break;
+	case Sequential:
+		advice = MADV_SEQUENTIAL;
+		break;
+	case Random:
+		advice = MADV_RANDOM;
+		break;
+	}
+
+	madvise(data + start, end - start, advice);
+}
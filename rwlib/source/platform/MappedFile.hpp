@@ -0,0 +1,55 @@
+#pragma once
+#ifndef _MAPPEDFILE_HPP_
+#define _MAPPEDFILE_HPP_
+
+#include <string>
+#include <cstddef>
+
+/**
+ * @brief A private memory mapping of a whole file.
+ *
+ * The mapping is copy-on-write: the file is never changed, and writing to
+ * a page only copies that page. The mapping lasts for the lifetime of the
+ * object, pointers returned by getData() must not be used after it is
+ * destroyed.
+ */
+class MappedFile
+{
+public:
+
+	/// Access patterns that can be hinted to the kernel with advise()
+	enum Access
+	{
+		/// Pages in the range will be read soon, start reading them in
+		WillNeed,
+		/// The range will be read front to back, read ahead aggressively
+		Sequential,
+		/// The range will be read in no particular order, don't read ahead
+		Random
+	};
+
+	MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/// Returns true if the file was mapped successfully
+	bool isMapped() const { return data != nullptr; }
+
+	char* getData() { return data; }
+	const char* getData() const { return data; }
+	size_t getSize() const { return size; }
+
+	/**
+	 * Hints the expected access pattern for a range of the file.
+	 * The range is expanded to page boundaries.
+	 */
+	void advise(size_t offset, size_t length, Access access) const;
+
+private:
+	char* data;
+	size_t size;
+};
+
+#endif
@@ -97,6 +97,7 @@ void ViewerWidget::paintGL()
 	}
 	
 	gworld->_work->update();
+	gworld->data->textureUploads.process();
 
 	r.getRenderer()->invalidate();
 
@@ -9,6 +9,9 @@
 #include <script/modules/VMModule.hpp>
 #include <script/modules/GameModule.hpp>
 #include <script/modules/ObjectModule.hpp>
+#include <engine/GameData.hpp>
+#include <core/Logger.hpp>
+#include <job/WorkContext.hpp>
 
 #define FIELD_DESC_WIDTH 30
 #define FIELD_PARAM_WIDTH 8
@@ -149,6 +152,43 @@ void disassemble(const std::string& scmname)
 	}
 }
 
+/**
+ * Writes the binary copy of every IPL file the game uses, so the game
+ * doesn't need to parse them the first time it starts
+ */
+int bakeWorld(const std::string& gamePath, const std::string& outputPath)
+{
+	Logger log;
+	StdOutReciever logPrinter;
+	log.addReciever(&logPrinter);
+
+	WorkContext work;
+	GameData data(&log, &work, gamePath);
+	data.parseDAT(gamePath + "/data/default.dat", true);
+	data.parseDAT(gamePath + "/data/gta3.dat", true);
+
+	for( auto& ide : data.ideLocations ) {
+		data.loadObjects(ide.second);
+	}
+
+	data.worldCachePath = outputPath;
+
+	int failed = 0;
+	for( auto& ipl : data.iplLocations ) {
+		WorldCache cache;
+		if( ! data.loadWorldCache(ipl.second, cache) ) {
+			std::cerr << "Failed to convert " << ipl.second << std::endl;
+			failed++;
+			continue;
+		}
+		std::cout << ipl.second << ": " << std::dec
+				  << cache.instances.size() << " instances, "
+				  << cache.zones.size() << " zones" << std::endl;
+	}
+
+	return failed > 0 ? 1 : 0;
+}
+
 int main(int argc, char** argv)
 {
 	if( argc < 2 ) {
@@ -157,6 +197,15 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
+	if( std::string(argv[1]) == "--bake-world" ) {
+		if( argc < 4 ) {
+			std::cerr << "Missing argument" << std::endl;
+			printUsage();
+			return 1;
+		}
+		return bakeWorld(argv[2], argv[3]);
+	}
+
 	disassemble(std::string(argv[1]));
 
 	return 0;
@@ -165,4 +214,5 @@ int main(int argc, char** argv)
 void printUsage() {
 	std::cout << "Usage:" << std::endl;
 	std::cout << " scripttool scmfile" << std::endl;
+	std::cout << " scripttool --bake-world gamedir outputdir" << std::endl;
 }
@@ -1,9 +1,181 @@
 #include <boost/test/unit_test.hpp>
 #include <platform//FileIndex.hpp>
 #include <test_globals.hpp>
+#include <test_benchmark.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+/**
+ * Creates a directory tree under a new temporary directory, with files
+ * spread evenly across subdirectories.
+ */
+std::string createTestTree(size_t directories, size_t filesPerDirectory)
+{
+	char root[] = "/tmp/rwfileindexXXXXXX";
+	BOOST_REQUIRE( mkdtemp(root) != nullptr );
+
+	for( size_t d = 0; d < directories; ++d ) {
+		auto directory = std::string(root) + "/Dir" + std::to_string(d);
+		mkdir(directory.c_str(), 0755);
+		for( size_t f = 0; f < filesPerDirectory; ++f ) {
+			auto path = directory + "/File" + std::to_string(d) + "_" + std::to_string(f) + ".DFF";
+			fclose(fopen(path.c_str(), "w"));
+		}
+	}
+
+	return root;
+}
+
+void removeTestTree(const std::string& path)
+{
+	DIR* dp = opendir(path.c_str());
+	if( dp == nullptr ) {
+		remove(path.c_str());
+		return;
+	}
+	while( dirent* ep = readdir(dp) ) {
+		std::string name = ep->d_name;
+		if( name != "." && name != ".." ) {
+			removeTestTree(path + "/" + name);
+		}
+	}
+	closedir(dp);
+	rmdir(path.c_str());
+}
 
 BOOST_AUTO_TEST_SUITE(FileIndexTests)
 
+BOOST_AUTO_TEST_CASE(test_index_case)
+{
+	auto root = createTestTree(2, 2);
+
+	FileIndex index;
+	index.indexTree(root);
+
+	BOOST_CHECK_EQUAL( index.getFileCount(), 4 );
+
+	FileIndex::IndexData data;
+	BOOST_CHECK( index.findFile("file1_0.dff", data) );
+	BOOST_CHECK_EQUAL( data.filename, "file1_0.dff" );
+	BOOST_CHECK_EQUAL( data.originalName, "File1_0.DFF" );
+	BOOST_CHECK_EQUAL( data.directory, root + "/Dir1" );
+
+	BOOST_CHECK( index.findFile("FILE1_0.DFF", data) );
+	BOOST_CHECK_EQUAL( data.filename, "file1_0.dff" );
+
+	BOOST_CHECK( ! index.findFile("file1_0.txd", data) );
+
+	removeTestTree(root);
+}
+
+BOOST_AUTO_TEST_CASE(test_index_cache)
+{
+	auto root = createTestTree(2, 2);
+	auto cache = root + ".cache";
+
+	// Give the directories an old time, so the changes below update them
+	utimbuf old { 1000, 1000 };
+	utime((root + "/Dir0").c_str(), &old);
+	utime((root + "/Dir1").c_str(), &old);
+
+	{
+		FileIndex index;
+		index.indexTree(root);
+		BOOST_CHECK( index.saveCache(cache) );
+	}
+
+	{
+		FileIndex index;
+		BOOST_REQUIRE( index.loadCache(cache) );
+		index.indexTree(root);
+
+		FileIndex::IndexData data;
+		BOOST_CHECK_EQUAL( index.getFileCount(), 4 );
+		BOOST_CHECK( index.findFile("file0_1.dff", data) );
+		BOOST_CHECK_EQUAL( data.originalName, "File0_1.DFF" );
+		BOOST_CHECK_EQUAL( data.directory, root + "/Dir0" );
+	}
+
+	// Adding or removing files invalidates the cache
+	fclose(fopen((root + "/Dir0/New.TXD").c_str(), "w"));
+	remove((root + "/Dir1/File1_0.DFF").c_str());
+
+	{
+		FileIndex index;
+		BOOST_REQUIRE( index.loadCache(cache) );
+		index.indexTree(root);
+
+		FileIndex::IndexData data;
+		BOOST_CHECK( index.findFile("new.txd", data) );
+		BOOST_CHECK( ! index.findFile("file1_0.dff", data) );
+	}
+
+	// Corrupt caches are rejected
+	{
+		FILE* f = fopen(cache.c_str(), "r+b");
+		fseek(f, 12, SEEK_SET);
+		uint32_t junk = 0xFFFFFFFF;
+		fwrite(&junk, sizeof(junk), 1, f);
+		fclose(f);
+
+		FileIndex index;
+		BOOST_CHECK( ! index.loadCache(cache) );
+	}
+
+	remove(cache.c_str());
+	removeTestTree(root);
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_index_cache)
+{
+	// 50k files in 500 directories
+	auto root = createTestTree(500, 100);
+	auto cache = root + ".cache";
+
+	auto coldStart = BenchmarkClock::now();
+	FileIndex cold;
+	cold.indexTree(root);
+	auto coldTime = elapsedMilliseconds(coldStart);
+
+	BOOST_CHECK_EQUAL( cold.getFileCount(), 50000 );
+	BOOST_REQUIRE( cold.saveCache(cache) );
+
+	auto warmStart = BenchmarkClock::now();
+	FileIndex warm;
+	BOOST_REQUIRE( warm.loadCache(cache) );
+	warm.indexTree(root);
+	auto warmTime = elapsedMilliseconds(warmStart);
+
+	BOOST_CHECK_EQUAL( warm.getFileCount(), 50000 );
+
+	FileIndex::IndexData data;
+	BOOST_CHECK( warm.findFile("file499_99.dff", data) );
+
+	auto lookupStart = BenchmarkClock::now();
+	size_t found = 0;
+	for( size_t d = 0; d < 500; ++d ) {
+		for( size_t f = 0; f < 100; ++f ) {
+			found += warm.findFile("file" + std::to_string(d) + "_" + std::to_string(f) + ".dff", data);
+		}
+	}
+	auto lookupTime = elapsedMilliseconds(lookupStart);
+
+	BOOST_CHECK_EQUAL( found, 50000 );
+
+	BOOST_TEST_MESSAGE( "FileIndex 50k files: cold " << coldTime << "ms, warm "
+						<< warmTime << "ms, 50k lookups " << lookupTime << "ms" );
+
+	remove(cache.c_str());
+	removeTestTree(root);
+}
+#endif
+
 #if RW_TEST_WITH_DATA
 BOOST_AUTO_TEST_CASE(test_index)
 {
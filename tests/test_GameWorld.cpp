@@ -2,7 +2,12 @@
 #include <engine/GameWorld.hpp>
 #include <engine/GameData.hpp>
 #include <objects/InstanceObject.hpp>
+#include <objects/CharacterObject.hpp>
+#include <objects/VehicleObject.hpp>
+#include <engine/Animator.hpp>
+#include <ai/CharacterController.hpp>
 #include <test_globals.hpp>
+#include <test_benchmark.hpp>
 
 BOOST_AUTO_TEST_SUITE(GameWorldTests)
 
@@ -16,6 +21,137 @@ BOOST_AUTO_TEST_CASE(test_gameobject_id)
 
 	BOOST_CHECK_NE( object1->getGameObjectID(), object2->getGameObjectID() );
 }
+
+/**
+ * Fills a world with a grid of alternating pedestrians and vehicles. The
+ * first pedestrian is left idle, the others either wander along a path
+ * joining every pedestrian or follow the first one.
+ */
+static void populateWorld(GameWorld& world, int count)
+{
+	PathData path { PathData::PATH_PED, 0, "", {} };
+	CharacterObject* leader = nullptr;
+
+	for( int i = 0; i < count; ++i ) {
+		glm::vec3 position(-200.f + (i % 25) * 16.f, -200.f + (i / 25) * 16.f, 10.f);
+		if( i % 2 == 0 ) {
+			auto character = world.createPedestrian(1, position);
+			BOOST_REQUIRE( character != nullptr );
+			BOOST_REQUIRE( character->controller != nullptr );
+			character->setRunning(i % 4 == 0);
+
+			if( leader == nullptr ) {
+				leader = character;
+			}
+			else if( i % 4 == 0 ) {
+				character->controller->setGoal(CharacterController::TrafficWander);
+			}
+			else {
+				character->controller->setGoal(CharacterController::FollowLeader);
+				character->controller->setTargetCharacter(leader);
+			}
+
+			path.nodes.push_back({ PathNode::INTERNAL, int32_t(path.nodes.size() + 1), position, 1.f, 0, 0 });
+		}
+		else {
+			BOOST_REQUIRE( world.createVehicle(90u, position) != nullptr );
+		}
+	}
+
+	if( ! path.nodes.empty() ) {
+		path.nodes.back().next = -1;
+		world.aigraph.createPathNodes(glm::vec3(), glm::quat(), path);
+	}
+}
+
+static void stepWorld(GameWorld& world, float dt)
+{
+	world._work->update();
+	world.tickObjects(dt);
+	world.destroyQueuedObjects();
+	world.dynamicsWorld->stepSimulation(dt, 2, dt);
+}
+
+BOOST_AUTO_TEST_CASE(test_tick_deterministic)
+{
+	// The same world updated by different numbers of threads
+	WorkContext singleWork(1);
+	WorkContext manyWork(4);
+	GameWorld single(&Global::get().log, &singleWork, Global::get().d);
+	GameWorld many(&Global::get().log, &manyWork, Global::get().d);
+
+	// The AI is seeded from the world, so both make the same choices
+	single.randomEngine.seed(1337);
+	many.randomEngine.seed(1337);
+
+	populateWorld(single, 100);
+	populateWorld(many, 100);
+
+	for( int t = 0; t < 120; ++t ) {
+		stepWorld(single, 1.f/60.f);
+		stepWorld(many, 1.f/60.f);
+	}
+
+	BOOST_REQUIRE_EQUAL( single.allObjects.size(), many.allObjects.size() );
+	for( size_t i = 0; i < single.allObjects.size(); ++i ) {
+		auto a = single.allObjects[i];
+		auto b = many.allObjects[i];
+		BOOST_CHECK_EQUAL( a->getPosition(), b->getPosition() );
+		if( a->type() == GameObject::Character ) {
+			auto animA = static_cast<CharacterObject*>(a)->animator;
+			auto animB = static_cast<CharacterObject*>(b)->animator;
+			BOOST_CHECK_EQUAL( animA->getAnimationTime(0), animB->getAnimationTime(0) );
+
+			auto controllerA = static_cast<CharacterObject*>(a)->controller;
+			auto controllerB = static_cast<CharacterObject*>(b)->controller;
+			BOOST_CHECK_EQUAL( controllerA->isCurrentActivity("GoTo"), controllerB->isCurrentActivity("GoTo") );
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_index_after_model_load)
+{
+	GameWorld world(&Global::get().log, &Global::get().work, Global::get().d);
+	auto vehicle = world.createVehicle(90u, glm::vec3(0.f, 0.f, 10.f));
+	BOOST_REQUIRE( vehicle != nullptr );
+
+	while( ! world._work->isEmpty() ) {
+		world._work->update();
+		std::this_thread::yield();
+	}
+	BOOST_REQUIRE( vehicle->model->resource != nullptr );
+
+	// The vehicle is indexed with its model's size from the next tick
+	world.tickObjects(0.f);
+	BOOST_CHECK( world.unloadedModelObjects.empty() );
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_tick_objects)
+{
+	const int objects = 500;
+	const int ticks = 120;
+
+	GameWorld world(&Global::get().log, &Global::get().work, Global::get().d);
+	populateWorld(world, objects);
+
+	double tickTime = 0.0;
+	for( int t = 0; t < ticks; ++t ) {
+		world._work->update();
+
+		auto begin = BenchmarkClock::now();
+		world.tickObjects(1.f/60.f);
+		tickTime += elapsedMilliseconds(begin);
+
+		world.destroyQueuedObjects();
+		world.dynamicsWorld->stepSimulation(1.f/60.f, 2, 1.f/60.f);
+	}
+
+	BOOST_TEST_MESSAGE( "tickObjects: " << objects << " pedestrians and vehicles on "
+						<< (world._work->getWorkerCount() + 1) << " threads, "
+						<< (tickTime / ticks) << "ms per tick" );
+}
+#endif
 #endif
 
 BOOST_AUTO_TEST_SUITE_END()
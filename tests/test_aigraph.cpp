@@ -0,0 +1,136 @@
+#include <boost/test/unit_test.hpp>
+#include <ai/AIGraph.hpp>
+#include <test_benchmark.hpp>
+#include <random>
+
+/**
+ * A path with one node at each position, each leading to the next
+ */
+static PathData createPath(PathData::PathType type, PathNode::NodeType nodeType,
+						   const std::vector<glm::vec3>& positions)
+{
+	PathData path { type, 0, "", {} };
+	for( size_t n = 0; n < positions.size(); ++n ) {
+		int32_t next = (n + 1 < positions.size()) ? int32_t(n + 1) : -1;
+		path.nodes.push_back({ nodeType, next, positions[n], 1.f, 0, 0 });
+	}
+	return path;
+}
+
+BOOST_AUTO_TEST_SUITE(AIGraphTests)
+
+BOOST_AUTO_TEST_CASE(test_nearest_nodes)
+{
+	AIGraph graph;
+	auto peds = createPath(PathData::PATH_PED, PathNode::INTERNAL,
+						   { {5.f, 0.f, 0.f}, {20.f, 0.f, 0.f}, {400.f, 0.f, 0.f} });
+	auto cars = createPath(PathData::PATH_CAR, PathNode::EXTERNAL,
+						   { {0.f, 3.f, 0.f}, {0.f, 150.f, 0.f} });
+	graph.createPathNodes(glm::vec3(), glm::quat(), peds);
+	graph.createPathNodes(glm::vec3(), glm::quat(), cars);
+
+	auto nearest = graph.findNearestNode(glm::vec3(0.f));
+	BOOST_REQUIRE( nearest != nullptr );
+	BOOST_CHECK_EQUAL( nearest->position.y, 3.f );
+
+	auto nearestPed = graph.findNearestNode(glm::vec3(0.f), AIGraph::typeBit(AIGraphNode::Pedestrian));
+	BOOST_REQUIRE( nearestPed != nullptr );
+	BOOST_CHECK_EQUAL( nearestPed->position.x, 5.f );
+
+	std::vector<AIGraphNode*> found;
+	graph.findNearestNodes(glm::vec3(0.f), 3, 1000.f, found, AIGraph::typeBit(AIGraphNode::Pedestrian));
+	BOOST_REQUIRE_EQUAL( found.size(), 3 );
+	BOOST_CHECK_EQUAL( found[1]->position.x, 20.f );
+	BOOST_CHECK_EQUAL( found[2]->position.x, 400.f );
+
+	found.clear();
+	graph.findNearestNodes(glm::vec3(0.f), 3, 100.f, found);
+	BOOST_CHECK_EQUAL( found.size(), 3 );
+
+	BOOST_CHECK( graph.findNearestNode(glm::vec3(0.f), AIGraph::typeBit(AIGraphNode::Vehicle), 2.f) == nullptr );
+
+	found.clear();
+	graph.gatherNodesNear(glm::vec3(0.f), 25.f, found);
+	BOOST_CHECK_EQUAL( found.size(), 3 );
+}
+
+BOOST_AUTO_TEST_CASE(test_nodes_outside_grid)
+{
+	AIGraph graph;
+	auto path = createPath(PathData::PATH_PED, PathNode::EXTERNAL,
+						   { {5000.f, -5000.f, 0.f} });
+	graph.createPathNodes(glm::vec3(), glm::quat(), path);
+
+	auto nearest = graph.findNearestNode(glm::vec3(0.f));
+	BOOST_REQUIRE( nearest != nullptr );
+	BOOST_CHECK_EQUAL( nearest->position.x, 5000.f );
+
+	std::vector<AIGraphNode*> external;
+	graph.gatherExternalNodesNear(glm::vec3(4990.f, -4990.f, 0.f), 20.f, external);
+	BOOST_CHECK_EQUAL( external.size(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE(test_shared_external_nodes)
+{
+	AIGraph graph;
+	auto a = createPath(PathData::PATH_PED, PathNode::EXTERNAL, { {0.f, 0.f, 0.f}, {10.f, 0.f, 0.f} });
+	auto b = createPath(PathData::PATH_PED, PathNode::EXTERNAL, { {10.f, 0.5f, 0.f}, {20.f, 0.f, 0.f} });
+	graph.createPathNodes(glm::vec3(), glm::quat(), a);
+	graph.createPathNodes(glm::vec3(), glm::quat(), b);
+
+	BOOST_CHECK_EQUAL( graph.nodes.size(), 3 );
+	BOOST_CHECK_EQUAL( graph.externalNodes.size(), 3 );
+	BOOST_CHECK_EQUAL( graph.nodes[1]->connections.size(), 2 );
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_nearest_node)
+{
+	AIGraph graph;
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> position(-1900.f, 1900.f);
+	for( int p = 0; p < 2000; ++p ) {
+		glm::vec3 start(position(random), position(random), 0.f);
+		auto path = createPath(p % 2 ? PathData::PATH_PED : PathData::PATH_CAR, PathNode::INTERNAL,
+							   { start, start + glm::vec3(10.f, 0.f, 0.f), start + glm::vec3(10.f, 10.f, 0.f),
+								 start + glm::vec3(0.f, 10.f, 0.f), start + glm::vec3(5.f, 5.f, 0.f) });
+		graph.createPathNodes(glm::vec3(), glm::quat(), path);
+	}
+
+	const int queries = 1000;
+	double indexedTime = 0.0, linearTime = 0.0;
+	bool matches = true;
+	auto types = AIGraph::typeBit(AIGraphNode::Pedestrian);
+	for( int q = 0; q < queries; ++q ) {
+		glm::vec3 center(position(random), position(random), 0.f);
+
+		auto begin = BenchmarkClock::now();
+		auto nearest = graph.findNearestNode(center, types);
+		indexedTime += elapsedMicroseconds(begin);
+
+		// What the AI used to do
+		begin = BenchmarkClock::now();
+		AIGraphNode* linear = nullptr;
+		float d = std::numeric_limits<float>::max();
+		for( auto node : graph.nodes ) {
+			if( node->type != AIGraphNode::Pedestrian ) {
+				continue;
+			}
+			float dist = glm::distance(node->position, center);
+			if( dist < d ) {
+				linear = node;
+				d = dist;
+			}
+		}
+		linearTime += elapsedMicroseconds(begin);
+
+		matches = matches && nearest == linear;
+	}
+
+	BOOST_CHECK( matches );
+	BOOST_TEST_MESSAGE( "Nearest node: " << (indexedTime / queries) << "us per query, "
+						<< (linearTime / queries) << "us scanning " << graph.nodes.size() << " nodes" );
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,10 +3,183 @@
 #include <data/Skeleton.hpp>
 #include <data/Model.hpp>
 #include <glm/gtx/string_cast.hpp>
+#include <cmath>
+#include <memory>
 #include "test_globals.hpp"
+#include "test_benchmark.hpp"
+
+/**
+ * Adds a bone that moves along x over one second
+ */
+static void addBone(Animation& animation, const std::string& name, float distance, size_t keyframes = 2)
+{
+	animation.duration = 1.f;
+	auto bone = new AnimationBone{ name, 0, 0, 1.f, AnimationBone::RT0, {} };
+	for( size_t k = 0; k < keyframes; ++k ) {
+		float t = k / float(keyframes - 1);
+		bone->addKeyframe({ glm::quat(), glm::vec3(distance * t, 0.f, 0.f), glm::vec3(), t, int(k) });
+	}
+	animation.bones[name] = bone;
+}
+
+static Model* createModel(const std::vector<std::string>& names)
+{
+	Model* model = new Model;
+	for( unsigned int f = 0; f < names.size(); ++f ) {
+		model->frames.push_back(new ModelFrame(f, nullptr, glm::mat3(), glm::vec3()));
+		model->frames.back()->setName(names[f]);
+	}
+	return model;
+}
 
 BOOST_AUTO_TEST_SUITE(AnimationTests)
 
+BOOST_AUTO_TEST_CASE(test_keyframe_cursor)
+{
+	AnimationBone bone { "bone", 0, 0, 1.f, AnimationBone::RT0, {} };
+	for( int k = 0; k <= 10; ++k ) {
+		bone.addKeyframe({ glm::quat(), glm::vec3(k, 0.f, 0.f), glm::vec3(), k * 0.1f, k });
+	}
+
+	// Forwards, backwards and past the end should match a fresh search
+	size_t cursor = 0;
+	for( float t : { 0.f, 0.05f, 0.31f, 0.32f, 0.9f, 0.15f, 0.2f, 2.f, 0.f } ) {
+		auto kf = bone.getInterpolatedKeyframe(t, cursor);
+		auto expected = bone.getInterpolatedKeyframe(t);
+		BOOST_CHECK_CLOSE( kf.position.x, expected.position.x, 0.01f );
+	}
+
+	cursor = 0;
+	BOOST_CHECK_CLOSE( bone.getInterpolatedKeyframe(0.35f, cursor).position.x, 3.5f, 0.01f );
+	BOOST_CHECK_EQUAL( cursor, 4 );
+	BOOST_CHECK_EQUAL( bone.getInterpolatedKeyframe(5.f, cursor).position.x, 10.f );
+}
+
+BOOST_AUTO_TEST_CASE(test_rotation_tracks)
+{
+	glm::quat rotation = glm::normalize(glm::quat(0.3f, -0.5f, 0.7f, 0.1f));
+	auto unpacked = AnimationRotation::pack(rotation).unpack();
+	BOOST_CHECK_SMALL( unpacked.x - rotation.x, 0.0001f );
+	BOOST_CHECK_SMALL( unpacked.y - rotation.y, 0.0001f );
+	BOOST_CHECK_SMALL( unpacked.z - rotation.z, 0.0001f );
+	BOOST_CHECK_SMALL( unpacked.w - rotation.w, 0.0001f );
+
+	// Rotation only bones don't keep positions or scales
+	AnimationBone bone { "bone", 0, 0, 1.f, AnimationBone::R00, {} };
+	bone.addKeyframe({ glm::quat(), glm::vec3(1.f, 2.f, 3.f), glm::vec3(2.f), 0.f, 0 });
+	bone.addKeyframe({ rotation, glm::vec3(1.f, 2.f, 3.f), glm::vec3(2.f), 1.f, 1 });
+	BOOST_CHECK_EQUAL( bone.getKeyframeCount(), 2 );
+	BOOST_CHECK( bone.positions.empty() );
+	BOOST_CHECK( bone.scales.empty() );
+
+	size_t cursor = 0;
+	glm::quat sampled;
+	glm::vec3 position(5.f);
+	bone.interpolate(1.f, cursor, sampled, position);
+	BOOST_CHECK( position == glm::vec3(0.f) );
+	BOOST_CHECK_SMALL( sampled.w - rotation.w, 0.0001f );
+	BOOST_CHECK( bone.getInterpolatedKeyframe(0.5f).scale == glm::vec3(1.f) );
+}
+
+BOOST_AUTO_TEST_CASE(test_binding_shared)
+{
+	Skeleton first, second;
+	Animation walk;
+	std::unique_ptr<Model> model(createModel({ "root", "unused", "arm" }));
+	addBone(walk, "root", 1.f);
+	addBone(walk, "arm", 2.f);
+
+	AnimationBindingCache bindings;
+	Animator a(model.get(), &first, &bindings), b(model.get(), &second, &bindings);
+	a.playAnimation(0, &walk, 1.f, false);
+	b.playAnimation(0, &walk, 1.f, false);
+	a.tick(0.5f);
+	b.tick(1.f);
+
+	// Bones are found once for the model and shared by both animators
+	BOOST_REQUIRE_EQUAL( bindings.getBindingCount(model.get()), 1 );
+	auto& binding = bindings.get(model.get(), &walk);
+	BOOST_REQUIRE_EQUAL( binding.size(), 2 );
+	BOOST_CHECK_EQUAL( binding[0].second, 0 );
+	BOOST_CHECK_EQUAL( binding[1].second, 2 );
+
+	BOOST_CHECK_CLOSE( first.getData(2).a.translation.x, 1.f, 0.01f );
+	BOOST_CHECK_CLOSE( second.getData(2).a.translation.x, 2.f, 0.01f );
+
+	bindings.removeModel(model.get());
+	BOOST_CHECK_EQUAL( bindings.getBindingCount(model.get()), 0 );
+
+	for( auto& bone : walk.bones ) delete bone.second;
+}
+
+BOOST_AUTO_TEST_CASE(test_blend_slots)
+{
+	Skeleton skeleton;
+	Animation walk, wave;
+	std::unique_ptr<Model> model(createModel({ "root", "arm" }));
+	addBone(walk, "root", 1.f);
+	addBone(walk, "arm", 1.f);
+	addBone(wave, "arm", 3.f);
+
+	Animator animator(model.get(), &skeleton);
+	animator.playAnimation(0, &walk, 1.f, false);
+	animator.playAnimation(1, &wave, 1.f, false);
+	animator.tick(1.f);
+
+	// The later slot replaces the earlier one
+	BOOST_CHECK_CLOSE( skeleton.getData(0).a.translation.x, 1.f, 0.01f );
+	BOOST_CHECK_CLOSE( skeleton.getData(1).a.translation.x, 3.f, 0.01f );
+
+	animator.setAnimationWeight(1, 0.5f);
+	animator.tick(0.f);
+	BOOST_CHECK_CLOSE( skeleton.getData(1).a.translation.x, 2.f, 0.01f );
+	BOOST_CHECK_CLOSE( skeleton.getData(1).b.translation.x, 3.f, 0.01f );
+
+	for( auto& bone : walk.bones ) delete bone.second;
+	for( auto& bone : wave.bones ) delete bone.second;
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_animator)
+{
+	const int characters = 100;
+	const int ticks = 300;
+	std::vector<std::string> names;
+	for( int b = 0; b < 32; ++b ) {
+		names.push_back("bone" + std::to_string(b));
+	}
+
+	Animation animation;
+	std::unique_ptr<Model> model(createModel(names));
+	for( auto& name : names ) {
+		addBone(animation, name, 1.f, 60);
+	}
+	std::vector<std::unique_ptr<Skeleton>> skeletons;
+	std::vector<std::unique_ptr<Animator>> animators;
+	for( int c = 0; c < characters; ++c ) {
+		skeletons.emplace_back(new Skeleton);
+		animators.emplace_back(new Animator(model.get(), skeletons.back().get()));
+		animators.back()->playAnimation(0, &animation, 1.f, true);
+	}
+
+	auto begin = BenchmarkClock::now();
+	for( int t = 0; t < ticks; ++t ) {
+		for( auto& animator : animators ) {
+			animator->tick(1.f / 60.f);
+		}
+		for( auto& skeleton : skeletons ) {
+			skeleton->interpolate(0.5f);
+		}
+	}
+	auto time = elapsedMilliseconds(begin);
+
+	BOOST_TEST_MESSAGE( "Animator: " << characters << " characters with " << names.size()
+						<< " bones, " << (time / ticks) << "ms per tick" );
+
+	for( auto& bone : animation.bones ) delete bone.second;
+}
+#endif
+
 #if RW_TEST_WITH_DATA
 BOOST_AUTO_TEST_CASE(test_matrix)
 {
@@ -16,24 +189,15 @@ BOOST_AUTO_TEST_CASE(test_matrix)
 		
 		/** Models are currently needed to relate animation bones <=> model frame #s. */
 		Global::get().e->data->loadDFF("player.dff");
-		ModelRef& test_model = Global::get().e->data->models["player"];
+		ModelRef& test_model = Global::get().e->data->models[StringTable::get().intern("player")];
 		
 		Animator animator(test_model->resource, &skeleton);
 
 		animation.duration = 1.f;
-		animation.bones["player"] = new AnimationBone{
-				"player",
-				0, 0, 1.0f,
-				AnimationBone::RT0,
-		{
-			{
-				glm::quat(), glm::vec3(0.f, 0.f, 0.f), glm::vec3(), 0.f, 0
-			},
-			{
-				glm::quat(), glm::vec3(0.f, 1.f, 0.f), glm::vec3(), 1.0f, 1
-			},
-		}
-		};
+		auto bone = new AnimationBone{ "player", 0, 0, 1.0f, AnimationBone::RT0, {} };
+		bone->addKeyframe({ glm::quat(), glm::vec3(0.f, 0.f, 0.f), glm::vec3(), 0.f, 0 });
+		bone->addKeyframe({ glm::quat(), glm::vec3(0.f, 1.f, 0.f), glm::vec3(), 1.0f, 1 });
+		animation.bones["player"] = bone;
 		
 		animator.playAnimation(0, &animation, 1.f, false);
 		
@@ -46,8 +210,80 @@ BOOST_AUTO_TEST_CASE(test_matrix)
 		
 		BOOST_CHECK( skeleton.getData(0).a.translation == glm::vec3(0.f, 1.f, 0.f) );
 		BOOST_CHECK( skeleton.getData(0).b.translation == glm::vec3(0.f, 0.f, 0.f) );
+
+		delete bone;
 	}
 }
+
+BOOST_AUTO_TEST_CASE(test_ped_ifp_tracks)
+{
+	auto& animations = Global::get().d->animations;
+	BOOST_REQUIRE( ! animations.empty() );
+
+	size_t keyframes = 0, compact = 0;
+	for( auto& animation : animations ) {
+		for( auto& bone : animation.second->bones ) {
+			keyframes += bone.second->getKeyframeCount();
+			compact += bone.second->getMemoryUsage();
+			if( bone.second->type == AnimationBone::R00 ) {
+				BOOST_CHECK( bone.second->positions.empty() );
+			}
+		}
+	}
+
+	// Each keyframe used to be stored whole
+	BOOST_CHECK( compact < keyframes * sizeof(AnimationKeyframe) );
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_ped_ifp)
+{
+	auto& animations = Global::get().d->animations;
+	BOOST_REQUIRE( ! animations.empty() );
+
+	size_t keyframes = 0, bones = 0, compact = 0, rotationOnly = 0;
+	std::vector<const AnimationBone*> allBones;
+	for( auto& animation : animations ) {
+		for( auto& bone : animation.second->bones ) {
+			bones++;
+			keyframes += bone.second->getKeyframeCount();
+			compact += bone.second->getMemoryUsage();
+			if( bone.second->type == AnimationBone::R00 ) {
+				rotationOnly++;
+			}
+			if( bone.second->getKeyframeCount() > 0 ) {
+				allBones.push_back(bone.second);
+			}
+		}
+	}
+	size_t uncompressed = keyframes * sizeof(AnimationKeyframe);
+
+	// Plays every bone forwards at 60 frames per second
+	const int samples = 120;
+	std::vector<size_t> cursors(allBones.size(), 0);
+	glm::quat rotation;
+	glm::vec3 position;
+	float checksum = 0.f;
+
+	auto begin = BenchmarkClock::now();
+	for( int s = 0; s < samples; ++s ) {
+		for( size_t b = 0; b < allBones.size(); ++b ) {
+			float time = std::fmod(s / 60.f, std::max(allBones[b]->duration, 0.001f));
+			allBones[b]->interpolate(time, cursors[b], rotation, position);
+			checksum += rotation.w;
+		}
+	}
+	auto seconds = elapsedSeconds(begin);
+	BOOST_CHECK( checksum != 0.f );
+
+	BOOST_TEST_MESSAGE( "ped.ifp: " << animations.size() << " animations, " << bones << " bones ("
+						<< rotationOnly << " rotation only), " << keyframes << " keyframes" );
+	BOOST_TEST_MESSAGE( "  " << (uncompressed / 1024) << "KiB as keyframes, "
+						<< (compact / 1024) << "KiB as tracks" );
+	BOOST_TEST_MESSAGE( "  " << (samples * allBones.size() / seconds / 1000000.0)
+						<< " million bone samples per second" );
+}
+#endif
 #endif
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,9 +1,107 @@
 #include <boost/test/unit_test.hpp>
 #include "test_globals.hpp"
 #include <loaders/LoaderIMG.hpp>
+#include <platform/FileIndex.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/**
+ * Writes a small archive with two assets to disk, the first asset's
+ * sectors are filled with 'a' and the second's with 'b'.
+ */
+void writeTestArchive(const std::string& base)
+{
+	LoaderIMGFile files[2] = {};
+	files[0].offset = 0;
+	files[0].size = 2;
+	strcpy(files[0].name, "first.dff");
+	files[1].offset = 2;
+	files[1].size = 1;
+	strcpy(files[1].name, "SECOND.TXD");
+
+	FILE* dir = fopen((base + ".dir").c_str(), "wb");
+	fwrite(files, sizeof(LoaderIMGFile), 2, dir);
+	fclose(dir);
+
+	std::vector<char> sectors(3 * 2048, 'a');
+	std::fill(sectors.begin() + 2 * 2048, sectors.end(), 'b');
+
+	FILE* img = fopen((base + ".img").c_str(), "wb");
+	fwrite(sectors.data(), 1, sectors.size(), img);
+	fclose(img);
+}
 
 BOOST_AUTO_TEST_SUITE(ArchiveTests)
 
+BOOST_AUTO_TEST_CASE(test_mapped_archive)
+{
+	writeTestArchive("test_mapped_archive");
+
+	LoaderIMG archive;
+	BOOST_REQUIRE( archive.load("test_mapped_archive.img") );
+	BOOST_CHECK( ! archive.isMapped() );
+
+	LoaderIMGFile second;
+	BOOST_REQUIRE( archive.findAssetInfo("second.txd", second) );
+
+	auto heap = archive.openAsset(second);
+	BOOST_REQUIRE( heap != nullptr );
+	BOOST_CHECK( heap->owner == nullptr );
+
+	BOOST_REQUIRE( archive.mapArchive() );
+	BOOST_CHECK( archive.isMapped() );
+
+	auto view = archive.openAsset(second);
+	BOOST_REQUIRE( view != nullptr );
+	BOOST_CHECK( view->owner != nullptr );
+	BOOST_CHECK_EQUAL( view->length, heap->length );
+	BOOST_CHECK( memcmp(view->data, heap->data, heap->length) == 0 );
+
+	// Views of the same asset share the one mapping
+	auto view2 = archive.openAsset(second);
+	BOOST_CHECK_EQUAL( view->data, view2->data );
+
+	// Copies still work once the archive is mapped
+	char* copy = archive.loadToMemory("first.dff");
+	BOOST_REQUIRE( copy != nullptr );
+	BOOST_CHECK_EQUAL( copy[0], 'a' );
+	BOOST_CHECK_EQUAL( copy[2 * 2048 - 1], 'a' );
+	delete[] copy;
+
+	remove("test_mapped_archive.dir");
+	remove("test_mapped_archive.img");
+
+	// The mapping outlives the archive's files and the loader
+	archive = LoaderIMG();
+	BOOST_CHECK_EQUAL( view->data[0], 'b' );
+}
+
+BOOST_AUTO_TEST_CASE(test_index_mapped_archive)
+{
+	writeTestArchive("test_index_archive");
+
+	for( bool mapped : { true, false } ) {
+		FileIndex index;
+		index.setMapArchives(mapped);
+		index.indexArchive("./test_index_archive.img");
+
+		auto first = index.openFile("first.dff");
+		BOOST_REQUIRE( first != nullptr );
+		BOOST_CHECK_EQUAL( first->length, 2 * 2048 );
+		BOOST_CHECK_EQUAL( first->owner != nullptr, mapped );
+		BOOST_CHECK_EQUAL( first->data[0], 'a' );
+
+		auto second = index.openFile("second.txd");
+		BOOST_REQUIRE( second != nullptr );
+		BOOST_CHECK_EQUAL( second->data[2047], 'b' );
+	}
+
+	remove("test_index_archive.dir");
+	remove("test_index_archive.img");
+}
+
 #if RW_TEST_WITH_DATA
 BOOST_AUTO_TEST_CASE(test_open_archive)
 {
@@ -0,0 +1,353 @@
+#include <boost/test/unit_test.hpp>
+#include <audio/PCMRingBuffer.hpp>
+#include <audio/MADDecoder.hpp>
+#include <audio/AudioDevice.hpp>
+#include <audio/SoundBank.hpp>
+#include <audio/VoicePool.hpp>
+#include <loaders/LoaderSDT.hpp>
+#include "test_globals.hpp"
+#include "test_benchmark.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * Writes an SDT archive of effects lasting one second at 1000Hz,
+ * each filled with its own index. Returns the path without an extension.
+ */
+static std::string createTestArchive(char* directory, size_t effects)
+{
+	BOOST_REQUIRE( mkdtemp(directory) != nullptr );
+	std::string base = std::string(directory) + "/SFX";
+
+	FILE* sdt = fopen((base + ".SDT").c_str(), "wb");
+	FILE* raw = fopen((base + ".RAW").c_str(), "wb");
+	std::vector<int16_t> samples(1000);
+	for( size_t e = 0; e < effects; ++e ) {
+		LoaderSDTFile info;
+		info.offset = e * samples.size() * sizeof(int16_t);
+		info.size = samples.size() * sizeof(int16_t);
+		info.sampleRate = 1000;
+		info.loopStart = 0;
+		info.loopEnd = -1;
+		fwrite(&info, sizeof(info), 1, sdt);
+
+		std::fill(samples.begin(), samples.end(), int16_t(e));
+		fwrite(samples.data(), sizeof(int16_t), samples.size(), raw);
+	}
+	fclose(sdt);
+	fclose(raw);
+
+	return base;
+}
+
+static void removeTestArchive(const std::string& base)
+{
+	remove((base + ".SDT").c_str());
+	remove((base + ".RAW").c_str());
+	rmdir(base.substr(0, base.rfind('/')).c_str());
+}
+
+BOOST_AUTO_TEST_SUITE(AudioTests)
+
+BOOST_AUTO_TEST_CASE(test_ring_buffer)
+{
+	PCMRingBuffer ring(6);
+	BOOST_CHECK_EQUAL( ring.capacity(), 8 );
+	BOOST_CHECK_EQUAL( ring.available(), 0 );
+
+	int16_t in[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	int16_t out[8] = {};
+	BOOST_CHECK_EQUAL( ring.write(in, 6), 6 );
+	BOOST_CHECK_EQUAL( ring.read(out, 4), 4 );
+	BOOST_CHECK_EQUAL( out[3], 4 );
+
+	// Wraps around the end, and stops when full
+	BOOST_CHECK_EQUAL( ring.write(in, 8), 6 );
+	BOOST_CHECK_EQUAL( ring.space(), 0 );
+	BOOST_CHECK_EQUAL( ring.read(out, 8), 8 );
+	BOOST_CHECK_EQUAL( out[0], 5 );
+	BOOST_CHECK_EQUAL( out[1], 6 );
+	BOOST_CHECK_EQUAL( out[2], 1 );
+	BOOST_CHECK_EQUAL( out[7], 6 );
+	BOOST_CHECK_EQUAL( ring.read(out, 8), 0 );
+}
+
+BOOST_AUTO_TEST_CASE(test_ring_buffer_threads)
+{
+	const int16_t count = 30000;
+	PCMRingBuffer ring(256);
+
+	std::thread writer([&] {
+		int16_t chunk[64];
+		int16_t next = 0;
+		while( next < count ) {
+			int16_t n = 0;
+			for( ; n < 64 && next + n < count; ++n ) {
+				chunk[n] = next + n;
+			}
+			size_t written = 0;
+			while( written < size_t(n) ) {
+				written += ring.write(chunk + written, n - written);
+				std::this_thread::yield();
+			}
+			next += n;
+		}
+	});
+
+	// Every sample arrives once, in order
+	int16_t expected = 0;
+	bool ordered = true;
+	int16_t chunk[100];
+	while( expected < count ) {
+		size_t read = ring.read(chunk, 100);
+		for( size_t s = 0; s < read; ++s ) {
+			ordered = ordered && chunk[s] == expected++;
+		}
+	}
+	writer.join();
+
+	BOOST_CHECK( ordered );
+	BOOST_CHECK_EQUAL( ring.available(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE(test_sdt_samples)
+{
+	char directory[] = "/tmp/rwsdtXXXXXX";
+	auto base = createTestArchive(directory, 4);
+
+	{
+		LoaderSDT archive;
+		BOOST_REQUIRE( archive.load(base) );
+		BOOST_CHECK_EQUAL( archive.getAssetCount(), 4 );
+
+		auto samples = archive.getSampleData(3);
+		BOOST_REQUIRE( samples != nullptr );
+		int16_t first;
+		std::memcpy(&first, samples, sizeof(first));
+		BOOST_CHECK_EQUAL( first, 3 );
+		BOOST_CHECK( archive.getSampleData(4) == nullptr );
+
+		// The copying interface still works, now from the mapping
+		char* wave = archive.loadToMemory(2, true);
+		BOOST_REQUIRE( wave != nullptr );
+		BOOST_CHECK( std::memcmp(wave, "RIFF", 4) == 0 );
+		delete[] wave;
+	}
+
+	removeTestArchive(base);
+}
+
+BOOST_AUTO_TEST_CASE(test_sound_bank)
+{
+	char directory[] = "/tmp/rwsdtXXXXXX";
+	auto base = createTestArchive(directory, 8);
+
+	{
+		LoaderSDT archive;
+		BOOST_REQUIRE( archive.load(base) );
+		NullAudioDevice device;
+
+		{
+			SoundBank bank(&archive, &device);
+			BOOST_CHECK_EQUAL( bank.getSoundCount(), 8 );
+			BOOST_CHECK_EQUAL( bank.getLoadedCount(), 0 );
+
+			// Effects are uploaded once, on first use
+			auto buffer = bank.getBuffer(5);
+			BOOST_CHECK( buffer != 0 );
+			BOOST_CHECK_EQUAL( bank.getBuffer(5), buffer );
+			BOOST_CHECK_EQUAL( bank.getBuffer(8), 0 );
+			BOOST_CHECK_EQUAL( bank.getLoadedCount(), 1 );
+			BOOST_CHECK_EQUAL( device.getUploadedBytes(), 2000 );
+		}
+
+		BOOST_CHECK_EQUAL( device.getBufferCount(), 0 );
+	}
+
+	removeTestArchive(base);
+}
+
+BOOST_AUTO_TEST_CASE(test_voice_stealing)
+{
+	char directory[] = "/tmp/rwsdtXXXXXX";
+	auto base = createTestArchive(directory, 8);
+
+	{
+		LoaderSDT archive;
+		BOOST_REQUIRE( archive.load(base) );
+		NullAudioDevice device;
+		SoundBank bank(&archive, &device);
+		VoicePool voices(&device, &bank, 2, 100.f);
+		BOOST_CHECK_EQUAL( device.getSourceCount(), 2 );
+
+		auto near = voices.play(0, glm::vec3(10.f, 0.f, 0.f));
+		auto far = voices.play(1, glm::vec3(50.f, 0.f, 0.f));
+		BOOST_CHECK( voices.isPlaying(near) );
+		BOOST_CHECK( voices.isPlaying(far) );
+
+		// Too far away to hear
+		BOOST_CHECK( ! voices.play(2, glm::vec3(200.f, 0.f, 0.f)).isValid() );
+
+		// Further than everything playing at the same priority
+		BOOST_CHECK( ! voices.play(2, glm::vec3(60.f, 0.f, 0.f)).isValid() );
+		BOOST_CHECK_EQUAL( voices.getStats().dropped, 2 );
+
+		// Takes the furthest voice
+		auto closer = voices.play(2, glm::vec3(20.f, 0.f, 0.f));
+		BOOST_CHECK( voices.isPlaying(closer) );
+		BOOST_CHECK( ! voices.isPlaying(far) );
+		BOOST_CHECK( voices.isPlaying(near) );
+
+		// Priority wins over distance
+		auto important = voices.play(3, glm::vec3(90.f, 0.f, 0.f), 1);
+		BOOST_CHECK( voices.isPlaying(important) );
+		BOOST_CHECK( ! voices.isPlaying(closer) );
+		BOOST_CHECK_EQUAL( voices.getStats().stolen, 2 );
+
+		// Stopping a stale handle leaves the new effect alone
+		voices.stop(far);
+		BOOST_CHECK( voices.isPlaying(important) );
+
+		// Finished effects give their voices back
+		device.advance(2.f);
+		voices.update();
+		BOOST_CHECK_EQUAL( voices.getActiveCount(), 0 );
+		BOOST_CHECK( ! voices.isPlaying(near) );
+	}
+
+	removeTestArchive(base);
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_voice_churn)
+{
+	char directory[] = "/tmp/rwsdtXXXXXX";
+	auto base = createTestArchive(directory, 64);
+
+	{
+		LoaderSDT archive;
+		BOOST_REQUIRE( archive.load(base) );
+		NullAudioDevice device;
+		SoundBank bank(&archive, &device);
+		VoicePool voices(&device, &bank, 32, 100.f);
+
+		// Hundreds of effects a second around a moving listener
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> offset(-120.f, 120.f);
+		std::uniform_int_distribution<int> sound(0, 63);
+		std::uniform_int_distribution<int> priority(0, 3);
+
+		auto begin = BenchmarkClock::now();
+
+		const int frames = 6000;
+		for( int f = 0; f < frames; ++f ) {
+			glm::vec3 listener(f * 0.1f, 0.f, 0.f);
+			voices.setListener(listener, glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 1.f));
+			for( int e = 0; e < 10; ++e ) {
+				glm::vec3 position = listener + glm::vec3(offset(random), offset(random), 0.f);
+				voices.play(sound(random), position, priority(random));
+			}
+			device.advance(1.f / 60.f);
+			voices.update();
+		}
+
+		double time = elapsedMilliseconds(begin);
+
+		auto& stats = voices.getStats();
+		BOOST_CHECK_EQUAL( device.getSourceCount(), 32 );
+		BOOST_CHECK( stats.stolen > 0 );
+		BOOST_CHECK_EQUAL( stats.played + stats.dropped, frames * 10 );
+		BOOST_CHECK( bank.getLoadedCount() <= 64 );
+
+		BOOST_TEST_MESSAGE( "Voice churn: " << (frames * 10) << " effects over " << frames
+							<< " frames in " << time << "ms (" << (time * 1000.0 / frames) << "us/frame)" );
+		BOOST_TEST_MESSAGE( "  played " << stats.played << ", stole " << stats.stolen
+							<< ", dropped " << stats.dropped );
+	}
+
+	removeTestArchive(base);
+}
+#endif
+
+#if RW_TEST_WITH_DATA
+/**
+ * Returns the path of one of the cutscene streams
+ */
+static std::string findStream()
+{
+	std::string directory = Global::getGamePath() + "/audio/";
+	std::string path;
+	if( DIR* dir = opendir(directory.c_str()) ) {
+		while( dirent* entry = readdir(dir) ) {
+			std::string name = entry->d_name;
+			if( name.size() > 4 && (name.substr(name.size() - 4) == ".mp3"
+									|| name.substr(name.size() - 4) == ".MP3") ) {
+				path = directory + name;
+				break;
+			}
+		}
+		closedir(dir);
+	}
+	return path;
+}
+
+/**
+ * Reads until the decoder has finished, returns the number of samples read
+ */
+static size_t decodeAll(MADDecoder& decoder)
+{
+	size_t samples = 0;
+	std::vector<int16_t> sink(8192);
+	while( ! decoder.isFinished() ) {
+		size_t read = decoder.read(sink.data(), sink.size());
+		if( read == 0 ) {
+			std::this_thread::yield();
+		}
+		samples += read;
+	}
+	return samples;
+}
+
+BOOST_AUTO_TEST_CASE(test_decode_mp3)
+{
+	auto path = findStream();
+	BOOST_REQUIRE( ! path.empty() );
+
+	// A small ring makes the decoder wait on the reader
+	MADDecoder decoder(4096);
+	BOOST_REQUIRE( decoder.open(path) );
+
+	size_t samples = decodeAll(decoder);
+	BOOST_CHECK( decoder.getSampleRate() > 0 );
+	BOOST_CHECK( samples > 0 );
+	BOOST_CHECK_EQUAL( samples % 2, 0 );
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_decode_mp3)
+{
+	auto path = findStream();
+	BOOST_REQUIRE( ! path.empty() );
+
+	MADDecoder decoder(4096);
+	BOOST_REQUIRE( decoder.open(path) );
+
+	auto begin = BenchmarkClock::now();
+	size_t samples = decodeAll(decoder);
+	auto seconds = elapsedSeconds(begin);
+	BOOST_REQUIRE( decoder.getSampleRate() > 0 );
+
+	double audioSeconds = samples / 2.0 / decoder.getSampleRate();
+	BOOST_TEST_MESSAGE( "Decoded " << path << ": " << audioSeconds << "s of audio in "
+						<< seconds << "s (" << (audioSeconds / seconds) << "x realtime)" );
+}
+#endif
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
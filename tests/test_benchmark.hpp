@@ -0,0 +1,36 @@
+#ifndef _TESTBENCHMARK_HPP_
+#define _TESTBENCHMARK_HPP_
+
+#include <chrono>
+
+/**
+ * Timing for the benchmark cases, which are only built when RW_TEST_BENCHMARKS
+ * is set (the TESTS_BENCHMARKS option)
+ */
+typedef std::chrono::steady_clock BenchmarkClock;
+
+template<class Period>
+double elapsedTime(BenchmarkClock::time_point begin, BenchmarkClock::time_point end)
+{
+	return std::chrono::duration<double, Period>(end - begin).count();
+}
+
+inline double elapsedMicroseconds(BenchmarkClock::time_point begin,
+								  BenchmarkClock::time_point end = BenchmarkClock::now())
+{
+	return elapsedTime<std::micro>(begin, end);
+}
+
+inline double elapsedMilliseconds(BenchmarkClock::time_point begin,
+								  BenchmarkClock::time_point end = BenchmarkClock::now())
+{
+	return elapsedTime<std::milli>(begin, end);
+}
+
+inline double elapsedSeconds(BenchmarkClock::time_point begin,
+							 BenchmarkClock::time_point end = BenchmarkClock::now())
+{
+	return elapsedTime<std::ratio<1>>(begin, end);
+}
+
+#endif
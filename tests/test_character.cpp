@@ -47,7 +47,9 @@ BOOST_AUTO_TEST_CASE(test_activities)
 
 		for(float t = 0.f; t < 11.5f; t+=(1.f/60.f)) {
 			controller->update(1.f/60.f);
+			character->tickParallel(1.f/60.f);
 			character->tick(1.f/60.f);
+			character->tickAnimation(1.f/60.f);
 			Global::get().e->dynamicsWorld->stepSimulation(1.f/60.f);
 		}
 
@@ -70,14 +72,18 @@ BOOST_AUTO_TEST_CASE(test_activities)
 		controller->setNextActivity( new Activities::EnterVehicle( vehicle, 0 ) );
 
 		for(float t = 0.f; t < 0.5f; t+=(1.f/60.f)) {
+			character->tickParallel(1.f/60.f);
 			character->tick(1.f/60.f);
+			character->tickAnimation(1.f/60.f);
 			Global::get().e->dynamicsWorld->stepSimulation(1.f/60.f);
 		}
 
 		BOOST_CHECK_EQUAL( nullptr, character->getCurrentVehicle() );
 
 		for(float t = 0.f; t < 9.0f; t+=(1.f/60.f)) {
+			character->tickParallel(1.f/60.f);
 			character->tick(1.f/60.f);
+			character->tickAnimation(1.f/60.f);
 			Global::get().e->dynamicsWorld->stepSimulation(1.f/60.f);
 		}
 
@@ -86,7 +92,9 @@ BOOST_AUTO_TEST_CASE(test_activities)
 		controller->setNextActivity( new Activities::ExitVehicle( ) );
 
 		for(float t = 0.f; t < 9.0f; t+=(1.f/60.f)) {
+			character->tickParallel(1.f/60.f);
 			character->tick(1.f/60.f);
+			character->tickAnimation(1.f/60.f);
 			Global::get().e->dynamicsWorld->stepSimulation(1.f/60.f);
 		}
 
@@ -96,7 +104,9 @@ BOOST_AUTO_TEST_CASE(test_activities)
 		controller->setNextActivity( new Activities::EnterVehicle( vehicle, 0 ) );
 
 		for(float t = 0.f; t < 0.5f; t+=(1.f/60.f)) {
+			character->tickParallel(1.f/60.f);
 			character->tick(1.f/60.f);
+			character->tickAnimation(1.f/60.f);
 			Global::get().e->dynamicsWorld->stepSimulation(1.f/60.f);
 		}
 
@@ -104,7 +114,9 @@ BOOST_AUTO_TEST_CASE(test_activities)
 		controller->skipActivity();
 
 		for(float t = 0.f; t < 5.0f; t+=(1.f/60.f)) {
+			character->tickParallel(1.f/60.f);
 			character->tick(1.f/60.f);
+			character->tickAnimation(1.f/60.f);
 			Global::get().e->dynamicsWorld->stepSimulation(1.f/60.f);
 		}
 
@@ -134,7 +146,9 @@ BOOST_AUTO_TEST_CASE(test_death)
 
 		BOOST_CHECK( ! character->isAlive() );
 
+		character->tickParallel(0.16f);
 		character->tick(0.16f);
+		character->tickAnimation(0.16f);
 
 		BOOST_CHECK_EQUAL(
 					character->animator->getAnimation(0),
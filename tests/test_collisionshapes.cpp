@@ -0,0 +1,148 @@
+#include <boost/test/unit_test.hpp>
+#include <dynamics/CollisionShapeCache.hpp>
+#include <data/CollisionModel.hpp>
+#include <dynamics/CollisionInstance.hpp>
+#include <objects/InstanceObject.hpp>
+#include "test_globals.hpp"
+#include <cstdio>
+#include <unistd.h>
+
+typedef std::map<std::string, std::unique_ptr<CollisionModel>> CollisionModels;
+
+/**
+ * Adds a model with a box and a grid of triangles
+ */
+static void addModel(CollisionModels& models, const std::string& name, float height)
+{
+	std::unique_ptr<CollisionModel> model(new CollisionModel);
+	model->name = name;
+	model->boxes.push_back({ glm::vec3(-1.f, -1.f, 0.f), glm::vec3(1.f, 1.f, height) });
+
+	const int size = 8;
+	for( int y = 0; y <= size; ++y ) {
+		for( int x = 0; x <= size; ++x ) {
+			model->vertices.push_back(glm::vec3(x, y, 0.f));
+		}
+	}
+	for( int y = 0; y < size; ++y ) {
+		for( int x = 0; x < size; ++x ) {
+			uint32_t i = y * (size + 1) + x;
+			model->indices.insert(model->indices.end(), { i, i + 1, i + size + 1 });
+			model->indices.insert(model->indices.end(), { i + 1, i + size + 2, i + size + 1 });
+		}
+	}
+
+	models[name] = std::move(model);
+}
+
+BOOST_AUTO_TEST_SUITE(CollisionShapeCacheTests)
+
+BOOST_AUTO_TEST_CASE(test_shared_shapes)
+{
+	CollisionModels models;
+	addModel(models, "crate", 2.f);
+	CollisionShapeCache cache(models);
+
+	auto a = cache.get("crate");
+	auto b = cache.get("crate");
+	BOOST_REQUIRE( a != nullptr );
+	BOOST_CHECK_EQUAL( a, b );
+	BOOST_CHECK_EQUAL( cache.size(), 1 );
+	BOOST_CHECK_EQUAL( cache.getBuiltBvhCount(), 1 );
+	BOOST_CHECK_EQUAL( a->compound->getNumChildShapes(), 2 );
+	BOOST_CHECK_CLOSE( a->height, 2.f, 0.001f );
+
+	BOOST_CHECK( cache.get("missing") == nullptr );
+}
+
+BOOST_AUTO_TEST_CASE(test_release_shape)
+{
+	CollisionModels models;
+	addModel(models, "crate", 2.f);
+	addModel(models, "barrel", 1.f);
+	CollisionShapeCache cache(models);
+
+	auto crate = cache.get("crate");
+	cache.get("barrel");
+	BOOST_CHECK_EQUAL( cache.size(), 1 );
+	BOOST_CHECK( cache.hasShape("crate") );
+	BOOST_CHECK( ! cache.hasShape("barrel") );
+
+	// Once the last user lets go the shape is deleted
+	std::weak_ptr<CollisionShape> released = crate;
+	crate.reset();
+	BOOST_CHECK( released.expired() );
+	BOOST_CHECK( ! cache.hasShape("crate") );
+	BOOST_CHECK_EQUAL( cache.size(), 0 );
+
+	// Its BVH is kept for the next time it's built
+	crate = cache.get("crate");
+	BOOST_CHECK_EQUAL( cache.getBuiltBvhCount(), 2 );
+	BOOST_CHECK( crate->loadedBvh != nullptr );
+
+	// Shapes can outlive the cache
+	CollisionShapeCache* temporary = new CollisionShapeCache(models);
+	auto barrel = temporary->get("barrel");
+	delete temporary;
+	barrel.reset();
+}
+
+#if RW_TEST_WITH_DATA
+BOOST_AUTO_TEST_CASE(test_destroyed_object_releases_shape)
+{
+	auto world = Global::get().e;
+
+	auto object = static_cast<InstanceObject*>(world->createInstance(1337, glm::vec3(0.f, 0.f, 1000.f)));
+	BOOST_REQUIRE( object != nullptr );
+	BOOST_REQUIRE( object->body != nullptr && object->body->shape != nullptr );
+	std::weak_ptr<CollisionShape> shape = object->body->shape;
+
+	world->destroyObjectQueued(object);
+	world->destroyQueuedObjects();
+	BOOST_CHECK( shape.expired() );
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(test_bvh_cache)
+{
+	char path[] = "/tmp/rwcollisionXXXXXX";
+	int fd = mkstemp(path);
+	BOOST_REQUIRE( fd != -1 );
+	close(fd);
+
+	CollisionModels models;
+	addModel(models, "crate", 2.f);
+	addModel(models, "barrel", 1.f);
+
+	{
+		CollisionShapeCache cache(models);
+		cache.get("crate");
+		cache.get("barrel");
+		BOOST_CHECK_EQUAL( cache.getBuiltBvhCount(), 2 );
+		BOOST_REQUIRE( cache.saveCache(path) );
+	}
+
+	// A changed mesh doesn't use the old BVH
+	models["barrel"]->vertices[0].z = 1.f;
+
+	CollisionShapeCache cache(models);
+	BOOST_REQUIRE( cache.loadCache(path) );
+	auto crate = cache.get("crate");
+	cache.get("barrel");
+	BOOST_CHECK_EQUAL( cache.getBuiltBvhCount(), 1 );
+	BOOST_REQUIRE( crate->mesh != nullptr );
+	BOOST_CHECK( crate->loadedBvh != nullptr );
+	BOOST_CHECK( crate->mesh->getOptimizedBvh() == crate->loadedBvh );
+
+	// The compound still covers the mesh
+	btVector3 min, max;
+	btTransform t; t.setIdentity();
+	crate->compound->getAabb(t, min, max);
+	BOOST_CHECK_CLOSE( max.x(), 8.f, 1.f );
+
+	BOOST_CHECK( ! cache.loadCache("/tmp/rw-missing-collision-cache") );
+
+	std::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
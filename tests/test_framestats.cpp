@@ -0,0 +1,87 @@
+#include <boost/test/unit_test.hpp>
+#include <core/FrameStats.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+static perf::FrameStats createStats(int frames)
+{
+	perf::FrameStats stats;
+	for( int f = 1; f <= frames; ++f ) {
+		perf::FrameTimes times;
+		times[perf::PhaseFrame] = f;
+		times[perf::PhaseDraw] = f * 0.5;
+		stats.addFrame(times);
+	}
+	return stats;
+}
+
+BOOST_AUTO_TEST_SUITE(FrameStatsTests)
+
+BOOST_AUTO_TEST_CASE(test_summary)
+{
+	auto stats = createStats(100);
+	BOOST_CHECK_EQUAL( stats.getFrameCount(), 100 );
+
+	auto frame = stats.summarise(perf::PhaseFrame);
+	BOOST_CHECK_CLOSE( frame.mean, 50.5, 0.001 );
+	BOOST_CHECK_EQUAL( frame.p50, 50.0 );
+	BOOST_CHECK_EQUAL( frame.p95, 95.0 );
+	BOOST_CHECK_EQUAL( frame.p99, 99.0 );
+	BOOST_CHECK_EQUAL( frame.max, 100.0 );
+
+	auto draw = stats.summarise(perf::PhaseDraw);
+	BOOST_CHECK_EQUAL( draw.p99, 49.5 );
+
+	auto script = stats.summarise(perf::PhaseScript);
+	BOOST_CHECK_EQUAL( script.max, 0.0 );
+}
+
+BOOST_AUTO_TEST_CASE(test_summary_few_frames)
+{
+	auto stats = createStats(1);
+	auto frame = stats.summarise(perf::PhaseFrame);
+	BOOST_CHECK_EQUAL( frame.p50, 1.0 );
+	BOOST_CHECK_EQUAL( frame.p99, 1.0 );
+
+	stats.clear();
+	frame = stats.summarise(perf::PhaseFrame);
+	BOOST_CHECK_EQUAL( frame.max, 0.0 );
+}
+
+BOOST_AUTO_TEST_CASE(test_write_reports)
+{
+	char root[] = "/tmp/rwframestatsXXXXXX";
+	BOOST_REQUIRE( mkdtemp(root) != nullptr );
+	std::string csvPath = std::string(root) + "/frames.csv";
+	std::string jsonPath = std::string(root) + "/frames.json";
+
+	auto stats = createStats(3);
+	BOOST_REQUIRE( stats.writeCSV(csvPath) );
+	BOOST_REQUIRE( stats.writeJSON(jsonPath, "test \"run\"") );
+
+	std::ifstream csv(csvPath);
+	std::string line;
+	std::getline(csv, line);
+	BOOST_CHECK_EQUAL( line, "index,frame,tick,physics,script,build,sort,draw" );
+	std::getline(csv, line);
+	BOOST_CHECK_EQUAL( line, "0,1,0,0,0,0,0,0.5" );
+	int rows = 1;
+	while( std::getline(csv, line) ) {
+		rows++;
+	}
+	BOOST_CHECK_EQUAL( rows, 3 );
+
+	std::ifstream json(jsonPath);
+	std::string contents((std::istreambuf_iterator<char>(json)), std::istreambuf_iterator<char>());
+	BOOST_CHECK( contents.find("\"name\": \"test \\\"run\\\"\"") != std::string::npos );
+	BOOST_CHECK( contents.find("\"frames\": 3") != std::string::npos );
+	BOOST_CHECK( contents.find("\"p99\": 3") != std::string::npos );
+
+	std::remove(csvPath.c_str());
+	std::remove(jsonPath.c_str());
+	rmdir(root);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -10,21 +10,15 @@ BOOST_AUTO_TEST_CASE(test_cleanup)
 {
 	GameObject* f = Global::get().e->createInstance(1337, glm::vec3(0.f, 0.f, 1000.f));
 	auto id = f->getGameObjectID();
-	auto& objects = Global::get().e->instancePool.objects;
+	auto& objects = Global::get().e->instancePool;
 
 	f->setLifetime(GameObject::TrafficLifetime);
 	
-	{
-		auto search = objects.find(id);
-		BOOST_CHECK( search != objects.end() );
-	}
+	BOOST_CHECK( objects.find(id) != nullptr );
 	
 	Global::get().e->cleanupTraffic(glm::vec3(0.f, 0.f, 0.f));
 	
-	{
-		auto search = objects.find(id);
-		BOOST_CHECK( search != objects.end() );
-	}
+	BOOST_CHECK( objects.find(id) != nullptr );
 }
 #endif
 
@@ -0,0 +1,187 @@
+#include <boost/test/unit_test.hpp>
+#include <engine/ObjectPool.hpp>
+#include <objects/GameObject.hpp>
+#include <test_benchmark.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+
+/**
+ * Creates objects that aren't part of any world
+ */
+static std::vector<std::unique_ptr<GameObject>> createObjects(size_t count)
+{
+	std::vector<std::unique_ptr<GameObject>> objects;
+	for( size_t i = 0; i < count; ++i ) {
+		objects.emplace_back(new GameObject(nullptr, glm::vec3(), glm::quat(), ModelRef()));
+	}
+	return objects;
+}
+
+BOOST_AUTO_TEST_SUITE(ObjectPoolTests)
+
+BOOST_AUTO_TEST_CASE(test_sequential_ids)
+{
+	auto objects = createObjects(3);
+	ObjectPool pool;
+	for( auto& o : objects ) {
+		pool.insert(o.get());
+	}
+
+	// The first objects get the IDs they always have
+	BOOST_CHECK_EQUAL( objects[0]->getGameObjectID(), 1 );
+	BOOST_CHECK_EQUAL( objects[1]->getGameObjectID(), 2 );
+	BOOST_CHECK_EQUAL( objects[2]->getGameObjectID(), 3 );
+	BOOST_CHECK_EQUAL( pool.find(2), objects[1].get() );
+	BOOST_CHECK_EQUAL( pool.size(), 3 );
+}
+
+BOOST_AUTO_TEST_CASE(test_stale_id)
+{
+	auto objects = createObjects(2);
+	ObjectPool pool;
+	pool.insert(objects[0].get());
+	auto id = objects[0]->getGameObjectID();
+
+	pool.remove(objects[0].get());
+	BOOST_CHECK( pool.find(id) == nullptr );
+
+	// The slot is reused under a new ID
+	pool.insert(objects[1].get());
+	auto newId = objects[1]->getGameObjectID();
+	BOOST_CHECK_NE( newId, id );
+	BOOST_CHECK_EQUAL( newId & ObjectPool::kSlotMask, id & ObjectPool::kSlotMask );
+	BOOST_CHECK( pool.find(id) == nullptr );
+	BOOST_CHECK_EQUAL( pool.find(newId), objects[1].get() );
+
+	// IDs stay positive for script variables
+	BOOST_CHECK( static_cast<int32_t>(newId) > 0 );
+}
+
+BOOST_AUTO_TEST_CASE(test_explicit_ids)
+{
+	auto objects = createObjects(4);
+	ObjectPool pool;
+
+	// Objects from a save keep their IDs
+	objects[0]->setGameObjectID(3);
+	pool.insert(objects[0].get());
+	auto reused = (1u << ObjectPool::kSlotBits) | 5;
+	objects[1]->setGameObjectID(reused);
+	pool.insert(objects[1].get());
+
+	BOOST_CHECK_EQUAL( pool.find(3), objects[0].get() );
+	BOOST_CHECK_EQUAL( pool.find(reused), objects[1].get() );
+	BOOST_CHECK( pool.find(5) == nullptr );
+
+	// New objects fill in the slots skipped over
+	pool.insert(objects[2].get());
+	pool.insert(objects[3].get());
+	auto id2 = objects[2]->getGameObjectID();
+	auto id3 = objects[3]->getGameObjectID();
+	BOOST_CHECK( id2 == 1 || id2 == 2 || id2 == 4 );
+	BOOST_CHECK( id3 == 1 || id3 == 2 || id3 == 4 );
+	BOOST_CHECK_NE( id2, id3 );
+	BOOST_CHECK_EQUAL( pool.find(id2), objects[2].get() );
+	BOOST_CHECK_EQUAL( pool.find(3), objects[0].get() );
+	BOOST_CHECK_EQUAL( pool.size(), 4 );
+}
+
+BOOST_AUTO_TEST_CASE(test_explicit_id_without_slot)
+{
+	auto objects = createObjects(2);
+	ObjectPool pool;
+	pool.insert(objects[0].get());
+
+	// Only generation bits, as a corrupt save might have
+	auto invalid = 3u << ObjectPool::kSlotBits;
+	objects[1]->setGameObjectID(invalid);
+	pool.insert(objects[1].get());
+
+	auto id = objects[1]->getGameObjectID();
+	BOOST_CHECK_NE( id, invalid );
+	BOOST_CHECK_EQUAL( id, 2 );
+	BOOST_CHECK_EQUAL( pool.find(id), objects[1].get() );
+	BOOST_CHECK( pool.find(invalid) == nullptr );
+	BOOST_CHECK_EQUAL( pool.size(), 2 );
+}
+
+BOOST_AUTO_TEST_CASE(test_iteration)
+{
+	auto objects = createObjects(6);
+	ObjectPool pool;
+	for( auto& o : objects ) {
+		pool.insert(o.get());
+	}
+	pool.remove(objects[1].get());
+	pool.remove(objects[4].get());
+	pool.remove(objects[4].get());
+
+	std::vector<GameObject*> live(pool.begin(), pool.end());
+	std::sort(live.begin(), live.end());
+	std::vector<GameObject*> expected = {
+		objects[0].get(), objects[2].get(), objects[3].get(), objects[5].get()
+	};
+	std::sort(expected.begin(), expected.end());
+	BOOST_CHECK( live == expected );
+
+	for( auto object : pool ) {
+		BOOST_CHECK_EQUAL( pool.find(object->getGameObjectID()), object );
+	}
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_pool_churn)
+{
+	const size_t count = 10000;
+	auto objects = createObjects(count);
+	std::vector<GameObjectID> handles(count);
+	ObjectPool pool;
+
+	auto begin = BenchmarkClock::now();
+
+	for( size_t i = 0; i < count; ++i ) {
+		pool.insert(objects[i].get());
+		handles[i] = objects[i]->getGameObjectID();
+	}
+
+	auto filled = BenchmarkClock::now();
+
+	// Destroy and respawn random objects, resolving handles in between
+	std::mt19937 random(1);
+	std::uniform_int_distribution<size_t> pick(0, count - 1);
+	const size_t churn = 100000;
+	size_t stale = 0;
+	size_t missing = 0;
+	for( size_t c = 0; c < churn; ++c ) {
+		auto i = pick(random);
+		pool.remove(objects[i].get());
+		objects[i]->setGameObjectID(0);
+		pool.insert(objects[i].get());
+
+		auto old = handles[i];
+		handles[i] = objects[i]->getGameObjectID();
+		if( pool.find(old) == nullptr ) {
+			stale++;
+		}
+		if( pool.find(handles[pick(random)]) == nullptr ) {
+			missing++;
+		}
+	}
+
+	auto end = BenchmarkClock::now();
+
+	BOOST_CHECK_EQUAL( pool.size(), count );
+	BOOST_CHECK_EQUAL( stale, churn );
+	BOOST_CHECK_EQUAL( missing, 0 );
+
+	auto fillTime = elapsedMilliseconds(begin, filled);
+	auto churnTime = elapsedMilliseconds(filled, end);
+	BOOST_TEST_MESSAGE( "Pool: spawned " << count << " objects in " << fillTime << "ms" );
+	BOOST_TEST_MESSAGE( "Pool: " << churn << " destroy/spawn/find cycles in " << churnTime
+						<< "ms (" << (churnTime * 1000000.0 / churn) << "ns each)" );
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
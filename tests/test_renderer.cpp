@@ -1,6 +1,37 @@
 #include <boost/test/unit_test.hpp>
 #include "test_globals.hpp"
 #include <render/GameRenderer.hpp>
+#include <render/RenderListSort.hpp>
+#include <render/NullRenderer.hpp>
+#include <job/WorkContext.hpp>
+
+#include <algorithm>
+#include <random>
+
+/**
+ * Creates a list with random keys, the start of each instruction is its
+ * original position in the list.
+ */
+RenderList createRandomRenderList(size_t count, RenderKey keyMask)
+{
+	std::mt19937_64 random(count);
+	RenderList list;
+	for( size_t i = 0; i < count; ++i ) {
+		Renderer::DrawParameters dp;
+		dp.start = i;
+		list.add(random() & keyMask, glm::mat4(float(i)), nullptr, dp);
+	}
+	return list;
+}
+
+bool isSortedStable(const RenderList& list)
+{
+	return std::is_sorted(list.instructions.begin(), list.instructions.end(),
+		[](const Renderer::RenderInstruction& a, const Renderer::RenderInstruction& b) {
+			return a.sortKey < b.sortKey ||
+				(a.sortKey == b.sortKey && a.drawInfo.start < b.drawInfo.start);
+		});
+}
 
 BOOST_AUTO_TEST_SUITE(RendererTests)
 
@@ -25,4 +56,136 @@ BOOST_AUTO_TEST_CASE(frustum_test_visible)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(test_sort_render_list)
+{
+	WorkContext work(3);
+
+	// Few distinct keys to check that equal keys keep their order
+	for( RenderKey mask : { RenderKey(0x3), RenderKey(0xFF00FF00), ~RenderKey(0) } ) {
+		for( size_t count : { 0, 1, 100, 50000 } ) {
+			auto serial = createRandomRenderList(count, mask);
+			auto parallel = serial;
+
+			sortRenderList(serial);
+			sortRenderList(parallel, &work);
+
+			BOOST_CHECK_EQUAL( serial.size(), count );
+			BOOST_CHECK( isSortedStable(serial) );
+			BOOST_REQUIRE_EQUAL( parallel.size(), count );
+			for( size_t i = 0; i < count; ++i ) {
+				auto& ri = parallel.instructions[i];
+				BOOST_REQUIRE_EQUAL( serial.instructions[i].drawInfo.start, ri.drawInfo.start );
+				// Each instruction still refers to its own matrix
+				BOOST_REQUIRE_EQUAL( parallel.getMatrix(ri)[0][0], float(ri.drawInfo.start) );
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_render_list_append)
+{
+	Renderer::DrawParameters dp;
+	dp.textures = {1, 2};
+	BOOST_CHECK_EQUAL( dp.textures.size(), 2 );
+	BOOST_CHECK_EQUAL( dp.textures[1], 2 );
+
+	RenderList a, b;
+	a.add(0, glm::mat4(1.f), nullptr, dp);
+	b.add(1, glm::mat4(2.f), nullptr, dp);
+	b.add(2, glm::mat4(3.f), nullptr, dp);
+
+	a.append(b);
+
+	BOOST_REQUIRE_EQUAL( a.size(), 3 );
+	for( size_t i = 0; i < a.size(); ++i ) {
+		auto& ri = a.instructions[i];
+		BOOST_CHECK_EQUAL( ri.sortKey, i );
+		BOOST_CHECK_EQUAL( ri.drawInfo.textures[0], 1 );
+		BOOST_CHECK_EQUAL( a.getMatrix(ri)[0][0], float(i + 1) );
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_draw_batched)
+{
+	DrawBuffer bufferA, bufferB;
+	Renderer::DrawParameters dp;
+	dp.count = 36;
+	dp.start = 0;
+	dp.textures = {1};
+
+	RenderList list;
+	for( size_t i = 0; i < Renderer::MaxBatchInstances + 10; ++i ) {
+		list.add(0, glm::mat4(float(i)), &bufferA, dp);
+	}
+	// Different texture
+	dp.textures = {2};
+	list.add(1, glm::mat4(), &bufferA, dp);
+	// Different buffer
+	list.add(2, glm::mat4(), &bufferB, dp);
+	// Different state
+	dp.depthWrite = false;
+	list.add(3, glm::mat4(), &bufferB, dp);
+
+	NullRenderer renderer;
+	renderer.setRecordObjectData(true);
+	renderer.drawBatched(list);
+
+	auto& draws = renderer.getDraws();
+	BOOST_REQUIRE_EQUAL( draws.size(), 5 );
+	BOOST_CHECK_EQUAL( draws[0].instances, Renderer::MaxBatchInstances );
+	BOOST_CHECK_EQUAL( draws[1].instances, 10 );
+	BOOST_CHECK_EQUAL( draws[2].instances, 1 );
+	BOOST_CHECK_EQUAL( draws[2].texture, 2 );
+	BOOST_CHECK( draws[3].dbuff == &bufferB );
+	BOOST_CHECK_EQUAL( renderer.getInstanceCount(), list.size() );
+
+	BOOST_CHECK_EQUAL( renderer.getDrawCount(), 5 );
+	BOOST_CHECK_EQUAL( renderer.getBufferCount(), 2 );
+	BOOST_CHECK_EQUAL( renderer.getTextureCount(), 2 );
+	BOOST_CHECK_EQUAL( renderer.getStateChangeCount(), 1 );
+	BOOST_CHECK_EQUAL( renderer.getUploadedBytes(),
+					   list.size() * sizeof(Renderer::ObjectUniformData) );
+
+	// Every instance gets its own matrix, in order
+	auto& objects = renderer.getObjectData();
+	BOOST_REQUIRE_EQUAL( objects.size(), list.size() );
+	BOOST_CHECK_EQUAL( objects[Renderer::MaxBatchInstances].model[0][0],
+					   float(Renderer::MaxBatchInstances) );
+
+	renderer.swap();
+	BOOST_CHECK_EQUAL( renderer.getDrawCount(), 0 );
+	BOOST_CHECK_EQUAL( renderer.getUploadedBytes(), 0 );
+	BOOST_CHECK( renderer.getDraws().empty() );
+}
+
+#if RW_TEST_WITH_DATA
+BOOST_AUTO_TEST_CASE(test_headless_render_world)
+{
+	NullRenderer backend;
+	GameRenderer renderer(&Global::get().log, Global::get().d, &backend);
+
+	auto world = Global::get().e;
+	// In a row in front of the camera
+	const size_t instanceCount = 10;
+	std::vector<GameObject*> objects;
+	for( size_t i = 0; i < instanceCount; ++i ) {
+		objects.push_back(world->createInstance(1337, glm::vec3(i * 2.f - 9.f, 20.f, 0.f)));
+	}
+
+	ViewCamera camera({0.f, 0.f, 0.f});
+	camera.rotation = glm::angleAxis(glm::half_pi<float>(), glm::vec3(0.f, 0.f, 1.f));
+	renderer.renderWorld(world, camera, 0.f);
+
+	// Each draw covers one or more instances, and every object is drawn
+	BOOST_REQUIRE_GT( backend.getDrawCount(), 0 );
+	BOOST_CHECK_EQUAL( backend.getDraws().size(), backend.getDrawCount() );
+	BOOST_CHECK_LE( backend.getDrawCount(), backend.getInstanceCount() );
+	BOOST_CHECK_GE( backend.getInstanceCount(), instanceCount );
+
+	for( auto object : objects ) {
+		world->destroyObject(object);
+	}
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,289 @@
+#include <boost/test/unit_test.hpp>
+#include <ai/RoutePlanner.hpp>
+#include <ai/AIGraph.hpp>
+#include <job/WorkContext.hpp>
+#include <loaders/WorldCache.hpp>
+#include "test_globals.hpp"
+#include "test_benchmark.hpp"
+#include <random>
+
+/**
+ * A path with one external node at each position, each leading to the next
+ */
+static PathData createPath(PathData::PathType type, const std::vector<glm::vec3>& positions)
+{
+	PathData path { type, 0, "", {} };
+	for( size_t n = 0; n < positions.size(); ++n ) {
+		int32_t next = (n + 1 < positions.size()) ? int32_t(n + 1) : -1;
+		path.nodes.push_back({ PathNode::EXTERNAL, next, positions[n], 1.f, 0, 0 });
+	}
+	return path;
+}
+
+/**
+ * Creates a width by width grid of pedestrian nodes, spacing apart
+ */
+static void createGrid(AIGraph& graph, int width, float spacing)
+{
+	float origin = -(width - 1) * spacing * 0.5f;
+	for( int i = 0; i < width; ++i ) {
+		std::vector<glm::vec3> row, column;
+		for( int j = 0; j < width; ++j ) {
+			row.push_back({ origin + j * spacing, origin + i * spacing, 0.f });
+			column.push_back({ origin + i * spacing, origin + j * spacing, 0.f });
+		}
+		auto rowPath = createPath(PathData::PATH_PED, row);
+		auto columnPath = createPath(PathData::PATH_PED, column);
+		graph.createPathNodes(glm::vec3(), glm::quat(), rowPath);
+		graph.createPathNodes(glm::vec3(), glm::quat(), columnPath);
+	}
+}
+
+static float routeLength(const RoutePlanner::Route& route)
+{
+	float length = 0.f;
+	for( size_t n = 1; n < route.size(); ++n ) {
+		length += glm::distance(route[n - 1]->position, route[n]->position);
+	}
+	return length;
+}
+
+#if RW_TEST_BENCHMARKS
+/**
+ * Times count random queries between the nodes of graph, with both
+ * algorithms and then again from the cache
+ */
+static void benchmarkRoutes(const AIGraph& graph, size_t count, const std::string& name)
+{
+	std::mt19937 random(3);
+	std::uniform_int_distribution<size_t> pick(0, graph.nodes.size() - 1);
+	std::vector<std::pair<AIGraphNode*, AIGraphNode*>> queries;
+	while( queries.size() < count ) {
+		auto start = graph.nodes[pick(random)];
+		auto goal = graph.nodes[pick(random)];
+		if( start->type == goal->type ) {
+			queries.push_back({ start, goal });
+		}
+	}
+
+	RoutePlanner astar(graph, count);
+	RoutePlanner bidirectional(graph, 0);
+	RoutePlanner::Route route;
+	size_t found = 0, matching = 0;
+	double astarTime = 0.0, bidirectionalTime = 0.0;
+	for( auto& query : queries ) {
+		route.clear();
+		auto begin = BenchmarkClock::now();
+		bool astarFound = astar.findRoute(query.first, query.second, route);
+		astarTime += elapsedMicroseconds(begin);
+		float astarLength = routeLength(route);
+
+		route.clear();
+		begin = BenchmarkClock::now();
+		bool bidirectionalFound = bidirectional.findRoute(query.first, query.second, route,
+														  RoutePlanner::Bidirectional);
+		bidirectionalTime += elapsedMicroseconds(begin);
+
+		found += astarFound;
+		matching += astarFound == bidirectionalFound
+				&& std::abs(astarLength - routeLength(route)) <= 0.01f * astarLength + 0.01f;
+	}
+
+	auto begin = BenchmarkClock::now();
+	for( auto& query : queries ) {
+		route.clear();
+		astar.findRoute(query.first, query.second, route);
+	}
+	double cachedTime = elapsedMicroseconds(begin);
+
+	BOOST_CHECK_EQUAL( matching, count );
+	BOOST_CHECK_GE( astar.getStats().hits, count );
+	BOOST_TEST_MESSAGE( name << ": " << count << " routes over " << graph.nodes.size() << " nodes, "
+						<< found << " found, "
+						<< (astarTime / count) << "us A* (" << (astar.getStats().expanded / count) << " expanded), "
+						<< (bidirectionalTime / count) << "us bidirectional ("
+						<< (bidirectional.getStats().expanded / count) << " expanded), "
+						<< (cachedTime / count) << "us cached" );
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE(RoutePlannerTests)
+
+BOOST_AUTO_TEST_CASE(test_find_route)
+{
+	AIGraph graph;
+	// A long way round and a short cut between the same ends
+	auto around = createPath(PathData::PATH_PED, { {0.f, 0.f, 0.f}, {0.f, 50.f, 0.f}, {50.f, 50.f, 0.f}, {50.f, 0.f, 0.f} });
+	auto across = createPath(PathData::PATH_PED, { {0.f, 0.f, 0.f}, {25.f, 5.f, 0.f}, {50.f, 0.f, 0.f} });
+	auto road = createPath(PathData::PATH_CAR, { {0.f, 10.f, 0.f}, {50.f, 10.f, 0.f} });
+	graph.createPathNodes(glm::vec3(), glm::quat(), around);
+	graph.createPathNodes(glm::vec3(), glm::quat(), across);
+	graph.createPathNodes(glm::vec3(), glm::quat(), road);
+
+	RoutePlanner planner(graph);
+	for( auto algorithm : { RoutePlanner::AStar, RoutePlanner::Bidirectional } ) {
+		RoutePlanner::Route route;
+		planner.clearCache();
+		BOOST_REQUIRE( planner.findRoute(graph.nodes[0], graph.nodes[3], route, algorithm) );
+		BOOST_REQUIRE_EQUAL( route.size(), 3 );
+		BOOST_CHECK( route[0] == graph.nodes[0] );
+		BOOST_CHECK_EQUAL( route[1]->position.x, 25.f );
+		BOOST_CHECK( route[2] == graph.nodes[3] );
+
+		route.clear();
+		BOOST_REQUIRE( planner.findRoute(graph.nodes[1], graph.nodes[1], route, algorithm) );
+		BOOST_CHECK_EQUAL( route.size(), 1 );
+
+		// Routes don't cross onto the roads
+		route.clear();
+		BOOST_CHECK( ! planner.findRoute(graph.nodes[0], graph.nodes[5], route, algorithm) );
+		BOOST_CHECK( route.empty() );
+	}
+
+	RoutePlanner::Route route;
+	BOOST_REQUIRE( planner.findRoute(glm::vec3(-2.f, 52.f, 0.f), glm::vec3(49.f, 11.f, 0.f),
+									 AIGraphNode::Pedestrian, route) );
+	BOOST_REQUIRE_EQUAL( route.size(), 3 );
+	BOOST_CHECK( route.front() == graph.nodes[1] );
+	BOOST_CHECK( route.back() == graph.nodes[3] );
+}
+
+BOOST_AUTO_TEST_CASE(test_disabled_nodes)
+{
+	AIGraph graph;
+	auto around = createPath(PathData::PATH_PED, { {0.f, 0.f, 0.f}, {0.f, 50.f, 0.f}, {50.f, 50.f, 0.f}, {50.f, 0.f, 0.f} });
+	auto across = createPath(PathData::PATH_PED, { {0.f, 0.f, 0.f}, {25.f, 5.f, 0.f}, {50.f, 0.f, 0.f} });
+	graph.createPathNodes(glm::vec3(), glm::quat(), around);
+	graph.createPathNodes(glm::vec3(), glm::quat(), across);
+
+	RoutePlanner planner(graph);
+	RoutePlanner::Route route;
+	BOOST_REQUIRE( planner.findRoute(graph.nodes[0], graph.nodes[3], route) );
+	BOOST_CHECK_EQUAL( route.size(), 3 );
+
+	graph.nodes[4]->disabled = true;
+	planner.refreshDisabled();
+	for( auto algorithm : { RoutePlanner::AStar, RoutePlanner::Bidirectional } ) {
+		route.clear();
+		planner.clearCache();
+		BOOST_REQUIRE( planner.findRoute(graph.nodes[0], graph.nodes[3], route, algorithm) );
+		BOOST_CHECK_EQUAL( route.size(), 4 );
+	}
+
+	// The start may be disabled, the goal can't be
+	graph.nodes[0]->disabled = true;
+	planner.refreshDisabled();
+	route.clear();
+	BOOST_CHECK( planner.findRoute(graph.nodes[0], graph.nodes[3], route) );
+	route.clear();
+	BOOST_CHECK( ! planner.findRoute(graph.nodes[3], graph.nodes[0], route) );
+
+	graph.nodes[1]->disabled = true;
+	planner.refreshDisabled();
+	route.clear();
+	BOOST_CHECK( ! planner.findRoute(graph.nodes[0], graph.nodes[3], route, RoutePlanner::Bidirectional) );
+}
+
+BOOST_AUTO_TEST_CASE(test_route_cache)
+{
+	AIGraph graph;
+	createGrid(graph, 4, 10.f);
+	RoutePlanner planner(graph, 2);
+
+	RoutePlanner::Route first, second;
+	BOOST_REQUIRE( planner.findRoute(graph.nodes[0], graph.nodes[15], first) );
+	BOOST_REQUIRE( planner.findRoute(graph.nodes[0], graph.nodes[15], second) );
+	BOOST_CHECK( first == second );
+	BOOST_CHECK_EQUAL( planner.getStats().hits, 1 );
+	BOOST_CHECK_EQUAL( planner.getStats().misses, 1 );
+
+	RoutePlanner::Route route;
+	planner.findRoute(graph.nodes[1], graph.nodes[15], route);
+	planner.findRoute(graph.nodes[0], graph.nodes[15], route);
+	// Pushes out 1 to 15, which was used longest ago
+	planner.findRoute(graph.nodes[2], graph.nodes[15], route);
+	BOOST_CHECK_EQUAL( planner.getCacheSize(), 2 );
+	planner.findRoute(graph.nodes[0], graph.nodes[15], route);
+	BOOST_CHECK_EQUAL( planner.getStats().hits, 3 );
+	planner.findRoute(graph.nodes[1], graph.nodes[15], route);
+	BOOST_CHECK_EQUAL( planner.getStats().misses, 4 );
+
+	// Adding nodes starts again
+	auto extra = createPath(PathData::PATH_PED, { {100.f, 100.f, 0.f}, {110.f, 100.f, 0.f} });
+	graph.createPathNodes(glm::vec3(), glm::quat(), extra);
+	planner.findRoute(graph.nodes[0], graph.nodes[15], route);
+	BOOST_CHECK_EQUAL( planner.getStats().misses, 5 );
+	BOOST_CHECK( ! planner.findRoute(graph.nodes[0], graph.nodes[16], route) );
+}
+
+BOOST_AUTO_TEST_CASE(test_route_async)
+{
+	AIGraph graph;
+	createGrid(graph, 10, 10.f);
+	RoutePlanner planner(graph);
+	WorkContext work(2);
+
+	RoutePlanner::Route expected;
+	BOOST_REQUIRE( planner.findRoute(graph.nodes[0], graph.nodes[99], expected) );
+	planner.clearCache();
+
+	int calls = 0;
+	RoutePlanner::Route result;
+	auto callback = [&](const RoutePlanner::Route& route) {
+		result = route;
+		calls++;
+	};
+	planner.findRouteAsync(&work, graph.nodes[0], graph.nodes[99], callback);
+	BOOST_CHECK_EQUAL( calls, 0 );
+	while( ! work.isEmpty() ) {
+		work.update();
+	}
+	BOOST_CHECK_EQUAL( calls, 1 );
+	BOOST_CHECK_EQUAL( routeLength(result), routeLength(expected) );
+
+	// Answered from the cache straight away
+	planner.findRouteAsync(&work, graph.nodes[0], graph.nodes[99], callback);
+	BOOST_CHECK_EQUAL( calls, 2 );
+	BOOST_CHECK_EQUAL( planner.getStats().hits, 1 );
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_routes)
+{
+	AIGraph graph;
+	createGrid(graph, 100, 20.f);
+	std::mt19937 random(7);
+	for( auto node : graph.nodes ) {
+		node->disabled = random() % 5 == 0;
+	}
+	benchmarkRoutes(graph, 1000, "Grid network");
+}
+
+#if RW_TEST_WITH_DATA
+BOOST_AUTO_TEST_CASE(benchmark_routes_full_network)
+{
+	auto data = Global::get().d;
+	AIGraph graph;
+	for( auto& ipl : data->iplLocations ) {
+		WorldCache cache;
+		if( ! data->loadWorldCache(ipl.second, cache) ) {
+			continue;
+		}
+		for( auto& inst : cache.instances ) {
+			auto object = data->findObjectType<ObjectData>(inst.id);
+			if( object == nullptr ) {
+				continue;
+			}
+			for( auto& path : object->paths ) {
+				graph.createPathNodes(inst.position, inst.rotation, path);
+			}
+		}
+	}
+
+	BOOST_REQUIRE( ! graph.nodes.empty() );
+	benchmarkRoutes(graph, 1000, "Path network");
+}
+#endif
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,10 @@
 #include "test_globals.hpp"
 #include <script/ScriptMachine.hpp>
 #include <script/SCMFile.hpp>
+#include <script/modules/VMModule.hpp>
+#include "test_benchmark.hpp"
+#include <cstring>
+#include <memory>
 
 SCMByte data[] = {
 	0x02,0x00,0x01,0x08,0x00,0x00,0x00,0x00,
@@ -12,6 +16,83 @@ SCMByte data[] = {
 	0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00
 };
 
+/**
+ * Builds an SCM file with empty model and mission sections, the code
+ * starts at the returned address
+ */
+static SCMAddress createScript(std::vector<SCMByte>& out, unsigned int globalsSize)
+{
+	auto writeJump = [&](SCMAddress at, SCMAddress target) {
+		out[at] = 0x02;
+		out[at+2] = 0x01;
+		std::memcpy(&out[at+3], &target, sizeof(target));
+	};
+
+	SCMAddress models = 8 + globalsSize;
+	SCMAddress missions = models + 12;
+	SCMAddress code = missions + 20;
+	out.assign(code, 0);
+	writeJump(0, models);
+	writeJump(models, missions);
+	writeJump(missions, code);
+	return code;
+}
+
+static void writeOpcode(std::vector<SCMByte>& out, SCMOpcode opcode)
+{
+	out.push_back(opcode & 0xFF);
+	out.push_back(opcode >> 8);
+}
+
+static void writeInt32(std::vector<SCMByte>& out, int32_t value)
+{
+	out.push_back(TInt32);
+	for( size_t b = 0; b < sizeof(value); ++b ) {
+		out.push_back((value >> (b * 8)) & 0xFF);
+	}
+}
+
+static void writeVariable(std::vector<SCMByte>& out, SCMType type, uint16_t index)
+{
+	out.push_back(type);
+	out.push_back(index & 0xFF);
+	out.push_back(index >> 8);
+}
+
+/**
+ * Counts a variable up to count
+ */
+static void writeCountingLoop(std::vector<SCMByte>& out, SCMType type, int32_t count)
+{
+	// set var = 0
+	writeOpcode(out, type == TGlobal ? 0x0004 : 0x0006);
+	writeVariable(out, type, 0);
+	writeInt32(out, 0);
+
+	SCMAddress loop = out.size();
+	// var += 1
+	writeOpcode(out, 0x0008);
+	writeVariable(out, type, 0);
+	writeInt32(out, 1);
+	// if var > count - 1
+	writeOpcode(out, 0x00D6);
+	writeInt32(out, 0);
+	writeOpcode(out, type == TGlobal ? 0x0018 : 0x0019);
+	writeVariable(out, type, 0);
+	writeInt32(out, count - 1);
+	// jump if false loop
+	writeOpcode(out, 0x004D);
+	writeInt32(out, loop);
+}
+
+static ScriptMachine* createMachine(std::vector<SCMByte>& bytes)
+{
+	auto file = new SCMFile;
+	file->loadFile(bytes.data(), bytes.size());
+	auto opcodes = new SCMOpcodes;
+	opcodes->modules.push_back(new VMModule);
+	return new ScriptMachine(nullptr, file, opcodes);
+}
 
 BOOST_AUTO_TEST_SUITE(ScriptMachineTests)
 
@@ -26,4 +107,84 @@ BOOST_AUTO_TEST_CASE(scmfile_test)
 	BOOST_CHECK_EQUAL( f.getCodeSection(), 0x28 );
 }
 
+BOOST_AUTO_TEST_CASE(test_execute_loop)
+{
+	std::vector<SCMByte> bytes;
+	auto start = createScript(bytes, 8);
+	writeCountingLoop(bytes, TGlobal, 1000);
+	writeOpcode(bytes, 0x004E);
+
+	std::unique_ptr<ScriptMachine> machine(createMachine(bytes));
+	machine->startThread(start);
+	machine->execute(0.f);
+
+	BOOST_CHECK( machine->getThreads().empty() );
+	int32_t counter;
+	std::memcpy(&counter, machine->getGlobals(), sizeof(counter));
+	BOOST_CHECK_EQUAL( counter, 1000 );
+
+	// Every instruction is only decoded once
+	BOOST_CHECK_EQUAL( machine->getDecodedInstructionCount(), 6 );
+}
+
+BOOST_AUTO_TEST_CASE(test_execute_locals)
+{
+	std::vector<SCMByte> bytes;
+	auto start = createScript(bytes, 8);
+	writeCountingLoop(bytes, TLocal, 10);
+	// Sleep so the thread's locals can be checked
+	writeOpcode(bytes, 0x0001);
+	writeInt32(bytes, 100000);
+
+	std::unique_ptr<ScriptMachine> machine(createMachine(bytes));
+	machine->startThread(start);
+	machine->startThread(start);
+	machine->execute(0.f);
+
+	// The same instructions must write to each thread's own locals
+	BOOST_REQUIRE_EQUAL( machine->getThreads().size(), 2 );
+	for( auto& thread : machine->getThreads() ) {
+		int32_t counter;
+		std::memcpy(&counter, thread.locals.data(), sizeof(counter));
+		BOOST_CHECK_EQUAL( counter, 10 );
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_illegal_instruction)
+{
+	std::vector<SCMByte> bytes;
+	auto start = createScript(bytes, 8);
+	writeOpcode(bytes, 0x7FFF);
+
+	std::unique_ptr<ScriptMachine> machine(createMachine(bytes));
+	machine->startThread(start);
+	BOOST_CHECK_THROW( machine->execute(0.f), IllegalInstruction );
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_execute)
+{
+	const int32_t iterations = 1000000;
+	std::vector<SCMByte> bytes;
+	auto start = createScript(bytes, 8);
+	writeCountingLoop(bytes, TGlobal, iterations);
+	writeOpcode(bytes, 0x004E);
+
+	std::unique_ptr<ScriptMachine> machine(createMachine(bytes));
+	machine->startThread(start);
+
+	auto begin = BenchmarkClock::now();
+	machine->execute(0.f);
+	auto seconds = elapsedSeconds(begin);
+
+	BOOST_CHECK( machine->getThreads().empty() );
+
+	// Two setup instructions, four per iteration
+	double instructions = 2.0 + 4.0 * iterations;
+	BOOST_TEST_MESSAGE( "ScriptMachine: " << instructions << " instructions in "
+						<< seconds * 1000.0 << "ms, " << (instructions / seconds)
+						<< " instructions/s" );
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
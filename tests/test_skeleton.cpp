@@ -60,5 +60,22 @@ BOOST_AUTO_TEST_CASE(test_interpolate)
 	BOOST_CHECK(skeleton.getInterpolated(0).translation == t2.translation);
 	BOOST_CHECK(skeleton.getInterpolated(0).rotation == t2.rotation);
 }
+
+BOOST_AUTO_TEST_CASE(test_current_matrix)
+{
+	Skeleton::FrameTransform t1 { glm::vec3(0.f, 0.f, 0.f), glm::quat() };
+	Skeleton::FrameTransform t2 { glm::vec3(1.f, 2.f, 3.f), glm::quat() };
+
+	Skeleton skeleton;
+
+	skeleton.setAllData({
+		{0, { t2, t1, true }}
+	});
+
+	/** The latest pose is used even if the skeleton was never interpolated */
+	auto current = skeleton.getCurrentMatrix(0) * glm::vec4(0.f, 0.f, 0.f, 1.f);
+	BOOST_CHECK(glm::vec3(current) == t2.translation);
+	BOOST_CHECK(skeleton.getCurrentMatrix(5) == glm::mat4());
+}
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,213 @@
+#include <boost/test/unit_test.hpp>
+#include <engine/SpatialIndex.hpp>
+#include <objects/GameObject.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <memory>
+#include <random>
+
+class TestObject : public GameObject
+{
+public:
+	TestObject(const glm::vec3& pos)
+		: GameObject(nullptr, pos, {}, nullptr)
+	{}
+
+	void tick(float dt) { RW_UNUSED(dt); }
+};
+
+static bool contains(const std::vector<GameObject*>& objects, GameObject* object)
+{
+	return std::find(objects.begin(), objects.end(), object) != objects.end();
+}
+
+BOOST_AUTO_TEST_SUITE(SpatialIndexTests)
+
+BOOST_AUTO_TEST_CASE(test_insert_remove)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	TestObject a({10.f, 10.f, 0.f});
+	TestObject b({-500.f, 200.f, 0.f});
+
+	index.insert(&a, 5.f, true);
+	index.insert(&b, 1.f, false);
+	BOOST_CHECK_EQUAL( index.size(), 2 );
+	BOOST_CHECK( index.contains(&a) );
+	BOOST_CHECK( index.contains(&b) );
+
+	index.remove(&a);
+	BOOST_CHECK_EQUAL( index.size(), 1 );
+	BOOST_CHECK( ! index.contains(&a) );
+
+	std::vector<GameObject*> found;
+	index.queryRadius({10.f, 10.f, 0.f}, 20.f, found);
+	BOOST_CHECK( found.empty() );
+
+	// Removing again is harmless
+	index.remove(&a);
+	BOOST_CHECK_EQUAL( index.size(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE(test_query_radius)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	TestObject near({100.f, 100.f, 10.f});
+	TestObject large({160.f, 100.f, 10.f});
+	TestObject far({400.f, 100.f, 10.f});
+	TestObject outside({3000.f, 3000.f, 0.f});
+
+	index.insert(&near, 2.f, true);
+	index.insert(&large, 50.f, true);
+	index.insert(&far, 2.f, false);
+	index.insert(&outside, 2.f, true);
+
+	std::vector<GameObject*> found;
+	index.queryRadius({100.f, 100.f, 10.f}, 20.f, found);
+	BOOST_CHECK_EQUAL( found.size(), 2 );
+	BOOST_CHECK( contains(found, &near) );
+	// Overlaps the radius with its bounds
+	BOOST_CHECK( contains(found, &large) );
+
+	found.clear();
+	index.queryRadius({3000.f, 3000.f, 0.f}, 5.f, found);
+	BOOST_REQUIRE_EQUAL( found.size(), 1 );
+	BOOST_CHECK_EQUAL( found[0], &outside );
+}
+
+BOOST_AUTO_TEST_CASE(test_dynamic_refresh)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	TestObject mover({0.f, 0.f, 0.f});
+	index.insert(&mover, 1.f, false);
+
+	mover.setPosition({500.f, -300.f, 0.f});
+
+	// Positions are only read when refreshed
+	std::vector<GameObject*> found;
+	index.queryRadius({500.f, -300.f, 0.f}, 5.f, found);
+	BOOST_CHECK( found.empty() );
+
+	index.refresh();
+	index.queryRadius({500.f, -300.f, 0.f}, 5.f, found);
+	BOOST_REQUIRE_EQUAL( found.size(), 1 );
+	BOOST_CHECK_EQUAL( found[0], &mover );
+
+	found.clear();
+	index.queryRadius({0.f, 0.f, 0.f}, 5.f, found);
+	BOOST_CHECK( found.empty() );
+
+	// Leaving the grid keeps the object findable
+	mover.setPosition({5000.f, 0.f, 0.f});
+	index.refresh();
+	index.queryRadius({5000.f, 0.f, 0.f}, 5.f, found);
+	BOOST_CHECK_EQUAL( found.size(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE(test_update_radius)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	TestObject object({0.f, 0.f, 0.f});
+	index.insert(&object, 1.f, true);
+
+	std::vector<GameObject*> found;
+	index.queryRadius({100.f, 0.f, 0.f}, 10.f, found);
+	BOOST_CHECK( found.empty() );
+
+	index.update(&object, 200.f);
+	index.queryRadius({100.f, 0.f, 0.f}, 10.f, found);
+	BOOST_CHECK_EQUAL( found.size(), 1 );
+	BOOST_CHECK_EQUAL( index.size(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE(test_query_frustum)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	TestObject ahead({100.f, 0.f, 0.f});
+	TestObject behind({-100.f, 0.f, 0.f});
+	TestObject movingAhead({50.f, 5.f, 0.f});
+	TestObject beyondFar({1000.f, 0.f, 0.f});
+
+	index.insert(&ahead, 5.f, true);
+	index.insert(&behind, 5.f, true);
+	index.insert(&movingAhead, 1.f, false);
+	index.insert(&beyondFar, 5.f, true);
+
+	ViewFrustum frustum(0.1f, 500.f, glm::radians(90.f), 1.f);
+	auto view = glm::lookAt(glm::vec3(0.f), glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 1.f));
+	frustum.update(frustum.projection() * view);
+
+	std::vector<GameObject*> found;
+	index.queryFrustum(frustum, found);
+	BOOST_CHECK_EQUAL( found.size(), 2 );
+	BOOST_CHECK( contains(found, &ahead) );
+	BOOST_CHECK( contains(found, &movingAhead) );
+}
+
+BOOST_AUTO_TEST_CASE(test_query_box)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	TestObject inside({100.f, 100.f, 10.f});
+	TestObject overlapping({130.f, 100.f, 10.f});
+	TestObject above({100.f, 100.f, 200.f});
+	TestObject moving({110.f, 90.f, 0.f});
+
+	index.insert(&inside, 2.f, true);
+	index.insert(&overlapping, 20.f, true);
+	index.insert(&above, 2.f, true);
+	index.insert(&moving, 1.f, false);
+
+	std::vector<GameObject*> found;
+	index.queryBox({80.f, 80.f, -10.f}, {120.f, 120.f, 50.f}, found);
+	BOOST_CHECK_EQUAL( found.size(), 3 );
+	BOOST_CHECK( contains(found, &inside) );
+	BOOST_CHECK( contains(found, &overlapping) );
+	BOOST_CHECK( contains(found, &moving) );
+}
+
+BOOST_AUTO_TEST_CASE(test_matches_linear_search)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-2500.f, 2500.f);
+	std::uniform_real_distribution<float> size(0.f, 300.f);
+
+	std::vector<std::unique_ptr<TestObject>> objects;
+	std::vector<float> radii;
+	for( int i = 0; i < 2000; ++i ) {
+		objects.emplace_back(new TestObject({position(random), position(random), 0.f}));
+		radii.push_back(i % 10 == 0 ? size(random) : size(random) / 30.f);
+		index.insert(objects.back().get(), radii.back(), i % 4 != 0);
+	}
+
+	// Remove and move some of them
+	for( size_t i = 0; i < objects.size(); i += 3 ) {
+		index.remove(objects[i].get());
+	}
+	for( size_t i = 1; i < objects.size(); i += 4 ) {
+		objects[i]->setPosition({position(random), position(random), 0.f});
+		index.update(objects[i].get(), radii[i]);
+	}
+
+	for( int q = 0; q < 50; ++q ) {
+		glm::vec3 center(position(random), position(random), 0.f);
+		float radius = size(random);
+
+		std::vector<GameObject*> found;
+		index.queryRadius(center, radius, found);
+
+		size_t expected = 0;
+		for( size_t i = 0; i < objects.size(); ++i ) {
+			if( ! index.contains(objects[i].get()) ) {
+				continue;
+			}
+			float d = glm::distance(center, objects[i]->getPosition());
+			if( d <= radius + radii[i] ) {
+				expected++;
+				BOOST_CHECK( contains(found, objects[i].get()) );
+			}
+		}
+		BOOST_CHECK_EQUAL( found.size(), expected );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
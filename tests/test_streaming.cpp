@@ -0,0 +1,279 @@
+#include <boost/test/unit_test.hpp>
+#include <engine/StreamingManager.hpp>
+#include <objects/InstanceObject.hpp>
+#include <job/WorkContext.hpp>
+#include "test_globals.hpp"
+#include "test_benchmark.hpp"
+
+#include <fstream>
+#include <thread>
+
+/**
+ * A world without any game data, for streaming made up resources
+ */
+struct StreamingWorld
+{
+	Logger log;
+	WorkContext work;
+	GameData data;
+	GameWorld world;
+	StreamingManager* streaming;
+
+	StreamingWorld()
+		: data(&log, &work, "")
+		, world(&log, &work, &data)
+		, streaming(new StreamingManager(&world))
+	{
+		// The world deletes it
+		world.streaming = streaming;
+	}
+
+	/// An empty model that's been loaded
+	ModelRef addModel(const std::string& name)
+	{
+		ModelRef model(new ResourceHandle<Model>(name));
+		model->resource = new Model;
+		model->resource->recalculateMetrics();
+		model->state = RW::Loaded;
+		data.models[GameData::modelID(name)] = model;
+		return model;
+	}
+
+	/// Puts a texture in the archive for each name, as if txd was loaded
+	std::vector<TextureArchive::key_type> addTextures(const std::string& txd,
+													  const std::vector<std::string>& names)
+	{
+		data.loadedFiles[txd + ".txd"] = true;
+		std::vector<TextureArchive::key_type> keys;
+		for( auto& name : names ) {
+			keys.push_back(textureKey(name));
+			data.textures[keys.back()] = TextureData::create(0, glm::ivec2(1, 1), false);
+		}
+		return keys;
+	}
+
+	InstanceObject* addInstance(ObjectID id, const std::string& model, const glm::vec3& position)
+	{
+		std::shared_ptr<ObjectData> object(new ObjectData);
+		object->ID = id;
+		object->modelName = model;
+		object->modelID = GameData::modelID(model);
+		object->numClumps = 1;
+		object->drawDistance[0] = object->drawDistance[1] = object->drawDistance[2] = 100.f;
+		object->flags = 0;
+		object->LOD = false;
+		data.objectTypes[id] = object;
+		return world.createInstance(id, position);
+	}
+};
+
+BOOST_AUTO_TEST_SUITE(StreamingTests)
+
+BOOST_AUTO_TEST_CASE(test_evict_least_recently_used)
+{
+	StreamingWorld w;
+	auto& streaming = *w.streaming;
+	auto oldest = w.addModel("oldest");
+	auto newer = w.addModel("newer");
+	auto newest = w.addModel("newest");
+
+	BOOST_REQUIRE( streaming.adoptModel(oldest, 100) );
+	streaming.update(glm::vec3());
+	BOOST_REQUIRE( streaming.adoptModel(newer, 100) );
+	streaming.update(glm::vec3());
+	BOOST_REQUIRE( streaming.adoptModel(newest, 100) );
+	streaming.update(glm::vec3());
+	BOOST_CHECK( ! streaming.adoptModel(newest, 100) );
+	BOOST_CHECK_EQUAL( streaming.getResidentBytes(), 300 );
+	BOOST_CHECK_EQUAL( streaming.getStats().evicted, 0 );
+
+	// Only as many as it takes to get within the budget are evicted
+	streaming.setMemoryBudget(150);
+	streaming.update(glm::vec3());
+	BOOST_CHECK_EQUAL( streaming.getStats().evicted, 2 );
+	BOOST_CHECK_EQUAL( streaming.getResidentBytes(), 100 );
+	BOOST_CHECK_EQUAL( streaming.getStats().residentCount[StreamingManager::ModelResource], 1 );
+
+	BOOST_CHECK( oldest->resource == nullptr );
+	BOOST_CHECK_EQUAL( oldest->state, RW::Unloaded );
+	BOOST_CHECK( newer->resource == nullptr );
+	BOOST_CHECK( newest->resource != nullptr );
+	BOOST_CHECK_EQUAL( newest->state, RW::Loaded );
+}
+
+BOOST_AUTO_TEST_CASE(test_evict_keeps_pinned_and_needed)
+{
+	StreamingWorld w;
+	auto& streaming = *w.streaming;
+	auto pinned = w.addModel("pinned");
+	auto needed = w.addModel("needed");
+	auto unused = w.addModel("unused");
+	BOOST_REQUIRE( w.addInstance(1, "pinned", glm::vec3(0.f)) != nullptr );
+	BOOST_REQUIRE( w.addInstance(2, "needed", glm::vec3(10.f, 0.f, 0.f)) != nullptr );
+
+	// The pinned model is left with whatever loaded it
+	BOOST_REQUIRE( streaming.adoptModel(needed, 100) );
+	BOOST_REQUIRE( streaming.adoptModel(unused, 100) );
+
+	streaming.setMemoryBudget(0);
+	streaming.update(glm::vec3());
+	BOOST_CHECK_EQUAL( streaming.getStats().evicted, 1 );
+	BOOST_CHECK( unused->resource == nullptr );
+	// Still needed where the camera is, even though it's over budget
+	BOOST_CHECK( needed->resource != nullptr );
+	BOOST_CHECK_EQUAL( streaming.getResidentBytes(), 100 );
+
+	streaming.update(glm::vec3(1500.f, 1500.f, 0.f));
+	BOOST_CHECK_EQUAL( streaming.getStats().evicted, 1 );
+	BOOST_CHECK( needed->resource == nullptr );
+	BOOST_CHECK_EQUAL( streaming.getResidentBytes(), 0 );
+
+	BOOST_CHECK( pinned->resource != nullptr );
+	BOOST_CHECK_EQUAL( pinned->state, RW::Loaded );
+}
+
+BOOST_AUTO_TEST_CASE(test_evict_keeps_shared_textures)
+{
+	// Evicting textures deletes them from GL
+	Global::get();
+
+	StreamingWorld w;
+	auto& streaming = *w.streaming;
+	auto shared = w.addTextures("shared", { "wall", "door" });
+	auto own = w.addTextures("own", { "floor" });
+	BOOST_REQUIRE( streaming.adoptTextures("shared", shared, 100) );
+	BOOST_REQUIRE( streaming.adoptTextures("own", own, 100) );
+	BOOST_CHECK( ! streaming.adoptTextures("missing", {}, 100) );
+
+	// As a model would keep one of the textures
+	auto held = w.data.textures[shared[1]];
+
+	streaming.setMemoryBudget(0);
+	streaming.update(glm::vec3());
+	BOOST_CHECK_EQUAL( streaming.getStats().evicted, 1 );
+	BOOST_CHECK( w.data.textures.find(own[0]) == w.data.textures.end() );
+	BOOST_CHECK( w.data.loadedFiles.find("own.txd") == w.data.loadedFiles.end() );
+	BOOST_CHECK( w.data.textures.find(shared[0]) != w.data.textures.end() );
+	BOOST_CHECK( w.data.textures.find(shared[1]) != w.data.textures.end() );
+	BOOST_CHECK_EQUAL( streaming.getResidentBytes(), 100 );
+
+	// Once nothing else uses them they can go too
+	held.reset();
+	streaming.update(glm::vec3());
+	BOOST_CHECK_EQUAL( streaming.getStats().evicted, 1 );
+	BOOST_CHECK( w.data.textures.find(shared[0]) == w.data.textures.end() );
+	BOOST_CHECK( w.data.textures.find(shared[1]) == w.data.textures.end() );
+	BOOST_CHECK_EQUAL( streaming.getResidentBytes(), 0 );
+}
+
+#if RW_TEST_WITH_DATA
+/**
+ * Reads the camera positions from a benchmark track
+ */
+static std::vector<glm::vec3> loadTrack(const std::string& path)
+{
+	std::ifstream stream(path);
+	std::string clock;
+	stream >> clock;
+
+	std::vector<glm::vec3> track;
+	float time;
+	glm::vec3 position;
+	glm::quat angle;
+	while( stream >> time >> position.x >> position.y >> position.z
+		   >> angle.x >> angle.y >> angle.z >> angle.w ) {
+		track.push_back(position);
+	}
+	return track;
+}
+
+static void finishWork(GameWorld* world)
+{
+	while( ! world->_work->isEmpty() ) {
+		world->_work->update();
+		std::this_thread::yield();
+	}
+	world->data->textureUploads.flush();
+}
+
+BOOST_AUTO_TEST_CASE(test_stream_track)
+{
+	auto track = loadTrack(RW_BENCHMARKS_PATH "/staunton.txt");
+	BOOST_REQUIRE( track.size() > 1 );
+
+	// Streaming unloads models and textures, so it gets its own data rather
+	// than changing what the other tests use
+	GameData gameData(&Global::get().log, &Global::get().work, Global::getGamePath());
+	auto data = &gameData;
+	data->loadIMG("/models/gta3");
+	data->load();
+	for( auto& ide : data->ideLocations ) {
+		data->loadObjects(ide.second);
+	}
+
+	GameState state;
+	GameWorld world(&Global::get().log, &Global::get().work, data);
+	world.state = &state;
+	finishWork(&world);
+
+	const size_t budget = 32 * 1024 * 1024;
+	world.streaming = new StreamingManager(&world);
+	world.streaming->setMemoryBudget(budget);
+
+	for( auto& ipl : data->iplLocations ) {
+		world.placeItems(ipl.second);
+	}
+
+	size_t requested = 0;
+	size_t evicted = 0;
+	size_t peak = 0;
+	size_t steps = 0;
+	size_t overBudget = 0;
+
+	auto begin = BenchmarkClock::now();
+
+	// Moves the camera in steps along each segment of the track
+	for( size_t p = 1; p < track.size(); ++p ) {
+		auto from = track[p - 1];
+		auto to = track[p];
+		int count = std::max(1, int(glm::distance(from, to) / 10.f));
+		for( int s = 0; s <= count; ++s ) {
+			world.streaming->update(glm::mix(from, to, float(s) / count));
+			finishWork(&world);
+
+			auto& stats = world.streaming->getStats();
+			requested += stats.requested;
+			evicted += stats.evicted;
+			peak = std::max(peak, world.streaming->getResidentBytes());
+			if( world.streaming->getResidentBytes() > budget ) {
+				overBudget++;
+			}
+			steps++;
+		}
+	}
+
+	double time = elapsedMilliseconds(begin);
+
+	auto& stats = world.streaming->getStats();
+	BOOST_CHECK( requested > 0 );
+	BOOST_CHECK( evicted > 0 );
+	BOOST_CHECK( world.streaming->getResidentBytes() > 0 );
+	BOOST_CHECK_EQUAL( overBudget, 0 );
+	BOOST_CHECK_LE( peak, budget );
+
+	BOOST_TEST_MESSAGE( "Streamed " << track.size() << " track points in " << steps
+						<< " steps, " << time << "ms" );
+	BOOST_TEST_MESSAGE( "Requested " << requested << ", evicted " << evicted
+						<< ", peak " << (peak / 1024) << "KiB of " << (budget / 1024) << "KiB" );
+	for( int t = 0; t < StreamingManager::ResourceTypeCount; ++t ) {
+		auto type = static_cast<StreamingManager::ResourceType>(t);
+		BOOST_TEST_MESSAGE( "  " << StreamingManager::getResourceTypeName(type) << ": "
+							<< stats.residentCount[t] << " resident, "
+							<< (stats.residentBytes[t] / 1024) << "KiB" );
+	}
+
+	// The world's destructor deletes the streaming manager
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+#include <boost/test/unit_test.hpp>
+#include <data/StringTable.hpp>
+#include <loaders/LoaderTXD.hpp>
+#include <engine/GameData.hpp>
+#include <test_benchmark.hpp>
+#include <map>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+BOOST_AUTO_TEST_SUITE(StringTableTests)
+
+BOOST_AUTO_TEST_CASE(test_intern)
+{
+	StringTable strings;
+	BOOST_CHECK_EQUAL( strings.intern(""), StringTable::Empty );
+	BOOST_CHECK_EQUAL( strings.size(), 1 );
+
+	auto a = strings.intern("rd_road1");
+	auto b = strings.intern("rd_road2");
+	BOOST_CHECK_NE( a, b );
+	BOOST_CHECK_NE( a, StringTable::Empty );
+	BOOST_CHECK_EQUAL( strings.intern("rd_road1"), a );
+	// Case matters, callers normalise names first
+	BOOST_CHECK_NE( strings.intern("RD_road1"), a );
+	BOOST_CHECK_EQUAL( strings.size(), 4 );
+
+	BOOST_CHECK_EQUAL( strings.getString(a), "rd_road1" );
+	BOOST_CHECK_EQUAL( strings.getString(1000), "" );
+	BOOST_CHECK_EQUAL( strings.getLookupCount(), 5 );
+}
+
+BOOST_AUTO_TEST_CASE(test_intern_threads)
+{
+	StringTable strings;
+	std::vector<std::vector<StringID>> ids(4);
+	std::vector<std::thread> threads;
+	for( size_t t = 0; t < ids.size(); ++t ) {
+		threads.emplace_back([&, t]() {
+			for( int i = 0; i < 1000; ++i ) {
+				ids[t].push_back(strings.intern("name" + std::to_string(i)));
+			}
+		});
+	}
+	for( auto& thread : threads ) {
+		thread.join();
+	}
+
+	BOOST_CHECK_EQUAL( strings.size(), 1001 );
+	for( size_t t = 1; t < ids.size(); ++t ) {
+		BOOST_CHECK( ids[t] == ids[0] );
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_texture_key)
+{
+	auto plain = textureKey("tex_wall");
+	BOOST_CHECK_EQUAL( plain, textureKey("tex_wall", "") );
+	BOOST_CHECK_NE( plain, textureKey("tex_wall", "tex_wallm") );
+	BOOST_CHECK_NE( textureKey("a", "b"), textureKey("b", "a") );
+	BOOST_CHECK_EQUAL( textureKey(StringTable::get().intern("tex_wall")), plain );
+}
+
+BOOST_AUTO_TEST_CASE(test_model_id)
+{
+	// Pickups load their models with the name as it's written in the IDE
+	auto id = GameData::modelID("Barrel1");
+	BOOST_CHECK_EQUAL( id, GameData::modelID("barrel1") );
+	BOOST_CHECK_EQUAL( StringTable::get().getString(id), "barrel1" );
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_texture_lookup)
+{
+	// Roughly how many textures the loaded world has, and the names they have
+	const size_t textureCount = 8000;
+	const size_t lookupCount = 200000;
+	std::mt19937 random(5);
+	std::vector<std::pair<std::string, std::string>> names;
+	for( size_t t = 0; t < textureCount; ++t ) {
+		std::string name = "sl_concrete_tile" + std::to_string(random() % 100000);
+		names.push_back({ name, (t % 4 == 0) ? name + "m" : "" });
+	}
+
+	std::map<std::pair<std::string, std::string>, TextureData::Handle> byName;
+	TextureArchive byKey;
+	std::vector<TextureKey> keys;
+	for( auto& name : names ) {
+		auto handle = TextureData::create(1, glm::ivec2(1), false);
+		byName[name] = handle;
+		keys.push_back(textureKey(name.first, name.second));
+		byKey[keys.back()] = handle;
+	}
+
+	std::vector<size_t> lookups;
+	for( size_t l = 0; l < lookupCount; ++l ) {
+		lookups.push_back(random() % textureCount);
+	}
+
+	size_t nameHits = 0;
+	auto begin = BenchmarkClock::now();
+	for( auto l : lookups ) {
+		nameHits += byName.find(names[l]) != byName.end();
+	}
+	double nameTime = elapsedMicroseconds(begin);
+
+	size_t keyHits = 0;
+	begin = BenchmarkClock::now();
+	for( auto l : lookups ) {
+		keyHits += byKey.find(keys[l]) != byKey.end();
+	}
+	double keyTime = elapsedMicroseconds(begin);
+
+	BOOST_CHECK_EQUAL( nameHits, lookupCount );
+	BOOST_CHECK_EQUAL( keyHits, lookupCount );
+	BOOST_TEST_MESSAGE( "Texture lookups: " << (nameTime * 1000.0 / lookupCount) << "ns by name, "
+						<< (keyTime * 1000.0 / lookupCount) << "ns by key, "
+						<< ((nameTime - keyTime) / 1000.0) << "ms saved over " << lookupCount );
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
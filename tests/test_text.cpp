@@ -3,6 +3,8 @@
 #include <data/GameTexts.hpp>
 #include <loaders/LoaderGXT.hpp>
 #include <engine/ScreenText.hpp>
+#include <render/TextRenderer.hpp>
+#include "test_benchmark.hpp"
 
 BOOST_AUTO_TEST_SUITE(TextTests)
 
@@ -169,4 +171,136 @@ BOOST_AUTO_TEST_CASE(format_remove)
 }
 #endif
 
+BOOST_AUTO_TEST_CASE(layout_markup)
+{
+	TextRenderer::TextInfo ti;
+	ti.size = 10.f;
+	ti.baseColour = glm::u8vec3(255, 255, 255);
+
+	TextRenderer::TextLayout plain, marked;
+	ti.text = "AB";
+	TextRenderer::layoutText(ti, false, plain);
+	ti.text = "~r~A~y~B";
+	TextRenderer::layoutText(ti, false, marked);
+
+	// Markup doesn't take up any space, only changes the colour
+	BOOST_REQUIRE_EQUAL( plain.vertices.size(), 12 );
+	BOOST_REQUIRE_EQUAL( marked.vertices.size(), 12 );
+	BOOST_CHECK_EQUAL( plain.width, marked.width );
+	BOOST_CHECK( marked.vertices[0].colour == glm::vec3(1.f, 0.f, 0.f) );
+	BOOST_CHECK( marked.vertices[6].colour == glm::vec3(1.f, 1.f, 0.f) );
+
+	// Unless the colour is forced
+	TextRenderer::layoutText(ti, true, marked);
+	BOOST_CHECK( marked.vertices[0].colour == glm::vec3(1.f) );
+
+	// Key markup prints the key's name
+	TextRenderer::TextLayout key;
+	ti.text = "~k~~AB~";
+	TextRenderer::layoutText(ti, false, key);
+	BOOST_CHECK_EQUAL( key.vertices.size(), 12 );
+	BOOST_CHECK_EQUAL( key.width, plain.width );
+}
+
+BOOST_AUTO_TEST_CASE(layout_wrap)
+{
+	TextRenderer::TextInfo ti;
+	ti.size = 10.f;
+	ti.text = "AAAA AAAA AAAA end";
+	TextRenderer::TextLayout line, wrapped;
+	TextRenderer::layoutText(ti, false, line);
+	BOOST_CHECK_EQUAL( line.height, 0.f );
+
+	ti.wrapX = 10;
+	TextRenderer::layoutText(ti, false, wrapped);
+	BOOST_CHECK_EQUAL( wrapped.vertices.size(), line.vertices.size() );
+	BOOST_CHECK( wrapped.width < line.width );
+	BOOST_CHECK_EQUAL( wrapped.height, 20.f );
+}
+
+BOOST_AUTO_TEST_CASE(layout_cache)
+{
+	TextRenderer::LayoutCache cache(2);
+	TextRenderer::TextInfo ti;
+	ti.text = "First";
+
+	auto first = &cache.get(ti, false);
+	BOOST_CHECK_EQUAL( &cache.get(ti, false), first );
+	BOOST_CHECK_EQUAL( cache.getStats().hits, 1 );
+	BOOST_CHECK_EQUAL( cache.getStats().misses, 1 );
+
+	// Anything that changes the layout is part of the key
+	cache.get(ti, true);
+	ti.size = 2.f;
+	cache.get(ti, false);
+	BOOST_CHECK_EQUAL( cache.getStats().misses, 3 );
+	BOOST_CHECK_EQUAL( cache.size(), 2 );
+
+	// The position isn't
+	ti.screenPosition = glm::vec2(100.f, 100.f);
+	cache.get(ti, false);
+	BOOST_CHECK_EQUAL( cache.getStats().hits, 2 );
+
+	// The least recently used entry was dropped
+	ti.size = 1.f;
+	cache.get(ti, false);
+	BOOST_CHECK_EQUAL( cache.getStats().misses, 4 );
+}
+
+BOOST_AUTO_TEST_CASE(layout_cache_reuse)
+{
+	TextRenderer::LayoutCache cache(1);
+	TextRenderer::TextInfo ti;
+	ti.text = "00:59";
+	auto first = &cache.get(ti, false);
+	first->uploaded = true;
+
+	// A timer changes every frame, its entry and buffers are reused
+	ti.text = "00:58";
+	auto second = &cache.get(ti, false);
+	BOOST_CHECK_EQUAL( second, first );
+	BOOST_CHECK_EQUAL( second->key.text, "00:58" );
+	BOOST_CHECK( ! second->uploaded );
+	BOOST_CHECK_EQUAL( cache.size(), 1 );
+
+	ti.text = "00:59";
+	cache.get(ti, false);
+	BOOST_CHECK_EQUAL( cache.getStats().misses, 3 );
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_layout_cache)
+{
+	const int frames = 1000;
+	std::vector<TextRenderer::TextInfo> hud(8);
+	for( size_t t = 0; t < hud.size(); ++t ) {
+		hud[t].size = 20.f;
+		hud[t].wrapX = 40;
+		hud[t].text = "~y~Mission ~w~" + std::to_string(t) + ": press ~k~~PED_FIREWEAPON~ to shoot the target";
+	}
+
+	TextRenderer::TextLayout layout;
+	auto begin = BenchmarkClock::now();
+	for( int f = 0; f < frames; ++f ) {
+		for( auto& ti : hud ) {
+			TextRenderer::layoutText(ti, false, layout);
+		}
+	}
+	auto uncached = elapsedMicroseconds(begin);
+
+	TextRenderer::LayoutCache cache;
+	begin = BenchmarkClock::now();
+	for( int f = 0; f < frames; ++f ) {
+		for( auto& ti : hud ) {
+			cache.get(ti, false);
+		}
+	}
+	auto cached = elapsedMicroseconds(begin);
+
+	BOOST_CHECK_EQUAL( cache.getStats().misses, hud.size() );
+	BOOST_TEST_MESSAGE( "Text layout: " << (uncached / frames) << "us per frame laid out, "
+						<< (cached / frames) << "us per frame cached" );
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
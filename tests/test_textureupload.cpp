@@ -0,0 +1,135 @@
+#include <boost/test/unit_test.hpp>
+#include <gl/TextureUploadQueue.hpp>
+#include "test_globals.hpp"
+
+/**
+ * Creates a decoded texture with size bytes of pixels
+ */
+static DecodedTexture createTexture(const std::string& name, const std::string& alpha, size_t size)
+{
+	DecodedTexture texture;
+	texture.name = name;
+	texture.alpha = alpha;
+	texture.size = glm::ivec2(1, 1);
+	texture.transparent = false;
+	texture.valid = true;
+	texture.pixels.resize(size);
+	return texture;
+}
+
+BOOST_AUTO_TEST_SUITE(TextureUploadTests)
+
+BOOST_AUTO_TEST_CASE(test_expand_palette)
+{
+	std::vector<uint32_t> palette(256);
+	for( size_t c = 0; c < palette.size(); ++c ) {
+		palette[c] = 0xFF000000 | (c * 0x010203);
+	}
+
+	// An odd count covers both the wide loop and the remainder
+	std::vector<uint8_t> indices(37);
+	for( size_t i = 0; i < indices.size(); ++i ) {
+		indices[i] = (i * 97) & 0xFF;
+	}
+
+	std::vector<uint32_t> colours(indices.size() + 1, 0);
+	TextureLoader::expandPalette(palette.data(), indices.data(), indices.size(), colours.data());
+
+	for( size_t i = 0; i < indices.size(); ++i ) {
+		BOOST_CHECK_EQUAL( colours[i], palette[indices[i]] );
+	}
+	BOOST_CHECK_EQUAL( colours.back(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE(test_upload_budget)
+{
+	std::vector<std::string> uploadOrder;
+	TextureUploadQueue queue([&](const DecodedTexture& texture) {
+		uploadOrder.push_back(texture.name);
+		return TextureData::create(uploadOrder.size(), texture.size, texture.transparent);
+	});
+	queue.setFrameBudget(1000);
+
+	TextureArchive archive;
+	std::vector<DecodedTexture> textures;
+	textures.push_back(createTexture("a", "", 600));
+	textures.push_back(createTexture("b", "", 300));
+	textures.push_back(createTexture("c", "", 200));
+	textures.push_back(createTexture("d", "d_mask", 2000));
+	queue.add(std::move(textures), archive);
+
+	BOOST_CHECK_EQUAL( queue.getFrameStats().pending, 4 );
+	BOOST_CHECK_EQUAL( queue.getFrameStats().pendingBytes, 3100 );
+	BOOST_CHECK( archive.empty() );
+
+	queue.process();
+	BOOST_CHECK_EQUAL( queue.getFrameStats().uploaded, 2 );
+	BOOST_CHECK_EQUAL( queue.getFrameStats().uploadedBytes, 900 );
+	BOOST_CHECK_EQUAL( queue.getFrameStats().pending, 2 );
+	BOOST_CHECK_EQUAL( archive.size(), 2 );
+	BOOST_CHECK( archive.find(textureKey("c")) == archive.end() );
+
+	// A texture larger than the budget still goes on its own
+	queue.process();
+	BOOST_CHECK_EQUAL( queue.getFrameStats().uploaded, 1 );
+	queue.process();
+	BOOST_CHECK_EQUAL( queue.getFrameStats().uploaded, 1 );
+	BOOST_CHECK_EQUAL( queue.getFrameStats().uploadedBytes, 2000 );
+	BOOST_CHECK( queue.isEmpty() );
+
+	BOOST_CHECK_EQUAL( archive.size(), 5 );
+	auto d = archive[textureKey("d")];
+	auto dMask = archive[textureKey("d", "d_mask")];
+	BOOST_CHECK( d != nullptr );
+	BOOST_CHECK( d == dMask );
+	BOOST_REQUIRE_EQUAL( uploadOrder.size(), 4 );
+	BOOST_CHECK_EQUAL( uploadOrder[3], "d" );
+
+	queue.process();
+	BOOST_CHECK_EQUAL( queue.getFrameStats().uploaded, 0 );
+}
+
+BOOST_AUTO_TEST_CASE(test_upload_flush)
+{
+	size_t uploads = 0;
+	TextureUploadQueue queue([&](const DecodedTexture& texture) {
+		uploads++;
+		return TextureData::create(uploads, texture.size, texture.transparent);
+	});
+	queue.setFrameBudget(1);
+
+	TextureArchive archive;
+	std::vector<DecodedTexture> textures;
+	for( int t = 0; t < 10; ++t ) {
+		textures.push_back(createTexture("t" + std::to_string(t), "", 64));
+	}
+	queue.add(std::move(textures), archive);
+
+	queue.flush();
+	BOOST_CHECK_EQUAL( uploads, 10 );
+	BOOST_CHECK( queue.isEmpty() );
+	BOOST_CHECK_EQUAL( queue.getFrameBudget(), 1 );
+}
+
+#if RW_TEST_WITH_DATA
+BOOST_AUTO_TEST_CASE(test_decode_txd)
+{
+	auto file = Global::get().d->index.openFile("particle.txd");
+	BOOST_REQUIRE( file != nullptr );
+
+	TextureLoader loader;
+	std::vector<DecodedTexture> textures;
+	BOOST_REQUIRE( loader.decode(file, textures) );
+	BOOST_REQUIRE( ! textures.empty() );
+
+	for( auto& texture : textures ) {
+		BOOST_CHECK( ! texture.name.empty() );
+		if( texture.valid && texture.format == GL_RGBA && texture.type == GL_UNSIGNED_BYTE ) {
+			BOOST_CHECK_EQUAL( texture.pixels.size(),
+							   texture.size.x * texture.size.y * sizeof(uint32_t) );
+		}
+	}
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
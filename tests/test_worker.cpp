@@ -1,5 +1,12 @@
 #include <boost/test/unit_test.hpp>
 #include <job/WorkContext.hpp>
+#include <test_benchmark.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
 
 class TestJob : public WorkJob
 {
@@ -15,6 +22,104 @@ public:
 	void complete() { *_completed = true; }
 };
 
+class CountingJob : public WorkJob
+{
+public:
+	std::atomic<int>* _worked;
+	int* _completed;
+
+	CountingJob( WorkContext* context, std::atomic<int>* w, int* c, Priority priority = Normal )
+		: WorkJob(context, priority), _worked(w), _completed(c)
+	{}
+
+	void work() { ++(*_worked); }
+
+	void complete() { ++(*_completed); }
+};
+
+class OrderJob : public WorkJob
+{
+public:
+	std::vector<int>* _order;
+	int _id;
+
+	OrderJob( WorkContext* context, std::vector<int>* order, int id, Priority priority )
+		: WorkJob(context, priority), _order(order), _id(id)
+	{}
+
+	void work() { }
+
+	void complete() { _order->push_back(_id); }
+};
+
+/**
+ * Blocks wait() until open() has been called
+ */
+class Latch
+{
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _open = false;
+
+public:
+	void open() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_open = true;
+		}
+		_condition.notify_all();
+	}
+
+	void wait() {
+		std::unique_lock<std::mutex> lock(_mutex);
+		_condition.wait(lock, [this] { return _open; });
+	}
+};
+
+class BlockingJob : public WorkJob
+{
+public:
+	std::atomic<bool>* _release;
+	Latch* _started;
+
+	BlockingJob( WorkContext* context, std::atomic<bool>* release, Latch* started = nullptr )
+		: WorkJob(context), _release(release), _started(started)
+	{}
+
+	void work() {
+		if( _started ) {
+			_started->open();
+		}
+		while( ! *_release ) {
+			std::this_thread::yield();
+		}
+	}
+};
+
+#if RW_TEST_BENCHMARKS
+class LatencyJob : public WorkJob
+{
+public:
+	BenchmarkClock::time_point _queued;
+	double* _latency;
+
+	LatencyJob( WorkContext* context, double* latency )
+		: WorkJob(context), _queued(BenchmarkClock::now()), _latency(latency)
+	{}
+
+	void work() {
+		*_latency = elapsedMicroseconds(_queued);
+	}
+};
+#endif
+
+void waitForJobs(WorkContext& context)
+{
+	while( ! context.isEmpty() ) {
+		context.update();
+		std::this_thread::yield();
+	}
+}
 
 BOOST_AUTO_TEST_SUITE(WorkTests)
 
@@ -44,5 +149,191 @@ BOOST_AUTO_TEST_CASE(test_interface)
 	}
 }
 
-BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_CASE(test_worker_count)
+{
+	WorkContext context(3);
+	BOOST_CHECK_EQUAL( context.getWorkerCount(), 3 );
+
+	WorkContext hardware;
+	BOOST_CHECK( hardware.getWorkerCount() >= 1 );
+}
+
+BOOST_AUTO_TEST_CASE(test_many_jobs)
+{
+	WorkContext context(4);
+
+	std::atomic<int> worked(0);
+	int completed = 0;
+	const int jobs = 1000;
+
+	for( int i = 0; i < jobs; ++i ) {
+		context.queueJob(new CountingJob(&context, &worked, &completed));
+	}
+
+	BOOST_CHECK( ! context.isEmpty() );
+
+	waitForJobs(context);
+
+	BOOST_CHECK_EQUAL( worked, jobs );
+	BOOST_CHECK_EQUAL( completed, jobs );
+	BOOST_CHECK_EQUAL( context.getPendingJobCount(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE(test_priority)
+{
+	WorkContext context(1);
+
+	// Hold the only worker until all of the jobs have been queued
+	std::atomic<bool> release(false);
+	Latch started;
+	context.queueJob(new BlockingJob(&context, &release, &started));
+	started.wait();
+
+	std::vector<int> order;
+	context.queueJob(new OrderJob(&context, &order, 2, WorkJob::Low));
+	context.queueJob(new OrderJob(&context, &order, 1, WorkJob::Normal));
+	context.queueJob(new OrderJob(&context, &order, 0, WorkJob::High));
+
+	release = true;
+
+	while( order.size() < 3 ) {
+		context.update();
+		std::this_thread::yield();
+	}
+
+	BOOST_CHECK_EQUAL( order[0], 0 );
+	BOOST_CHECK_EQUAL( order[1], 1 );
+	BOOST_CHECK_EQUAL( order[2], 2 );
+}
+
+BOOST_AUTO_TEST_CASE(test_stealing)
+{
+	WorkContext context(2);
+
+	// Blocks one worker, the other must steal the rest of the work
+	std::atomic<bool> release(false);
+	context.queueJob(new BlockingJob(&context, &release));
+
+	std::atomic<int> worked(0);
+	int completed = 0;
+	for( int i = 0; i < 10; ++i ) {
+		context.queueJob(new CountingJob(&context, &worked, &completed));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	while( worked < 10 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5) ) {
+		std::this_thread::yield();
+	}
 
+	BOOST_CHECK_EQUAL( worked, 10 );
+
+	release = true;
+	waitForJobs(context);
+
+	BOOST_CHECK_EQUAL( completed, 10 );
+}
+
+BOOST_AUTO_TEST_CASE(test_completion_queue)
+{
+	class CountingQueue : public LockedCompletionQueue
+	{
+	public:
+		std::atomic<int>* pushed;
+		CountingQueue(std::atomic<int>* p) : pushed(p) {}
+		void push(WorkJob* job) { ++(*pushed); LockedCompletionQueue::push(job); }
+	};
+
+	std::atomic<int> pushed(0);
+	WorkContext context(2, new CountingQueue(&pushed));
+
+	std::atomic<int> worked(0);
+	int completed = 0;
+	for( int i = 0; i < 16; ++i ) {
+		context.queueJob(new CountingJob(&context, &worked, &completed));
+	}
+
+	waitForJobs(context);
+
+	BOOST_CHECK_EQUAL( pushed, 16 );
+	BOOST_CHECK_EQUAL( completed, 16 );
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_for)
+{
+	WorkContext context(3);
+
+	std::vector<int> values(10000, 0);
+	context.parallelFor(values.size(), 64, [&](size_t begin, size_t end) {
+		for( size_t i = begin; i < end; ++i ) {
+			values[i] += int(i);
+		}
+	});
+
+	bool correct = true;
+	for( size_t i = 0; i < values.size(); ++i ) {
+		correct = correct && values[i] == int(i);
+	}
+	BOOST_CHECK( correct );
+
+	// Still finishes when every worker is busy
+	std::atomic<bool> release(false);
+	for( size_t w = 0; w < context.getWorkerCount(); ++w ) {
+		context.queueJob(new BlockingJob(&context, &release));
+	}
+
+	std::atomic<int> chunks(0);
+	context.parallelFor(100, 10, [&](size_t, size_t) { ++chunks; });
+	BOOST_CHECK_EQUAL( chunks, 10 );
+
+	release = true;
+	waitForJobs(context);
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_throughput)
+{
+	WorkContext context;
+
+	std::atomic<int> worked(0);
+	int completed = 0;
+	const int jobs = 100000;
+
+	auto start = BenchmarkClock::now();
+
+	for( int i = 0; i < jobs; ++i ) {
+		context.queueJob(new CountingJob(&context, &worked, &completed));
+	}
+	waitForJobs(context);
+
+	auto seconds = elapsedSeconds(start);
+
+	BOOST_CHECK_EQUAL( completed, jobs );
+	BOOST_TEST_MESSAGE( "WorkContext throughput: " << context.getWorkerCount()
+						<< " workers, " << jobs / seconds << " jobs/s" );
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_latency)
+{
+	WorkContext context;
+
+	const int samples = 200;
+	std::vector<double> latencies(samples);
+
+	for( int i = 0; i < samples; ++i ) {
+		// Let the workers go back to sleep, so wake-up time is included
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+		context.queueJob(new LatencyJob(&context, &latencies[i]));
+		waitForJobs(context);
+	}
+
+	BOOST_CHECK( context.isEmpty() );
+
+	std::sort(latencies.begin(), latencies.end());
+
+	BOOST_TEST_MESSAGE( "WorkContext latency: p50 " << latencies[samples / 2]
+						<< "us p99 " << latencies[samples * 99 / 100]
+						<< "us max " << latencies.back() << "us" );
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,228 @@
+#include <boost/test/unit_test.hpp>
+#include <loaders/WorldCache.hpp>
+#include <loaders/LoaderIPL.hpp>
+#include <engine/GameData.hpp>
+#include <core/Logger.hpp>
+#include <job/WorkContext.hpp>
+#include <test_benchmark.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef std::map<ObjectID, ObjectInformationPtr> ObjectMap;
+
+static void addObject(ObjectMap& objects, ObjectID id, const std::string& model, bool lod)
+{
+	std::shared_ptr<ObjectData> object(new ObjectData);
+	object->ID = id;
+	object->modelName = model;
+	object->LOD = lod;
+	objects[id] = object;
+}
+
+static std::string tempPath()
+{
+	char path[] = "/tmp/rwworldcacheXXXXXX";
+	int fd = mkstemp(path);
+	close(fd);
+	return path;
+}
+
+/**
+ * Writes an IPL with an instance of each object in a grid, repeated count times
+ */
+static void writeIPL(const std::string& path, const ObjectMap& objects, int count)
+{
+	std::ofstream ipl(path);
+	ipl << "# test\ninst\n";
+	for( int i = 0; i < count; ++i ) {
+		for( auto& object : objects ) {
+			auto data = std::static_pointer_cast<ObjectData>(object.second);
+			ipl << object.first << ", " << data->modelName << ", "
+				<< i << ", " << object.first << ", 10, 1, 1, 1, 0, 0, 0, 1\n";
+		}
+	}
+	ipl << "end\nzone\nDOWNTOWN, 0, -10, -20, -30, 10, 20, 30, 1\nend\n";
+}
+
+BOOST_AUTO_TEST_SUITE(WorldCacheTests)
+
+BOOST_AUTO_TEST_CASE(test_build_lods)
+{
+	ObjectMap objects;
+	addObject(objects, 100, "nbtm_house", false);
+	addObject(objects, 101, "LODm_house", true);
+	addObject(objects, 102, "nbtm_shop", false);
+	addObject(objects, 103, "LODm_shop", true);
+	addObject(objects, 104, "nbtm_tree", false);
+
+	auto path = tempPath();
+	{
+		std::ofstream ipl(path);
+		ipl << "inst\n"
+			<< "100, nbtm_house, 1, 2, 3, 1, 1, 1, 0, 0, 0, 1\n"
+			<< "102, nbtm_shop, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1\n"
+			<< "104, nbtm_tree, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1\n"
+			<< "101, LODm_house, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1\n"
+			<< "999, missing, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1\n"
+			<< "end\n";
+	}
+
+	LoaderIPL loader;
+	BOOST_REQUIRE( loader.load(path) );
+	auto cache = WorldCache::build(loader, 1, WorldCache::hashObjects(objects), objects);
+
+	BOOST_REQUIRE_EQUAL( cache.instances.size(), 5 );
+	BOOST_CHECK_EQUAL( cache.instances[0].id, 100 );
+	BOOST_CHECK_EQUAL( cache.instances[0].position.z, 3.f );
+	BOOST_CHECK_EQUAL( cache.instances[0].lod, 3 );
+	BOOST_CHECK_EQUAL( cache.instances[1].lod, WorldCache::ExternalLOD );
+	BOOST_CHECK_EQUAL( cache.instances[2].lod, WorldCache::NoLOD );
+	BOOST_CHECK_EQUAL( cache.instances[3].lod, WorldCache::NoLOD );
+	BOOST_CHECK_EQUAL( cache.instances[4].lod, WorldCache::NoLOD );
+
+	std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_round_trip)
+{
+	ObjectMap objects;
+	addObject(objects, 100, "nbtm_house", false);
+	addObject(objects, 101, "LODm_house", true);
+
+	auto iplPath = tempPath();
+	auto cachePath = tempPath();
+	writeIPL(iplPath, objects, 3);
+
+	uint64_t hash;
+	BOOST_REQUIRE( WorldCache::hashFile(iplPath, hash) );
+	LoaderIPL loader;
+	BOOST_REQUIRE( loader.load(iplPath) );
+	auto built = WorldCache::build(loader, hash, WorldCache::hashObjects(objects), objects);
+	BOOST_REQUIRE( built.save(cachePath) );
+
+	WorldCache loaded;
+	BOOST_REQUIRE( loaded.load(cachePath) );
+	BOOST_CHECK_EQUAL( loaded.sourceHash, hash );
+	BOOST_CHECK_EQUAL( loaded.objectHash, WorldCache::hashObjects(objects) );
+	BOOST_REQUIRE_EQUAL( loaded.instances.size(), built.instances.size() );
+	for( size_t i = 0; i < loaded.instances.size(); ++i ) {
+		BOOST_CHECK_EQUAL( loaded.instances[i].id, built.instances[i].id );
+		BOOST_CHECK_EQUAL( loaded.instances[i].lod, built.instances[i].lod );
+		BOOST_CHECK( loaded.instances[i].position == built.instances[i].position );
+		BOOST_CHECK( loaded.instances[i].rotation == built.instances[i].rotation );
+	}
+	BOOST_REQUIRE_EQUAL( loaded.zones.size(), 1 );
+	BOOST_CHECK_EQUAL( loaded.zones[0].name, "DOWNTOWN" );
+	BOOST_CHECK_EQUAL( loaded.zones[0].max.y, 20.f );
+	BOOST_CHECK_EQUAL( loaded.zones[0].island, 1 );
+
+	// Renaming an object changes what the cache was built against
+	addObject(objects, 100, "nbtm_home", false);
+	BOOST_CHECK( loaded.objectHash != WorldCache::hashObjects(objects) );
+
+	// Editing the text changes its checksum
+	{
+		std::ofstream ipl(iplPath, std::ios_base::app);
+		ipl << "# edited\n";
+	}
+	uint64_t edited;
+	BOOST_REQUIRE( WorldCache::hashFile(iplPath, edited) );
+	BOOST_CHECK( edited != hash );
+
+	BOOST_CHECK( ! loaded.load("/tmp/rw-missing-world-cache") );
+
+	std::remove(iplPath.c_str());
+	std::remove(cachePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_cache_per_path)
+{
+	char root[] = "/tmp/rwworlddataXXXXXX";
+	BOOST_REQUIRE( mkdtemp(root) != nullptr );
+	std::string dataPath = root;
+	std::string cacheDir = dataPath + "/cache";
+	mkdir((dataPath + "/a").c_str(), 0700);
+	mkdir((dataPath + "/b").c_str(), 0700);
+	mkdir(cacheDir.c_str(), 0700);
+
+	// Two IPLs with the same name in different directories
+	ObjectMap first, second;
+	addObject(first, 100, "nbtm_house", false);
+	addObject(second, 200, "nbtm_shop", false);
+	writeIPL(dataPath + "/a/same.ipl", first, 1);
+	writeIPL(dataPath + "/b/same.ipl", second, 2);
+
+	Logger log;
+	WorkContext work;
+	GameData data(&log, &work, dataPath);
+	data.worldCachePath = cacheDir;
+
+	for( int pass = 0; pass < 2; ++pass ) {
+		WorldCache a, b;
+		BOOST_REQUIRE( data.loadWorldCache(dataPath + "/a/same.ipl", a) );
+		BOOST_REQUIRE( data.loadWorldCache(dataPath + "/b/same.ipl", b) );
+		BOOST_REQUIRE_EQUAL( a.instances.size(), 1 );
+		BOOST_CHECK_EQUAL( a.instances[0].id, 100 );
+		BOOST_REQUIRE_EQUAL( b.instances.size(), 2 );
+		BOOST_CHECK_EQUAL( b.instances[0].id, 200 );
+	}
+
+	std::string cacheA = cacheDir + "/a_same.ipl.bin";
+	std::string cacheB = cacheDir + "/b_same.ipl.bin";
+	BOOST_CHECK_EQUAL( access(cacheA.c_str(), F_OK), 0 );
+	BOOST_CHECK_EQUAL( access(cacheB.c_str(), F_OK), 0 );
+
+	std::remove(cacheA.c_str());
+	std::remove(cacheB.c_str());
+	std::remove((dataPath + "/a/same.ipl").c_str());
+	std::remove((dataPath + "/b/same.ipl").c_str());
+	rmdir(cacheDir.c_str());
+	rmdir((dataPath + "/a").c_str());
+	rmdir((dataPath + "/b").c_str());
+	rmdir(root);
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_AUTO_TEST_CASE(benchmark_world_load)
+{
+	ObjectMap objects;
+	for( ObjectID id = 0; id < 100; id += 2 ) {
+		addObject(objects, id, "nbtm_" + std::to_string(id), false);
+		addObject(objects, id + 1, "LODm_" + std::to_string(id), true);
+	}
+
+	auto iplPath = tempPath();
+	auto cachePath = tempPath();
+	writeIPL(iplPath, objects, 200);
+
+	auto begin = BenchmarkClock::now();
+	uint64_t hash;
+	WorldCache::hashFile(iplPath, hash);
+	LoaderIPL loader;
+	loader.load(iplPath);
+	auto built = WorldCache::build(loader, hash, WorldCache::hashObjects(objects), objects);
+	auto textTime = elapsedMilliseconds(begin);
+
+	built.save(cachePath);
+
+	begin = BenchmarkClock::now();
+	WorldCache::hashFile(iplPath, hash);
+	WorldCache loaded;
+	loaded.load(cachePath);
+	bool valid = loaded.sourceHash == hash && loaded.objectHash == WorldCache::hashObjects(objects);
+	auto binaryTime = elapsedMilliseconds(begin);
+
+	BOOST_CHECK( valid );
+	BOOST_CHECK_EQUAL( loaded.instances.size(), built.instances.size() );
+	BOOST_TEST_MESSAGE( "World load: " << built.instances.size() << " instances, text "
+						<< textTime << "ms, binary " << binaryTime << "ms" );
+
+	std::remove(iplPath.c_str());
+	std::remove(cachePath.c_str());
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
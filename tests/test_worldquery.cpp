@@ -0,0 +1,267 @@
+#include <boost/test/unit_test.hpp>
+#include <engine/WorldQuery.hpp>
+#include <test_benchmark.hpp>
+#include <algorithm>
+#include <memory>
+#include <random>
+
+/**
+ * An object of any type and model, without a world
+ */
+class QueryObject : public GameObject
+{
+public:
+	QueryObject(const glm::vec3& pos, Type objectType, ObjectID modelID,
+				StringID modelName = StringTable::Empty)
+		: GameObject(nullptr, pos, {}, nullptr)
+		, objectType(objectType)
+		, modelID(modelID)
+		, modelName(modelName)
+	{}
+
+	Type type() { return objectType; }
+	ObjectID getModelID() const { return modelID; }
+	StringID getModelName() const { return modelName; }
+
+	void tick(float dt) { RW_UNUSED(dt); }
+
+private:
+	Type objectType;
+	ObjectID modelID;
+	StringID modelName;
+};
+
+static bool contains(const std::vector<GameObject*>& objects, GameObject* object)
+{
+	return std::find(objects.begin(), objects.end(), object) != objects.end();
+}
+
+/**
+ * A world's worth of instances with some vehicles and peds among them
+ */
+struct QueryFixture
+{
+	SpatialIndex index;
+	WorldQuery query;
+	std::vector<std::unique_ptr<QueryObject>> objects;
+
+	QueryFixture()
+		: index(4000.f, 7, 50.f)
+		, query(index)
+	{
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> position(-2000.f, 2000.f);
+		std::uniform_int_distribution<int> model(0, 99);
+		for( int i = 0; i < 20000; ++i ) {
+			glm::vec3 pos(position(random), position(random), position(random) / 100.f);
+			auto type = (i % 10 == 0) ? GameObject::Vehicle
+					: (i % 10 == 1) ? GameObject::Character
+					: GameObject::Instance;
+			objects.emplace_back(new QueryObject(pos, type, model(random)));
+			index.insert(objects.back().get(), 5.f, type == GameObject::Instance);
+		}
+	}
+};
+
+BOOST_AUTO_TEST_SUITE(WorldQueryTests)
+
+BOOST_AUTO_TEST_CASE(test_filters)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	WorldQuery query(index);
+	QueryObject lamp({10.f, 0.f, 0.f}, GameObject::Instance, 50);
+	QueryObject bin({12.f, 0.f, 0.f}, GameObject::Instance, 51);
+	QueryObject car({5.f, 5.f, 0.f}, GameObject::Vehicle, 90);
+	QueryObject ped({-5.f, 0.f, 0.f}, GameObject::Character, 1);
+	QueryObject farLamp({500.f, 0.f, 0.f}, GameObject::Instance, 50);
+	for( auto o : std::vector<QueryObject*>{ &lamp, &bin, &car, &ped, &farLamp } ) {
+		index.insert(o, 1.f, o->type() == GameObject::Instance);
+	}
+
+	std::vector<GameObject*> found;
+	query.sphere({0.f, 0.f, 0.f}, 20.f, {}, found);
+	BOOST_CHECK_EQUAL( found.size(), 4 );
+
+	found.clear();
+	query.sphere({0.f, 0.f, 0.f}, 20.f, WorldQuery::Filter({GameObject::Instance}).withModel(50), found);
+	BOOST_REQUIRE_EQUAL( found.size(), 1 );
+	BOOST_CHECK_EQUAL( found[0], &lamp );
+
+	found.clear();
+	query.box({-10.f, -10.f, -1.f}, {11.f, 10.f, 1.f}, {GameObject::Vehicle, GameObject::Character}, found);
+	BOOST_CHECK_EQUAL( found.size(), 2 );
+	BOOST_CHECK( contains(found, &car) );
+	BOOST_CHECK( contains(found, &ped) );
+
+	// Positions, not bounds, decide what's inside
+	BOOST_CHECK( ! query.anyInBox({11.5f, -1.f, -1.f}, {11.9f, 1.f, 1.f}, {}) );
+	BOOST_CHECK( query.anyInBox({11.5f, -1.f, -1.f}, {12.5f, 1.f, 1.f}, {}) );
+	BOOST_CHECK( ! query.anyInBox({11.5f, -1.f, -1.f}, {12.5f, 1.f, 1.f}, {GameObject::Vehicle}) );
+}
+
+BOOST_AUTO_TEST_CASE(test_filter_model_name)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	WorldQuery query(index);
+	auto door = StringTable::get().intern("test_door");
+	// Two definitions sharing a model, as IDE files sometimes have
+	QueryObject door1({1.f, 0.f, 0.f}, GameObject::Instance, 60, door);
+	QueryObject door2({2.f, 0.f, 0.f}, GameObject::Instance, 61, door);
+	QueryObject wall({3.f, 0.f, 0.f}, GameObject::Instance, 62,
+					 StringTable::get().intern("test_wall"));
+	for( auto o : std::vector<QueryObject*>{ &door1, &door2, &wall } ) {
+		index.insert(o, 1.f, true);
+	}
+
+	std::vector<GameObject*> found;
+	query.sphere({0.f, 0.f, 0.f}, 10.f, WorldQuery::Filter({GameObject::Instance}).withModelID(door), found);
+	BOOST_CHECK_EQUAL( found.size(), 2 );
+	BOOST_CHECK( contains(found, &door1) );
+	BOOST_CHECK( contains(found, &door2) );
+
+	found.clear();
+	query.sphere({0.f, 0.f, 0.f}, 10.f, WorldQuery::Filter().withModel(61).withModelID(door), found);
+	BOOST_REQUIRE_EQUAL( found.size(), 1 );
+	BOOST_CHECK_EQUAL( found[0], &door2 );
+}
+
+BOOST_AUTO_TEST_CASE(test_nearest)
+{
+	SpatialIndex index(4000.f, 7, 50.f);
+	WorldQuery query(index);
+	QueryObject a({3.f, 0.f, 0.f}, GameObject::Vehicle, 90);
+	QueryObject b({-1.f, 0.f, 0.f}, GameObject::Vehicle, 90);
+	QueryObject c({200.f, 0.f, 0.f}, GameObject::Vehicle, 90);
+	QueryObject d({2.f, 0.f, 0.f}, GameObject::Character, 1);
+	for( auto o : std::vector<QueryObject*>{ &a, &b, &c, &d } ) {
+		index.insert(o, 1.f, false);
+	}
+
+	std::vector<GameObject*> found;
+	query.nearest({0.f, 0.f, 0.f}, 2, 1000.f, {GameObject::Vehicle}, found);
+	BOOST_REQUIRE_EQUAL( found.size(), 2 );
+	BOOST_CHECK_EQUAL( found[0], &b );
+	BOOST_CHECK_EQUAL( found[1], &a );
+
+	// Widens the search until there are enough
+	found.clear();
+	query.nearest({0.f, 0.f, 0.f}, 5, 1000.f, {GameObject::Vehicle}, found);
+	BOOST_REQUIRE_EQUAL( found.size(), 3 );
+	BOOST_CHECK_EQUAL( found[2], &c );
+
+	found.clear();
+	query.nearest({0.f, 0.f, 0.f}, 5, 100.f, {GameObject::Vehicle}, found);
+	BOOST_CHECK_EQUAL( found.size(), 2 );
+}
+
+#if RW_TEST_BENCHMARKS
+BOOST_FIXTURE_TEST_CASE(benchmark_query_box, QueryFixture)
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-1900.f, 1900.f);
+	const int queries = 1000;
+
+	size_t indexed = 0, linear = 0;
+	double indexedTime = 0.0, linearTime = 0.0;
+	WorldQuery::Filter filter({GameObject::Vehicle});
+	for( int q = 0; q < queries; ++q ) {
+		glm::vec3 min(position(random), position(random), -50.f);
+		glm::vec3 max = min + glm::vec3(60.f, 40.f, 100.f);
+
+		auto begin = BenchmarkClock::now();
+		std::vector<GameObject*> found;
+		query.box(min, max, filter, found);
+		indexedTime += elapsedMicroseconds(begin);
+		indexed += found.size();
+
+		// What the opcodes used to do
+		begin = BenchmarkClock::now();
+		for( auto& o : objects ) {
+			auto p = o->getPosition();
+			if( filter.matches(o.get()) && glm::all(glm::greaterThanEqual(p, min))
+					&& glm::all(glm::lessThanEqual(p, max)) ) {
+				linear++;
+			}
+		}
+		linearTime += elapsedMicroseconds(begin);
+	}
+
+	BOOST_CHECK_EQUAL( indexed, linear );
+	BOOST_TEST_MESSAGE( "Box: " << (indexedTime / queries) << "us per query, "
+						<< (linearTime / queries) << "us scanning " << objects.size() << " objects" );
+}
+
+BOOST_FIXTURE_TEST_CASE(benchmark_query_sphere, QueryFixture)
+{
+	std::mt19937 random(2);
+	std::uniform_real_distribution<float> position(-1900.f, 1900.f);
+	const int queries = 1000;
+
+	size_t indexed = 0, linear = 0;
+	double indexedTime = 0.0, linearTime = 0.0;
+	WorldQuery::Filter filter = WorldQuery::Filter({GameObject::Instance}).withModel(42);
+	for( int q = 0; q < queries; ++q ) {
+		glm::vec3 center(position(random), position(random), 0.f);
+		float radius = 50.f;
+
+		auto begin = BenchmarkClock::now();
+		std::vector<GameObject*> found;
+		query.sphere(center, radius, filter, found);
+		indexedTime += elapsedMicroseconds(begin);
+		indexed += found.size();
+
+		begin = BenchmarkClock::now();
+		for( auto& o : objects ) {
+			if( filter.matches(o.get()) && glm::distance(o->getPosition(), center) <= radius ) {
+				linear++;
+			}
+		}
+		linearTime += elapsedMicroseconds(begin);
+	}
+
+	BOOST_CHECK_EQUAL( indexed, linear );
+	BOOST_TEST_MESSAGE( "Sphere: " << (indexedTime / queries) << "us per query, "
+						<< (linearTime / queries) << "us scanning " << objects.size() << " objects" );
+}
+
+BOOST_FIXTURE_TEST_CASE(benchmark_query_nearest, QueryFixture)
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(-1900.f, 1900.f);
+	const int queries = 1000;
+
+	double indexedTime = 0.0, linearTime = 0.0;
+	bool matches = true;
+	WorldQuery::Filter filter({GameObject::Vehicle});
+	for( int q = 0; q < queries; ++q ) {
+		glm::vec3 center(position(random), position(random), 0.f);
+
+		auto begin = BenchmarkClock::now();
+		std::vector<GameObject*> found;
+		query.nearest(center, 4, 500.f, filter, found);
+		indexedTime += elapsedMicroseconds(begin);
+
+		begin = BenchmarkClock::now();
+		std::vector<std::pair<float, GameObject*>> all;
+		for( auto& o : objects ) {
+			float d = glm::distance(o->getPosition(), center);
+			if( filter.matches(o.get()) && d <= 500.f ) {
+				all.push_back({ d, o.get() });
+			}
+		}
+		std::sort(all.begin(), all.end());
+		linearTime += elapsedMicroseconds(begin);
+
+		matches = matches && found.size() == std::min<size_t>(4, all.size());
+		for( size_t i = 0; i < found.size() && matches; ++i ) {
+			matches = found[i] == all[i].second;
+		}
+	}
+
+	BOOST_CHECK( matches );
+	BOOST_TEST_MESSAGE( "Nearest: " << (indexedTime / queries) << "us per query, "
+						<< (linearTime / queries) << "us scanning " << objects.size() << " objects" );
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()